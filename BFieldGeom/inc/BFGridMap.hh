@@ -71,6 +71,11 @@ namespace mu2e {
 
         virtual bool getBFieldWithStatus(const CLHEP::Hep3Vector&, CLHEP::Hep3Vector&) const;
 
+        // Field and the analytic derivatives of the interpolation polynomial, in one pass.
+        virtual bool getBFieldWithGradient(const CLHEP::Hep3Vector& point,
+                                           CLHEP::Hep3Vector& result,
+                                           CLHEP::Hep3Vector grad[3]) const;
+
         // Validity checker
         virtual bool isValid(const CLHEP::Hep3Vector& point) const;
         bool isValid(const GridPoint& ipoint) const {
@@ -146,6 +151,22 @@ namespace mu2e {
 
         bool interpolateTriLinear(const CLHEP::Hep3Vector&, CLHEP::Hep3Vector&) const;
         bool interpolateQuadratic(const CLHEP::Hep3Vector&, CLHEP::Hep3Vector&) const;
+
+        // Same as above, also returning the derivatives of the interpolated field.
+        bool interpolateTriLinear(const CLHEP::Hep3Vector&,
+                                  CLHEP::Hep3Vector&,
+                                  CLHEP::Hep3Vector grad[3]) const;
+        bool interpolateQuadratic(const CLHEP::Hep3Vector&,
+                                  CLHEP::Hep3Vector&,
+                                  CLHEP::Hep3Vector grad[3]) const;
+
+        // Find the 3x3x3 neighbors used by the quadratic interpolation, and the
+        // position of the point in their unit grid.  Point is the test point with
+        // the y-symmetry applied.
+        bool quadraticNeighbors(const CLHEP::Hep3Vector& testpoint,
+                                const CLHEP::Hep3Vector& point,
+                                CLHEP::Hep3Vector neighborsBF[3][3][3],
+                                CLHEP::Hep3Vector& frac) const;
     };
 
     inline BFGridMap::GridPoint BFGridMap::point2grid(const CLHEP::Hep3Vector& pos) const {
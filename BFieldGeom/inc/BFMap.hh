@@ -50,6 +50,25 @@ namespace mu2e {
         // Accessors
         virtual bool getBFieldWithStatus(const CLHEP::Hep3Vector&, CLHEP::Hep3Vector&) const = 0;
 
+        // Field and its derivatives at a point, grad[i] is dB/dx_i in tesla/mm.
+        // This default uses central differences with a 1 mm step; grid maps
+        // override it with the derivatives of their interpolation.
+        virtual bool getBFieldWithGradient(const CLHEP::Hep3Vector& point,
+                                           CLHEP::Hep3Vector& result,
+                                           CLHEP::Hep3Vector grad[3]) const {
+            static const double h(1.0);
+            bool retval = getBFieldWithStatus(point, result);
+            for (int i = 0; i != 3; ++i) {
+                CLHEP::Hep3Vector dx;
+                dx[i] = h;
+                CLHEP::Hep3Vector bm, bp;
+                getBFieldWithStatus(point - dx, bm);
+                getBFieldWithStatus(point + dx, bp);
+                grad[i] = (bp - bm) / (2. * h);
+            }
+            return retval;
+        }
+
         // Validity checker
         virtual bool isValid(const CLHEP::Hep3Vector& point) const = 0;
 
@@ -44,6 +44,12 @@ namespace mu2e {
                                  BFCacheManager const&,
                                  CLHEP::Hep3Vector&) const;
 
+        // Get field and its derivatives, grad[i] = dB/dx_i in tesla/mm, from the
+        // map containing the point.  Zero field and gradient for out of range.
+        bool getBFieldWithGradient(const CLHEP::Hep3Vector&,
+                                   CLHEP::Hep3Vector&,
+                                   CLHEP::Hep3Vector grad[3]) const;
+
         // Just return zero for out of range.
         CLHEP::Hep3Vector getBField(const CLHEP::Hep3Vector& pos) const {
             // Default c'tor sets all components to zero - which is what we need here.
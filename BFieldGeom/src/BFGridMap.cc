@@ -26,6 +26,30 @@
 
 using namespace std;
 
+namespace {
+
+    // Weights of the Lagrange 2nd order polynomial through x = 0, 1, 2 (see gmcpoly2),
+    // and their derivatives
+    void gmcweights(double x, double w[3], double dw[3]) {
+        w[0] = 0.5 * (x - 1.) * (x - 2.);
+        w[1] = -x * (x - 2.);
+        w[2] = 0.5 * x * (x - 1.);
+        dw[0] = x - 1.5;
+        dw[1] = 2. - 2. * x;
+        dw[2] = x - 0.5;
+    }
+
+    // The field at y < 0 of a map with XZ-plane symmetry is (Bx, -By, Bz)(x, -y, z)
+    void flipYGradient(CLHEP::Hep3Vector& result, CLHEP::Hep3Vector grad[3]) {
+        result.setY(-result.y());
+        grad[0].setY(-grad[0].y());
+        grad[2].setY(-grad[2].y());
+        grad[1].setX(-grad[1].x());
+        grad[1].setZ(-grad[1].z());
+    }
+
+}  // end anonymous namespace
+
 namespace mu2e {
 
     // function to determine if the point is in the map; take into account Y-symmetry
@@ -170,6 +194,29 @@ namespace mu2e {
         return retval;
     }
 
+    bool BFGridMap::getBFieldWithGradient(const CLHEP::Hep3Vector& testpoint,
+                                          CLHEP::Hep3Vector& result,
+                                          CLHEP::Hep3Vector grad[3]) const {
+        bool retval(false);
+
+        if (_interpStyle == BFInterpolationStyle::trilinear) {
+            retval = interpolateTriLinear(testpoint, result, grad);
+
+        } else if (_interpStyle == BFInterpolationStyle::meco) {
+            retval = interpolateQuadratic(testpoint, result, grad);
+
+        } else {
+            throw cet::exception("GEOM")
+                << "Unrecognized option for interpolation into the BField: " << _interpStyle
+                << "\n";
+        }
+        result *= _scaleFactor;
+        for (int i = 0; i != 3; ++i) {
+            grad[i] *= _scaleFactor;
+        }
+        return retval;
+    }
+
     // The algorithm is:
     // Find the grid cube in which the point lives - this defines eight corner points.
     // Assign a weight to each corner that is the "distance" to each corner - see below for
@@ -239,6 +286,66 @@ namespace mu2e {
         return true;
     }
 
+    // Trilinear interpolation and its derivatives: the weights are linear in each
+    // coordinate, so the derivative along x uses the weights -1/dx and +1/dx for
+    // the two x corners, and similarly for y and z.
+    bool BFGridMap::interpolateTriLinear(const CLHEP::Hep3Vector& p,
+                                         CLHEP::Hep3Vector& result,
+                                         CLHEP::Hep3Vector grad[3]) const {
+        result = CLHEP::Hep3Vector(0., 0., 0.);
+        for (int n = 0; n != 3; ++n) {
+            grad[n] = CLHEP::Hep3Vector(0., 0., 0.);
+        }
+
+        double px = p.x();
+        double py = p.y();
+        if (_flipy)
+            py = std::abs(p.y());
+        double pz = p.z();
+
+        // Indicies into each dimension;
+        int i = floor((px - _xmin) / _dx);
+        int j = floor((py - _ymin) / _dy);
+        int k = floor((pz - _zmin) / _dz);
+
+        // Check that we are inside the map.
+        if (i < 0 || i >= int(_nx) || j < 0 || j >= int(_ny) || k < 0 || k >= int(_nz)) {
+            if (_warnIfOutside) {
+                mf::LogWarning("GEOM")
+                    << "Point is outside of the valid region of the map: " << _key << "\n"
+                    << "Point in input coordinates: " << p << "\n";
+            }
+            return false;
+        }
+
+        // Trilinear fractional weighting factors.
+        double fx = 1.0 - (px - _xmin - i * _dx) / _dx;
+        double fy = 1.0 - (py - _ymin - j * _dy) / _dy;
+        double fz = 1.0 - (pz - _zmin - k * _dz) / _dz;
+
+        const double wx[2] = {fx, 1.0 - fx}, dwx[2] = {-1.0 / _dx, 1.0 / _dx};
+        const double wy[2] = {fy, 1.0 - fy}, dwy[2] = {-1.0 / _dy, 1.0 / _dy};
+        const double wz[2] = {fz, 1.0 - fz}, dwz[2] = {-1.0 / _dz, 1.0 / _dz};
+
+        for (int c = 0; c != 2; ++c) {
+            for (int b = 0; b != 2; ++b) {
+                for (int a = 0; a != 2; ++a) {
+                    const CLHEP::Hep3Vector& f = _field(i + a, j + b, k + c);
+                    result += (wx[a] * wy[b] * wz[c]) * f;
+                    grad[0] += (dwx[a] * wy[b] * wz[c]) * f;
+                    grad[1] += (wx[a] * dwy[b] * wz[c]) * f;
+                    grad[2] += (wx[a] * wy[b] * dwz[c]) * f;
+                }
+            }
+        }
+
+        // Need the signed value of p.y() here - the variable py will not do.
+        if (_flipy && p.y() < 0) {
+            flipYGradient(result, grad);
+        }
+        return true;
+    }
+
     // Function to return the BField for any point
     bool BFGridMap::interpolateQuadratic(const CLHEP::Hep3Vector& testpoint,
                                          CLHEP::Hep3Vector& result) const {
@@ -261,6 +368,88 @@ namespace mu2e {
                  << "\tPoint:              " << point << endl;
         }
 
+        // Get the BField values of the nearest grid neighbors and the fractional grid point
+        CLHEP::Hep3Vector neighborsBF[3][3][3];
+        CLHEP::Hep3Vector frac;
+        if (!quadraticNeighbors(testpoint, point, neighborsBF, frac)) {
+            return false;
+        }
+
+        // Run the interpolator
+        result = interpolate(neighborsBF, frac);
+        if (dflag) {
+            cout << "Interpolated Field: " << result << endl;
+        }
+
+        // Reassign y sign
+        if (_flipy && sign == -1) {
+            result.setY(-result.y());
+        }
+        return true;
+    }
+
+    // Quadratic interpolation and its derivatives.  The interpolation of
+    // interpolate() is the tensor product of the 1D Lagrange polynomials, so
+    // its derivative along x is the same sum with the x weights replaced by
+    // their derivatives.
+    bool BFGridMap::interpolateQuadratic(const CLHEP::Hep3Vector& testpoint,
+                                         CLHEP::Hep3Vector& result,
+                                         CLHEP::Hep3Vector grad[3]) const {
+        result = CLHEP::Hep3Vector(0., 0., 0.);
+        for (int n = 0; n != 3; ++n) {
+            grad[n] = CLHEP::Hep3Vector(0., 0., 0.);
+        }
+
+        // Allow y-symmetry if grid is only defined for y > 0;
+        int sign(1);
+        CLHEP::Hep3Vector point(testpoint.x(), testpoint.y(), testpoint.z());
+        if (_flipy && testpoint.y() < 0) {
+            sign = -1;
+            double y = -testpoint.y();
+            point.setY(y);
+        }
+
+        CLHEP::Hep3Vector neighborsBF[3][3][3];
+        CLHEP::Hep3Vector frac;
+        if (!quadraticNeighbors(testpoint, point, neighborsBF, frac)) {
+            return false;
+        }
+
+        double wx[3], wy[3], wz[3], dwx[3], dwy[3], dwz[3];
+        gmcweights(frac.x(), wx, dwx);
+        gmcweights(frac.y(), wy, dwy);
+        gmcweights(frac.z(), wz, dwz);
+
+        // derivatives on the unit grid of the neighbors
+        CLHEP::Hep3Vector du, dv, dw;
+        for (int i = 0; i != 3; ++i) {
+            for (int j = 0; j != 3; ++j) {
+                for (int k = 0; k != 3; ++k) {
+                    const CLHEP::Hep3Vector& b = neighborsBF[i][j][k];
+                    result += (wx[i] * wy[j] * wz[k]) * b;
+                    du += (dwx[i] * wy[j] * wz[k]) * b;
+                    dv += (wx[i] * dwy[j] * wz[k]) * b;
+                    dw += (wx[i] * wy[j] * dwz[k]) * b;
+                }
+            }
+        }
+        grad[0] = du / _dx;
+        grad[1] = dv / _dy;
+        grad[2] = dw / _dz;
+
+        if (_flipy && sign == -1) {
+            flipYGradient(result, grad);
+        }
+        return true;
+    }
+
+    // Validity checks and neighbor lookup for the quadratic interpolation.
+    bool BFGridMap::quadraticNeighbors(const CLHEP::Hep3Vector& testpoint,
+                                       const CLHEP::Hep3Vector& point,
+                                       CLHEP::Hep3Vector neighborsBF[3][3][3],
+                                       CLHEP::Hep3Vector& frac) const {
+        static const bool dflag = false;
+
         // Check validity.  Return a zero field and optionally print a warning.
         if (!isValid(point)) {
             if (_warnIfOutside) {
@@ -335,7 +524,6 @@ namespace mu2e {
         }
 
         // Get the BField values of the nearest grid neighbors to the point
-        CLHEP::Hep3Vector neighborsBF[3][3][3];
         if (!getNeighbors(ix, iy, iz, neighborsBF)) {
             if (_warnIfOutside) {
                 mf::LogWarning("GEOM")
@@ -364,18 +552,8 @@ namespace mu2e {
             cout << "Used Point:      " << grid2point(xindex, yindex, zindex) << endl;
         }
 
-        CLHEP::Hep3Vector frac(cellFraction(point, GridPoint(xindex, yindex, zindex)));
+        frac = cellFraction(point, GridPoint(xindex, yindex, zindex));
 
-        // Run the interpolator
-        result = interpolate(neighborsBF, frac);
-        if (dflag) {
-            cout << "Interpolated Field: " << result << endl;
-        }
-
-        // Reassign y sign
-        if (_flipy && sign == -1) {
-            result.setY(-result.y());
-        }
         return true;
     }
 
@@ -42,6 +42,25 @@ namespace mu2e {
     }
 
 
+    // Get field and gradient at an arbitrary point, from the map that contains it.
+    bool BFieldManager::getBFieldWithGradient(const CLHEP::Hep3Vector& point,
+                                              CLHEP::Hep3Vector& result,
+                                              CLHEP::Hep3Vector grad[3]) const {
+        auto m = cm_.findMap(point);
+
+        if (m) {
+            m->getBFieldWithGradient(point, result, grad);
+        } else {
+            result = CLHEP::Hep3Vector(0., 0., 0.);
+            for (int i = 0; i != 3; ++i) {
+                grad[i] = CLHEP::Hep3Vector(0., 0., 0.);
+            }
+        }
+
+        return (m != 0);
+    }
+
+
     std::shared_ptr<BFGridMap> BFieldManager::addBFGridMap(MapContainerType* mapContainer,
                                                            const std::string& key,
                                                            int nx,
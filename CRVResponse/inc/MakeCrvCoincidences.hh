@@ -0,0 +1,80 @@
+#ifndef MakeCrvCoincidences_h
+#define MakeCrvCoincidences_h
+
+//Finds the coincidences of the CRV hits of one sector type and side (see CrvCoincidenceCheck).
+//The hits of each layer are sorted by time into flat arrays, and the combinations of hits
+//are only formed within the largest maxTimeDifference and the maxSlope of the layer pairs.
+//The results (including their order) are those of the loops over all hit combinations,
+//which are kept in FindNested for comparisons.
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+namespace mu2eCrv
+{
+
+class MakeCrvCoincidences
+{
+  public:
+  struct Hit
+  {
+    double _time;
+    int    _PEs;
+    int    _layer, _counter;
+    double _x, _y;
+    int    _PEthreshold;
+    double _adjacentPulseTimeDifference;
+    double _maxTimeDifference;
+    bool   _useFourLayers;
+  };
+
+  struct Coincidence
+  {
+    std::array<size_t,4> _hits;  //indices of the hits in the vector given to Find
+    int    _nHits;
+    double _timeMin, _timeMax;
+  };
+
+  MakeCrvCoincidences(double maxSlope, double maxSlopeDifference, bool acceptThreeAdjacentCounters);
+
+  //hits of one sector type and side in the order in which they were collected.
+  //coincidences of four layers come first, then those of three layers, then those of three adjacent counters.
+  void Find(const std::vector<Hit> &hits, std::vector<Coincidence> &coincidences);
+  void FindNested(const std::vector<Hit> &hits, std::vector<Coincidence> &coincidences);
+
+  private:
+  MakeCrvCoincidences();
+
+  struct TimeIndex
+  {
+    double _time;
+    size_t _index;  //index in the (filtered) hits of the layer
+    bool operator<(const TimeIndex &rhs) const {return _time<rhs._time;}
+  };
+
+  //keeps the hits which reach the PE threshold together with the other SiPM or an adjacent counter
+  void FilterHits(const std::vector<Hit> &hits, bool sweep);
+  //the range of the time sorted hits of a layer between tMin and tMax
+  std::pair<size_t,size_t> TimeRange(int layer, double tMin, double tMax) const;
+
+  bool CheckFour(const Hit *h[4], Coincidence &c) const;
+  bool CheckThree(const Hit *h[3], Coincidence &c) const;
+  bool CheckAdjacent(const Hit *h[3], Coincidence &c) const;
+
+  double _maxSlope;
+  double _maxSlopeDifference;
+  bool   _acceptThreeAdjacentCounters;
+
+  //work space, reused between calls
+  std::vector<size_t>    _filtered[4];      //indices of the hits above threshold in each layer, in hit order
+  std::vector<TimeIndex> _sorted[4];        //the same hits sorted by time
+  std::vector<double>    _minMaxTime[4][2]; //running minimum of maxTimeDifference in hit order
+                                            //(all hits, hits without useFourLayers)
+  std::vector<TimeIndex> _sortedAll[4];     //all hits of each layer sorted by time (for FilterHits)
+  std::vector<std::array<size_t,4> > _found;
+};
+
+}
+
+#endif
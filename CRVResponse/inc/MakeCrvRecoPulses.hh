@@ -12,7 +12,7 @@ class MakeCrvRecoPulses
   public:
   MakeCrvRecoPulses(double minADCdifference, double defaultBeta, double minBeta, double maxBeta,
                     double maxTimeDifference, double minPulseHeightRatio, double maxPulseHeightRatio,
-                    double LEtimeFactor);
+                    double LEtimeFactor, bool useTF1Fit=true);
   void         SetWaveform(const std::vector<unsigned int> &waveform, unsigned int startTDC, 
                            double digitizationPeriod, double pedestal, double calibrationFactor, 
                            double calibrationFactorPulseHeight);
@@ -35,6 +35,13 @@ class MakeCrvRecoPulses
   private:
   MakeCrvRecoPulses();
 
+  //least squares fit of the Gumbel pulse shape par[0]*exp(-(t-par[1])/par[2]-exp(-(t-par[1])/par[2]))
+  //to the waveform between startBin and endBin (the same chi2 as the TF1 fit),
+  //returns false if the fit did not converge
+  bool FitPulse(const std::vector<unsigned int> &waveform, int startBin, int endBin,
+                unsigned int startTDC, double digitizationPeriod, double pedestal,
+                double *par, double &chi2) const;
+
   TF1    _f;
   double _minADCdifference;
   double _defaultBeta;
@@ -42,6 +49,7 @@ class MakeCrvRecoPulses
   double _maxTimeDifference;
   double _minPulseHeightRatio, _maxPulseHeightRatio;
   double _LEtimeFactor;
+  bool   _useTF1Fit;
 
   std::vector<int>    _PEs, _PEsPulseHeight;
   std::vector<double> _pulseTimes, _pulseHeights, _pulseBetas, _pulseFitChi2s;
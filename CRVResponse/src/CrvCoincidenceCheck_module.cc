@@ -7,6 +7,7 @@
 #include "CosmicRayShieldGeom/inc/CosmicRayShield.hh"
 #include "DataProducts/inc/CRSScintillatorBarIndex.hh"
 #include "CRVResponse/inc/CrvHelper.hh"
+#include "CRVResponse/inc/MakeCrvCoincidences.hh"
 
 #include "ConditionsService/inc/AcceleratorParams.hh"
 #include "ConditionsService/inc/ConditionsHandle.hh"
@@ -58,6 +59,8 @@ namespace mu2e
     double      _timeWindowStart;
     double      _timeWindowEnd;
     double      _microBunchPeriod;
+    bool        _useNestedLoops;  //find the coincidences with the loops over all hit combinations instead of the time sorted sweep
+    mu2eCrv::MakeCrvCoincidences _makeCrvCoincidences;
 
     //the following variable are only used to print out results and summaries
     int         _totalEvents;
@@ -70,26 +73,16 @@ namespace mu2e
     double      _muonMinTime, _muonMaxTime;
     std::string _genParticleModuleLabel;
 
-    struct CrvHit
+    struct CrvHits
     {
-      art::Ptr<CrvRecoPulse>        _crvRecoPulse;
-      double                        _time;
-      int                           _PEs;
-      int                           _layer, _counter;
-      double                        _x, _y;
-      int                           _PEthreshold;
-      double                        _adjacentPulseTimeDifference;
-      double                        _maxTimeDifference;
-      bool                          _useFourLayers;
-      CrvHit(const art::Ptr<CrvRecoPulse> &crvRecoPulse, double time, int PEs, int layer, int counter, double x, double y,
-                                                          int PEthreshold, double adjacentPulseTimeDifference, double maxTimeDifference, bool useFourLayers):
-                                                          _crvRecoPulse(crvRecoPulse), _time(time), _PEs(PEs), _layer(layer), _counter(counter), _x(x), _y(y),
-                                                          _PEthreshold(PEthreshold), _adjacentPulseTimeDifference(adjacentPulseTimeDifference),
-                                                          _maxTimeDifference(maxTimeDifference), _useFourLayers(useFourLayers) {}
+      std::vector<art::Ptr<CrvRecoPulse> >        _crvRecoPulses;
+      std::vector<mu2eCrv::MakeCrvCoincidences::Hit> _hits;
       void Print(int sectorType) const
       {
-        std::cout<<"sectorType: "<<sectorType<<"   layer: "<<_layer<<"   counter: "<<_counter<<"  SiPM: "<<_crvRecoPulse->GetSiPMNumber()<<"      ";
-        std::cout<<"  PEs: "<<_PEs<<"   time: "<<_time<<"   x: "<<_x<<"   y: "<<_y<<"         "<<_crvRecoPulse->GetScintillatorBarIndex()<<std::endl;
+        const mu2eCrv::MakeCrvCoincidences::Hit &hit=_hits.back();
+        const art::Ptr<CrvRecoPulse> &crvRecoPulse=_crvRecoPulses.back();
+        std::cout<<"sectorType: "<<sectorType<<"   layer: "<<hit._layer<<"   counter: "<<hit._counter<<"  SiPM: "<<crvRecoPulse->GetSiPMNumber()<<"      ";
+        std::cout<<"  PEs: "<<hit._PEs<<"   time: "<<hit._time<<"   x: "<<hit._x<<"   y: "<<hit._y<<"         "<<crvRecoPulse->GetScintillatorBarIndex()<<std::endl;
       }
     };
 
@@ -125,6 +118,8 @@ namespace mu2e
     _acceptThreeAdjacentCounters(pset.get<bool>("acceptThreeAdjacentCounters")),
     _timeWindowStart(pset.get<double>("timeWindowStart")),
     _timeWindowEnd(pset.get<double>("timeWindowEnd")),
+    _useNestedLoops(pset.get<bool>("useNestedLoops",false)),
+    _makeCrvCoincidences(_maxSlope, _maxSlopeDifference, _acceptThreeAdjacentCounters),
     _muonsOnly(pset.get<bool>("muonsOnly",false))
   {
     produces<CrvCoincidenceCollection>();
@@ -203,7 +198,7 @@ namespace mu2e
     event.getByLabel(_crvRecoPulsesModuleLabel,"",crvRecoPulseCollection);
 
     //collect crvHits
-    std::map<int, std::vector<CrvHit> > crvHits;    //hits are separated by sector type (like CRV-T, CRV-R, ...)
+    std::map<int, CrvHits> crvHits;                 //hits are separated by sector type (like CRV-T, CRV-R, ...)
                                                     //the key is -sector type for sipms at side 0
                                                     //the key is +sector type for sipms at side 1
                                                     //(sector types start at 1)
@@ -257,224 +252,48 @@ namespace mu2e
       if(crvRecoPulse->GetPulseTime()>=_timeWindowStart && crvRecoPulse->GetPulseTime()<=_timeWindowEnd)
       {
         //get the right set of hits based on the hitmap key, and insert a new hit
-        crvHits[sectorType].emplace_back(crvRecoPulse, time, PEs, layerNumber, counterNumber, x,y,
-                                         sector.PEthreshold, sector.adjacentPulseTimeDifference, sector.maxTimeDifference, sector.useFourLayers);
-        if(_verboseLevel==4) crvHits[sectorType].back().Print(sectorType);
+        CrvHits &hits=crvHits[sectorType];
+        hits._crvRecoPulses.push_back(crvRecoPulse);
+        hits._hits.push_back(mu2eCrv::MakeCrvCoincidences::Hit{time, PEs, layerNumber, counterNumber, x, y,
+                                                                sector.PEthreshold, sector.adjacentPulseTimeDifference,
+                                                                sector.maxTimeDifference, sector.useFourLayers});
+        if(_verboseLevel==4) hits.Print(sectorType);
       }//loop over SiPM
     }//loop over reco pulse collection
 
 
     //find coincidences for each sector type and side (=hitmap key)
-    std::map<int,std::vector<CrvHit> >::const_iterator iterHitMap;
+    bool   haveGenTime=false;
+    double genTime=0;
+    std::vector<mu2eCrv::MakeCrvCoincidences::Coincidence> coincidences;
+    std::map<int,CrvHits>::const_iterator iterHitMap;
     for(iterHitMap = crvHits.begin(); iterHitMap!=crvHits.end(); iterHitMap++)
     {
       //this is the collection for which a coincidence needs to be found
-      const std::vector<CrvHit> &crvHitsOfSectorType = iterHitMap->second;
+      const CrvHits &crvHitsOfSectorType = iterHitMap->second;
+      int sectorType=iterHitMap->first;
 
-      //remove hits below the threshold
-      std::vector< std::vector<CrvHit> > crvHitsFiltered;  //separated by layers
-      crvHitsFiltered.resize(4); //for 4 layers
-      std::vector<CrvHit>::const_iterator iterHit;
-      for(iterHit=crvHitsOfSectorType.begin(); iterHit!=crvHitsOfSectorType.end(); iterHit++)
-      {
-        int layer=iterHit->_layer;
-        int counter=iterHit->_counter;
-        int PEs=iterHit->_PEs;
-        int time=iterHit->_time;
-
-        int    PEthreshold=iterHit->_PEthreshold;
-        double adjacentPulseTimeDifference=iterHit->_adjacentPulseTimeDifference;
-
-        //check other SiPM and the SiPMs at the adjacent counters
-        int PEs_thisCounter=PEs;
-        int PEs_adjacentCounter1=0;
-        int PEs_adjacentCounter2=0;
-        std::vector<CrvHit>::const_iterator iterHitAdjacent;
-        for(iterHitAdjacent=crvHitsOfSectorType.begin(); iterHitAdjacent!=crvHitsOfSectorType.end(); iterHitAdjacent++)
-        {
-          if(std::distance(iterHitAdjacent,iterHit)==0) continue;  //don't compare with itself
-          if(iterHitAdjacent->_layer!=layer) continue;             //compare hits of the same layer only
-          if(fabs(iterHitAdjacent->_time-time)>adjacentPulseTimeDifference) continue; //compare hits within a certain time window only
-
-          int counterDiff=iterHitAdjacent->_counter-counter;
-          if(counterDiff==0) PEs_thisCounter+=iterHitAdjacent->_PEs;   //add PEs from the same counter (i.e. the "other" SiPM),
-                                                                       //if the "other" hit is within a certain time window (5ns)
-          if(counterDiff==-1) PEs_adjacentCounter1+=iterHitAdjacent->_PEs;  //add PEs from an adjacent counter,
-                                                                            //if these hits are within a certain time window (5ns)
-          if(counterDiff==1) PEs_adjacentCounter2+=iterHitAdjacent->_PEs;   //add PEs from an adjacent counter,
-                                                                            //if these hits are within a certain time window (5ns)
-        }
-        //check, if the number of PEs of the adjacent counter added to the current hit's PE number
-        //brings this hit above the threshold, add this hit to vector of hits
-        if(PEs_thisCounter+PEs_adjacentCounter1>=PEthreshold) crvHitsFiltered[layer].push_back(*iterHit);
-        else {if(PEs_thisCounter+PEs_adjacentCounter2>=PEthreshold) crvHitsFiltered[layer].push_back(*iterHit);}
-      }
+      if(_useNestedLoops) _makeCrvCoincidences.FindNested(crvHitsOfSectorType._hits, coincidences);
+      else _makeCrvCoincidences.Find(crvHitsOfSectorType._hits, coincidences);
 
+      for(const mu2eCrv::MakeCrvCoincidences::Coincidence &coincidence : coincidences)
       {
-      //find coincidences using 4 hits in 4 layers
-        const std::vector<CrvHit> &layer0Hits=crvHitsFiltered[0];
-        const std::vector<CrvHit> &layer1Hits=crvHitsFiltered[1];
-        const std::vector<CrvHit> &layer2Hits=crvHitsFiltered[2];
-        const std::vector<CrvHit> &layer3Hits=crvHitsFiltered[3];
-        std::vector<CrvHit>::const_iterator layer0Iter;
-        std::vector<CrvHit>::const_iterator layer1Iter;
-        std::vector<CrvHit>::const_iterator layer2Iter;
-        std::vector<CrvHit>::const_iterator layer3Iter;
-
-        for(layer0Iter=layer0Hits.begin(); layer0Iter!=layer0Hits.end(); layer0Iter++)
-        for(layer1Iter=layer1Hits.begin(); layer1Iter!=layer1Hits.end(); layer1Iter++)
-        for(layer2Iter=layer2Hits.begin(); layer2Iter!=layer2Hits.end(); layer2Iter++)
-        for(layer3Iter=layer3Hits.begin(); layer3Iter!=layer3Hits.end(); layer3Iter++)
+        if(_muonsOnly)   //used for efficiency checks with overlayed background: accept coincidence only, if it happens within e.g. 20ns and 120ns
         {
-          double maxTimeDifferences[4]={layer0Iter->_maxTimeDifference,layer1Iter->_maxTimeDifference,layer2Iter->_maxTimeDifference,layer3Iter->_maxTimeDifference};
-          double maxTimeDifference=*std::max_element(maxTimeDifferences,maxTimeDifferences+4);
-
-          double times[4]={layer0Iter->_time,layer1Iter->_time,layer2Iter->_time,layer3Iter->_time};
-          double timeMin = *std::min_element(times,times+4);
-          double timeMax = *std::max_element(times,times+4);
-          if(timeMax-timeMin>maxTimeDifference) continue;  //hits don't fall within the time window
-
-          double x[4]={layer0Iter->_x,layer1Iter->_x,layer2Iter->_x,layer3Iter->_x};
-          double y[4]={layer0Iter->_y,layer1Iter->_y,layer2Iter->_y,layer3Iter->_y};
-
-          bool coincidenceFound=true;
-          double slope[3];
-          for(int d=0; d<3; d++)
-          {
-            slope[d]=(x[d+1]-x[d])/(y[d+1]-y[d]);
-            if(fabs(slope[d])>_maxSlope) coincidenceFound=false;   //not more than maxSlope allowed for coincidence;
-          }
-
-          if(fabs(slope[0]-slope[1])>_maxSlopeDifference) coincidenceFound=false;   //slope must not change more than 2mm over 1mm (which is a little bit more than 1 counter per layer)
-          if(fabs(slope[0]-slope[2])>_maxSlopeDifference) coincidenceFound=false;   //slope must not change more than 2mm over 1mm (which is a little bit more than 1 counter per layer)
-          if(fabs(slope[1]-slope[2])>_maxSlopeDifference) coincidenceFound=false;   //slope must not change more than 2mm over 1mm (which is a little bit more than 1 counter per layer)
-
-          if(_muonsOnly)   //used for efficiency checks with overlayed background: accept coincidence only, if it happens within e.g. 20ns and 120ns
+          if(!haveGenTime)
           {
             art::Handle<GenParticleCollection> genParticleCollection;
             event.getByLabel(_genParticleModuleLabel,"",genParticleCollection);
-            double genTime = genParticleCollection->at(0).time();
-            if(timeMax>genTime+_muonMaxTime || timeMin<genTime+_muonMinTime) coincidenceFound=false;
-          }
-
-          if(coincidenceFound)
-          {
-            std::vector<art::Ptr<CrvRecoPulse> > crvRecoPulses{layer0Iter->_crvRecoPulse,layer1Iter->_crvRecoPulse,layer2Iter->_crvRecoPulse,layer3Iter->_crvRecoPulse};
-            int sectorType=iterHitMap->first;
-            crvCoincidenceCollection->emplace_back(crvRecoPulses, sectorType);
+            genTime = genParticleCollection->at(0).time();
+            haveGenTime=true;
           }
+          if(coincidence._timeMax>genTime+_muonMaxTime || coincidence._timeMin<genTime+_muonMinTime) continue;
         }
-      } // four layer coincidences
-
-      //find coincidences using 3 hits in 3 layers (ignored, if all three hits have a useFourLayers flag)
-      for(int layer1=0; layer1<4; layer1++)
-      for(int layer2=layer1+1; layer2<4; layer2++)
-      for(int layer3=layer2+1; layer3<4; layer3++)
-      {
-
-        const std::vector<CrvHit> &layer1Hits=crvHitsFiltered[layer1];
-        const std::vector<CrvHit> &layer2Hits=crvHitsFiltered[layer2];
-        const std::vector<CrvHit> &layer3Hits=crvHitsFiltered[layer3];
-        std::vector<CrvHit>::const_iterator layer1Iter;
-        std::vector<CrvHit>::const_iterator layer2Iter;
-        std::vector<CrvHit>::const_iterator layer3Iter;
-
-        for(layer1Iter=layer1Hits.begin(); layer1Iter!=layer1Hits.end(); layer1Iter++)
-        for(layer2Iter=layer2Hits.begin(); layer2Iter!=layer2Hits.end(); layer2Iter++)
-        for(layer3Iter=layer3Hits.begin(); layer3Iter!=layer3Hits.end(); layer3Iter++)
-        {
-          if(layer1Iter->_useFourLayers && layer2Iter->_useFourLayers && layer3Iter->_useFourLayers) continue; //all hits require a four layer coincidence
-
-          double maxTimeDifferences[3]={layer1Iter->_maxTimeDifference,layer2Iter->_maxTimeDifference,layer3Iter->_maxTimeDifference};
-          double maxTimeDifference=*std::max_element(maxTimeDifferences,maxTimeDifferences+3);
-
-          if(fabs(layer1Iter->_time-layer2Iter->_time)>maxTimeDifference) break;  //no need to check any triplets containing the current pair of layer1 and layer2
-
-          double times[3]={layer1Iter->_time,layer2Iter->_time,layer3Iter->_time};
-          double timeMin = *std::min_element(times,times+3);
-          double timeMax = *std::max_element(times,times+3);
-          if(timeMax-timeMin>maxTimeDifference) continue;  //hits don't fall within the time window
-
-          double x[3]={layer1Iter->_x,layer2Iter->_x,layer3Iter->_x};
-          double y[3]={layer1Iter->_y,layer2Iter->_y,layer3Iter->_y};
-
-          bool coincidenceFound=true;
-          double slope[2];
-          for(int d=0; d<2; d++)
-          {
-            slope[d]=(x[d+1]-x[d])/(y[d+1]-y[d]);
-            if(fabs(slope[d])>_maxSlope) coincidenceFound=false;   //not more than maxSlope allowed for coincidence;
-          }
-
-          if(fabs(slope[0])>_maxSlope) break;  //no need to check any triplets containing the current pair of layer1 and layer2
-
-          if(fabs(slope[0]-slope[1])>_maxSlopeDifference) coincidenceFound=false;   //slope must not change more than 2mm over 1mm (which is a little bit more than 1 counter per layer)
-
-          if(_muonsOnly)   //used for efficiency checks with overlayed background: accept coincidence only, if it happens within e.g. 20ns and 120ns
-          {
-            art::Handle<GenParticleCollection> genParticleCollection;
-            event.getByLabel(_genParticleModuleLabel,"",genParticleCollection);
-            double genTime = genParticleCollection->at(0).time();
-            if(timeMax>genTime+_muonMaxTime || timeMin<genTime+_muonMinTime) coincidenceFound=false;
-          }
-
-          if(coincidenceFound)
-          {
-            std::vector<art::Ptr<CrvRecoPulse> > crvRecoPulses{layer1Iter->_crvRecoPulse,layer2Iter->_crvRecoPulse,layer3Iter->_crvRecoPulse};
-            int sectorType=iterHitMap->first;
-            crvCoincidenceCollection->emplace_back(crvRecoPulses, sectorType);
-          }
-        }
-      }  //three layer coincidences
-
-
-      //find coincidences using 3 hits in adjacent counters in one layer
-      if(_acceptThreeAdjacentCounters)
-      {
-        for(int layer=0; layer<4; layer++)
-        {
-          const std::vector<CrvHit> &layerHits=crvHitsFiltered[layer];
-          if(layerHits.size()<3) continue; //less than three hits in this layer
-
-          std::vector<CrvHit>::const_iterator i1;
-          std::vector<CrvHit>::const_iterator i2;
-          std::vector<CrvHit>::const_iterator i3;
-          for(i1=layerHits.begin(); i1!=layerHits.end(); i1++)
-          for(i2=i1+1; i2!=layerHits.end(); i2++)
-          for(i3=i2+1; i3!=layerHits.end(); i3++)
-          {
-            double times[3]={i1->_time,i2->_time,i3->_time};
-            double timeMin = *std::min_element(times,times+3);
-            double timeMax = *std::max_element(times,times+3);
-
-            double maxTimeDifferences[3]={i1->_maxTimeDifference,i2->_maxTimeDifference,i3->_maxTimeDifference};
-            double maxTimeDifference=*std::max_element(maxTimeDifferences,maxTimeDifferences+3);
-
-            if(timeMax-timeMin>maxTimeDifference) continue;  //hits don't fall within the time window
-
-            std::set<int> counters{i1->_counter,i2->_counter,i3->_counter};
-            bool coincidenceFound=true;
-            if(counters.size()<3) coincidenceFound=false;
-            if(*counters.rbegin()-*counters.begin()!=2) coincidenceFound=false;
-
-            if(_muonsOnly)   //used for efficiency checks with overlayed background: accept coincidence only, if it happens within e.g. 20ns and 120ns
-            {
-              art::Handle<GenParticleCollection> genParticleCollection;
-              event.getByLabel(_genParticleModuleLabel,"",genParticleCollection);
-              double genTime = genParticleCollection->at(0).time();
-              if(timeMax>genTime+_muonMaxTime || timeMin<genTime+_muonMinTime) coincidenceFound=false;
-            }
-
-            if(coincidenceFound)
-            {
-              std::vector<art::Ptr<CrvRecoPulse> > crvRecoPulses{i1->_crvRecoPulse,i2->_crvRecoPulse,i3->_crvRecoPulse};
-              int sectorType=iterHitMap->first;
-              crvCoincidenceCollection->emplace_back(crvRecoPulses, sectorType);
-            }
-          }
-        }
-      } //accept three adjacent counters
 
+        std::vector<art::Ptr<CrvRecoPulse> > crvRecoPulses;
+        for(int i=0; i<coincidence._nHits; i++) crvRecoPulses.push_back(crvHitsOfSectorType._crvRecoPulses[coincidence._hits[i]]);
+        crvCoincidenceCollection->emplace_back(crvRecoPulses, sectorType);
+      }
     }
 
     _totalEvents++;
@@ -57,6 +57,7 @@ namespace mu2e
       fhicl::Atom<double> maxPulseHeightRatio{Name("maxPulseHeightRatio"), Comment("largest accepted ratio between largest ADC value and fitted peak")}; //1.5
       fhicl::Atom<double> LEtimeFactor{Name("LEtimeFactor"), Comment("time of leading edge is peakTime-LEtimeFactor*beta (0.985,1.385,1.587 for a leading edge of 0.5,0.2,0.1 pulse height")};
       fhicl::Atom<int> minPEs{Name("minPEs"), Comment("minimum number of PEs")}; //0
+      fhicl::Atom<bool> useTF1Fit{Name("useTF1Fit"), Comment("fit the pulses with a ROOT TF1 instead of the analytic fit"), true};
     };
 
     typedef art::EDProducer::Table<Config> Parameters;
@@ -93,7 +94,8 @@ namespace mu2e
                                                                                                     conf().maxTimeDifference(),
                                                                                                     conf().minPulseHeightRatio(),
                                                                                                     conf().maxPulseHeightRatio(),
-                                                                                                    conf().LEtimeFactor()));
+                                                                                                    conf().LEtimeFactor(),
+                                                                                                    conf().useTF1Fit()));
   }
 
   void CrvRecoPulsesFinder::beginJob()
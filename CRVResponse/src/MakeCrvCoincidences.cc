@@ -0,0 +1,365 @@
+#include "CRVResponse/inc/MakeCrvCoincidences.hh"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <set>
+
+namespace
+{
+  //the time windows of the sweeps are wider by this amount [ns], so that they can't miss a combination
+  //due to rounding errors. the exact cuts are applied to each combination found by the sweeps.
+  const double timeSlack = 1e-6;
+}
+
+namespace mu2eCrv
+{
+
+MakeCrvCoincidences::MakeCrvCoincidences(double maxSlope, double maxSlopeDifference, bool acceptThreeAdjacentCounters) :
+                                         _maxSlope(maxSlope), _maxSlopeDifference(maxSlopeDifference),
+                                         _acceptThreeAdjacentCounters(acceptThreeAdjacentCounters)
+{}
+
+void MakeCrvCoincidences::FilterHits(const std::vector<Hit> &hits, bool sweep)
+{
+  for(int layer=0; layer<4; layer++)
+  {
+    _filtered[layer].clear();
+    _sortedAll[layer].clear();
+  }
+  if(sweep)
+  {
+    for(size_t i=0; i<hits.size(); i++) _sortedAll[hits[i]._layer].push_back(TimeIndex{hits[i]._time,i});
+    for(int layer=0; layer<4; layer++) std::sort(_sortedAll[layer].begin(),_sortedAll[layer].end());
+  }
+
+  for(size_t i=0; i<hits.size(); i++)
+  {
+    const Hit &hit=hits[i];
+    int layer=hit._layer;
+    int counter=hit._counter;
+    int time=hit._time;  //the time is compared as an integer, as it has always been done
+
+    //check other SiPM and the SiPMs at the adjacent counters
+    int PEs_thisCounter=hit._PEs;
+    int PEs_adjacentCounter1=0;
+    int PEs_adjacentCounter2=0;
+    auto addAdjacent = [&](size_t j)
+    {
+      const Hit &other=hits[j];
+      if(j==i) return;  //don't compare with itself
+      if(other._layer!=layer) return;  //compare hits of the same layer only
+      if(fabs(other._time-time)>hit._adjacentPulseTimeDifference) return; //compare hits within a certain time window only
+
+      int counterDiff=other._counter-counter;
+      if(counterDiff==0) PEs_thisCounter+=other._PEs;       //the "other" SiPM of the same counter
+      if(counterDiff==-1) PEs_adjacentCounter1+=other._PEs; //adjacent counters
+      if(counterDiff==1) PEs_adjacentCounter2+=other._PEs;
+    };
+    if(sweep)
+    {
+      const std::vector<TimeIndex> &sorted=_sortedAll[layer];
+      double tMin=time-hit._adjacentPulseTimeDifference-timeSlack;
+      double tMax=time+hit._adjacentPulseTimeDifference+timeSlack;
+      auto j=std::lower_bound(sorted.begin(),sorted.end(),TimeIndex{tMin,0});
+      for(; j!=sorted.end() && j->_time<=tMax; j++) addAdjacent(j->_index);
+    }
+    else
+    {
+      for(size_t j=0; j<hits.size(); j++) addAdjacent(j);
+    }
+
+    //check, if the number of PEs of the adjacent counter added to the current hit's PE number
+    //brings this hit above the threshold
+    if(PEs_thisCounter+PEs_adjacentCounter1>=hit._PEthreshold) _filtered[layer].push_back(i);
+    else {if(PEs_thisCounter+PEs_adjacentCounter2>=hit._PEthreshold) _filtered[layer].push_back(i);}
+  }
+}
+
+std::pair<size_t,size_t> MakeCrvCoincidences::TimeRange(int layer, double tMin, double tMax) const
+{
+  const std::vector<TimeIndex> &sorted=_sorted[layer];
+  size_t first=std::lower_bound(sorted.begin(),sorted.end(),TimeIndex{tMin,0})-sorted.begin();
+  size_t last=std::upper_bound(sorted.begin(),sorted.end(),TimeIndex{tMax,0})-sorted.begin();
+  return std::make_pair(first,last);
+}
+
+bool MakeCrvCoincidences::CheckFour(const Hit *h[4], Coincidence &c) const
+{
+  double maxTimeDifference=std::max({h[0]->_maxTimeDifference,h[1]->_maxTimeDifference,h[2]->_maxTimeDifference,h[3]->_maxTimeDifference});
+  double times[4]={h[0]->_time,h[1]->_time,h[2]->_time,h[3]->_time};
+  c._timeMin=*std::min_element(times,times+4);
+  c._timeMax=*std::max_element(times,times+4);
+  if(c._timeMax-c._timeMin>maxTimeDifference) return false;  //hits don't fall within the time window
+
+  bool coincidenceFound=true;
+  double slope[3];
+  for(int d=0; d<3; d++)
+  {
+    slope[d]=(h[d+1]->_x-h[d]->_x)/(h[d+1]->_y-h[d]->_y);
+    if(fabs(slope[d])>_maxSlope) coincidenceFound=false;   //not more than maxSlope allowed for coincidence;
+  }
+  if(fabs(slope[0]-slope[1])>_maxSlopeDifference) coincidenceFound=false;
+  if(fabs(slope[0]-slope[2])>_maxSlopeDifference) coincidenceFound=false;
+  if(fabs(slope[1]-slope[2])>_maxSlopeDifference) coincidenceFound=false;
+  return coincidenceFound;
+}
+
+bool MakeCrvCoincidences::CheckThree(const Hit *h[3], Coincidence &c) const
+{
+  double maxTimeDifference=std::max({h[0]->_maxTimeDifference,h[1]->_maxTimeDifference,h[2]->_maxTimeDifference});
+  double times[3]={h[0]->_time,h[1]->_time,h[2]->_time};
+  c._timeMin=*std::min_element(times,times+3);
+  c._timeMax=*std::max_element(times,times+3);
+  if(c._timeMax-c._timeMin>maxTimeDifference) return false;  //hits don't fall within the time window
+
+  bool coincidenceFound=true;
+  double slope[2];
+  for(int d=0; d<2; d++)
+  {
+    slope[d]=(h[d+1]->_x-h[d]->_x)/(h[d+1]->_y-h[d]->_y);
+    if(fabs(slope[d])>_maxSlope) coincidenceFound=false;   //not more than maxSlope allowed for coincidence;
+  }
+  if(fabs(slope[0]-slope[1])>_maxSlopeDifference) coincidenceFound=false;
+  return coincidenceFound;
+}
+
+bool MakeCrvCoincidences::CheckAdjacent(const Hit *h[3], Coincidence &c) const
+{
+  double times[3]={h[0]->_time,h[1]->_time,h[2]->_time};
+  c._timeMin=*std::min_element(times,times+3);
+  c._timeMax=*std::max_element(times,times+3);
+  double maxTimeDifference=std::max({h[0]->_maxTimeDifference,h[1]->_maxTimeDifference,h[2]->_maxTimeDifference});
+  if(c._timeMax-c._timeMin>maxTimeDifference) return false;  //hits don't fall within the time window
+
+  std::set<int> counters{h[0]->_counter,h[1]->_counter,h[2]->_counter};
+  if(counters.size()<3) return false;
+  if(*counters.rbegin()-*counters.begin()!=2) return false;
+  return true;
+}
+
+void MakeCrvCoincidences::Find(const std::vector<Hit> &hits, std::vector<Coincidence> &coincidences)
+{
+  coincidences.clear();
+  FilterHits(hits, true);
+
+  //no combination of hits can be further apart in time than the largest maxTimeDifference
+  double maxTime=0;
+  for(int layer=0; layer<4; layer++)
+  {
+    _sorted[layer].clear();
+    for(int k=0; k<2; k++) _minMaxTime[layer][k].clear();
+    double minMaxTime[2]={std::numeric_limits<double>::infinity(),std::numeric_limits<double>::infinity()};
+    for(size_t k=0; k<_filtered[layer].size(); k++)
+    {
+      const Hit &hit=hits[_filtered[layer][k]];
+      _sorted[layer].push_back(TimeIndex{hit._time,k});
+      maxTime=std::max(maxTime,hit._maxTimeDifference);
+      minMaxTime[0]=std::min(minMaxTime[0],hit._maxTimeDifference);
+      if(!hit._useFourLayers) minMaxTime[1]=std::min(minMaxTime[1],hit._maxTimeDifference);
+      for(int i=0; i<2; i++) _minMaxTime[layer][i].push_back(minMaxTime[i]);
+    }
+    std::sort(_sorted[layer].begin(),_sorted[layer].end());
+  }
+  double window=maxTime+timeSlack;
+
+  auto hitAt = [&](int layer, size_t k) -> const Hit& {return hits[_filtered[layer][k]];};
+  auto slopeOK = [&](const Hit &a, const Hit &b) {return !(fabs((b._x-a._x)/(b._y-a._y))>_maxSlope);};
+  //stores the found combinations in the order of the loops over all hits
+  auto store = [&](const std::array<int,4> &layers, int nHits, bool adjacent)
+  {
+    std::sort(_found.begin(),_found.end());
+    for(const std::array<size_t,4> &found : _found)
+    {
+      Coincidence c;
+      const Hit *h[4];
+      for(int i=0; i<nHits; i++)
+      {
+        c._hits[i]=_filtered[layers[i]][found[i]];
+        h[i]=&hits[c._hits[i]];
+      }
+      c._nHits=nHits;
+      if(nHits==4) CheckFour(h,c);
+      else if(adjacent) CheckAdjacent(h,c);
+      else CheckThree(h,c);
+      coincidences.push_back(c);
+    }
+    _found.clear();
+  };
+
+  //find coincidences using 4 hits in 4 layers
+  _found.clear();
+  for(size_t k0=0; k0<_filtered[0].size(); k0++)
+  {
+    const Hit &h0=hitAt(0,k0);
+    auto range1=TimeRange(1,h0._time-window,h0._time+window);
+    for(size_t i1=range1.first; i1<range1.second; i1++)
+    {
+      size_t k1=_sorted[1][i1]._index;
+      const Hit &h1=hitAt(1,k1);
+      if(!slopeOK(h0,h1)) continue;
+      double tMin=std::max(h0._time,h1._time)-window;
+      double tMax=std::min(h0._time,h1._time)+window;
+      auto range2=TimeRange(2,tMin,tMax);
+      for(size_t i2=range2.first; i2<range2.second; i2++)
+      {
+        size_t k2=_sorted[2][i2]._index;
+        const Hit &h2=hitAt(2,k2);
+        if(!slopeOK(h1,h2)) continue;
+        auto range3=TimeRange(3,std::max(tMin,h2._time-window),std::min(tMax,h2._time+window));
+        for(size_t i3=range3.first; i3<range3.second; i3++)
+        {
+          size_t k3=_sorted[3][i3]._index;
+          const Hit &h3=hitAt(3,k3);
+          if(!slopeOK(h2,h3)) continue;
+          const Hit *h[4]={&h0,&h1,&h2,&h3};
+          Coincidence c;
+          if(CheckFour(h,c)) _found.push_back({k0,k1,k2,k3});
+        }
+      }
+    }
+  }
+  store({0,1,2,3},4,false);
+
+  //find coincidences using 3 hits in 3 layers (ignored, if all three hits have a useFourLayers flag).
+  //the loops over all hits stop looking at the hits of the third layer for a pair of hits of the first two layers,
+  //if these are further apart in time than the maxTimeDifference of the next hit of the third layer.
+  //this is reproduced with the running minimum of the maxTimeDifferences of the third layer.
+  for(int layer1=0; layer1<4; layer1++)
+  for(int layer2=layer1+1; layer2<4; layer2++)
+  for(int layer3=layer2+1; layer3<4; layer3++)
+  {
+    for(size_t k1=0; k1<_filtered[layer1].size(); k1++)
+    {
+      const Hit &h1=hitAt(layer1,k1);
+      auto range2=TimeRange(layer2,h1._time-window,h1._time+window);
+      for(size_t i2=range2.first; i2<range2.second; i2++)
+      {
+        size_t k2=_sorted[layer2][i2]._index;
+        const Hit &h2=hitAt(layer2,k2);
+        if(!slopeOK(h1,h2)) continue;
+        bool skipFourLayerHits=h1._useFourLayers && h2._useFourLayers;
+        size_t kEnd=_filtered[layer3].size();
+        double timeDifference=fabs(h1._time-h2._time);
+        if(timeDifference>std::max(h1._maxTimeDifference,h2._maxTimeDifference))
+        {
+          const std::vector<double> &minMaxTime=_minMaxTime[layer3][skipFourLayerHits?1:0];
+          kEnd=std::partition_point(minMaxTime.begin(),minMaxTime.end(),
+                                    [timeDifference](double m){return !(m<timeDifference);})-minMaxTime.begin();
+        }
+        auto range3=TimeRange(layer3,std::max(h1._time,h2._time)-window,std::min(h1._time,h2._time)+window);
+        for(size_t i3=range3.first; i3<range3.second; i3++)
+        {
+          size_t k3=_sorted[layer3][i3]._index;
+          if(k3>=kEnd) continue;
+          const Hit &h3=hitAt(layer3,k3);
+          if(skipFourLayerHits && h3._useFourLayers) continue;
+          const Hit *h[3]={&h1,&h2,&h3};
+          Coincidence c;
+          if(CheckThree(h,c)) _found.push_back({k1,k2,k3,0});
+        }
+      }
+    }
+    store({layer1,layer2,layer3,0},3,false);
+  }
+
+  //find coincidences using 3 hits in adjacent counters in one layer
+  if(_acceptThreeAdjacentCounters)
+  {
+    for(int layer=0; layer<4; layer++)
+    {
+      const std::vector<TimeIndex> &sorted=_sorted[layer];
+      for(size_t i1=0; i1<sorted.size(); i1++)
+      {
+        double tMax=sorted[i1]._time+window;
+        for(size_t i2=i1+1; i2<sorted.size() && sorted[i2]._time<=tMax; i2++)
+        for(size_t i3=i2+1; i3<sorted.size() && sorted[i3]._time<=tMax; i3++)
+        {
+          std::array<size_t,4> k={sorted[i1]._index,sorted[i2]._index,sorted[i3]._index,0};
+          std::sort(k.begin(),k.begin()+3);
+          const Hit *h[3]={&hitAt(layer,k[0]),&hitAt(layer,k[1]),&hitAt(layer,k[2])};
+          Coincidence c;
+          if(CheckAdjacent(h,c)) _found.push_back(k);
+        }
+      }
+      store({layer,layer,layer,0},3,true);
+    }
+  }
+}
+
+void MakeCrvCoincidences::FindNested(const std::vector<Hit> &hits, std::vector<Coincidence> &coincidences)
+{
+  coincidences.clear();
+  FilterHits(hits, false);
+
+  //find coincidences using 4 hits in 4 layers
+  for(size_t i0 : _filtered[0])
+  for(size_t i1 : _filtered[1])
+  for(size_t i2 : _filtered[2])
+  for(size_t i3 : _filtered[3])
+  {
+    const Hit *h[4]={&hits[i0],&hits[i1],&hits[i2],&hits[i3]};
+    Coincidence c;
+    if(CheckFour(h,c))
+    {
+      c._hits={i0,i1,i2,i3};
+      c._nHits=4;
+      coincidences.push_back(c);
+    }
+  }
+
+  //find coincidences using 3 hits in 3 layers (ignored, if all three hits have a useFourLayers flag)
+  for(int layer1=0; layer1<4; layer1++)
+  for(int layer2=layer1+1; layer2<4; layer2++)
+  for(int layer3=layer2+1; layer3<4; layer3++)
+  {
+    for(size_t i1 : _filtered[layer1])
+    for(size_t i2 : _filtered[layer2])
+    for(size_t i3 : _filtered[layer3])
+    {
+      const Hit *h[3]={&hits[i1],&hits[i2],&hits[i3]};
+      if(h[0]->_useFourLayers && h[1]->_useFourLayers && h[2]->_useFourLayers) continue; //all hits require a four layer coincidence
+
+      double maxTimeDifference=std::max({h[0]->_maxTimeDifference,h[1]->_maxTimeDifference,h[2]->_maxTimeDifference});
+      if(fabs(h[0]->_time-h[1]->_time)>maxTimeDifference) break;  //no need to check any triplets containing the current pair of layer1 and layer2
+
+      Coincidence c;
+      bool coincidenceFound=CheckThree(h,c);
+      if(c._timeMax-c._timeMin>maxTimeDifference) continue;  //hits don't fall within the time window
+
+      if(fabs((h[1]->_x-h[0]->_x)/(h[1]->_y-h[0]->_y))>_maxSlope) break;  //no need to check any triplets containing the current pair of layer1 and layer2
+
+      if(coincidenceFound)
+      {
+        c._hits={i1,i2,i3,0};
+        c._nHits=3;
+        coincidences.push_back(c);
+      }
+    }
+  }
+
+  //find coincidences using 3 hits in adjacent counters in one layer
+  if(_acceptThreeAdjacentCounters)
+  {
+    for(int layer=0; layer<4; layer++)
+    {
+      const std::vector<size_t> &layerHits=_filtered[layer];
+      if(layerHits.size()<3) continue; //less than three hits in this layer
+
+      for(size_t j1=0; j1<layerHits.size(); j1++)
+      for(size_t j2=j1+1; j2<layerHits.size(); j2++)
+      for(size_t j3=j2+1; j3<layerHits.size(); j3++)
+      {
+        const Hit *h[3]={&hits[layerHits[j1]],&hits[layerHits[j2]],&hits[layerHits[j3]]};
+        Coincidence c;
+        if(CheckAdjacent(h,c))
+        {
+          c._hits={layerHits[j1],layerHits[j2],layerHits[j3],0};
+          c._nHits=3;
+          coincidences.push_back(c);
+        }
+      }
+    }
+  }
+}
+
+}
@@ -3,6 +3,9 @@
 #include <TFitResultPtr.h>
 #include <TGraph.h>
 #include <TMath.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
 
 namespace
 {
@@ -11,6 +14,15 @@ namespace
     double const x = xs[0];
     return par[0]*(TMath::Exp(-(x-par[1])/par[2]-TMath::Exp(-(x-par[1])/par[2])));
   }
+
+  //convergence and iteration limits of FitPulse.
+  //the EDM limit is that of the default Minuit minimization used by TGraph::Fit,
+  //applied to the chi2 in units of the residual variance chi2/ndf of the fit.
+  //the residual variance is not taken below the ADC quantization noise of 1/12 ADC^2.
+  const double maxEDM        = 1e-5;
+  const double minVariance   = 1.0/12.0;
+  const int    maxIterations = 100;
+  const double maxLambda     = 1e10;
 }
 
 namespace mu2eCrv
@@ -18,15 +30,130 @@ namespace mu2eCrv
 
 MakeCrvRecoPulses::MakeCrvRecoPulses(double minADCdifference, double defaultBeta, double minBeta, double maxBeta,
                                      double maxTimeDifference, double minPulseHeightRatio, double maxPulseHeightRatio,
-                                     double LEtimeFactor) :
+                                     double LEtimeFactor, bool useTF1Fit) :
                                      _f("peakfitter",Gumbel,0,0,3), _minADCdifference(minADCdifference), 
                                      _defaultBeta(defaultBeta), _minBeta(minBeta), _maxBeta(maxBeta), 
                                      _maxTimeDifference(maxTimeDifference),
                                      _minPulseHeightRatio(minPulseHeightRatio),
                                      _maxPulseHeightRatio(maxPulseHeightRatio),
-                                     _LEtimeFactor(LEtimeFactor)
+                                     _LEtimeFactor(LEtimeFactor), _useTF1Fit(useTF1Fit)
 {}
 
+bool MakeCrvRecoPulses::FitPulse(const std::vector<unsigned int> &waveform, int startBin, int endBin,
+                                 unsigned int startTDC, double digitizationPeriod, double pedestal,
+                                 double *par, double &chi2) const
+{
+  //Levenberg-Marquardt iterations with the analytic derivatives of the pulse shape.
+  //the points are read from the waveform at each iteration, so that nothing needs to be stored.
+  double alpha[3][3], beta[3];
+  auto normalEquations = [&](const double *p)
+  {
+    double sum=0;
+    for(int k=0; k<3; k++)
+    {
+      beta[k]=0;
+      for(int l=0; l<3; l++) alpha[k][l]=0;
+    }
+    for(int bin=startBin; bin<=endBin; bin++)
+    {
+      double t=(startTDC+bin)*digitizationPeriod;
+      double v=waveform[bin]-pedestal;
+      double z=(t-p[1])/p[2];
+      double e=exp(-z);
+      double shape=exp(-z-e);
+      double f=p[0]*shape;
+      double deriv[3]={shape, f*(1.0-e)/p[2], f*(1.0-e)*z/p[2]};
+      double r=v-f;
+      sum+=r*r;
+      for(int k=0; k<3; k++)
+      {
+        beta[k]+=deriv[k]*r;
+        for(int l=0; l<=k; l++) alpha[k][l]+=deriv[k]*deriv[l];
+      }
+    }
+    for(int k=0; k<3; k++) for(int l=k+1; l<3; l++) alpha[k][l]=alpha[l][k];
+    return sum;
+  };
+  auto chi2At = [&](const double *p)
+  {
+    double sum=0;
+    for(int bin=startBin; bin<=endBin; bin++)
+    {
+      double t=(startTDC+bin)*digitizationPeriod;
+      double z=(t-p[1])/p[2];
+      double r=waveform[bin]-pedestal-p[0]*exp(-z-exp(-z));
+      sum+=r*r;
+    }
+    return sum;
+  };
+  //solves m*x=b for a 3x3 matrix, returns false if m is singular or not positive
+  auto solve = [](const double m[3][3], const double *b, double *x)
+  {
+    double c00=m[1][1]*m[2][2]-m[1][2]*m[2][1];
+    double c01=m[1][2]*m[2][0]-m[1][0]*m[2][2];
+    double c02=m[1][0]*m[2][1]-m[1][1]*m[2][0];
+    double det=m[0][0]*c00+m[0][1]*c01+m[0][2]*c02;
+    if(!(det>0) || !std::isfinite(det)) return false;
+    double inv[3][3]={{c00, m[0][2]*m[2][1]-m[0][1]*m[2][2], m[0][1]*m[1][2]-m[0][2]*m[1][1]},
+                      {c01, m[0][0]*m[2][2]-m[0][2]*m[2][0], m[0][2]*m[1][0]-m[0][0]*m[1][2]},
+                      {c02, m[0][1]*m[2][0]-m[0][0]*m[2][1], m[0][0]*m[1][1]-m[0][1]*m[1][0]}};
+    for(int k=0; k<3; k++) x[k]=(inv[k][0]*b[0]+inv[k][1]*b[1]+inv[k][2]*b[2])/det;
+    return true;
+  };
+
+  //the fit counts as converged when the estimated distance to the minimum (as Minuit's EDM)
+  //is small compared to the residual variance, and the parameter step has become smaller
+  //than the previous accepted step.  the curvature at the minimum needs to be positive
+  //(as for Minuit), which is checked by solve().
+  int ndf=endBin-startBin+1-3;
+  auto converged = [&](const double *delta, double step, double lastStep)
+  {
+    double variance=ndf>0 ? std::max(chi2/ndf, minVariance) : minVariance;
+    double edm=delta[0]*beta[0]+delta[1]*beta[1]+delta[2]*beta[2];
+    return edm<maxEDM*variance && step<lastStep;
+  };
+  //largest parameter change relative to the parameter
+  auto stepSize = [&](const double *delta)
+  {
+    double step=0;
+    for(int k=0; k<3; k++) step=std::max(step, fabs(delta[k])/std::max(fabs(par[k]),1e-9));
+    return step;
+  };
+
+  double lambda=1e-3;
+  double lastStep=std::numeric_limits<double>::infinity();
+  chi2=normalEquations(par);
+  for(int iteration=0; iteration<maxIterations && lambda<maxLambda; iteration++)
+  {
+    double damped[3][3], delta[3];
+    for(int k=0; k<3; k++) for(int l=0; l<3; l++) damped[k][l]=alpha[k][l]*(k==l?1.0+lambda:1.0);
+    if(!solve(damped,beta,delta)) return false;
+
+    double trial[3]={par[0]+delta[0], par[1]+delta[1], par[2]+delta[2]};
+    double trialChi2=chi2At(trial);
+    if(!(trialChi2<=chi2))  //also rejects steps to NaN
+    {
+      //no smaller chi2 within the rounding errors at the minimum
+      double delta0[3];
+      if(solve(alpha,beta,delta0) && converged(delta0,stepSize(delta0),lastStep)) return true;
+      lambda*=10;
+      continue;
+    }
+    //convergence is judged with the derivatives before the step
+    bool done=converged(delta,stepSize(delta),lastStep);
+    lastStep=stepSize(delta);
+    for(int k=0; k<3; k++) par[k]=trial[k];
+    lambda*=0.1;
+    chi2=normalEquations(par);
+    if(done)
+    {
+      double delta0[3];
+      return solve(alpha,beta,delta0);
+    }
+  }
+  return false;
+}
+
 void MakeCrvRecoPulses::SetWaveform(const std::vector<unsigned int> &waveform, 
                                     unsigned int startTDC, double digitizationPeriod, double pedestal, 
                                     double calibrationFactor, double calibrationFactorPulseHeight)
@@ -100,29 +227,43 @@ void MakeCrvRecoPulses::SetWaveform(const std::vector<unsigned int> &waveform,
     double t2=(startTDC+endBin)*digitizationPeriod;
     double peakTime=(startTDC+0.5*(peakStartBin+peakEndBin))*digitizationPeriod;
 
-    //fill the graph
-    std::vector<double> t,v;
-    for(int bin=startBin; bin<=endBin; bin++) 
+    //start values of the fit
+    double par[3]={(waveform[peakStartBin]-pedestal)*TMath::E(), peakTime, _defaultBeta};
+    double fitChi2=0;
+    bool invalidFit=false;
+
+    if(_useTF1Fit)
     {
-      t.emplace_back((startTDC+bin)*digitizationPeriod);
-      v.emplace_back(waveform[bin]-pedestal);
-    }
-    TGraph g(t.size(), t.data(), v.data());
+      //fill the graph
+      std::vector<double> t,v;
+      for(int bin=startBin; bin<=endBin; bin++) 
+      {
+        t.emplace_back((startTDC+bin)*digitizationPeriod);
+        v.emplace_back(waveform[bin]-pedestal);
+      }
+      TGraph g(t.size(), t.data(), v.data());
 
-    //set the fit function
-    _f.SetParameter(0, (waveform[peakStartBin]-pedestal)*TMath::E());
-    _f.SetParameter(1, peakTime);
-    _f.SetParameter(2, _defaultBeta);
+      //set the fit function
+      _f.SetParameter(0, par[0]);
+      _f.SetParameter(1, par[1]);
+      _f.SetParameter(2, par[2]);
 
-    //do the fit
-    TFitResultPtr fr = g.Fit(&_f,"NQS");
+      //do the fit
+      TFitResultPtr fr = g.Fit(&_f,"NQS");
 
-    bool invalidFit=false;
-    if(!fr->IsValid()) invalidFit=true;;
+      if(!fr->IsValid()) invalidFit=true;
+
+      for(int k=0; k<3; k++) par[k]=fr->Parameter(k);
+      fitChi2 = fr->Chi2();
+    }
+    else
+    {
+      if(!FitPulse(waveform, startBin, endBin, startTDC, digitizationPeriod, pedestal, par, fitChi2)) invalidFit=true;
+    }
 
-    double fitParam0 = fr->Parameter(0);
-    double fitParam1 = fr->Parameter(1);
-    double fitParam2 = fr->Parameter(2);
+    double fitParam0 = par[0];
+    double fitParam1 = par[1];
+    double fitParam2 = par[2];
 
     //trying to identify fake pulse
     if(fitParam0<=0) invalidFit=true;
@@ -135,7 +276,7 @@ void MakeCrvRecoPulses::SetWaveform(const std::vector<unsigned int> &waveform,
     double pulseTime    = fitParam1;
     double pulseHeight  = fitParam0/TMath::E();
     double pulseBeta    = fitParam2;
-    double pulseFitChi2 = fr->Chi2();
+    double pulseFitChi2 = fitChi2;
     double LEtime       = 0;
     if(invalidFit)
     {
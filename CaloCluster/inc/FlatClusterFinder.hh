@@ -0,0 +1,75 @@
+//
+// Proto-cluster finder working on flat arrays, an alternative to ClusterFinder that gives the same
+// proto-clusters as CaloProtoClusterFromCrystalHit with ClusterFinder (same hits, in the same order).
+//
+// The crystal hits passing the noise and time cuts are grouped by crystal in a single array
+// (offsets per crystal, hits kept in the collection order, i.e. time ordered), with their time, energy
+// and a used flag stored next to each other. Clusters are grown by a breadth first search over the flat
+// neighbor table of the calorimeter. The visited crystals are marked with the number of the current
+// cluster, so the marks do not need to be cleared between clusters, and all buffers are kept between
+// events.
+//
+
+#ifndef CaloCluster_FlatClusterFinder_HH_
+#define CaloCluster_FlatClusterFinder_HH_
+
+// Mu2e includes
+#include "RecoDataProducts/inc/CaloCrystalHitCollection.hh"
+#include "CalorimeterGeom/inc/Calorimeter.hh"
+
+// C++ includes
+#include <vector>
+
+
+
+namespace mu2e {
+
+
+    class FlatClusterFinder {
+
+
+         public:
+
+             typedef std::vector<CaloCrystalHit const*>  CaloCrystalVec;
+
+
+             FlatClusterFinder(double deltaTime, double ExpandCut, double EnoiseCut, double timeCut, double EminSeed);
+             ~FlatClusterFinder(){};
+
+             // form the main (seed above EminSeed) and split-off proto-clusters, hits sorted by decreasing energy
+             void makeClusters(Calorimeter const& cal, CaloCrystalHitCollection const& hits,
+                               std::vector<CaloCrystalVec>& mainClusters, std::vector<CaloCrystalVec>& splitClusters);
+
+
+
+         private:
+
+             void fillHits(Calorimeter const& cal, CaloCrystalHitCollection const& hits);
+             void formCluster(int seed, CaloCrystalVec& cluster);
+             void newEpoch();
+
+             Calorimeter const*            cal_;
+             double                        deltaTime_;
+             double                        ExpandCut_;
+             double                        EnoiseCut_;
+             double                        timeCut_;
+             double                        EminSeed_;
+
+             std::vector<int>              crystalOffset_;   // hits of crystal i are [crystalOffset_[i],crystalOffset_[i+1])
+             std::vector<double>           hitTime_;
+             std::vector<double>           hitEnergy_;
+             std::vector<int>              hitCrystal_;
+             std::vector<char>             hitUsed_;
+             std::vector<const CaloCrystalHit*> hitPtr_;
+
+             std::vector<int>              seeds_;           // hit indices by decreasing energy
+             std::vector<unsigned>         visited_;         // epoch of the last visit of each crystal
+             unsigned                      epoch_;
+             std::vector<int>              crystalToVisit_;
+             std::vector<int>              clusterHits_;
+    };
+
+
+}
+
+#endif
@@ -205,6 +205,8 @@ void CaloClusterFast::extractRecoDigi(const art::Handle<CaloDigiCollection>& cal
 
       if (seeds_.empty()) return;
       std::vector<art::Ptr<CaloRecoDigi> > caloRecoDigi;
+      const CaloNeighborTable& neighborTable = cal->neighborTable();
+      const int neighborLevel = extendSecond_ ? 2 : 1;
 
 
       /* In this version, we do the usual seed + neighbors clustering. There is the option to look at next-to-neighbors crystals
@@ -225,7 +227,7 @@ void CaloClusterFast::extractRecoDigi(const art::Handle<CaloDigiCollection>& cal
 		 //seed->val_ = 0;
 
 		 std::queue<int> crystalToVisit;
-		 for (const auto& nid : cal->neighbors(seed->crId_)) crystalToVisit.push(nid);
+		 for (int nid : neighborTable.neighbors(seed->crId_)) crystalToVisit.push(nid);
 
 		 double     hitTime = (seed->index_+offsetT0_)*digiSampling_-timeCorrection_;
 		 if (includeCrystalHits_) {
@@ -249,8 +251,7 @@ void CaloClusterFast::extractRecoDigi(const art::Handle<CaloDigiCollection>& cal
                  			recoCrystalHits.push_back(CaloCrystalHit(hit.crId_, 2, hitTime, 0, hit.val_*adcToEnergy_, 0., caloRecoDigi));
                			}
 			       hit.val_ = 0;
-			       for (const auto& neighbor : cal->neighbors(nid)) crystalToVisit.push(neighbor);
-			       if (extendSecond_) for (const auto& nneighbor : cal->nextNeighbors(nid)) crystalToVisit.push(nneighbor);
+			       for (int neighbor : neighborTable.neighborsUpTo(nid,neighborLevel)) crystalToVisit.push(neighbor);
             		}
 			for (auto& hit : hitList_[seed->index_-1])
 			{
@@ -264,8 +265,7 @@ void CaloClusterFast::extractRecoDigi(const art::Handle<CaloDigiCollection>& cal
                  recoCrystalHits.push_back(CaloCrystalHit(hit.crId_, 2, hitTime, 0, hit.val_*adcToEnergy_, 0., caloRecoDigi));
                			}
 			       hit.val_ = 0;
-			       for (const auto& neighbor : cal->neighbors(nid)) crystalToVisit.push(neighbor);
-			       if (extendSecond_) for (const auto& nneighbor : cal->nextNeighbors(nid)) crystalToVisit.push(nneighbor);
+			       for (int neighbor : neighborTable.neighborsUpTo(nid,neighborLevel)) crystalToVisit.push(neighbor);
            		}
 	    
 			for (auto& hit : hitList_[seed->index_+1])
@@ -280,8 +280,7 @@ void CaloClusterFast::extractRecoDigi(const art::Handle<CaloDigiCollection>& cal
 				 recoCrystalHits.push_back(CaloCrystalHit(hit.crId_, 2, hitTime, 0, hit.val_*adcToEnergy_, 0., caloRecoDigi));
 				}
 			       hit.val_ = 0;
-			       for (const auto& neighbor : cal->neighbors(nid)) crystalToVisit.push(neighbor);
-			       if (extendSecond_) for (const auto& nneighbor : cal->nextNeighbors(nid)) crystalToVisit.push(nneighbor);
+			       for (int neighbor : neighborTable.neighborsUpTo(nid,neighborLevel)) crystalToVisit.push(neighbor);
             		}
 
             		crystalToVisit.pop();
@@ -231,8 +231,8 @@ namespace mu2e {
   {
     int seedId              = caloCrystalHitsPtrVector[0]->id();
     double seedEnergy       = caloCrystalHitsPtrVector[0]->energyDep();
-    auto const neighborsId  = cal.crystal(seedId).neighbors();
-    auto const nneighborsId = cal.crystal(seedId).nextNeighbors();
+    auto const neighborsId  = cal.neighborTable().neighbors(seedId);
+    auto const nneighborsId = cal.neighborTable().nextNeighbors(seedId);
 
     double e1(seedEnergy),e9(seedEnergy),e25(seedEnergy);
     for (const auto& il : caloCrystalHitsPtrVector)
@@ -23,6 +23,7 @@
 // Note: 1. One can try to filter the hits first, before producing energetic proto-clusters (use two iterators on the time ordered crystal list, see commented code at the end).
 //          The performance difference is very small compared to this implementation, but more obscure, so for clarity, I kept this one.
 //       2. I tried a bunch of other optimizations but the performance increase is small and the code harder to read, so I left it as is
+//       3. flatClusterFinder : true uses FlatClusterFinder, which produces the same proto-clusters from flat arrays (see CaloCluster/inc/FlatClusterFinder.hh)
 //
 // Original author: B. Echenard
 //
@@ -36,6 +37,7 @@
 #include "cetlib_except/exception.h"
 
 #include "CaloCluster/inc/ClusterFinder.hh"
+#include "CaloCluster/inc/FlatClusterFinder.hh"
 #include "CalorimeterGeom/inc/Calorimeter.hh"
 #include "GeometryService/inc/GeomHandle.hh"
 #include "GeometryService/inc/GeometryService.hh"
@@ -75,6 +77,8 @@ namespace mu2e {
       timeCut_(pset.get<double>("timeCut")),
       deltaTime_(pset.get<double>("deltaTime")),
       diagLevel_(pset.get<int>("diagLevel",0)),
+      useFlatFinder_(pset.get<bool>("flatClusterFinder",false)),
+      flatFinder_(deltaTime_, ExpandCut_, EnoiseCut_, timeCut_, EminSeed_),
       messageCategory_("CLUSTER")
     {
       produces<CaloProtoClusterCollection>(producerNameMain_);
@@ -94,17 +98,25 @@ namespace mu2e {
     double            timeCut_;
     double            deltaTime_;
     int               diagLevel_;
+    bool              useFlatFinder_;
+    FlatClusterFinder flatFinder_;
     const std::string messageCategory_;
 
     void makeProtoClusters(CaloProtoClusterCollection& caloProtoClustersMain,
                            CaloProtoClusterCollection& caloProtoClustersSplit,
                            const art::Handle<CaloCrystalHitCollection>& CaloCrystalHitsHandle);
 
+    void makeListClusters(const Calorimeter& cal,
+                          CaloProtoClusterCollection& caloProtoClustersMain,
+                          CaloProtoClusterCollection& caloProtoClustersSplit,
+                          const art::Handle<CaloCrystalHitCollection>& CaloCrystalHitsHandle);
+
     void filterByTime(CaloCrystalList& liste,
                       const std::vector<double>& clusterTime,
                       std::list<const CaloCrystalHit*> &seedList);
 
-    void fillCluster(CaloProtoClusterCollection& caloProtoClustersColl, const CaloCrystalList& clusterList,
+    template <class HitContainer>
+    void fillCluster(CaloProtoClusterCollection& caloProtoClustersColl, const HitContainer& clusterList,
                      const art::Handle<CaloCrystalHitCollection>& CaloCrystalHitsHandle);
 
     void dump(const std::vector<CaloCrystalList>& caloIdHitMap);
@@ -142,6 +154,34 @@ namespace mu2e {
     const CaloCrystalHitCollection& CaloCrystalHits(*CaloCrystalHitsHandle);
     if (CaloCrystalHits.empty()) return;
 
+    if (useFlatFinder_)
+      {
+        std::vector<CaloCrystalVec> mainClusters, splitClusters;
+        flatFinder_.makeClusters(cal, CaloCrystalHits, mainClusters, splitClusters);
+
+        for (const auto& cluster : mainClusters)  fillCluster(caloProtoClustersMain,cluster,CaloCrystalHitsHandle);
+        for (const auto& cluster : splitClusters) fillCluster(caloProtoClustersSplit,cluster,CaloCrystalHitsHandle);
+      }
+    else
+      {
+        makeListClusters(cal, caloProtoClustersMain, caloProtoClustersSplit, CaloCrystalHitsHandle);
+      }
+
+    //sort these guys
+    std::sort(caloProtoClustersMain.begin(),  caloProtoClustersMain.end(), [](const CaloProtoCluster& a, const CaloProtoCluster& b) {return a.time() < b.time();});
+    std::sort(caloProtoClustersSplit.begin(), caloProtoClustersSplit.end(),[](const CaloProtoCluster& a, const CaloProtoCluster& b) {return a.time() < b.time();});
+  }
+
+
+
+  //----------------------------------------------------------------------------------------------------------
+  void CaloProtoClusterFromCrystalHit::makeListClusters(const Calorimeter& cal,
+                                                        CaloProtoClusterCollection& caloProtoClustersMain,
+                                                        CaloProtoClusterCollection& caloProtoClustersSplit,
+                                                        const art::Handle<CaloCrystalHitCollection> & CaloCrystalHitsHandle)
+  {
+    const CaloCrystalHitCollection& CaloCrystalHits(*CaloCrystalHitsHandle);
+
 
     //declare and fill the hash map crystal_id -> list of CaloHits
     std::vector<CaloCrystalList>      mainClusterList, splitClusterList,caloIdHitMap(cal.nCrystal());
@@ -199,13 +239,6 @@ namespace mu2e {
     //save the main and split clusters
     for (auto cluster : mainClusterList)  fillCluster(caloProtoClustersMain,cluster,CaloCrystalHitsHandle);
     for (auto cluster : splitClusterList) fillCluster(caloProtoClustersSplit,cluster,CaloCrystalHitsHandle);
-
-
-
-    //sort these guys
-    std::sort(caloProtoClustersMain.begin(),  caloProtoClustersMain.end(), [](const CaloProtoCluster& a, const CaloProtoCluster& b) {return a.time() < b.time();});
-    std::sort(caloProtoClustersSplit.begin(), caloProtoClustersSplit.end(),[](const CaloProtoCluster& a, const CaloProtoCluster& b) {return a.time() < b.time();});
-
   }
 
 
@@ -213,7 +246,8 @@ namespace mu2e {
 
 
   //----------------------------------------------------------------------------------------------------------
-  void CaloProtoClusterFromCrystalHit::fillCluster(CaloProtoClusterCollection& caloProtoClustersColl, const CaloCrystalList& clusterPtrList,
+  template <class HitContainer>
+  void CaloProtoClusterFromCrystalHit::fillCluster(CaloProtoClusterCollection& caloProtoClustersColl, const HitContainer& clusterPtrList,
                                                    const art::Handle<CaloCrystalHitCollection>& CaloCrystalHitsHandle)
   {
 
@@ -22,7 +22,7 @@ namespace mu2e {
 
 	ClusterFinder::ClusterFinder(Calorimeter const& cal, CaloCrystalHit const* crystalSeed, double deltaTime, double ExpandCut) : 
 	  cal_(&cal), crystalSeed_(crystalSeed),seedTime_(crystalSeed->time()), clusterList_(), crystalToVisit_(), isVisited_(cal.nCrystal()),
-	  deltaTime_(deltaTime), ExpandCut_(ExpandCut)
+	  deltaTime_(deltaTime), ExpandCut_(ExpandCut), isOnline_(false)
 	{}
        
        
@@ -48,11 +48,9 @@ namespace mu2e {
 			int visitId         = crystalToVisit_.front();
 			isVisited_[visitId] = 1;
 
-			std::vector<int>  neighborsId = cal_->crystal(visitId).neighbors();
-			if(isOnline_){
-				for (const auto& nneighbor : cal_->nextNeighbors(visitId)) neighborsId.push_back(nneighbor);
-			}
-			for (auto& iId : neighborsId)
+			//online mode also looks at the next neighbors, stored right after the neighbors in the table
+			auto neighborsId = cal_->neighborTable().neighborsUpTo(visitId, isOnline_ ? 2 : 1);
+			for (int iId : neighborsId)
 		 	{               
 		    
 				if (isVisited_[iId]) continue;
@@ -0,0 +1,155 @@
+//
+// Proto-cluster finder working on flat arrays, see CaloCluster/inc/FlatClusterFinder.hh
+//
+// The order in which ClusterFinder visits the crystals and hits is kept on purpose: the hits of a cluster
+// are collected in the same order, then stable sorted by energy the same way, so that hits with equal
+// energies come out in the same order as well.
+//
+
+#include "CaloCluster/inc/FlatClusterFinder.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+
+namespace mu2e {
+
+
+       FlatClusterFinder::FlatClusterFinder(double deltaTime, double ExpandCut, double EnoiseCut, double timeCut, double EminSeed) :
+         cal_(nullptr), deltaTime_(deltaTime), ExpandCut_(ExpandCut), EnoiseCut_(EnoiseCut), timeCut_(timeCut), EminSeed_(EminSeed),
+         crystalOffset_(), hitTime_(), hitEnergy_(), hitCrystal_(), hitUsed_(), hitPtr_(), seeds_(), visited_(), epoch_(0),
+         crystalToVisit_(), clusterHits_()
+       {}
+
+
+
+       //----------------------------------------------------------------------------------------------------------
+       void FlatClusterFinder::makeClusters(Calorimeter const& cal, CaloCrystalHitCollection const& hits,
+                                            std::vector<CaloCrystalVec>& mainClusters, std::vector<CaloCrystalVec>& splitClusters)
+       {
+             cal_ = &cal;
+             fillHits(cal, hits);
+             if (hitPtr_.empty()) return;
+
+             //produce main clusters
+             double minClusterTime = std::numeric_limits<double>::max();
+             bool   hasCluster(false);
+             for (int seed : seeds_)
+             {
+                  if (hitUsed_[seed]) continue;
+                  if (hitEnergy_[seed] < EminSeed_) break;
+
+                  mainClusters.emplace_back();
+                  formCluster(seed, mainClusters.back());
+                  minClusterTime = std::min(minClusterTime, hitTime_[seed]);
+                  hasCluster = true;
+             }
+
+             //filter unneeded hits: keep those with (clusterTime - time) < deltaTime for at least one main cluster
+             for (size_t i=0;i<hitUsed_.size();++i)
+                 if (!hasCluster || !(minClusterTime - hitTime_[i] < deltaTime_)) hitUsed_[i] = 1;
+
+             //produce split-offs clusters
+             for (int seed : seeds_)
+             {
+                  if (hitUsed_[seed]) continue;
+                  splitClusters.emplace_back();
+                  formCluster(seed, splitClusters.back());
+             }
+       }
+
+
+
+       //----------------------------------------------------------------------------------------------------------
+       // group the hits by crystal, keeping the collection order inside each crystal (counting sort)
+       void FlatClusterFinder::fillHits(Calorimeter const& cal, CaloCrystalHitCollection const& hits)
+       {
+             unsigned nCrystal = cal.nCrystal();
+             if (visited_.size() != nCrystal) {visited_.assign(nCrystal,0); epoch_ = 0;}
+
+             crystalOffset_.assign(nCrystal+1,0);
+             for (const auto& hit : hits)
+             {
+                  if (hit.energyDep() < EnoiseCut_ || hit.time() < timeCut_) continue;
+                  ++crystalOffset_[hit.id()+1];
+             }
+             for (unsigned i=0;i<nCrystal;++i) crystalOffset_[i+1] += crystalOffset_[i];
+
+             unsigned nHits = crystalOffset_[nCrystal];
+             hitTime_.resize(nHits);
+             hitEnergy_.resize(nHits);
+             hitCrystal_.resize(nHits);
+             hitPtr_.resize(nHits);
+             hitUsed_.assign(nHits,0);
+             seeds_.clear();
+
+             // seeds are listed in collection order before the stable sort, as the seed list of ClusterFinder
+             std::vector<int> fill(crystalOffset_.begin(), crystalOffset_.end()-1);
+             std::vector<int> hitIndex;
+             hitIndex.reserve(nHits);
+             for (const auto& hit : hits)
+             {
+                  if (hit.energyDep() < EnoiseCut_ || hit.time() < timeCut_) continue;
+                  int idx = fill[hit.id()]++;
+                  hitTime_[idx]    = hit.time();
+                  hitEnergy_[idx]  = hit.energyDep();
+                  hitCrystal_[idx] = hit.id();
+                  hitPtr_[idx]     = &hit;
+                  seeds_.push_back(idx);
+             }
+
+             std::stable_sort(seeds_.begin(), seeds_.end(), [this](int a, int b) {return hitEnergy_[a] > hitEnergy_[b];});
+       }
+
+
+
+       //----------------------------------------------------------------------------------------------------------
+       void FlatClusterFinder::formCluster(int seed, CaloCrystalVec& cluster)
+       {
+             newEpoch();
+             const CaloNeighborTable& neighborTable = cal_->neighborTable();
+             double seedTime = hitTime_[seed];
+
+             clusterHits_.clear();
+             clusterHits_.push_back(seed);
+             hitUsed_[seed] = 1;
+
+             crystalToVisit_.clear();
+             crystalToVisit_.push_back(hitCrystal_[seed]);
+             visited_[hitCrystal_[seed]] = epoch_;
+
+             for (size_t iv=0; iv<crystalToVisit_.size(); ++iv)
+             {
+                  for (int iId : neighborTable.neighbors(crystalToVisit_[iv]))
+                  {
+                       if (visited_[iId] == epoch_) continue;
+                       visited_[iId] = epoch_;
+
+                       for (int ih=crystalOffset_[iId]; ih<crystalOffset_[iId+1]; ++ih)
+                       {
+                            if (hitUsed_[ih] || !(std::abs(hitTime_[ih] - seedTime) < deltaTime_)) continue;
+                            if (hitEnergy_[ih] > ExpandCut_) crystalToVisit_.push_back(iId);
+                            clusterHits_.push_back(ih);
+                            hitUsed_[ih] = 1;
+                       }
+                  }
+             }
+
+             // ClusterFinder adds the hits at the front of its list before sorting them
+             std::reverse(clusterHits_.begin(), clusterHits_.end());
+             std::stable_sort(clusterHits_.begin(), clusterHits_.end(), [this](int a, int b) {return hitEnergy_[a] > hitEnergy_[b];});
+
+             cluster.reserve(clusterHits_.size());
+             for (int ih : clusterHits_) cluster.push_back(hitPtr_[ih]);
+       }
+
+
+
+       //----------------------------------------------------------------------------------------------------------
+       void FlatClusterFinder::newEpoch()
+       {
+             if (++epoch_ == 0) {std::fill(visited_.begin(), visited_.end(), 0); epoch_ = 1;}
+       }
+
+}
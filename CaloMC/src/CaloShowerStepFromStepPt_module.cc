@@ -24,6 +24,10 @@
 // The compressibility is determined by looking at the interaction codes of the StepPointMCs.
 // Particles are compressed in small intervals of time and crystal longitudinal slices.
 //
+// With batchCompression, the StepPointMCs are instead collected in a flat array, with the ancestor of each
+// SimParticle looked up once per event, and sorted by (ancestor, crystal, SimParticle, time). The CaloShowerSteps are then
+// accumulated in a single pass over the sorted array, in the same order as the map based compression.
+//
 // See doc-db XXXX for more details
 //
 
@@ -48,11 +52,13 @@
 #include "CLHEP/Vector/ThreeVector.h"
 #include "TH2F.h"
 
+#include <algorithm>
 #include <iostream>
 #include <string>
 #include <cmath>
 #include <map>
 #include <vector>
+#include <unordered_map>
 #include <unordered_set>
 #include <utility>
 
@@ -90,6 +96,59 @@ namespace mu2e {
       std::vector<art::Ptr<SimParticle> >  sims_;
       std::unordered_set<int>              procs_;
     };
+
+
+    // Hash of a SimParticle Ptr for the per event lookup tables (not a std::hash specialization, see note above)
+    struct SimPtrHash {
+      size_t operator()(const art::Ptr<SimParticle>& sim) const
+      {
+        return std::hash<size_t>()(sim.key() ^ (size_t(sim.id().value()) << 32));
+      }
+    };
+
+
+    // A StepPointMC in the flat array of the batch compression. Steps with the same group, volume and sim are
+    // compressed together: group is the rank of the ancestor SimParticle (of the SimParticle for readouts), and sim
+    // the rank of the SimParticle, or 0 when the ancestor is compressible. While the steps are collected, group and
+    // sim hold the index of the ancestor and of the SimParticle in the per event tables instead.
+    // order is the position of the step in the input, which also keeps the steps with the same time in input order.
+    struct CaloStepRecord {
+      unsigned            group;
+      int                 volId;
+      unsigned            sim;
+      unsigned            order;
+      const StepPointMC*  step;
+
+      bool sameShower(const CaloStepRecord& other) const {return group==other.group && volId==other.volId && sim==other.sim;}
+
+      bool operator<(const CaloStepRecord& other) const
+      {
+        if (group != other.group) return group < other.group;
+        if (volId != other.volId) return volId < other.volId;
+        if (sim   != other.sim)   return sim   < other.sim;
+        if (step->time() != other.step->time()) return step->time() < other.step->time();
+        return order < other.order;
+      }
+    };
+
+    // Indices of the ancestor and of the SimParticle (if it made StepPointMCs) in the per event tables, -1 if not known yet
+    struct SimIndices {
+      int ancestor = -1;
+      int sim      = -1;
+    };
+
+    const StepPointMC* stepOf(const StepPointMC* step)      {return step;}
+    const StepPointMC* stepOf(const CaloStepRecord& record) {return record.step;}
+
+    // Largest capacity of the batch compression work space kept between events. The memory taken by an event with
+    // more StepPointMCs or SimParticles is released at the end of that event.
+    const size_t maxKeptWorkSize = 65536;
+
+    template <class T> void releaseAbove(std::vector<T>& work, size_t maxSize)
+    {
+      work.clear();
+      if (work.capacity() > maxSize) work.shrink_to_fit();
+    }
   }
 
 
@@ -107,6 +166,7 @@ namespace mu2e {
       physVolToken_{consumes<PhysicalVolumeInfoMultiCollection, art::InSubRun>(pset.get<std::string>("physVolInfoInput"))},
       caloMaterial_(            pset.get<std::vector<std::string> >("caloMaterial") ),
       compressMuons_(           pset.get<bool>(       "compressMuons") ),
+      batchCompression_(        pset.get<bool>(       "batchCompression",false) ),
       diagLevel_(               pset.get<int>(        "diagLevel",0) ),
       messageCategory_("CaloCompressHits"),
       vols_(),
@@ -136,6 +196,7 @@ namespace mu2e {
     art::ProductToken<PhysicalVolumeInfoMultiCollection> const physVolToken_;
     std::vector<std::string>                       caloMaterial_;
     bool const                                     compressMuons_;
+    bool const                                     batchCompression_;
     int const                                      diagLevel_;
     std::string const                              messageCategory_;
     PhysicalVolumeInfoMultiCollection const*       vols_;
@@ -143,6 +204,20 @@ namespace mu2e {
     double                                         zSliceSize_;
     std::unordered_set<const PhysicalVolumeInfo*>  mapPhysVol_;
 
+    // Work space of the batch compression, kept between events up to maxKeptWorkSize entries
+    std::vector<CaloStepRecord>                    records_;
+    std::vector<SimPtr>                            stepSims_;
+    std::vector<unsigned>                          simOrder_;
+    std::vector<unsigned>                          simRank_;
+    std::vector<SimPtr>                            ancestors_;
+    std::vector<std::unordered_set<int>>           ancestorProcs_;
+    std::vector<SimParticlePtrCollection>          ancestorSims_;
+    std::vector<unsigned>                          ancestorOrder_;
+    std::vector<unsigned>                          ancestorRank_;
+    std::vector<bool>                              ancestorCompress_;
+    SimParticlePtrCollection                       inspectedSims_;
+    std::unordered_map<SimPtr,SimIndices,SimPtrHash> simIndices_;
+
 
     TH2F*  hStartPos_;
     TH2F*  hStopPos_;
@@ -160,6 +235,11 @@ namespace mu2e {
 
     void makeCompressedHits(const HandleVector&, const HandleVector&, CaloShowerStepCollection&,
                             CaloShowerStepCollection&, SimParticlePtrCollection&);
+    void makeCompressedHitsBatch(const HandleVector&, const HandleVector&, CaloShowerStepCollection&,
+                                 CaloShowerStepCollection&, SimParticlePtrCollection&);
+    int findAncestor(const Calorimeter&, const PhysicalVolumeMultiHelper&, const SimPtr&);
+    void releaseWorkSpace();
+    void rankSims(const std::vector<SimPtr>&, std::vector<unsigned>& order, std::vector<unsigned>& rank);
     void collectStepBySimAncestor(const Calorimeter&, const PhysicalVolumeMultiHelper& ,
                                   const HandleVector&, std::map<SimPtr,CaloCompressUtil>&);
     void collectStepBySim(const HandleVector&, std::map<SimPtr,std::vector<const StepPointMC*> >&);
@@ -167,6 +247,9 @@ namespace mu2e {
     bool isCompressible(int simPdgId, const  std::unordered_set<int>&, const  SimParticlePtrCollection&);
     void compressSteps(const Calorimeter&, CaloShowerStepCollection&, bool isCrystal,
                        int volId, const SimPtr&, std::vector<const StepPointMC*>&);
+    template <class StepIter>
+    void accumulateSteps(const Calorimeter&, CaloShowerStepCollection&, bool isCrystal, int volId, const SimPtr&,
+                         StepIter first, StepIter last, ShowerStepUtil&);
     void dumpAllInfo(const HandleVector& stepsHandles,const Calorimeter& cal);
   };
 
@@ -246,7 +329,10 @@ namespace mu2e {
     event.getMany(getCrystalSteps, crystalStepsHandles);
     event.getMany(getReadoutSteps, readoutStepsHandles);
 
-    makeCompressedHits(crystalStepsHandles,readoutStepsHandles,*caloShowerStepMCs,*caloROShowerStepMCs,*simsToKeep);
+    if (batchCompression_)
+      makeCompressedHitsBatch(crystalStepsHandles,readoutStepsHandles,*caloShowerStepMCs,*caloROShowerStepMCs,*simsToKeep);
+    else
+      makeCompressedHits(crystalStepsHandles,readoutStepsHandles,*caloShowerStepMCs,*caloROShowerStepMCs,*simsToKeep);
 
     if (diagLevel_ > 0) {
       std::cout << "[CaloShowerStepFromStepPt::produce] Total energy deposited / number of stepPointMC: " <<totalEdep_<<" / "<<totalStep_<<std::endl
@@ -381,6 +467,245 @@ namespace mu2e {
   }
 
 
+  //------------------------------------------------------------------------------------------------------------------
+  void CaloShowerStepFromStepPt::makeCompressedHitsBatch(const HandleVector& crystalStepsHandles,
+                                                         const HandleVector& readoutStepsHandles,
+                                                         CaloShowerStepCollection& caloShowerStepMCs,
+                                                         CaloShowerStepCollection& caloROShowerStepMCs,
+                                                         SimParticlePtrCollection& simsToKeep)
+  {
+
+    PhysicalVolumeMultiHelper vi(*vols_);
+
+    const Calorimeter& cal = *(GeomHandle<Calorimeter>());
+    zSliceSize_             = (cal.caloInfo().getDouble("crystalZLength")+0.01)/float(numZSlices_);
+
+    size_t nSteps(0);
+    for (const auto& handle : crystalStepsHandles) nSteps += handle->size();
+
+    records_.clear();
+    records_.reserve(nSteps);
+    stepSims_.clear();
+    ancestors_.clear();
+    ancestorProcs_.clear();
+    ancestorSims_.clear();
+    simIndices_.clear();
+
+
+    // Collect the crystal StepPointMCs, the ancestor is found once per SimParticle
+    //-----------------------------------------------------------------------------
+    for (const auto& handle : crystalStepsHandles)
+      {
+        const StepPointMCCollection& steps(*handle);
+        if (diagLevel_ > 0) totalStep_ += steps.size();
+
+        for (const auto& step : steps)
+          {
+            SimIndices& indices = simIndices_[step.simParticle()];
+            if (indices.sim < 0)
+              {
+                if (indices.ancestor < 0) indices.ancestor = findAncestor(cal, vi, step.simParticle());
+                indices.sim = stepSims_.size();
+                stepSims_.push_back(step.simParticle());
+              }
+
+            ancestorProcs_[indices.ancestor].insert(step.endProcessCode());
+            records_.push_back(CaloStepRecord{unsigned(indices.ancestor), step.volumeId(), unsigned(indices.sim), unsigned(records_.size()), &step});
+
+            totalEdep_ += step.totalEDep();
+          }
+      }
+
+    if (diagLevel_ == 99)  dumpAllInfo(crystalStepsHandles,cal);
+
+    // not needed past this point, free the memory before the CaloShowerSteps are made
+    simIndices_.clear();
+
+
+    // Check if the ancestors are compressible, and sort the steps in the order of the map based compression
+    //-------------------------------------------------------------------------------------------------------
+    int nCompress(0),nCompressAll(0);
+
+    ancestorCompress_.assign(ancestors_.size(),false);
+    for (unsigned i=0;i<ancestors_.size();++i)
+      {
+        ancestorCompress_[i] = isCompressible(ancestors_[i]->pdgId(),ancestorProcs_[i],ancestorSims_[i]);
+        totalSim_ += ancestorSims_[i].size();
+        ++nCompressAll;
+        if (ancestorCompress_[i]) ++nCompress;
+      }
+
+    rankSims(ancestors_, ancestorOrder_, ancestorRank_);
+    rankSims(stepSims_,  simOrder_,      simRank_);
+
+    for (auto& record : records_)
+      {
+        record.sim   = ancestorCompress_[record.group] ? 0 : simRank_[record.sim];
+        record.group = ancestorRank_[record.group];
+      }
+    std::sort(records_.begin(),records_.end());
+
+
+    // Produce the caloShowerSteps of each ancestor / crystal / SimParticle
+    //---------------------------------------------------------------------
+    ShowerStepUtil buffer(numZSlices_,ShowerStepUtil::weight_type::energy );
+    for (size_t first=0, last=0; first<records_.size(); first=last)
+      {
+        while (last<records_.size() && records_[last].sameShower(records_[first])) ++last;
+
+        const CaloStepRecord& record = records_[first];
+        unsigned ancestor            = ancestorOrder_[record.group];
+        bool doCompress              = ancestorCompress_[ancestor];
+        const SimPtr& sim            = doCompress ? ancestors_[ancestor] : stepSims_[simOrder_[record.sim]];
+
+        simsToKeep.push_back(sim);
+        accumulateSteps(cal, caloShowerStepMCs, true, record.volId, sim, records_.data()+first, records_.data()+last, buffer);
+
+        if (doCompress && diagLevel_ > 2)
+          {
+            CLHEP::Hep3Vector startSection = cal.geomUtil().mu2eToDisk(0,sim->startPosition());
+            CLHEP::Hep3Vector endSection   = cal.geomUtil().mu2eToDisk(0,sim->endPosition());
+            double rStart = sqrt(startSection.x()*startSection.x()+startSection.y()*startSection.y());
+            double rEnd   = sqrt(endSection.x()*endSection.x()+endSection.y()*endSection.y());
+
+            hStartPos_->Fill(sim->startPosition().z(),rStart);
+            hStopPos_->Fill( sim->endPosition().z(),  rEnd);
+            for (const auto& simD: ancestorSims_[ancestor])
+              {
+                hStartPos2_->Fill(simD->startPosition().z());
+                hStopPos2_->Fill(simD->endPosition().z());
+              }
+          }
+      }
+
+
+    // Do the same for the readouts, sorted by SimParticle / readout, but there is no need to compress
+    //------------------------------------------------------------------------------------------------
+    records_.clear();
+    stepSims_.clear();
+
+    for (const auto& handle : readoutStepsHandles)
+      {
+        for (const auto& step : *handle)
+          {
+            SimIndices& indices = simIndices_[step.simParticle()];
+            if (indices.sim < 0)
+              {
+                indices.sim = stepSims_.size();
+                stepSims_.push_back(step.simParticle());
+              }
+            records_.push_back(CaloStepRecord{unsigned(indices.sim), step.volumeId(), 0, unsigned(records_.size()), &step});
+          }
+      }
+
+    rankSims(stepSims_, simOrder_, simRank_);
+    for (auto& record : records_) record.group = simRank_[record.group];
+    std::sort(records_.begin(),records_.end());
+
+    for (size_t first=0, last=0; first<records_.size(); first=last)
+      {
+        while (last<records_.size() && records_[last].sameShower(records_[first])) ++last;
+
+        const CaloStepRecord& record = records_[first];
+        accumulateSteps(cal, caloROShowerStepMCs, false, record.volId, stepSims_[simOrder_[record.group]],
+                        records_.data()+first, records_.data()+last, buffer);
+      }
+
+
+    if (diagLevel_ > 2) hEtot_->Fill(totalEdep_);
+
+    if (diagLevel_ > 2)
+      {
+        std::cout<<"CaloShowerStepFromStepPt summary"<<std::endl;
+        for (auto caloShowerStepMC : caloShowerStepMCs) std::cout<<caloShowerStepMC.volumeId()<<" "<<caloShowerStepMC.nCompress()<<"  "<<caloShowerStepMC.energyMC()<<std::endl;
+      }
+
+    //Final statistics
+    if (diagLevel_ > 1) std::cout<<"[CaloShowerStepFromStepPt::makeCompressedHitsBatch] compressed "<<nCompress<<" / "<<nCompressAll<<" incoming SimParticles"<<std::endl;
+    if (diagLevel_ > 1) std::cout<<"[CaloShowerStepFromStepPt::makeCompressedHitsBatch] keeping "<<simsToKeep.size()<<" CaloShowerSteps"<<std::endl;
+
+    releaseWorkSpace();
+  }
+
+
+  //------------------------------------------------------------------------------------------------------------------
+  // Empty the work space of the batch compression. The per ancestor sets and SimParticle lists are freed, and the
+  // tables that grew above maxKeptWorkSize in this event give their memory back.
+  void CaloShowerStepFromStepPt::releaseWorkSpace()
+  {
+    releaseAbove(records_,          maxKeptWorkSize);
+    releaseAbove(stepSims_,         maxKeptWorkSize);
+    releaseAbove(simOrder_,         maxKeptWorkSize);
+    releaseAbove(simRank_,          maxKeptWorkSize);
+    releaseAbove(ancestors_,        maxKeptWorkSize);
+    releaseAbove(ancestorProcs_,    maxKeptWorkSize);
+    releaseAbove(ancestorSims_,     maxKeptWorkSize);
+    releaseAbove(ancestorOrder_,    maxKeptWorkSize);
+    releaseAbove(ancestorRank_,     maxKeptWorkSize);
+    releaseAbove(ancestorCompress_, maxKeptWorkSize);
+    releaseAbove(inspectedSims_,    maxKeptWorkSize);
+
+    if (simIndices_.bucket_count() > maxKeptWorkSize) decltype(simIndices_)().swap(simIndices_);
+    else simIndices_.clear();
+  }
+
+
+  //------------------------------------------------------------------------------------------------------------------
+  // Same walk as collectStepBySimAncestor, returns the index of the ancestor. The ancestor of the SimParticles inspected
+  // on the way is recorded, and they are added to the SimParticles of the ancestor.
+  int CaloShowerStepFromStepPt::findAncestor(const Calorimeter& cal, const PhysicalVolumeMultiHelper& vi, const SimPtr& stepSim)
+  {
+    inspectedSims_.clear();
+    int ancestor(-1);
+
+    SimPtr sim = stepSim;
+    while (sim->hasParent() && isInsideCalorimeter(cal, vi,sim) )
+      {
+        //simparticle starting in one section and ending in another one see note above
+        if (!cal.geomUtil().isContainedSection(sim->startPosition(),sim->endPosition()) ) break;
+
+        auto const alreadyInspected = simIndices_.find(sim);
+        if (alreadyInspected != simIndices_.end() && alreadyInspected->second.ancestor >= 0) {ancestor = alreadyInspected->second.ancestor; break;}
+
+        inspectedSims_.push_back(sim);
+        sim = sim->parent();
+      }
+
+    // The walk stopped at the ancestor: it is its own ancestor
+    if (ancestor < 0)
+      {
+        SimIndices& indices = simIndices_[sim];
+        if (indices.ancestor < 0)
+          {
+            indices.ancestor = ancestors_.size();
+            ancestors_.push_back(sim);
+            ancestorProcs_.emplace_back();
+            ancestorSims_.emplace_back();
+          }
+        ancestor = indices.ancestor;
+      }
+
+    for (const SimPtr& inspectedSim : inspectedSims_) simIndices_[inspectedSim].ancestor = ancestor;
+    SimParticlePtrCollection& sims = ancestorSims_[ancestor];
+    sims.insert(sims.end(),inspectedSims_.begin(),inspectedSims_.end());
+
+    return ancestor;
+  }
+
+
+  //------------------------------------------------------------------------------------------------------------------
+  // order[rank] is the index of the SimParticle with the given rank in the art::Ptr ordering, rank[index] the inverse
+  void CaloShowerStepFromStepPt::rankSims(const std::vector<SimPtr>& sims, std::vector<unsigned>& order, std::vector<unsigned>& rank)
+  {
+    order.resize(sims.size());
+    for (unsigned i=0;i<sims.size();++i) order[i] = i;
+    std::sort(order.begin(),order.end(),[&sims](unsigned a, unsigned b) {return sims[a] < sims[b];});
+
+    rank.resize(sims.size());
+    for (unsigned i=0;i<order.size();++i) rank[order[i]] = i;
+  }
+
+
   //------------------------------------------------------------------------------------------------------------------
   void CaloShowerStepFromStepPt::collectStepBySimAncestor(const Calorimeter& cal,
                                                           const PhysicalVolumeMultiHelper& vi,
@@ -462,8 +787,20 @@ namespace mu2e {
     std::sort( steps.begin(), steps.end(), [](const StepPointMC* a, const StepPointMC* b) {return a->time() < b->time();} );
 
     ShowerStepUtil buffer(numZSlices_,ShowerStepUtil::weight_type::energy );
-    for (const StepPointMC* step : steps)
+    accumulateSteps(cal, caloShowerStepMCs, isCrystal, volId, sim, steps.data(), steps.data()+steps.size(), buffer);
+  }
+
+
+  //-------------------------------------------------------------------------------------------------------------------------------
+  // Steps (StepPointMC pointers or batch records) sorted by time, the buffer is left empty
+  template <class StepIter>
+  void CaloShowerStepFromStepPt::accumulateSteps(const Calorimeter& cal, CaloShowerStepCollection &caloShowerStepMCs,
+                                                 bool isCrystal, int volId, const SimPtr& sim,
+                                                 StepIter first, StepIter last, ShowerStepUtil& buffer)
+  {
+    for (StepIter istep = first; istep != last; ++istep)
       {
+        const StepPointMC* step = stepOf(*istep);
         CLHEP::Hep3Vector pos  = (isCrystal) ?
           cal.geomUtil().mu2eToCrystal(volId,step->position()) : cal.geomUtil().mu2eToCrystal(cal.caloInfo().crystalByRO(volId),step->position());
         int               idx  = (isCrystal) ? int(std::max(1e-6,pos.z())/zSliceSize_) : 0;
@@ -509,6 +846,7 @@ namespace mu2e {
 
             if (diagLevel_ > 3) {std::cout<<"[CaloShowerStepFromStepPt::compressSteps] inserted     ";  buffer.printBucket(i);}
           }
+        buffer.reset(i);
       }
   }
 
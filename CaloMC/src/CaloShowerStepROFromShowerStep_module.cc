@@ -27,6 +27,7 @@
 #include "MCDataProducts/inc/CaloShowerStepCollection.hh"
 #include "MCDataProducts/inc/CaloShowerStepROCollection.hh"
 #include "MCDataProducts/inc/CaloShowerSimCollection.hh"
+#include "MCDataProducts/inc/StepTimeIndex.hh"
 #include "Mu2eUtilities/inc/SimParticleTimeOffset.hh"
 #include "SeedService/inc/SeedService.hh"
 
@@ -43,6 +44,8 @@
 #include <map>
 #include <vector>
 #include <utility>
+#include <numeric>
+#include <algorithm>
 
 
 // Anonymous namespace to hold some helper classes.
@@ -110,6 +113,7 @@ namespace mu2e {
       fhicl::Sequence<art::InputTag> caloCrystalShowerInputs{ Name("caloCrystalShowerInputs"), Comment("Compressed shower inputs for calo crystals") };
 
       fhicl::Table<SimParticleTimeOffset::Config> timeOffsets{ Name("TimeOffsets"), Comment("Time maps to apply to sim particles before digitization.") };
+      fhicl::Atom<std::string> timeIndex{ Name("timeIndex"), Comment("StepTimeIndexCollection of the shower inputs. If set, only the steps that can fold into the live window are processed"), "" };
 
       fhicl::Atom<double> blindTime{ Name("blindTime"), Comment("Time cut on digis? Or something related to that.") };
       fhicl::Atom<bool>   caloLRUCorrection{ Name("caloLRUCorrection") };
@@ -124,6 +128,7 @@ namespace mu2e {
     explicit CaloShowerStepROFromShowerStep(const Parameters& config) :
       EDProducer{config},
       toff_                       (config().timeOffsets()),
+      timeIndexTag_               (config().timeIndex()),
       blindTime_                  (config().blindTime()),
       caloLRUCorrection_          (config().caloLRUCorrection()),
       caloBirksCorrection_        (config().caloBirksCorrection()),
@@ -144,6 +149,7 @@ namespace mu2e {
       for (auto const& tag : config().timeOffsets().inputs()) {
         consumes<SimParticleTimeMap>(tag);
       }
+      if (!timeIndexTag_.label().empty()) consumes<StepTimeIndexCollection>(timeIndexTag_);
 
       produces<CaloShowerStepROCollection>();
       produces<CaloShowerSimCollection>();
@@ -159,6 +165,8 @@ namespace mu2e {
     std::vector<art::ProductToken<CaloShowerStepCollection>> caloCrystalShowerTokens_;
 
     SimParticleTimeOffset   toff_;
+    art::InputTag           timeIndexTag_;
+    std::vector<unsigned>   selectedSteps_;
     double                  blindTime_;
     double                  mbtime_;
 
@@ -181,7 +189,8 @@ namespace mu2e {
     TH2F*                   hPECorr_;
     TH1F*                   hPECorr2_;
 
-    void   makeReadoutHits(const StepHandles&, CaloShowerStepROCollection&, CaloShowerSimCollection&);
+    void   makeReadoutHits(const StepHandles&, const StepTimeIndexCollection*, CaloShowerStepROCollection&, CaloShowerSimCollection&);
+    void   selectSteps(const StepTimeIndex&, std::vector<unsigned>&) const;
     double LRUCorrection(int crystalID, double normalizedPosZ, double edepInit, const ConditionsHandle<CalorimeterCalibrations>&);
     double BirksCorrection(int particleCode, double edepInit, const ConditionsHandle<CalorimeterCalibrations>&);
     double photoStatisticsCorrection(int crystalID, double edepInit, double NpePerMeV);
@@ -219,7 +228,10 @@ namespace mu2e {
     cet::transform_all(caloCrystalShowerTokens_,
                        back_inserter(hh),
                        [&event](auto const& token) { return event.getValidHandle(token); });
-    makeReadoutHits(hh, *caloShowerStepROs, *caloShowerSims);
+    const StepTimeIndexCollection* timeIndices = nullptr;
+    if (!timeIndexTag_.label().empty()) timeIndices = event.getValidHandle<StepTimeIndexCollection>(timeIndexTag_).product();
+
+    makeReadoutHits(hh, timeIndices, *caloShowerStepROs, *caloShowerSims);
 
     // Add the output hit collection to the event
     event.put(std::move(caloShowerStepROs));
@@ -231,7 +243,7 @@ namespace mu2e {
 
 
   //-------------------------------------------------------------------------------------------------------------------------------------
-  void CaloShowerStepROFromShowerStep::makeReadoutHits(const StepHandles& crystalShowerHandles,
+  void CaloShowerStepROFromShowerStep::makeReadoutHits(const StepHandles& crystalShowerHandles, const StepTimeIndexCollection* timeIndices,
                                                        CaloShowerStepROCollection& caloShowerStepROs, CaloShowerSimCollection& caloShowerSims)
   {
 
@@ -257,17 +269,28 @@ namespace mu2e {
 
       const CaloShowerStepCollection& caloShowerSteps(*showerHandle);
 
-      for (auto istep = caloShowerSteps.begin(); istep !=caloShowerSteps.end(); ++istep)
+      // steps to process, in collection order: all of them, or those the time index puts in the live window
+      const StepTimeIndex* timeIndex = nullptr;
+      if (timeIndices)
+        for (const auto& index : *timeIndices) if (index.steps() == showerHandle.id()) timeIndex = &index;
+
+      if (timeIndex) selectSteps(*timeIndex, selectedSteps_);
+      else
         {
-          const CaloShowerStep& step = *istep;
+          selectedSteps_.resize(caloShowerSteps.size());
+          std::iota(selectedSteps_.begin(), selectedSteps_.end(), 0u);
+        }
+
+      for (size_t idx : selectedSteps_)
+        {
+          const CaloShowerStep& step = caloShowerSteps[idx];
 
           // time folding and filtering, see docdb-3425 for a stunning explanation
-          double hitTimeUnfolded = toff_.totalTimeOffset(istep->simParticle())+istep->timeStepMC();
+          double hitTimeUnfolded = toff_.totalTimeOffset(step.simParticle())+step.timeStepMC();
           double hitTime         = fmod(hitTimeUnfolded,mbtime_);
 
           if (hitTime < blindTime_ || hitTime > mbtime_ ) continue;
 
-          size_t idx = std::distance(caloShowerSteps.begin(), istep);
           art::Ptr<CaloShowerStep> stepPtr = art::Ptr<CaloShowerStep>(showerHandle,idx);
 
           int    crystalID = step.volumeId();
@@ -392,6 +415,19 @@ namespace mu2e {
   }
 
 
+  //----------------------------------------------------------------------------------------------------------------------------------
+  // select the steps whose offset time can fold into [blindTime, mbtime], sorted in collection order so that
+  // the random sequence, and hence the output, is the same as when looping over all steps
+  void CaloShowerStepROFromShowerStep::selectSteps(const StepTimeIndex& timeIndex, std::vector<unsigned>& selected) const
+  {
+    selected.clear();
+    for (const auto& group : timeIndex.groups())
+      timeIndex.select(group, toff_.totalTimeOffset(group._primary), blindTime_, mbtime_, mbtime_, selected);
+
+    std::sort(selected.begin(), selected.end());
+  }
+
+
   //----------------------------------------------------------------------------------------------------------------------------------
   // apply a correction of type Energy = ((1-s)*Z/HL+s)*energy where Z position along the crystal, HL is the crystal half-length
   // and s is the intercept at Z=0 (i.e. non-uniformity factor, e.g. 5% -> s = 1.05)
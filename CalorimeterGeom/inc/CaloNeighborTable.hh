@@ -0,0 +1,71 @@
+#ifndef CalorimeterGeom_CaloNeighborTable_hh
+#define CalorimeterGeom_CaloNeighborTable_hh
+//
+// Flat table of the crystal neighbors, filled once when the calorimeter is built.
+//
+// The neighbors of all crystals are stored in a single array, the first and second
+// rings of crystal i being contiguous:
+//
+//    indices_[ offsets_[2i]   ... offsets_[2i+1] [   neighbors      (level 1)
+//    indices_[ offsets_[2i+1] ... offsets_[2i+2] [   next neighbors (level 2)
+//
+// so the neighbors up to a given level are a single range, and the clustering can
+// loop over them without copying the vectors held by each crystal. The ranges are
+// only valid as long as the calorimeter is. neighborsUpTo accepts level 1 or 2.
+//
+
+#include <cstddef>
+#include <vector>
+
+
+namespace mu2e {
+
+    class CaloNeighborTable {
+
+        public:
+
+           class Range {
+              public:
+                 Range(const int* first, const int* last) : first_(first), last_(last) {}
+
+                 const int* begin()          const {return first_;}
+                 const int* end()            const {return last_;}
+                 std::size_t size()          const {return last_-first_;}
+                 bool       empty()          const {return first_==last_;}
+                 int        operator[](int i) const {return first_[i];}
+
+              private:
+                 const int* first_;
+                 const int* last_;
+           };
+
+
+           CaloNeighborTable() : offsets_(1,0), indices_() {}
+
+           int   nCrystal()                                const {return (offsets_.size()-1)/2;}
+
+           Range neighbors(int crystalId)                  const {return range(2*crystalId,  2*crystalId+1);}
+           Range nextNeighbors(int crystalId)              const {return range(2*crystalId+1,2*crystalId+2);}
+           Range neighborsUpTo(int crystalId, int level)   const {return range(2*crystalId,  2*crystalId+level);}
+
+           // crystals must be added in the order of their global id
+           void add(const std::vector<int>& neighbors, const std::vector<int>& nextNeighbors)
+           {
+               indices_.insert(indices_.end(), neighbors.begin(), neighbors.end());
+               offsets_.push_back(indices_.size());
+               indices_.insert(indices_.end(), nextNeighbors.begin(), nextNeighbors.end());
+               offsets_.push_back(indices_.size());
+           }
+
+
+        private:
+
+           Range range(int i0, int i1) const {return Range(indices_.data()+offsets_.at(i0), indices_.data()+offsets_.at(i1));}
+
+           std::vector<int> offsets_;
+           std::vector<int> indices_;
+    };
+
+}
+
+#endif
@@ -11,6 +11,7 @@
 #include "CalorimeterGeom/inc/CaloGeomUtil.hh"
 #include "CalorimeterGeom/inc/Disk.hh"
 #include "CalorimeterGeom/inc/Crystal.hh"
+#include "CalorimeterGeom/inc/CaloNeighborTable.hh"
 
 #include "CLHEP/Vector/ThreeVector.h"
 #include <vector>
@@ -48,6 +49,7 @@ namespace mu2e {
            virtual       std::vector<int>   neighborsByLevel(int crystalId, int level, bool rawMap = false) const = 0; 
            virtual int                      crystalIdxFromPosition(const CLHEP::Hep3Vector& pos)            const = 0;
            virtual int                      nearestIdxFromPosition(const CLHEP::Hep3Vector& pos)            const = 0;
+           virtual const CaloNeighborTable& neighborTable(bool rawMap=false)                                const = 0;
 
            // get to know me!
            virtual void                     print(std::ostream &os = std::cout)  const = 0;
@@ -28,6 +28,8 @@ namespace mu2e {
 	   virtual CLHEP::Hep2Vector  xyFromIndex(int thisIndex)                       const = 0;
            virtual int                indexFromXY(double x, double y)                  const = 0;
            virtual int                indexFromRowCol(int nRow, int nCol)              const = 0;
+           virtual void               rowColFromXY(double x, double y, 
+                                                   int& nRow, int& nCol)               const = 0; //indexFromRowCol(nRow,nCol) == indexFromXY(x,y)
            virtual bool               isInsideCrystal(double x, double y,  
                                                       const CLHEP::Hep3Vector& pos, 
                                                       const CLHEP::Hep3Vector& size)   const = 0; 
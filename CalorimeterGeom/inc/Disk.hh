@@ -56,6 +56,7 @@ namespace mu2e {
        
            void                            fillCrystalsIdeal(const CLHEP::Hep3Vector &crystalOriginInDisk);
            void                            fillCrystals(const CLHEP::Hep3Vector &crystalOriginInDisk);
+           void                            fillPositionGrid();
            bool                            isInsideDisk(double x, double y, double widthX, double widthY) const;
            bool                            isInsideCrystal(int icry, double x, double y) const;
            void                            checkCrystalSize();
@@ -72,6 +73,9 @@ namespace mu2e {
        	   std::shared_ptr<CrystalMapper>  crystalMap_;
            std::vector<int>                mapToCrystal_;
 	   std::vector<int>                crystalToMap_;
+           int                             gridRowMax_;
+           int                             gridColMax_;
+           std::vector<int>                positionGrid_;  //crystal id for each (row,col) of the mapper, -1 if none
 
    };
 
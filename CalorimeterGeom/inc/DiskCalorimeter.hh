@@ -13,6 +13,7 @@
 #include "CalorimeterGeom/inc/CaloGeomUtil.hh"
 #include "CalorimeterGeom/inc/Disk.hh"
 #include "CalorimeterGeom/inc/Crystal.hh"
+#include "CalorimeterGeom/inc/CaloNeighborTable.hh"
 
 #include "CLHEP/Vector/ThreeVector.h"
 
@@ -61,6 +62,7 @@ namespace mu2e {
             virtual       std::vector<int>   neighborsByLevel(int crystalId, int level, bool rawMap) const; 
             virtual int                      crystalIdxFromPosition(const CLHEP::Hep3Vector& pos) const;
             virtual int                      nearestIdxFromPosition(const CLHEP::Hep3Vector& pos) const; 
+            virtual const CaloNeighborTable& neighborTable(bool rawMap) const  {return rawMap ? neighborTableRaw_ : neighborTable_;}
 
 
             // get to know me!
@@ -81,6 +83,8 @@ namespace mu2e {
 	    std::vector<DiskPtr>          disks_;
             
 	    std::vector<const Crystal*>   fullCrystalList_; //non-owning crystal pointers
+            CaloNeighborTable             neighborTable_;   //flat copy of the crystal neighbors
+            CaloNeighborTable             neighborTableRaw_;
             CaloInfo                      caloInfo_;
 	    CaloGeomUtil                  geomUtil_;
      };
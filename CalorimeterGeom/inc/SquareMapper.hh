@@ -38,6 +38,7 @@ namespace mu2e {
 	    virtual CLHEP::Hep2Vector xyFromIndex(int thisIndex)          const;
             virtual int               indexFromXY(double x, double y)     const;
             virtual int               indexFromRowCol(int nRow, int nCol) const;
+            virtual void              rowColFromXY(double x, double y, int& nRow, int& nCol) const;
             virtual bool              isInsideCrystal(double x, double y, 
                                                       const CLHEP::Hep3Vector& pos, 
                                                       const CLHEP::Hep3Vector& size) const; 
@@ -34,13 +34,17 @@ namespace mu2e {
 	nominalCellSize_(nominalCellSize),
         globalCrystalOffset_(offset),
 	mapToCrystal_(),
-	crystalToMap_()
+	crystalToMap_(),
+        gridRowMax_(0),
+        gridColMax_(0),
+        positionGrid_()
       { 
 	   geomInfo_.originToCrystalOrigin(diskOriginToCrystalOrigin);           
            crystalMap_ = std::shared_ptr<CrystalMapper>(new SquareShiftMapper());
 
 	   fillCrystalsIdeal(diskOriginToCrystalOrigin); //See note in DiskCalorimeterMaker
 	   //fillCrystals(diskOriginToCrystalOrigin); //See note in DiskCalorimeterMaker
+           fillPositionGrid();
       }
       
 
@@ -115,6 +119,28 @@ namespace mu2e {
 
 
 
+      //-----------------------------------------------------------------------------
+      // direct lookup table (row,col) -> crystal id covering the disk, used by idxFromPosition 
+      // instead of going through the mapper index. Positions outside the grid have no crystal.
+      void Disk::fillPositionGrid()
+      {   
+          gridRowMax_ = int(radiusOut_/nominalCellSize_)+2;
+          gridColMax_ = gridRowMax_+1;
+          int nCol    = 2*gridColMax_+1;
+          
+          positionGrid_.assign((2*gridRowMax_+1)*nCol, -1);
+          for (int row=-gridRowMax_;row<=gridRowMax_;++row)
+          {
+              for (int col=-gridColMax_;col<=gridColMax_;++col)
+              {
+                  unsigned mapIdx = crystalMap_->indexFromRowCol(row,col);
+                  if (mapIdx < mapToCrystal_.size()) positionGrid_[(row+gridRowMax_)*nCol + col+gridColMax_] = mapToCrystal_[mapIdx];
+              }
+          }
+      }
+
+
+
       //-----------------------------------------------------------------------------
       bool Disk::isInsideDisk(double x, double y, double widthX, double widthY) const
       {    	 	 
@@ -201,9 +227,10 @@ namespace mu2e {
       //-----------------------------------------------------------------------------
       int Disk::idxFromPosition(double x, double y) const 
       {
-          unsigned int mapIdx = crystalMap_->indexFromXY(x/nominalCellSize_,y/nominalCellSize_);
-          if (mapIdx < mapToCrystal_.size() ) return mapToCrystal_.at(mapIdx);
- 	  return -1;
+          int row,col;
+          crystalMap_->rowColFromXY(x/nominalCellSize_,y/nominalCellSize_,row,col);
+          if (std::abs(row) > gridRowMax_ || std::abs(col) > gridColMax_) return -1;
+          return positionGrid_[(row+gridRowMax_)*(2*gridColMax_+1) + col+gridColMax_];
 
           /*
           unsigned int mapIdx = crystalMap_->indexFromXY(x/nominalCellSize_,y/nominalCellSize_);          
@@ -90,6 +90,14 @@ namespace mu2e {
 	  return index(lk);
       }
 
+      void SquareMapper::rowColFromXY(double x0, double y0, int& nRow, int& nCol) const
+      {
+          nCol = int( std::abs(x0)+0.5);
+          nRow = int( std::abs(y0)+0.5 );
+	  if (x0<0) nCol *= -1;
+	  if (y0<0) nRow *= -1;
+      }
+
       
       //--------------------------------------------------------------------------------
       bool SquareMapper::isInsideCrystal(double x, double y, const CLHEP::Hep3Vector& pos, 
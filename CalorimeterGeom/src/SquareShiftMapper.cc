@@ -108,6 +108,18 @@ namespace mu2e {
 	  return index(lk);
       }
 
+      // same rounding as indexFromXY; odd rows are shifted by half a crystal, and nRow/2 
+      // rounds towards zero in indexFromRowCol, hence the extra column for odd positive rows
+      void SquareShiftMapper::rowColFromXY(double x0, double y0, int& nRow, int& nCol) const
+      {
+	  nRow = (y0>0) ? int(std::abs(y0)+0.5) : -int(std::abs(y0)+0.5);
+
+	  if (nRow%2==0) nCol = (x0>0) ? int(std::abs(x0)+0.5) : -int(std::abs(x0)+0.5);
+	  else           nCol = (x0>0) ? int(std::abs(x0)) : (-int(std::abs(x0))-1);
+
+	  if (nRow%2!=0 && nRow>0) ++nCol;
+      }
+
 
       //--------------------------------------------------------------------------------
       bool SquareShiftMapper::isInsideCrystal(double x, double y, const CLHEP::Hep3Vector& pos, 
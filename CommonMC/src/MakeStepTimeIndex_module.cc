@@ -0,0 +1,142 @@
+// Build time indices of the mixed StrawGasStep and CaloShowerStep collections:
+// for each input collection the steps are grouped by their primary SimParticle
+// and sorted by time (see MCDataProducts/inc/StepTimeIndex.hh).  The
+// digitizers use them to go directly to the steps that can fold into their
+// live window.  The indices only depend on the step collections, not on the
+// per-event time offsets, so this module can run as soon as the steps exist.
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "messagefacility/MessageLogger/MessageLogger.h"
+#include "canvas/Persistency/Common/Ptr.h"
+#include "canvas/Utilities/InputTag.h"
+#include "fhiclcpp/types/Atom.h"
+#include "fhiclcpp/types/Sequence.h"
+#include "art/Framework/Core/EDProducer.h"
+#include "art/Framework/Core/ModuleMacros.h"
+#include "art/Framework/Principal/Event.h"
+#include "art/Framework/Principal/Handle.h"
+
+#include "MCDataProducts/inc/SimParticle.hh"
+#include "MCDataProducts/inc/StrawGasStep.hh"
+#include "MCDataProducts/inc/CaloShowerStepCollection.hh"
+#include "MCDataProducts/inc/StepTimeIndex.hh"
+
+namespace mu2e {
+
+  namespace {
+    double stepTime(StrawGasStep const& step) { return step.time(); }
+    double stepTime(CaloShowerStep const& step) { return step.timeStepMC(); }
+  }
+
+  class MakeStepTimeIndex : public art::EDProducer {
+  public:
+
+    struct Config {
+      using Name=fhicl::Name;
+      using Comment=fhicl::Comment;
+
+      fhicl::Sequence<art::InputTag> strawGasSteps{ Name("StrawGasSteps"),
+          Comment("StrawGasStep collections to index, output instance \"tracker\""),
+          std::vector<art::InputTag>() };
+
+      fhicl::Sequence<art::InputTag> caloShowerSteps{ Name("CaloShowerSteps"),
+          Comment("CaloShowerStep collections to index, output instance \"calorimeter\""),
+          std::vector<art::InputTag>() };
+
+      fhicl::Atom<int> diagLevel{ Name("diagLevel"), Comment("Diagnostic printout level"), 0 };
+    };
+
+    using Parameters = art::EDProducer::Table<Config>;
+    explicit MakeStepTimeIndex(const Parameters& conf);
+
+    void produce(art::Event& event) override;
+
+  private:
+    std::vector<art::InputTag> sgsTags_;
+    std::vector<art::InputTag> cssTags_;
+    int diagLevel_;
+
+    template<class STEPS>
+    void indexSteps(art::Event const& event, art::InputTag const& tag, StepTimeIndexCollection& index) const;
+  };
+
+  //================================================================
+  MakeStepTimeIndex::MakeStepTimeIndex(const Parameters& conf)
+    : art::EDProducer{conf}
+    , sgsTags_(conf().strawGasSteps())
+    , cssTags_(conf().caloShowerSteps())
+    , diagLevel_(conf().diagLevel())
+  {
+    for(auto const& tag : sgsTags_) consumes<StrawGasStepCollection>(tag);
+    for(auto const& tag : cssTags_) consumes<CaloShowerStepCollection>(tag);
+    produces<StepTimeIndexCollection>("tracker");
+    produces<StepTimeIndexCollection>("calorimeter");
+  }
+
+  //================================================================
+  void MakeStepTimeIndex::produce(art::Event& event) {
+    auto sgsIndex = std::make_unique<StepTimeIndexCollection>();
+    for(auto const& tag : sgsTags_) indexSteps<StrawGasStepCollection>(event, tag, *sgsIndex);
+
+    auto cssIndex = std::make_unique<StepTimeIndexCollection>();
+    for(auto const& tag : cssTags_) indexSteps<CaloShowerStepCollection>(event, tag, *cssIndex);
+
+    event.put(std::move(sgsIndex), "tracker");
+    event.put(std::move(cssIndex), "calorimeter");
+  }
+
+  //================================================================
+  template<class STEPS>
+  void MakeStepTimeIndex::indexSteps(art::Event const& event, art::InputTag const& tag, StepTimeIndexCollection& index) const {
+    auto sh = event.getValidHandle<STEPS>(tag);
+    STEPS const& steps = *sh;
+
+    // group of each SimParticle seen so far, and of each primary
+    std::map<art::Ptr<SimParticle>, size_t> particleGroup;
+    std::map<art::Ptr<SimParticle>, size_t> primaryGroup;
+    std::vector<art::Ptr<SimParticle> > primaries;
+    std::vector<std::vector<StepTimeIndex::Entry> > groups;
+
+    art::Ptr<SimParticle> lastParticle;
+    size_t lastGroup(0);
+    for(size_t istep = 0; istep < steps.size(); ++istep) {
+      auto const& step = steps[istep];
+      auto const& sim = step.simParticle();
+      // consecutive steps usually come from the same particle
+      if(istep == 0 || sim != lastParticle) {
+        auto ip = particleGroup.find(sim);
+        if(ip == particleGroup.end()) {
+          auto primary = sim;
+          while(primary->parent()) primary = primary->parent();
+          auto ig = primaryGroup.find(primary);
+          if(ig == primaryGroup.end()) {
+            ig = primaryGroup.emplace(primary, groups.size()).first;
+            primaries.push_back(primary);
+            groups.emplace_back();
+          }
+          ip = particleGroup.emplace(sim, ig->second).first;
+        }
+        lastParticle = sim;
+        lastGroup = ip->second;
+      }
+      groups[lastGroup].emplace_back(stepTime(step), istep);
+    }
+
+    StepTimeIndex sti(sh.id());
+    for(size_t ig = 0; ig < groups.size(); ++ig) {
+      sti.addGroup(primaries[ig], groups[ig]);
+    }
+    if(diagLevel_ > 0) {
+      mf::LogInfo("StepTimeIndex") << "MakeStepTimeIndex: " << tag << " " << steps.size()
+                                   << " steps in " << groups.size() << " groups";
+    }
+    index.push_back(std::move(sti));
+  }
+
+}
+
+DEFINE_ART_MODULE(mu2e::MakeStepTimeIndex);
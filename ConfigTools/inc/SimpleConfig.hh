@@ -63,11 +63,18 @@ namespace mu2e {
      * messageOnDefault     - Print a message when a parameter is not found in the file
      *                        and takes on a default value.
      *
+     * snapshotFile         - If not empty, a binary snapshot written by writeSnapshot.
+     *                        It is used instead of parsing the input file if it was made
+     *                        from the same file with the same allowReplacement policy
+     *                        and none of the files it was made from has changed.
+     *                        Otherwise the input file is parsed as usual.
+     *
      */
     SimpleConfig( const std::string& filename = "runtime.conf",
                   bool allowReplacement       = true,
                   bool messageOnReplacement   = false,
-                  bool messageOnDefault       = false );
+                  bool messageOnDefault       = false,
+                  const std::string& snapshotFile = "" );
 
     ~SimpleConfig(){}
 
@@ -316,6 +323,23 @@ namespace mu2e {
     // count of input file lines, available after construction
     std::size_t inputFileLines() const {return _inputFileLines;}
 
+    // the input file and all of the files it includes, as given in the include lines
+    std::vector<std::string> const& sourceFiles() const {return _sourceFiles;}
+
+    /**
+     * Write the parsed configuration to a binary snapshot that can be given to
+     * the constructor; see SimpleConfigSnapshot.
+     *
+     * @return
+     */
+    void writeSnapshot( const std::string& filename ) const;
+
+    // true if this object was filled from a snapshot rather than by parsing
+    bool fromSnapshot() const { return _fromSnapshot; }
+
+    // time taken to parse the input files or to load the snapshot, in ms
+    double loadTime() const { return _loadTime; }
+
     /**
      * Print access counts for each record.
      *
@@ -367,6 +391,11 @@ namespace mu2e {
     std::size_t _inputFileHash;
     // count of input lines
     std::size_t _inputFileLines;
+    // input file and included files, in the order in which they were opened
+    std::vector<std::string> _sourceFiles;
+    // how the configuration was loaded and how long it took (ms)
+    bool   _fromSnapshot;
+    double _loadTime;
 
     // If a parameter is repeated in the input file, one two things can happen:
     // true  - the latest value over writes the previous value.
@@ -398,6 +427,9 @@ namespace mu2e {
     // each was requested.
     mutable DefaultCounter_type _defaultCounter;
 
+    // Writes and reads the records to and from a binary snapshot.
+    friend class SimpleConfigSnapshot;
+
     // Private methods.
 
     /**
@@ -431,6 +463,12 @@ namespace mu2e {
      */
     void ReadFile();
 
+    /**
+     * Form the map from names to records from the image.
+     *
+     */
+    void FillMap();
+
     /**
      * Test to see if a record is complete.
      *
@@ -13,6 +13,7 @@
 //
 
 // C++ includes
+#include <chrono>
 #include <fstream>
 #include <sstream>
 #include <iomanip>
@@ -28,6 +29,7 @@
 #include "ConfigTools/inc/ConfigFileLookupPolicy.hh"
 #include "ConfigTools/inc/SimpleConfig.hh"
 #include "ConfigTools/src/SimpleConfigRecord.hh"
+#include "ConfigTools/src/SimpleConfigSnapshot.hh"
 #include "GeneralUtilities/inc/trimInPlace.hh"
 
 using namespace std;
@@ -46,17 +48,45 @@ namespace mu2e {
   SimpleConfig::SimpleConfig( const string& filename,
                               bool allowReplacement,
                               bool messageOnReplacement,
-                              bool messageOnDefault):
+                              bool messageOnDefault,
+                              const string& snapshotFile):
     _inputFileString(filename),
     _inputFileHash(0),
     _inputFileLines(0),
+    _fromSnapshot(false),
+    _loadTime(0.),
     _allowReplacement(allowReplacement),
     _messageOnReplacement(messageOnReplacement),
     _messageOnDefault(messageOnDefault)     {
 
+    auto t0 = std::chrono::steady_clock::now();
+
     ConfigFileLookupPolicy configFile;
     _inputfile = configFile(filename);
-    ReadFile();
+
+    if ( !snapshotFile.empty() ){
+      string reason;
+      _fromSnapshot = SimpleConfigSnapshot::read( *this, snapshotFile, reason );
+      if ( !_fromSnapshot ){
+        mf::LogInfo("GEOM")
+          << "SimpleConfig: not using snapshot " << snapshotFile
+          << ": " << reason << "; parsing " << _inputfile;
+        _inputFileHash  = 0;
+        _inputFileLines = 0;
+        _sourceFiles.clear();
+        _image.clear();
+      }
+    }
+
+    if ( !_fromSnapshot ){
+      ReadFile();
+    }
+
+    _loadTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+  }
+
+  void SimpleConfig::writeSnapshot( const string& filename ) const{
+    SimpleConfigSnapshot::write( *this, filename );
   }
 
   /**
@@ -559,6 +589,7 @@ namespace mu2e {
         << _inputfile
         << endl;
     }
+    _sourceFiles.push_back(_inputFileString);
 
     string line;
     while ( in ){
@@ -622,6 +653,14 @@ namespace mu2e {
     }
 
     // Form the map after the image has been made.
+    FillMap();
+  }
+
+  /**
+   * Form the map from names to records from the image, applying the replacement policy.
+   *
+   */
+  void SimpleConfig::FillMap(){
 
     // Loop over all records in the image.
     Image_type::const_iterator b0 = _image.begin();
@@ -796,6 +835,7 @@ namespace mu2e {
     // collect contribution to the hash
     boost::hash_combine<std::size_t>(_inputFileHash,nestedFile.inputFileHash());
     _inputFileLines += nestedFile.inputFileLines();
+    _sourceFiles.insert(_sourceFiles.end(),nestedFile._sourceFiles.begin(),nestedFile._sourceFiles.end());
 
     // Copy the contents of the included file into this one.
     for ( Image_type::const_iterator i=nestedFile._image.begin();
@@ -846,6 +886,8 @@ namespace mu2e {
     std::cout << tag << " file: "<< _inputfile << std::endl;
     std::cout << tag << " lines: "<< _inputFileLines 
 	      <<"  hash: " << _inputFileHash << std::endl;
+    std::cout << tag << ( _fromSnapshot ? " loaded from snapshot in " : " parsed in " )
+              << _loadTime << " ms" << std::endl;
   }
 
   void SimpleConfig::printStatisticsByType ( std::ostream& ost, std::string tag ) const{
@@ -39,11 +39,21 @@ namespace mu2e {
   // Constructor.
   SimpleConfigRecord::SimpleConfigRecord( const string& record_a ):
     record(record_a),
+    _converted(false),
     _accessCount(0),
     _isCommentOrBlank(false),
     _isVector(false),
     _superceded(false){
     Parse();
+    Convert();
+  }
+
+  SimpleConfigRecord::SimpleConfigRecord():
+    _converted(false),
+    _accessCount(0),
+    _isCommentOrBlank(false),
+    _isVector(false),
+    _superceded(false){
   }
 
   // Accessors to return supported data types.
@@ -59,6 +69,7 @@ namespace mu2e {
       ++_accessCount;
     }
     CheckType("int");
+    if ( _converted ) return static_cast<int>(_numbers.at(0));
     return toInt( Values.at(0) );
   }
 
@@ -67,6 +78,7 @@ namespace mu2e {
       ++_accessCount;
     }
     CheckType("double");
+    if ( _converted ) return _numbers.at(0);
     return toDouble( Values.at(0) );
   }
 
@@ -75,6 +87,7 @@ namespace mu2e {
       ++_accessCount;
     }
     CheckType("bool");
+    if ( _converted ) return _numbers.at(0) != 0.;
     return toBool( Values.at(0) );
   }
 
@@ -93,6 +106,12 @@ namespace mu2e {
       ++_accessCount;
     }
     CheckType("vector<int>");
+    if ( _converted ){
+      for ( double d : _numbers ){
+        v.push_back(static_cast<int>(d));
+      }
+      return;
+    }
     vector<string>::const_iterator b = Values.begin();
     vector<string>::const_iterator e = Values.end();
     for ( ; b!=e; ++b ){
@@ -108,6 +127,10 @@ namespace mu2e {
       ++_accessCount;
     }
     CheckType("vector<double>");
+    if ( _converted ){
+      V.insert(V.end(), _numbers.begin(), _numbers.end());
+      return;
+    }
     vector<string>::const_iterator b = Values.begin();
     vector<string>::const_iterator e = Values.end();
     for ( ;b!=e; ++b ){
@@ -268,6 +291,28 @@ namespace mu2e {
   }
 
 
+  // Convert the values once so that the accessors do not parse strings on every call.
+  // A value that does not convert is left for the accessors to report, so that a
+  // bad record only throws if it is used, as before.
+  void SimpleConfigRecord::Convert () {
+    if ( _isCommentOrBlank ) return;
+    try {
+      if ( Type == "int" || Type == "vector<int>" ){
+        for ( auto const& val : Values ) _numbers.push_back( toInt(val) );
+      } else if ( Type == "double" || Type == "vector<double>" ){
+        for ( auto const& val : Values ) _numbers.push_back( toDouble(val) );
+      } else if ( Type == "bool" ){
+        _numbers.push_back( toBool(Values.at(0)) ? 1. : 0. );
+      } else {
+        return;
+      }
+      _converted = true;
+    }
+    catch ( cet::exception& ){
+      _numbers.clear();
+    }
+  }
+
   /**
    *
    * Split this record into 3 fields: Type Name = Value;
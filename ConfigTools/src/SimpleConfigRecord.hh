@@ -34,6 +34,9 @@ namespace mu2e {
 
 class SimpleConfigRecord {
 
+  // Writes and reads the parsed records to and from a binary snapshot.
+  friend class SimpleConfigSnapshot;
+
  public:
 
   // Constructor.
@@ -203,6 +206,12 @@ private:
   // The value field, parsed into components.
   std::vector<std::string> Values;
 
+  // For int, double and bool records, scalar or vector, the values converted
+  // once at construction; not filled if any of them fails to convert, in which
+  // case the accessors convert, and throw, on each call as before.
+  std::vector<double> _numbers;
+  bool _converted;
+
   // State data.
   mutable int _accessCount;
   bool _isCommentOrBlank;
@@ -211,6 +220,9 @@ private:
 
   //  Private methods.
 
+  // Used by SimpleConfigSnapshot, which fills all of the data members.
+  SimpleConfigRecord();
+
   /**
    *
    * Parse this record, starting from its input string.
@@ -218,6 +230,13 @@ private:
    */
   void Parse ();
 
+  /**
+   *
+   * Convert the values of numeric and bool records, filling _numbers.
+   *
+   */
+  void Convert ();
+
   /**
    *
    * Split this record into 3 fields: Type Name = Value;
@@ -0,0 +1,301 @@
+//
+// Binary snapshot of a parsed SimpleConfig.
+// See ConfigTools/src/SimpleConfigSnapshot.hh for the layout.
+//
+
+// C++ includes
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <sstream>
+#include <vector>
+
+// Framework includes
+#include "cetlib_except/exception.h"
+
+// Mu2e includes
+#include "ConfigTools/inc/ConfigFileLookupPolicy.hh"
+#include "ConfigTools/inc/SimpleConfig.hh"
+#include "ConfigTools/src/SimpleConfigRecord.hh"
+#include "ConfigTools/src/SimpleConfigSnapshot.hh"
+
+using namespace std;
+
+namespace mu2e {
+
+  namespace {
+
+    const char          magic[8]  = { 'M','U','2','E','S','C','F','G' };
+    const std::uint32_t byteOrder = 0x01020304;
+
+    // Bits of the per-record flags.
+    enum RecordFlags { commentOrBlank = 1, isVector = 2, superceded = 4, converted = 8 };
+
+    // Output helpers.
+    template <class T>
+    void put( ostream& os, T const& t ){
+      os.write( reinterpret_cast<const char*>(&t), sizeof(T) );
+    }
+
+    void putString( ostream& os, string const& s ){
+      put( os, std::uint32_t(s.size()) );
+      os.write( s.data(), s.size() );
+    }
+
+    // Input from the snapshot held in memory; any overrun marks the input as bad.
+    struct Input {
+      const char* p;
+      const char* end;
+      bool ok;
+
+      Input( string const& buf ): p(buf.data()), end(buf.data()+buf.size()), ok(true){}
+
+      template <class T>
+      T get(){
+        T t{};
+        if ( ok && size_t(end-p) >= sizeof(T) ){
+          std::memcpy( &t, p, sizeof(T) );
+          p += sizeof(T);
+        } else {
+          ok = false;
+        }
+        return t;
+      }
+
+      // A count of items, each at least minSize bytes long.
+      std::uint32_t getCount( size_t minSize ){
+        std::uint32_t n = get<std::uint32_t>();
+        if ( !ok || size_t(end-p) < n*minSize ){
+          ok = false;
+          return 0;
+        }
+        return n;
+      }
+
+      string getString(){
+        std::uint32_t n = get<std::uint32_t>();
+        if ( !ok || size_t(end-p) < n ){
+          ok = false;
+          return string();
+        }
+        string s(p,n);
+        p += n;
+        return s;
+      }
+    };
+
+    // Index of a string in the table, adding it if needed.
+    std::uint32_t intern( string const& s,
+                          map<string,std::uint32_t>& index,
+                          vector<string>& table ){
+      auto i = index.find(s);
+      if ( i != index.end() ) return i->second;
+      std::uint32_t n = table.size();
+      index[s] = n;
+      table.push_back(s);
+      return n;
+    }
+
+  } // end anonymous namespace
+
+  const std::uint32_t SimpleConfigSnapshot::version;
+
+  // 64 bit FNV-1a hash of the file contents.
+  std::uint64_t SimpleConfigSnapshot::contentHash( const string& filename ){
+    ifstream in( filename.c_str(), ios::binary );
+    if ( !in ) return 0;
+    std::uint64_t hash = 14695981039346656037ULL;
+    char buf[65536];
+    while ( in ){
+      in.read( buf, sizeof(buf) );
+      for ( streamsize i=0; i<in.gcount(); ++i ){
+        hash ^= static_cast<unsigned char>(buf[i]);
+        hash *= 1099511628211ULL;
+      }
+    }
+    return hash;
+  }
+
+  void SimpleConfigSnapshot::write( const SimpleConfig& config, const string& filename ){
+
+    ConfigFileLookupPolicy configFile;
+
+    // Intern the types and names.
+    map<string,std::uint32_t> index;
+    vector<string>            table;
+    vector<std::uint32_t>     types, names;
+    for ( auto const& r : config._image ){
+      types.push_back( intern( r->Type, index, table ) );
+      names.push_back( intern( r->Name, index, table ) );
+    }
+
+    ostringstream os;
+    os.write( magic, sizeof(magic) );
+    put( os, byteOrder );
+    put( os, version );
+    put( os, std::uint8_t(config._allowReplacement) );
+    putString( os, config._inputFileString );
+    put( os, std::uint64_t(config._inputFileHash) );
+    put( os, std::uint64_t(config._inputFileLines) );
+
+    put( os, std::uint32_t(config._sourceFiles.size()) );
+    for ( auto const& source : config._sourceFiles ){
+      std::uint64_t hash = contentHash( configFile(source) );
+      if ( hash == 0 ){
+        throw cet::exception("SimpleConfig")
+          << "SimpleConfigSnapshot: cannot read source file " << source << "\n";
+      }
+      putString( os, source );
+      put( os, hash );
+    }
+
+    put( os, std::uint32_t(table.size()) );
+    for ( auto const& s : table ){
+      putString( os, s );
+    }
+
+    put( os, std::uint32_t(config._image.size()) );
+    for ( size_t i=0; i<config._image.size(); ++i ){
+      SimpleConfigRecord const& r = *config._image[i];
+      std::uint8_t flags = ( r._isCommentOrBlank ? commentOrBlank : 0 ) |
+                           ( r._isVector         ? isVector       : 0 ) |
+                           ( r._superceded       ? superceded     : 0 ) |
+                           ( r._converted        ? converted      : 0 );
+      put( os, flags );
+      put( os, types[i] );
+      put( os, names[i] );
+      putString( os, r.record );
+      putString( os, r.comment );
+      put( os, std::uint32_t(r.Values.size()) );
+      for ( auto const& v : r.Values ){
+        putString( os, v );
+      }
+      if ( r._converted ){
+        for ( double d : r._numbers ){
+          put( os, d );
+        }
+      }
+    }
+
+    ofstream out( filename.c_str(), ios::binary );
+    string const& buf = os.str();
+    out.write( buf.data(), buf.size() );
+    if ( !out ){
+      throw cet::exception("SimpleConfig")
+        << "SimpleConfigSnapshot: cannot write snapshot file " << filename << "\n";
+    }
+  }
+
+  bool SimpleConfigSnapshot::read( SimpleConfig& config, const string& filename, string& reason ){
+
+    ifstream in( filename.c_str(), ios::binary );
+    if ( !in ){
+      reason = "cannot open the file";
+      return false;
+    }
+    string buf( (istreambuf_iterator<char>(in)), istreambuf_iterator<char>() );
+
+    Input input(buf);
+    if ( buf.size() < sizeof(magic) || std::memcmp( buf.data(), magic, sizeof(magic) ) != 0 ){
+      reason = "not a SimpleConfig snapshot";
+      return false;
+    }
+    input.p += sizeof(magic);
+    if ( input.get<std::uint32_t>() != byteOrder ){
+      reason = "written with another byte order";
+      return false;
+    }
+    std::uint32_t fileVersion = input.get<std::uint32_t>();
+    if ( fileVersion != version ){
+      ostringstream os;
+      os << "format version " << fileVersion << ", expected " << version;
+      reason = os.str();
+      return false;
+    }
+    bool allowReplacement = input.get<std::uint8_t>();
+    if ( allowReplacement != config._allowReplacement ){
+      reason = "made with another allowReplacement policy";
+      return false;
+    }
+    string inputFile = input.getString();
+    if ( inputFile != config._inputFileString ){
+      reason = "made from " + inputFile;
+      return false;
+    }
+    std::uint64_t inputFileHash  = input.get<std::uint64_t>();
+    std::uint64_t inputFileLines = input.get<std::uint64_t>();
+
+    // Check that none of the source files has changed.
+    ConfigFileLookupPolicy configFile;
+    vector<string> sources( input.getCount( sizeof(std::uint32_t)+sizeof(std::uint64_t) ) );
+    for ( auto& source : sources ){
+      source = input.getString();
+      std::uint64_t hash = input.get<std::uint64_t>();
+      if ( !input.ok ) break;
+      string path;
+      try {
+        path = configFile(source);
+      }
+      catch ( cet::exception& ){
+        reason = "cannot find source file " + source;
+        return false;
+      }
+      if ( contentHash(path) != hash ){
+        reason = "source file " + path + " has changed";
+        return false;
+      }
+    }
+
+    vector<string> table( input.getCount( sizeof(std::uint32_t) ) );
+    for ( auto& s : table ){
+      s = input.getString();
+    }
+
+    std::uint32_t nRecords = input.getCount( 1+5*sizeof(std::uint32_t) );
+    SimpleConfig::Image_type image;
+    image.reserve( nRecords );
+    for ( std::uint32_t i=0; i<nRecords && input.ok; ++i ){
+      SimpleConfig::Record_sptr r( new SimpleConfigRecord() );
+      std::uint8_t  flags = input.get<std::uint8_t>();
+      std::uint32_t type  = input.get<std::uint32_t>();
+      std::uint32_t name  = input.get<std::uint32_t>();
+      if ( type >= table.size() || name >= table.size() ){
+        input.ok = false;
+        break;
+      }
+      r->Type              = table[type];
+      r->Name              = table[name];
+      r->record            = input.getString();
+      r->comment           = input.getString();
+      r->_isCommentOrBlank = flags & commentOrBlank;
+      r->_isVector         = flags & isVector;
+      r->_superceded       = flags & superceded;
+      r->_converted        = flags & converted;
+      r->Values.resize( input.getCount( sizeof(std::uint32_t) ) );
+      for ( auto& v : r->Values ){
+        v = input.getString();
+      }
+      if ( r->_converted ){
+        r->_numbers.resize( r->Values.size() );
+        for ( auto& d : r->_numbers ){
+          d = input.get<double>();
+        }
+      }
+      image.push_back(r);
+    }
+
+    if ( !input.ok || input.p != input.end ){
+      reason = "file is truncated or corrupt";
+      return false;
+    }
+
+    config._inputFileHash  = inputFileHash;
+    config._inputFileLines = inputFileLines;
+    config._sourceFiles    = sources;
+    config._image.swap(image);
+    config.FillMap();
+    return true;
+  }
+
+} // end namespace mu2e
@@ -0,0 +1,50 @@
+#ifndef ConfigTools_src_SimpleConfigSnapshot_hh
+#define ConfigTools_src_SimpleConfigSnapshot_hh
+//
+// Binary snapshot of a parsed SimpleConfig: the records of the image with their
+// values already split and converted, so that a job can skip reading and parsing
+// the text files and their includes.
+//
+// The snapshot records the input file, the replacement policy and a hash of the
+// contents of every file that was read.  It is only used if all of them still
+// match; otherwise SimpleConfig falls back to parsing the text files.
+//
+// Layout (native byte order, checked on reading):
+//   header    : magic, byte order mark, format version, allowReplacement,
+//               input file name, inputFileHash, inputFileLines
+//   sources   : count, then for each file its name and content hash
+//   strings   : count, then each string; record types and names are stored as
+//               indices into this table
+//   records   : count, then for each record its flags, type and name indices,
+//               raw record, comment, values and converted values
+//
+
+#include <cstdint>
+#include <string>
+
+namespace mu2e {
+
+  class SimpleConfig;
+
+  class SimpleConfigSnapshot {
+
+  public:
+
+    // Increment when the layout changes; snapshots with another version are ignored.
+    static const std::uint32_t version = 1;
+
+    // Write the snapshot of a configuration; throws on failure.
+    static void write( const SimpleConfig& config, const std::string& filename );
+
+    // Fill an empty configuration from a snapshot.  Return false, with the reason,
+    // if the snapshot does not exist, is not readable or is out of date.
+    static bool read( SimpleConfig& config, const std::string& filename, std::string& reason );
+
+    // Hash of the contents of a file, 0 if it cannot be read.
+    static std::uint64_t contentHash( const std::string& filename );
+
+  };
+
+} // end namespace mu2e
+
+#endif /* ConfigTools_src_SimpleConfigSnapshot_hh */
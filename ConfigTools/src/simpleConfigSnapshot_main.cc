@@ -0,0 +1,72 @@
+//
+// Compile a SimpleConfig file, with all of its includes, into a binary snapshot
+// that SimpleConfig can load instead of parsing the text files.  The snapshot is
+// read back and compared with the parsed configuration before the tool exits.
+//
+// Usage: simpleConfigSnapshot [--noReplacement] <input file> <snapshot file>
+//
+// The input file is looked up in MU2E_SEARCH_PATH, as in a job.  The snapshot is
+// only used by jobs that give the same input file name and the same
+// allowReplacement policy (--noReplacement for allowReplacement : false).
+//
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "cetlib_except/exception.h"
+
+#include "ConfigTools/inc/SimpleConfig.hh"
+
+int main(int argc, char**argv) {
+
+  std::vector<std::string> words;
+  for(size_t i=1; i<size_t(argc);++i) {
+    words.emplace_back(argv[i]);
+  }
+
+  bool allowReplacement = true;
+  std::vector<std::string> files;
+  for(auto const& w : words) {
+    if(w == "--noReplacement") {
+      allowReplacement = false;
+    } else {
+      files.push_back(w);
+    }
+  }
+  if(files.size() != 2) {
+    std::cerr << "Usage: simpleConfigSnapshot [--noReplacement] <input file> <snapshot file>" << std::endl;
+    return 1;
+  }
+
+  try {
+    mu2e::SimpleConfig config(files[0], allowReplacement);
+    config.writeSnapshot(files[1]);
+
+    mu2e::SimpleConfig check(files[0], allowReplacement, false, false, files[1]);
+    std::ostringstream parsed, loaded;
+    config.printFullImage(parsed);
+    check.printFullImage(loaded);
+    if(!check.fromSnapshot() || parsed.str() != loaded.str()) {
+      std::cerr << "simpleConfigSnapshot: the snapshot " << files[1]
+                << " does not reproduce " << files[0] << std::endl;
+      return 2;
+    }
+
+    std::vector<std::string> names;
+    config.getNames(names);
+    std::cout << "simpleConfigSnapshot: wrote " << files[1] << "\n"
+              << "  input file  : " << config.inputFile() << "\n"
+              << "  source files: " << config.sourceFiles().size() << "\n"
+              << "  parameters  : " << names.size() << "\n"
+              << "  parse time  : " << config.loadTime() << " ms\n"
+              << "  load time   : " << check.loadTime() << " ms" << std::endl;
+  }
+  catch(cet::exception& e) {
+    std::cerr << "simpleConfigSnapshot: " << e.what() << std::endl;
+    return 3;
+  }
+
+  return 0;
+}
@@ -0,0 +1,33 @@
+#ifndef _COSMIC_RECO_GAUSSNEWTONDRIFTFITTER_HH
+#define _COSMIC_RECO_GAUSSNEWTONDRIFTFITTER_HH
+
+// Purpose: straight line drift time fit of a cosmic track seed without Minuit.  Minimizes the
+// same chi2 as GaussianDriftFit (hit times and positions along the wire) over (a0, b0, a1, b1,
+// t0) by Levenberg-Marquardt damped Gauss-Newton steps.  The time derivatives are the analytic
+// DOCA derivatives generated for the alignment (TrackerAlignment/inc/AlignmentDerivatives.hh).
+
+#include "CosmicReco/inc/PDFFit.hh"
+#include "RecoDataProducts/inc/CosmicTrackSeed.hh"
+#include "TrackerConditions/inc/StrawResponse.hh"
+#include "TrackerGeom/inc/Tracker.hh"
+
+#include <vector>
+
+namespace GaussNewtonDriftFitter {
+
+// fit the hits of fit (except its excluded hit) starting from pars; the errors and packed
+// covariance are filled in the same format as MinuitDriftFitter::DoDriftTimeFit
+void DoDriftTimeFit(
+    std::vector<double> & pars,
+    std::vector<double> & errors,
+    std::vector<double> & cov_out,
+    bool & converged,
+    GaussianDriftFit const& fit,
+    int diag=0, unsigned maxiter=20, double tolerance=1e-3);
+
+void DoDriftTimeFit(int const& diag, CosmicTrackSeed& tseed, StrawResponse const& srep,
+                    const Tracker* tracker, unsigned maxiter=20, double tolerance=1e-3);
+
+} // namespace GaussNewtonDriftFitter
+
+#endif
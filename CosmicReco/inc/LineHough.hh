@@ -0,0 +1,77 @@
+#ifndef CosmicReco_LineHough_hh
+#define CosmicReco_LineHough_hh
+//
+// Hough transform seeding of straight (cosmic) tracks in the tracker, used by LineFinder.
+//
+// A line is a direction and a point in the plane perpendicular to it.  For each direction
+// of a grid on the downward hemisphere, every hit votes for the cells of a 2D accumulator in
+// that plane crossed by the projection of its wire, within +-reach of the hit position along
+// the wire.  The cells with the most votes are lines passing close to the most wires.  The
+// best directions are then refined on finer grids around them (coarse to fine).  The final
+// candidates are fit to the wires of their hits (DCA least squares) and compared with the
+// LineFinder criteria: number of hits within maxDOCA of the line inside their straw, then
+// the likelihood of the positions along the wires.  Lines with too few hits to fit, and
+// small clusters, use the LineFinder scan of the lines through pairs of hits instead.
+//
+#include "CLHEP/Vector/ThreeVector.h"
+#include <vector>
+namespace mu2e {
+
+  class LineHough {
+    public:
+      struct Config {
+        double maxDOCA;    // largest DOCA of a hit on the line (mm)
+        int    nSteps;     // number of steps within reach of a hit in the pair scans
+        int    minHits;    // smaller clusters are seeded by the pair scan of all their hits
+        double coarseStep; // direction step of the first pass (radians)
+        int    nLevels;    // number of passes, each with a 4 times finer direction step
+        int    nPeaks;     // number of candidates kept from each pass
+      };
+      // straw geometry and hit information
+      struct Hit {
+        CLHEP::Hep3Vector mid;  // straw mid point
+        CLHEP::Hep3Vector wdir; // straw direction
+        double halfLength;      // straw half length
+        CLHEP::Hep3Vector pos;  // hit position
+        double reach;           // half length along the wire of the region the hit votes for
+        double wireDist;        // hit position along the wire
+        double wireErr2;        // and its variance
+      };
+
+      explicit LineHough(Config const& config);
+
+      void clear() { _hits.clear(); }
+      void addHit(Hit const& hit) { _hits.push_back(hit); }
+      std::vector<Hit> const& hits() const { return _hits; }
+      // find the best line; returns the number of hits on it
+      int findLine(CLHEP::Hep3Vector& pos, CLHEP::Hep3Vector& dir);
+      // number of hits on a line, and the sum of the squared pulls of their positions along the wire
+      int score(CLHEP::Hep3Vector const& pos, CLHEP::Hep3Vector const& dir, double& ll) const;
+
+    private:
+      struct Candidate {
+        int votes;
+        CLHEP::Hep3Vector dir;
+        CLHEP::Hep3Vector pos;
+        double cell;            // accumulator cell size (mm)
+      };
+      static constexpr int _nfit = 10; // number of refits of each final candidate
+      Config _config;
+      std::vector<Hit> _hits;
+      CLHEP::Hep3Vector _center; // hit centroid, origin of the accumulator planes
+      double _extent;            // size of the hit region
+      // accumulator and per cell last voter, reused for all directions
+      std::vector<unsigned short> _votes;
+      std::vector<unsigned> _voter;
+      unsigned _nvoter;
+
+      void vote(CLHEP::Hep3Vector const& dir, double step, CLHEP::Hep3Vector const& origin, double width,
+          Candidate& best);
+      void keepBest(std::vector<Candidate>& cands, double minangle, std::vector<Candidate>& best) const;
+      int scanPairs(std::vector<Hit const*> const& hits, int count,
+          CLHEP::Hep3Vector& pos, CLHEP::Hep3Vector& dir, double& ll) const;
+      bool fitLine(CLHEP::Hep3Vector const& pos, CLHEP::Hep3Vector const& dir, double tol,
+          CLHEP::Hep3Vector& fpos, CLHEP::Hep3Vector& fdir) const;
+  };
+}
+#endif
@@ -66,6 +66,14 @@ void DoDriftTimeFit(
 void DoDriftTimeFit(int const& diag, CosmicTrackSeed& tseed, StrawResponse const& srep,
                     const Tracker* tracker, double mntolerance=0.1, double mnprecision=-1);
 
+// drift time fit parameters (a0, b0, a1, b1, t0) and errors seeded from the seed track
+void SeedDriftTimeFit(CosmicTrackSeed const& tseed, std::vector<double>& pars,
+                      std::vector<double>& errors);
+
+// store the drift time fit result in the track and flag the hits far from it as outliers
+void StoreDriftTimeFit(CosmicTrackSeed& tseed, std::vector<double> const& pars,
+                       std::vector<double> const& errors, const Tracker* tracker);
+
 } // namespace MinuitDriftFitter
 
 #endif
@@ -22,6 +22,7 @@
 #include "GeneralUtilities/inc/Angles.hh"
 #include "art/Utilities/make_tool.h"
 #include "canvas/Persistency/Common/Ptr.h"
+#include "cetlib_except/exception.h"
 
 //MU2E:
 #include "RecoDataProducts/inc/StrawHitCollection.hh"
@@ -32,6 +33,7 @@
 #include "TrkReco/inc/TrkTimeCalculator.hh"
 #include "ProditionsService/inc/ProditionsHandle.hh"
 #include "CosmicReco/inc/MinuitDriftFitter.hh"
+#include "CosmicReco/inc/GaussNewtonDriftFitter.hh"
 
 //utils:
 #include "Mu2eUtilities/inc/ParametricFit.hh"
@@ -91,6 +93,9 @@ public:
     fhicl::Atom<bool> UseTime{Name("UseTime"),Comment("use time for drift fit")};
     fhicl::Atom<double> mnTolerance{Name("MinuitTolerance"),Comment("Tolerance for minuit convergence"),0.1};
     fhicl::Atom<double> mnPrecision{Name("MinuitPrecision"),Comment("Effective precision for likelihood function"),-1};
+    fhicl::Atom<std::string> driftFitter{Name("DriftFitter"),Comment("drift time fit: Minuit or GaussNewton (analytic derivatives)"),"Minuit"};
+    fhicl::Atom<unsigned> gnMaxIterations{Name("GaussNewtonMaxIterations"),Comment("maximum number of Gauss-Newton steps"),20};
+    fhicl::Atom<double> gnTolerance{Name("GaussNewtonTolerance"),Comment("chi2 change for Gauss-Newton convergence"),1e-3};
     fhicl::Table<CosmicTrackFit::Config> tfit{Name("CosmicTrackFit"), Comment("fit")};
 	};
 	typedef art::EDProducer::Table<Config> Parameters;
@@ -124,6 +129,9 @@ public:
         bool       _UseTime;
         double _mnTolerance;
         double _mnPrecision;
+        bool       _gaussNewton;
+        unsigned   _gnMaxIterations;
+        double _gnTolerance;
 
 	CosmicTrackFit     _tfit;
 
@@ -150,12 +158,17 @@ public:
       _UseTime (conf().UseTime()),
       _mnTolerance (conf().mnTolerance()),
       _mnPrecision (conf().mnPrecision()),
+      _gaussNewton (conf().driftFitter() == "GaussNewton"),
+      _gnMaxIterations (conf().gnMaxIterations()),
+      _gnTolerance (conf().gnTolerance()),
       _tfit (conf().tfit())
     {
       consumes<ComboHitCollection>(_chToken);
       consumes<TimeClusterCollection>(_tcToken);
       mayConsume<CosmicTrackSeedCollection>(_lfToken);
       produces<CosmicTrackSeedCollection>();
+      if (!_gaussNewton && conf().driftFitter() != "Minuit")
+        throw cet::exception("RECO")<<"CosmicTrackFinder: unknown DriftFitter " << conf().driftFitter() << std::endl;
 
     }
 
@@ -264,7 +277,9 @@ public:
           if (tseed.status().hasAnyProperty(_saveflag)){
 
             if(_DoDrift) {
-              if (_UseTime) {
+              if (_UseTime && _gaussNewton) {
+                GaussNewtonDriftFitter::DoDriftTimeFit(_debug,tseed, srep, &tracker, _gnMaxIterations, _gnTolerance );
+              } else if (_UseTime) {
                 MinuitDriftFitter::DoDriftTimeFit(_debug,tseed, srep, &tracker, _mnTolerance, _mnPrecision );
               } else {
                 _tfit.DriftFit(tseed, srep);
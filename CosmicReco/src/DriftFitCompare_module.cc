@@ -0,0 +1,153 @@
+//
+// Compare the drift time fits of two CosmicTrackFinder instances run on the same time clusters
+// (for example the Minuit and Gauss-Newton fitters).  The seeds are matched by time cluster;
+// for each pair the parameters, errors and chi2 of both fits are written to a tree, and the
+// agreement of the parameters is summarized at the end of the job.
+//
+#include <iostream>
+#include <string>
+#include <cmath>
+
+#include "CosmicReco/inc/PDFFit.hh"
+#include "RecoDataProducts/inc/CosmicTrackSeed.hh"
+#include "ProditionsService/inc/ProditionsHandle.hh"
+#include "TrackerConditions/inc/StrawResponse.hh"
+#include "TrackerGeom/inc/Tracker.hh"
+
+// Framework includes.
+#include "art/Framework/Core/EDAnalyzer.h"
+#include "art/Framework/Principal/Event.h"
+#include "art/Framework/Principal/Handle.h"
+#include "art/Framework/Core/ModuleMacros.h"
+#include "art_root_io/TFileService.h"
+//ROOT
+#include "TTree.h"
+
+namespace mu2e
+{
+  class DriftFitCompare : public art::EDAnalyzer {
+    public:
+      struct Config{
+        using Name=fhicl::Name;
+        using Comment=fhicl::Comment;
+        fhicl::Atom<int> diag{Name("diagLevel"), Comment("set to 1 for info"),0};
+        fhicl::Atom<art::InputTag> reftag{Name("ReferenceSeedCollection"),Comment("CosmicTrackSeed collection of the reference fit")};
+        fhicl::Atom<art::InputTag> testtag{Name("TestSeedCollection"),Comment("CosmicTrackSeed collection of the compared fit")};
+      };
+      typedef art::EDAnalyzer::Table<Config> Parameters;
+
+      explicit DriftFitCompare(const Parameters& conf);
+      virtual ~DriftFitCompare() {}
+      virtual void beginJob() override;
+      virtual void endJob() override;
+      virtual void analyze(const art::Event& e) override;
+    private:
+      static constexpr int _npar = 5;
+
+      int _diag;
+      art::InputTag _reftag;
+      art::InputTag _testtag;
+      ProditionsHandle<Tracker> _alignedTracker_h;
+      ProditionsHandle<StrawResponse> _strawResponse_h;
+
+      TTree* _fitT;
+      Int_t _evt, _nhits;
+      Int_t _refconverged, _testconverged;
+      Float_t _refpar[_npar], _referr[_npar], _testpar[_npar], _testerr[_npar];
+      Float_t _refchi2, _testchi2;
+
+      // summary counts
+      unsigned _nref, _ntest, _nmatched, _nboth;
+      unsigned _nagree[_npar];
+      double _sumdchi2;
+  };
+
+  DriftFitCompare::DriftFitCompare(const Parameters& conf) :
+    art::EDAnalyzer(conf),
+    _diag (conf().diag()),
+    _reftag (conf().reftag()),
+    _testtag (conf().testtag()),
+    _nref(0), _ntest(0), _nmatched(0), _nboth(0), _sumdchi2(0)
+  {
+    for (int i=0; i<_npar; ++i) _nagree[i] = 0;
+  }
+
+  void DriftFitCompare::beginJob() {
+    art::ServiceHandle<art::TFileService> tfs;
+    _fitT=tfs->make<TTree>("fitT","Drift fit comparison");
+    _fitT->Branch("evt",&_evt,"evt/I");
+    _fitT->Branch("nhits",&_nhits,"nhits/I");
+    _fitT->Branch("refconverged",&_refconverged,"refconverged/I");
+    _fitT->Branch("testconverged",&_testconverged,"testconverged/I");
+    _fitT->Branch("refpar",_refpar,"refpar[5]/F");
+    _fitT->Branch("referr",_referr,"referr[5]/F");
+    _fitT->Branch("testpar",_testpar,"testpar[5]/F");
+    _fitT->Branch("testerr",_testerr,"testerr[5]/F");
+    _fitT->Branch("refchi2",&_refchi2,"refchi2/F");
+    _fitT->Branch("testchi2",&_testchi2,"testchi2/F");
+  }
+
+  void DriftFitCompare::analyze(const art::Event& event) {
+    auto const& refcol = *event.getValidHandle<CosmicTrackSeedCollection>(_reftag);
+    auto const& testcol = *event.getValidHandle<CosmicTrackSeedCollection>(_testtag);
+    Tracker const& tracker = _alignedTracker_h.get(event.id());
+    StrawResponse const& srep = _strawResponse_h.get(event.id());
+    _evt = event.id().event();
+    _nref += refcol.size();
+    _ntest += testcol.size();
+
+    for (auto const& ref : refcol) {
+      for (auto const& test : testcol) {
+        if (test._timeCluster != ref._timeCluster) continue;
+        ++_nmatched;
+        auto const& rp = ref._track.MinuitParams;
+        auto const& tp = test._track.MinuitParams;
+        std::vector<double> refx {rp.A0, rp.B0, rp.A1, rp.B1, rp.T0};
+        std::vector<double> testx {tp.A0, tp.B0, tp.A1, tp.B1, tp.T0};
+        std::vector<double> referr {rp.deltaA0, rp.deltaB0, rp.deltaA1, rp.deltaB1, rp.deltaT0};
+        std::vector<double> testerr {tp.deltaA0, tp.deltaB0, tp.deltaA1, tp.deltaB1, tp.deltaT0};
+        for (int i=0; i<_npar; ++i) {
+          _refpar[i] = refx[i];
+          _referr[i] = referr[i];
+          _testpar[i] = testx[i];
+          _testerr[i] = testerr[i];
+        }
+        // both chi2 are evaluated on the hits of the reference seed
+        GaussianDriftFit fit(ref._straw_chits, srep, &tracker);
+        _nhits = ref._straw_chits.size();
+        _refchi2 = fit(refx);
+        _testchi2 = fit(testx);
+        _refconverged = ref._track.minuit_converged;
+        _testconverged = test._track.minuit_converged;
+        if (_refconverged && _testconverged) {
+          ++_nboth;
+          _sumdchi2 += _testchi2 - _refchi2;
+          for (int i=0; i<_npar; ++i) {
+            if (fabs(testx[i]-refx[i]) < 0.1*referr[i]) ++_nagree[i];
+          }
+        }
+        if (_diag > 0) {
+          std::cout << "DriftFitCompare: event " << _evt << " hits " << _nhits
+                    << " chi2 " << _refchi2 << " " << _testchi2 << std::endl;
+        }
+        _fitT->Fill();
+        break;
+      }
+    }
+  }
+
+  void DriftFitCompare::endJob() {
+    std::cout << "DriftFitCompare: " << _reftag << " " << _nref << " seeds, " << _testtag << " "
+              << _ntest << " seeds, " << _nmatched << " matched, " << _nboth << " both converged"
+              << std::endl;
+    if (_nboth == 0) return;
+    std::cout << "DriftFitCompare: mean chi2 difference (test - reference) " << _sumdchi2/_nboth
+              << std::endl;
+    std::cout << "DriftFitCompare: fraction within 0.1 sigma (a0 b0 a1 b1 t0)";
+    for (int i=0; i<_npar; ++i) std::cout << " " << double(_nagree[i])/_nboth;
+    std::cout << std::endl;
+  }
+}
+
+using mu2e::DriftFitCompare;
+DEFINE_ART_MODULE(DriftFitCompare);
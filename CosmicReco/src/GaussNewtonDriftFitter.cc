@@ -0,0 +1,186 @@
+// Purpose: Gauss-Newton drift time fit of a cosmic track seed, see GaussNewtonDriftFitter.hh
+
+#include "CosmicReco/inc/GaussNewtonDriftFitter.hh"
+#include "CosmicReco/inc/MinuitDriftFitter.hh"
+#include "Mu2eUtilities/inc/TwoLinePCA.hh"
+#include "TrackerAlignment/inc/AlignmentDerivatives.hh"
+
+#include "CLHEP/Matrix/SymMatrix.h"
+#include "CLHEP/Matrix/Vector.h"
+
+#include <cmath>
+#include <iostream>
+
+using CLHEP::Hep3Vector;
+using CLHEP::HepSymMatrix;
+using CLHEP::HepVector;
+
+using namespace mu2e;
+
+namespace GaussNewtonDriftFitter {
+
+namespace {
+
+// normal equations (gamma = J^T J, beta = -J^T r) of the GaussianDriftFit chi2 at pars
+void NormalEquations(GaussianDriftFit const& fit, std::vector<double> const& pars,
+                     HepSymMatrix& gamma, HepVector& beta) {
+  gamma = HepSymMatrix(5, 0);
+  beta = HepVector(5, 0);
+
+  Hep3Vector intercept(pars[0], 0, pars[1]);
+  Hep3Vector vdir(pars[2], -1, pars[3]);
+  double vmag = vdir.mag();
+  Hep3Vector dir = vdir / vmag;
+  // derivatives of the unit direction with respect to a1 and b1
+  Hep3Vector ddir_a1 = (Hep3Vector(1, 0, 0) - dir * dir.x()) / vmag;
+  Hep3Vector ddir_b1 = (Hep3Vector(0, 0, 1) - dir * dir.z()) / vmag;
+
+  HepVector deriv(5);
+  for (size_t i = 0; i < fit.shs.size(); i++) {
+    if (fit.excludeHit == (int)i) {
+      continue;
+    }
+    ComboHit const& hit = fit.shs[i];
+    StrawId const& id = hit.strawId();
+    Straw const& straw = fit.tracker->getStraw(id);
+    Hep3Vector const& mid = straw.getMidPoint();
+    Hep3Vector const& wdir = straw.getDirection();
+    TwoLinePCA pca(intercept, dir, mid, wdir);
+    if (pca.closeToParallel()) {
+      continue;
+    }
+
+    // time residual: the drift time derivatives are those of the alignment, for the nominal
+    // geometry (no plane or panel displacements).  The dependence of the errors on the DOCA
+    // and the flight time (traj_time) are neglected in the derivatives
+    double driftvel = fit.srep.driftInstantSpeed(id, pca.dca(), 0);
+    double drift_res = fit.srep.driftTimeError(id, 0, 0, pca.dca());
+    double tres = fit.TimeResidual(hit, pars) / drift_res;
+    auto const& plane_origin = fit.tracker->getPlane(id.getPlane()).origin();
+    auto const& panel_origin = fit.tracker->getPanel(id).straw0MidPoint();
+    std::vector<double> dtdp = CosmicTrack_DCA_LocalDeriv(
+        pars[0], pars[1], pars[2], pars[3], pars[4],
+        0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0,
+        mid.x(), mid.y(), mid.z(), wdir.x(), wdir.y(), wdir.z(),
+        plane_origin.x(), plane_origin.y(), plane_origin.z(),
+        panel_origin.x(), panel_origin.y(), panel_origin.z(), driftvel);
+    // the derivatives are those of the DCA signed by the hit ambiguity
+    int ambig = fit.HitAmbiguity(hit, pars);
+    for (int k = 0; k < 4; k++) {
+      deriv(k + 1) = ambig * dtdp[k] / drift_res;
+    }
+    deriv(5) = 1.0 / drift_res;
+    beta -= tres * deriv;
+    gamma += vT_times_v(deriv);
+
+    // position along the wire of the point of closest approach,
+    // s = (D.w - (D.u) c)/(1 - c^2), D = intercept - mid, c = u.w
+    Hep3Vector sep = intercept - mid;
+    double c = dir.dot(wdir);
+    double den = 1 - c * c;
+    double num = sep.dot(wdir) - sep.dot(dir) * c;
+    double longdist = num / den;
+    double longres = fit.srep.wpRes(hit.energyDep() * 1000., fabs(longdist));
+    double lres = (longdist - hit.wireDist()) / longres;
+    deriv(1) = (wdir.x() - dir.x() * c) / den / longres;
+    deriv(2) = (wdir.z() - dir.z() * c) / den / longres;
+    Hep3Vector const* ddir[2] = {&ddir_a1, &ddir_b1};
+    for (int k = 0; k < 2; k++) {
+      double dc = ddir[k]->dot(wdir);
+      double dnum = -sep.dot(*ddir[k]) * c - sep.dot(dir) * dc;
+      double dden = -2 * c * dc;
+      deriv(k + 3) = (dnum * den - num * dden) / (den * den) / longres;
+    }
+    deriv(5) = 0;
+    beta -= lres * deriv;
+    gamma += vT_times_v(deriv);
+  }
+}
+
+} // namespace
+
+void DoDriftTimeFit(
+    std::vector<double> & pars,
+    std::vector<double> & errors,
+    std::vector<double> & cov_out,
+    bool & converged,
+    GaussianDriftFit const& fit,
+    int diag, unsigned maxiter, double tolerance) {
+
+  converged = false;
+  cov_out = std::vector<double>(15, 0);
+
+  // Levenberg-Marquardt: the diagonal of the normal equations is scaled by (1 + lambda),
+  // lambda decreasing after each step that reduces the chi2 and increasing otherwise
+  double lambda = 1e-3;
+  double chi2 = fit(pars);
+  HepSymMatrix gamma;
+  HepVector beta;
+  NormalEquations(fit, pars, gamma, beta);
+  for (unsigned iter = 0; iter < maxiter; iter++) {
+    HepSymMatrix damped(gamma);
+    for (int k = 1; k <= 5; k++) {
+      damped.fast(k, k) *= 1 + lambda;
+    }
+    int ierr;
+    damped.invert(ierr);
+    if (ierr != 0) {
+      break;
+    }
+    HepVector delta = damped * beta;
+    std::vector<double> trial(pars);
+    for (int k = 0; k < 5; k++) {
+      trial[k] += delta(k + 1);
+    }
+    double trialchi2 = fit(trial);
+    if (diag > 1) {
+      std::cout << "GaussNewtonDriftFitter iteration " << iter << " lambda " << lambda
+                << " chi2 " << chi2 << " -> " << trialchi2 << std::endl;
+    }
+    if (trialchi2 <= chi2) {
+      pars = trial;
+      bool done = chi2 - trialchi2 < tolerance;
+      chi2 = trialchi2;
+      lambda *= 0.1;
+      NormalEquations(fit, pars, gamma, beta);
+      if (done) {
+        converged = true;
+        break;
+      }
+    } else {
+      lambda *= 10;
+    }
+  }
+
+  // covariance from the undamped normal equations at the minimum (the chi2 Up is 1)
+  int ierr;
+  gamma.invert(ierr);
+  if (ierr != 0) {
+    converged = false;
+    return;
+  }
+  for (int i = 0; i < 5; i++) {
+    errors[i] = sqrt(gamma.fast(i + 1, i + 1));
+    for (int j = 0; j <= i; j++) {
+      cov_out[j + i * (i + 1) / 2] = gamma.fast(i + 1, j + 1);
+    }
+  }
+}
+
+void DoDriftTimeFit(int const& diag, CosmicTrackSeed& tseed, StrawResponse const& srep,
+                    const Tracker* tracker, unsigned maxiter, double tolerance) {
+
+  std::vector<double> errors, pars;
+  MinuitDriftFitter::SeedDriftTimeFit(tseed, pars, errors);
+
+  // the result is stored in the same fields as the Minuit fit, so downstream code is unchanged
+  GaussianDriftFit fit(tseed._straw_chits, srep, tracker);
+  DoDriftTimeFit(pars, errors, tseed._track.MinuitParams.cov,
+    tseed._track.minuit_converged, fit,
+    diag, maxiter, tolerance);
+
+  MinuitDriftFitter::StoreDriftTimeFit(tseed, pars, errors, tracker);
+}
+
+} // namespace GaussNewtonDriftFitter
@@ -19,6 +19,7 @@
 #include "GeometryService/inc/DetectorSystem.hh"
 #include "TrackerGeom/inc/Tracker.hh"
 #include "Mu2eUtilities/inc/TwoLinePCA.hh"
+#include "CosmicReco/inc/LineHough.hh"
 
 #include "RecoDataProducts/inc/ComboHit.hh"
 #include "RecoDataProducts/inc/TimeCluster.hh"
@@ -53,6 +54,11 @@ namespace mu2e{
         fhicl::Atom<float> t0offset{Name("t0offset"), Comment("T0 offset"), 0};
         fhicl::Atom<int> nsteps{Name("NSteps"), Comment("Number of steps per straw"), 8};
         fhicl::Atom<float> stepsize{Name("StepSize"), Comment("Size of each step in fraction of res"), 0.5};
+        fhicl::Atom<std::string> seedEngine{Name("SeedEngine"), Comment("Line seeding: BruteForce (hit pair scan) or Hough (accumulator)"), "BruteForce"};
+        fhicl::Atom<int> houghMinHits{Name("HoughMinHits"), Comment("Time clusters with fewer hits are seeded by the pair scan"), 15};
+        fhicl::Atom<float> houghStep{Name("HoughStep"), Comment("Direction step of the first Hough pass (rad)"), 0.1};
+        fhicl::Atom<int> houghLevels{Name("HoughLevels"), Comment("Number of Hough passes, each 4 times finer"), 4};
+        fhicl::Atom<int> houghPeaks{Name("HoughPeaks"), Comment("Number of Hough candidates kept from each pass"), 8};
         fhicl::Atom<art::InputTag> chToken{Name("ComboHitCollection"),Comment("tag for straw hit collection")};
         fhicl::Atom<art::InputTag> tcToken{Name("TimeClusterCollection"),Comment("tag for time cluster collection")};
       };
@@ -72,12 +78,15 @@ namespace mu2e{
       float _t0offset;
       int _Nsteps;
       float _stepSize;
+      bool _hough;
       art::InputTag  _chToken;
       art::InputTag  _tcToken;
 
       ProditionsHandle<Tracker> _alignedTracker_h;
+      LineHough _lineHough;
 
       int findLine(const ComboHitCollection& shC, art::Event const& event, CosmicTrackSeed &tseed);
+      void houghSeed(const ComboHitCollection& shC, const Tracker* tracker, CLHEP::Hep3Vector& seedDir, CLHEP::Hep3Vector& seedInt);
   };
 
 
@@ -89,9 +98,13 @@ namespace mu2e{
         _t0offset (conf().t0offset()),
         _Nsteps (conf().nsteps()),
         _stepSize (conf().stepsize()),
+        _hough (conf().seedEngine() == "Hough"),
     	_chToken (conf().chToken()),
-	_tcToken (conf().tcToken())
+	_tcToken (conf().tcToken()),
+        _lineHough (LineHough::Config{conf().maxDOCA(),conf().nsteps(),conf().houghMinHits(),conf().houghStep(),conf().houghLevels(),conf().houghPeaks()})
 {
+  if (!_hough && conf().seedEngine() != "BruteForce")
+    throw cet::exception("RECO")<<"LineFinder: unknown SeedEngine " << conf().seedEngine() << std::endl;
   consumes<ComboHitCollection>(_chToken);
   consumes<TimeClusterCollection>(_tcToken);
   produces<CosmicTrackSeedCollection>();
@@ -152,36 +165,40 @@ int LineFinder::findLine(const ComboHitCollection& shC, art::Event const& event,
   CLHEP::Hep3Vector seedDir(0,0,0);
   CLHEP::Hep3Vector seedInt(0,0,0);
 
-  // lets get the best pairwise vector
-  for (size_t i=0;i<shC.size();i++){
-    Straw const& strawi = tracker->getStraw(shC[i].strawId());
-    for (size_t j=i+1;j<shC.size();j++){
-      Straw const& strawj = tracker->getStraw(shC[j].strawId());
-      for (int is=-1*_Nsteps;is<_Nsteps+1;is++){
-        CLHEP::Hep3Vector ipos = shC[i].posCLHEP() + strawi.getDirection()*shC[i].wireRes()*_stepSize*is;
-        for (int js=-1*_Nsteps;js<_Nsteps+1;js++){
-          CLHEP::Hep3Vector jpos = shC[j].posCLHEP() + strawj.getDirection()*shC[j].wireRes()*_stepSize*js;
-
-          CLHEP::Hep3Vector newdir = (jpos-ipos).unit();
-          // now loop over all hits and see how many are in this track
-          int count = 0;
-          double ll = 0;
-          for (size_t k=0;k<shC.size();k++){
-            Straw const& strawk = tracker->getStraw(shC[k].strawId());
-            TwoLinePCA pca( strawk.getMidPoint(), strawk.getDirection(),
-                ipos, newdir);
-            double dist = (pca.point1()-strawk.getMidPoint()).mag();
-            if (pca.dca() < _maxDOCA && dist < strawk.halfLength()){
-              count += 1;
-              ll += pow(dist-shC[k].wireDist(),2)/shC[k].wireErr2();
+  if (_hough){
+    houghSeed(shC, tracker, seedDir, seedInt);
+  } else {
+    // lets get the best pairwise vector
+    for (size_t i=0;i<shC.size();i++){
+      Straw const& strawi = tracker->getStraw(shC[i].strawId());
+      for (size_t j=i+1;j<shC.size();j++){
+        Straw const& strawj = tracker->getStraw(shC[j].strawId());
+        for (int is=-1*_Nsteps;is<_Nsteps+1;is++){
+          CLHEP::Hep3Vector ipos = shC[i].posCLHEP() + strawi.getDirection()*shC[i].wireRes()*_stepSize*is;
+          for (int js=-1*_Nsteps;js<_Nsteps+1;js++){
+            CLHEP::Hep3Vector jpos = shC[j].posCLHEP() + strawj.getDirection()*shC[j].wireRes()*_stepSize*js;
+
+            CLHEP::Hep3Vector newdir = (jpos-ipos).unit();
+            // now loop over all hits and see how many are in this track
+            int count = 0;
+            double ll = 0;
+            for (size_t k=0;k<shC.size();k++){
+              Straw const& strawk = tracker->getStraw(shC[k].strawId());
+              TwoLinePCA pca( strawk.getMidPoint(), strawk.getDirection(),
+                  ipos, newdir);
+              double dist = (pca.point1()-strawk.getMidPoint()).mag();
+              if (pca.dca() < _maxDOCA && dist < strawk.halfLength()){
+                count += 1;
+                ll += pow(dist-shC[k].wireDist(),2)/shC[k].wireErr2();
+              }
+            }
+            if (count > bestcount || (count == bestcount && ll < bestll)){
+              bestcount = count;
+              bestll = ll;
+              seedDir = newdir.unit();
+              if (seedDir.y() > 0) seedDir *= -1;
+              seedInt = ipos - newdir*ipos.y()/newdir.y();
             }
-          }
-          if (count > bestcount || (count == bestcount && ll < bestll)){
-            bestcount = count;
-            bestll = ll;
-            seedDir = newdir.unit();
-            if (seedDir.y() > 0) seedDir *= -1;
-            seedInt = ipos - newdir*ipos.y()/newdir.y();
           }
         }
       }
@@ -243,6 +260,28 @@ int LineFinder::findLine(const ComboHitCollection& shC, art::Event const& event,
   return good_hits;
 }
 
+void LineFinder::houghSeed(const ComboHitCollection& shC, const Tracker* tracker, CLHEP::Hep3Vector& seedDir, CLHEP::Hep3Vector& seedInt){
+  // the straw geometry is looked up once per hit, the hits vote over the same range as the pair scan
+  _lineHough.clear();
+  for (size_t k=0;k<shC.size();k++){
+    Straw const& strawk = tracker->getStraw(shC[k].strawId());
+    LineHough::Hit hit;
+    hit.mid = strawk.getMidPoint();
+    hit.wdir = strawk.getDirection();
+    hit.halfLength = strawk.halfLength();
+    hit.pos = shC[k].posCLHEP();
+    hit.reach = shC[k].wireRes()*_stepSize*_Nsteps;
+    hit.wireDist = shC[k].wireDist();
+    hit.wireErr2 = shC[k].wireErr2();
+    _lineHough.addHit(hit);
+  }
+  CLHEP::Hep3Vector pos, dir;
+  if (_lineHough.findLine(pos, dir) == 0 || dir.y() == 0) return;
+  seedDir = dir.unit();
+  if (seedDir.y() > 0) seedDir *= -1;
+  seedInt = pos - seedDir*pos.y()/seedDir.y();
+}
+
 }//end mu2e namespace
 using mu2e::LineFinder;
 DEFINE_ART_MODULE(LineFinder);
@@ -0,0 +1,277 @@
+//
+// Hough transform seeding of straight tracks, see LineHough.hh
+//
+#include "CosmicReco/inc/LineHough.hh"
+#include "Mu2eUtilities/inc/TwoLinePCA.hh"
+#include "CLHEP/Matrix/Vector.h"
+#include "CLHEP/Matrix/SymMatrix.h"
+#include <algorithm>
+#include <cmath>
+
+using CLHEP::Hep3Vector;
+using CLHEP::HepVector;
+using CLHEP::HepSymMatrix;
+
+namespace mu2e {
+
+  LineHough::LineHough(Config const& config) : _config(config), _extent(0.0), _nvoter(0) {}
+
+  int LineHough::findLine(Hep3Vector& pos, Hep3Vector& dir) {
+    if (_hits.size() < 2) return 0;
+    // small clusters: the pair scan of all the hits is cheaper than the accumulator
+    if (int(_hits.size()) < _config.minHits) {
+      std::vector<Hit const*> all;
+      for (auto const& hit : _hits) all.push_back(&hit);
+      double ll(0.0);
+      return scanPairs(all,0,pos,dir,ll);
+    }
+    _center = Hep3Vector();
+    for (auto const& hit : _hits) _center += hit.pos;
+    _center /= _hits.size();
+    _extent = 0.0;
+    for (auto const& hit : _hits) _extent = std::max(_extent,(hit.pos-_center).mag()+hit.reach);
+
+    // first pass: directions on the downward hemisphere, theta measured from -y
+    double step = _config.coarseStep;
+    std::vector<Candidate> cands, best;
+    int ntheta = int(std::ceil(0.5*M_PI/step));
+    for (int itheta=0; itheta<=ntheta; ++itheta) {
+      double theta = 0.5*M_PI*itheta/ntheta;
+      int nphi = std::max(1,int(std::ceil(2.0*M_PI*sin(theta)/step)));
+      for (int iphi=0; iphi<nphi; ++iphi) {
+        double phi = 2.0*M_PI*iphi/nphi;
+        cands.push_back(Candidate());
+        vote(Hep3Vector(sin(theta)*cos(phi),-cos(theta),sin(theta)*sin(phi)),step,_center,_extent,cands.back());
+      }
+    }
+    keepBest(cands,2.0*step,best);
+
+    // finer passes, covering the direction bin of each of the previous best candidates.  The
+    // accumulator only covers the previous cell, around the point of the line closest to the hits
+    for (int ilevel=1; ilevel<_config.nLevels; ++ilevel) {
+      step *= 0.25;
+      cands.clear();
+      for (auto const& prev : best) {
+        Hep3Vector e1 = prev.dir.orthogonal().unit();
+        Hep3Vector e2 = prev.dir.cross(e1);
+        Hep3Vector origin = prev.pos + prev.dir*(_center-prev.pos).dot(prev.dir);
+        for (int i1=-2; i1<=2; ++i1) {
+          for (int i2=-2; i2<=2; ++i2) {
+            cands.push_back(Candidate());
+            vote((prev.dir + e1*(i1*step) + e2*(i2*step)).unit(),step,origin,2.0*prev.cell,cands.back());
+          }
+        }
+      }
+      keepBest(cands,2.0*step,best);
+    }
+
+    // score the candidates as LineFinder does, after refitting them to the wires of their hits
+    int bestcount = 0;
+    double bestll = 0.0;
+    for (auto const& cand : best) {
+      Hep3Vector cpos(cand.pos), cdir(cand.dir);
+      double ll;
+      int count = score(cpos,cdir,ll);
+      Hep3Vector fpos(cpos), fdir(cdir);
+      // the first fit collects the hits within the accumulator cell, the window then shrinks to maxDOCA
+      double tol0 = cand.cell + _config.maxDOCA;
+      double tol = tol0;
+      for (int ifit=0; ifit<_nfit; ++ifit) {
+        if (!fitLine(fpos,fdir,tol,fpos,fdir)) break;
+        tol = std::max(0.5*tol,_config.maxDOCA);
+        double fll;
+        int fcount = score(fpos,fdir,fll);
+        if (fcount > count || (fcount == count && fll < ll)) {
+          count = fcount;
+          ll = fll;
+          cpos = fpos;
+          cdir = fdir;
+        }
+      }
+      // too few hits to fit: scan the lines through pairs of the hits near the candidate
+      if (count < 4) {
+        std::vector<Hit const*> near;
+        for (auto const& hit : _hits) {
+          TwoLinePCA pca(hit.mid,hit.wdir,cand.pos,cand.dir);
+          if (pca.dca() < tol0) near.push_back(&hit);
+        }
+        count = scanPairs(near,count,cpos,cdir,ll);
+      }
+      if (count > bestcount || (count == bestcount && ll < bestll)) {
+        bestcount = count;
+        bestll = ll;
+        pos = cpos;
+        dir = cdir;
+      }
+    }
+    return bestcount;
+  }
+
+  int LineHough::score(Hep3Vector const& pos, Hep3Vector const& dir, double& ll) const {
+    int count = 0;
+    ll = 0.0;
+    for (auto const& hit : _hits) {
+      TwoLinePCA pca(hit.mid,hit.wdir,pos,dir);
+      double dist = (pca.point1()-hit.mid).mag();
+      if (pca.dca() < _config.maxDOCA && dist < hit.halfLength) {
+        count += 1;
+        ll += pow(dist-hit.wireDist,2)/hit.wireErr2;
+      }
+    }
+    return count;
+  }
+
+  int LineHough::scanPairs(std::vector<Hit const*> const& hits, int bestcount,
+      Hep3Vector& pos, Hep3Vector& dir, double& ll) const {
+    // the lines through the points stepped along the wires of each pair of hits
+    int nsteps = _config.nSteps;
+    double frac = nsteps > 0 ? 1.0/nsteps : 0.0;
+    for (size_t i=0; i<hits.size(); ++i) {
+      for (size_t j=i+1; j<hits.size(); ++j) {
+        for (int is=-nsteps; is<=nsteps; ++is) {
+          Hep3Vector ipos = hits[i]->pos + hits[i]->wdir*(hits[i]->reach*frac*is);
+          for (int js=-nsteps; js<=nsteps; ++js) {
+            Hep3Vector jpos = hits[j]->pos + hits[j]->wdir*(hits[j]->reach*frac*js);
+            Hep3Vector newdir = (jpos-ipos).unit();
+            double newll;
+            int count = score(ipos,newdir,newll);
+            if (count > bestcount || (count == bestcount && newll < ll)) {
+              bestcount = count;
+              ll = newll;
+              pos = ipos;
+              dir = newdir;
+            }
+          }
+        }
+      }
+    }
+    return bestcount;
+  }
+
+  void LineHough::vote(Hep3Vector const& dir, double step, Hep3Vector const& origin, double width,
+      Candidate& best) {
+    // the cell must contain the line for all directions in the bin
+    double cell = 2.0*_config.maxDOCA + 0.5*step*_extent;
+    int half = int(std::ceil(width/cell)) + 2;
+    int ncells = 2*half;
+    if (_votes.size() != size_t(ncells*ncells)) {
+      _votes.resize(ncells*ncells);
+      _voter.assign(ncells*ncells,0);
+      _nvoter = 0;
+    }
+    std::fill(_votes.begin(),_votes.end(),0);
+
+    Hep3Vector e1 = dir.orthogonal().unit();
+    Hep3Vector e2 = dir.cross(e1);
+    int bestidx(-1);
+    best.votes = 0;
+    for (auto const& hit : _hits) {
+      // the part of the wire within reach of the hit and inside the straw
+      double along = (hit.pos-hit.mid).dot(hit.wdir);
+      double tmin = std::max(-hit.reach,-hit.halfLength-along);
+      double tmax = std::min(hit.reach,hit.halfLength-along);
+      if (tmin > tmax) continue;
+      // its projection on the accumulator plane, in cell units
+      Hep3Vector start = hit.pos + hit.wdir*tmin - origin;
+      Hep3Vector span = hit.wdir*(tmax-tmin);
+      double x0 = start.dot(e1)/cell, y0 = start.dot(e2)/cell;
+      double dx = span.dot(e1)/cell, dy = span.dot(e2)/cell;
+      int nstep = int(std::ceil(2.0*sqrt(dx*dx+dy*dy)));
+      // each hit votes once for each cell on or next to its projection
+      ++_nvoter;
+      for (int istep=0; istep<=nstep; ++istep) {
+        double frac = nstep > 0 ? double(istep)/nstep : 0.0;
+        int ix = int(std::floor(x0 + frac*dx)) + half;
+        int iy = int(std::floor(y0 + frac*dy)) + half;
+        if (ix < -1 || ix > ncells || iy < -1 || iy > ncells) continue;
+        for (int jx=std::max(ix-1,0); jx<=std::min(ix+1,ncells-1); ++jx) {
+          for (int jy=std::max(iy-1,0); jy<=std::min(iy+1,ncells-1); ++jy) {
+            int idx = jx*ncells + jy;
+            if (_voter[idx] != _nvoter) {
+              _voter[idx] = _nvoter;
+              if (++_votes[idx] > best.votes) {
+                best.votes = _votes[idx];
+                bestidx = idx;
+              }
+            }
+          }
+        }
+      }
+    }
+    best.dir = dir;
+    best.cell = cell;
+    best.pos = origin;
+    if (bestidx < 0) return;
+    // the votes are spread over the neighbouring cells: take the center of the plateau around the peak
+    int bx = bestidx/ncells, by = bestidx%ncells;
+    double sx(0.0), sy(0.0);
+    int np(0);
+    for (int jx=std::max(bx-2,0); jx<=std::min(bx+2,ncells-1); ++jx) {
+      for (int jy=std::max(by-2,0); jy<=std::min(by+2,ncells-1); ++jy) {
+        if (_votes[jx*ncells+jy] == best.votes) {
+          sx += jx;
+          sy += jy;
+          ++np;
+        }
+      }
+    }
+    best.pos += e1*((sx/np - half + 0.5)*cell);
+    best.pos += e2*((sy/np - half + 0.5)*cell);
+  }
+
+  void LineHough::keepBest(std::vector<Candidate>& cands, double minangle, std::vector<Candidate>& best) const {
+    // the most voted candidates, skipping those within minangle of a better one
+    std::stable_sort(cands.begin(),cands.end(),
+        [](Candidate const& a, Candidate const& b) { return a.votes > b.votes; });
+    double mincos = cos(minangle);
+    best.clear();
+    for (auto const& cand : cands) {
+      if (cand.votes == 0 || int(best.size()) >= _config.nPeaks) break;
+      bool distinct(true);
+      for (auto const& kept : best) {
+        if (fabs(cand.dir.dot(kept.dir)) > mincos) {
+          distinct = false;
+          break;
+        }
+      }
+      if (distinct) best.push_back(cand);
+    }
+  }
+
+  bool LineHough::fitLine(Hep3Vector const& pos, Hep3Vector const& dir, double tol,
+      Hep3Vector& fpos, Hep3Vector& fdir) const {
+    // one Gauss-Newton step minimizing the squared DCAs to the wires of the hits within tol.
+    // The line is moved in the plane perpendicular to it (a, b) and rotated (c, d) around the
+    // point closest to the hit centroid, so the position and direction are nearly uncorrelated
+    Hep3Vector udir = dir.unit();
+    Hep3Vector ref = pos + udir*(_center-pos).dot(udir);
+    Hep3Vector e1 = udir.orthogonal().unit();
+    Hep3Vector e2 = udir.cross(e1);
+    HepVector beta(4,0);
+    HepSymMatrix gamma(4,0);
+    unsigned nused(0);
+    for (auto const& hit : _hits) {
+      TwoLinePCA pca(hit.mid,hit.wdir,ref,udir);
+      if (pca.closeToParallel() || pca.dca() > tol || fabs(pca.s1()) > hit.halfLength) continue;
+      // signed DCA along the common normal and its derivatives
+      Hep3Vector norm = hit.wdir.cross(udir).unit();
+      double dca = (ref-hit.mid).dot(norm);
+      HepVector deriv(4);
+      deriv(1) = e1.dot(norm);
+      deriv(2) = e2.dot(norm);
+      deriv(3) = pca.s2()*deriv(1);
+      deriv(4) = pca.s2()*deriv(2);
+      beta -= dca*deriv;
+      gamma += vT_times_v(deriv);
+      ++nused;
+    }
+    if (nused < 4) return false;
+    int ierr;
+    gamma.invert(ierr);
+    if (ierr != 0) return false;
+    HepVector delta = gamma*beta;
+    fpos = ref + e1*delta(1) + e2*delta(2);
+    fdir = (udir + e1*delta(3) + e2*delta(4)).unit();
+    return true;
+  }
+}
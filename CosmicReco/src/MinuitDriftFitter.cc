@@ -253,8 +253,8 @@ void DoDriftTimeFit(
   }
 }
 
-void DoDriftTimeFit(int const& diag, CosmicTrackSeed& tseed, StrawResponse const& srep,
-                    const Tracker* tracker, double mntolerance, double mnprecision) {
+void SeedDriftTimeFit(CosmicTrackSeed const& tseed, std::vector<double>& pars,
+                      std::vector<double>& errors) {
 
   auto dir = tseed._track.FitEquation.Dir;
   auto intercept = tseed._track.FitEquation.Pos;
@@ -262,8 +262,8 @@ void DoDriftTimeFit(int const& diag, CosmicTrackSeed& tseed, StrawResponse const
   intercept -= dir * intercept.y() / dir.y();
 
   // now gaussian fit, transverse distance only
-  std::vector<double> errors(5, 0);
-  std::vector<double> pars(5, 0);
+  errors.assign(5, 0);
+  pars.assign(5, 0);
 
   pars[0] = intercept.x();
   pars[1] = intercept.z();
@@ -275,12 +275,10 @@ void DoDriftTimeFit(int const& diag, CosmicTrackSeed& tseed, StrawResponse const
   errors[2] = tseed._track.FitParams.Covarience.sigA1;
   errors[3] = tseed._track.FitParams.Covarience.sigB1;
   errors[4] = tseed._t0.t0Err();
+}
 
-  // Define the PDF used by Minuit:
-  GaussianDriftFit fit(tseed._straw_chits, srep, tracker);
-  DoDriftTimeFit(pars, errors, tseed._track.MinuitParams.cov, 
-    tseed._track.minuit_converged, fit, 
-    diag, mntolerance, mnprecision);
+void StoreDriftTimeFit(CosmicTrackSeed& tseed, std::vector<double> const& pars,
+                       std::vector<double> const& errors, const Tracker* tracker) {
 
   tseed._track.MinuitParams.A0 = pars[0];
   tseed._track.MinuitParams.B0 = pars[1];
@@ -317,4 +315,19 @@ void DoDriftTimeFit(int const& diag, CosmicTrackSeed& tseed, StrawResponse const
   }
 }
 
+void DoDriftTimeFit(int const& diag, CosmicTrackSeed& tseed, StrawResponse const& srep,
+                    const Tracker* tracker, double mntolerance, double mnprecision) {
+
+  std::vector<double> errors, pars;
+  SeedDriftTimeFit(tseed, pars, errors);
+
+  // Define the PDF used by Minuit:
+  GaussianDriftFit fit(tseed._straw_chits, srep, tracker);
+  DoDriftTimeFit(pars, errors, tseed._track.MinuitParams.cov, 
+    tseed._track.minuit_converged, fit, 
+    diag, mntolerance, mnprecision);
+
+  StoreDriftTimeFit(tseed, pars, errors, tracker);
+}
+
 } // namespace MinuitDriftFitter
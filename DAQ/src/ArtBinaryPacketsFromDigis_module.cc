@@ -11,6 +11,7 @@
 #include <iostream>
 #include <string>
 #include <cmath>
+#include <chrono>
 
 #include <math.h>
 
@@ -122,6 +123,7 @@ namespace mu2e {
       fhicl::Atom<int>            includeCrv            { Name("includeCrv"),             Comment("include Crv digis")};
       fhicl::Atom<int>            includeDMAHeaders     { Name("includeDMAHeaders"),      Comment("include DMA Headers")};
       fhicl::Atom<int>            generateBinaryFile    { Name("generateBinaryFile"),     Comment("generate BinaryFile")};
+      fhicl::Atom<int>            streamingMode         { Name("streamingMode"),          Comment("serialize ROC packets directly into a reusable DMA buffer"), 0};
       fhicl::Atom<std::string>    outputFile            { Name("outputFile"),             Comment("output File name")};
       fhicl::Atom<int>            generateTextFile      { Name("generateTextFile"),       Comment("generate Text File")};
       fhicl::Atom<int>            diagLevel             { Name("diagLevel"),              Comment("diagnostic Level")};
@@ -158,6 +160,11 @@ namespace mu2e {
     // Set to 1 to save packet data to a binary file
     int _generateBinaryFile;
 
+    // Set to 1 to encode each ROC directly into a single reusable DMA buffer
+    // which is written out as soon as it fills, instead of building the full
+    // list of DataBlocks and DMA buffers of the event in memory
+    int _streamingMode;
+
     string                _outputFile;
     ofstream              outputStream;
 
@@ -212,6 +219,18 @@ namespace mu2e {
 
     size_t  _numWordsWritten;
     size_t  _numEventsProcessed;
+    double  _encodingTime;           // [s] time spent encoding and writing the events
+
+    //--------------------------------------------------------------------------------
+    // streaming mode buffers, reused from event to event
+    //--------------------------------------------------------------------------------
+    mu2e_databuff_t       _streamBuffer;
+    size_t                _streamPos;
+    std::vector<size_t>   _rocOffsets;  // first entry of each ROC in _rocHits
+    std::vector<size_t>   _rocHits;     // digi indices grouped by ROC, in digi order
+    std::vector<size_t>   _hitRocs;     // ROC of each digi
+    std::vector<CRVHitReadoutPacket> _crvHits;
+    CrvDataPacket         _crvScratch;
 
 
     const Calorimeter* _calorimeter; // cached pointer to the calorimeter geometry
@@ -311,6 +330,20 @@ namespace mu2e {
       }
     }
 
+    //--------------------------------------------------------------------------------
+    //  methods used in streaming mode
+    //--------------------------------------------------------------------------------
+    void   streamOpenBuffer() { _streamPos = 16; } // DMA Size words
+    void   streamWriteBuffer();
+    void   streamReserve(size_t blockSize);
+    void   streamAppend(const void* data, size_t size);
+    void   streamPad();
+    void   groupHitsByRoc(size_t nRocs);
+
+    void   streamTrackerData(art::Event& evt, uint64_t& eventNum);
+    void   streamCalorimeterData(art::Event& evt, uint64_t& eventNum);
+    void   streamCrvData(art::Event& evt, uint64_t& eventNum);
+
     std::vector<adc_t> generateDMABlockHeader(size_t theCount) const;
     std::vector<adc_t> generateEventByteHeader(size_t theCount) const;
   };
@@ -623,6 +656,7 @@ namespace mu2e {
     _includeCrv            (config().includeCrv()),
     _includeDMAHeaders     (config().includeDMAHeaders()),
     _generateBinaryFile    (config().generateBinaryFile()),
+    _streamingMode         (config().streamingMode()),
     _outputFile            (config().outputFile()),
     _generateTextFile      (config().generateTextFile()),
     _diagLevel             (config().diagLevel()),
@@ -631,7 +665,9 @@ namespace mu2e {
     _cdtoken               { consumes<mu2e::CaloDigiCollection> (config().cdtoken())},
     _crvtoken              { consumes<mu2e::CrvDigiCollection>  (config().crvtoken())},
     _numWordsWritten(0),
-    _numEventsProcessed(0){
+    _numEventsProcessed(0),
+    _encodingTime(0),
+    _streamPos(0){
 
       produces<timestamp>();
 
@@ -693,6 +729,16 @@ namespace mu2e {
 		<< " events to "
 		<< _outputFile
 		<< std::endl;
+      if (_encodingTime > 0) {
+	std::cout << "BinaryPacketsFromDataBlocks: "
+		  << (_streamingMode ? "streaming" : "buffered")
+		  << " encoding took "
+		  << _encodingTime
+		  << " s ("
+		  << _numEventsProcessed/_encodingTime
+		  << " events/s)"
+		  << std::endl;
+      }
     }
 
   }
@@ -718,6 +764,33 @@ namespace mu2e {
       cout << "ArtBinaryPacketsFromDigis: eventNum: " << eventNum << endl;
     }
 
+    auto start_time = std::chrono::high_resolution_clock::now();
+
+    if (_streamingMode > 0 && _generateBinaryFile == 1) {
+      streamOpenBuffer();
+
+      if (_includeTracker > 0) {
+	streamTrackerData(evt, ts);
+      }
+
+      if (_includeCalorimeter > 0) {
+	streamCalorimeterData(evt, ts);
+      }
+
+      if (_includeCrv > 0) {
+	streamCrvData(evt, ts);
+      }
+
+      streamWriteBuffer();
+      outputStream << std::flush;
+
+      _encodingTime += std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start_time).count();
+      _numEventsProcessed += 1;
+
+      evt.put(std::unique_ptr<timestamp>(new timestamp(ts)));
+      return;
+    }
+
     tracker_data_block_list_t trackerData;
     calo_data_block_list_t caloData;
     crv_data_block_list_t crvData;
@@ -760,6 +833,7 @@ namespace mu2e {
       flushBuffer(dataStream);
     }
 
+    _encodingTime += std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start_time).count();
     _numEventsProcessed += 1;
 
     // Store the timestamp and DataBlockCollection in the event
@@ -1326,6 +1400,252 @@ namespace mu2e {
     dataStream.back().second = pos;
   }
 
+  //--------------------------------------------------------------------------------
+  // streaming mode: the DataBlocks of each ROC are serialized directly into
+  // _streamBuffer, which is written to the output file as soon as the next
+  // DataBlock does not fit. The byte stream is identical to the one produced
+  // through the DataBlock lists and flushBuffer
+  //--------------------------------------------------------------------------------
+  void   ArtBinaryPacketsFromDigis::streamWriteBuffer() {
+    uint64_t sz = _streamPos;
+    if (sz < 48) {
+      bzero(&_streamBuffer[sz], 48 - sz);
+      sz = 48;
+    }
+    uint64_t ex_sz = sz - 16;
+
+    memcpy(&_streamBuffer[0], &sz, sizeof(uint64_t));
+    memcpy(&_streamBuffer[8], &ex_sz, sizeof(uint64_t));
+
+    outputStream.write(reinterpret_cast<const char*>(&_streamBuffer[0]), sz);
+    _numWordsWritten += sz;
+  }
+
+  void   ArtBinaryPacketsFromDigis::streamReserve(size_t blockSize) {
+    if (blockSize >= sizeof(mu2e_databuff_t)) {
+      throw cet::exception("Online-RECO")<<"ArtBinaryPacketsFromDigis::streamReserve : DataBlock of " << blockSize
+					 << " bytes does not fit in a DMA buffer" << std::endl;
+    }
+    if (_streamPos + blockSize >= sizeof(mu2e_databuff_t)) {
+      streamWriteBuffer();
+      streamOpenBuffer();
+    }
+  }
+
+  void   ArtBinaryPacketsFromDigis::streamAppend(const void* data, size_t size) {
+    memcpy(&_streamBuffer[_streamPos], data, size);
+    _streamPos += size;
+  }
+
+  void   ArtBinaryPacketsFromDigis::streamPad() {
+    while (_streamPos % 16 != 0) _streamBuffer[_streamPos++] = 0;
+  }
+
+  //--------------------------------------------------------------------------------
+  // counting sort of the digi indices stored in _hitRocs by ROC, keeping the
+  // digi order within each ROC
+  //--------------------------------------------------------------------------------
+  void   ArtBinaryPacketsFromDigis::groupHitsByRoc(size_t nRocs) {
+    for (auto roc : _hitRocs) {
+      if (roc >= nRocs) nRocs = roc + 1;
+    }
+    _rocOffsets.assign(nRocs + 1, 0);
+    for (auto roc : _hitRocs) ++_rocOffsets[roc + 1];
+    for (size_t i = 0; i < nRocs; ++i) _rocOffsets[i + 1] += _rocOffsets[i];
+
+    _rocHits.resize(_hitRocs.size());
+    for (size_t i = 0; i < _hitRocs.size(); ++i) {
+      _rocHits[_rocOffsets[_hitRocs[i]]++] = i;
+    }
+    // restore the start offsets, shifted by one entry during the fill
+    for (size_t i = nRocs; i > 0; --i) _rocOffsets[i] = _rocOffsets[i - 1];
+    _rocOffsets[0] = 0;
+  }
+
+  void   ArtBinaryPacketsFromDigis::streamTrackerData(art::Event& evt, uint64_t& eventNum) {
+    auto  const& sdH = evt.getValidHandle(_sdtoken);
+    const StrawDigiCollection& hits_SD(*sdH);
+
+    _hitRocs.resize(hits_SD.size());
+    for (size_t i = 0; i < hits_SD.size(); ++i) {
+      size_t globalROCID = hits_SD[i].strawId().getPlane()*number_of_rocs_per_dtc + hits_SD[i].strawId().getPanel();
+      if (globalROCID >= number_of_rocs) {
+	throw cet::exception("DATA") << " Global ROC ID " << globalROCID
+				     << " exceeds limit of " << number_of_rocs;
+      }
+      _hitRocs[i] = globalROCID;
+    }
+    groupHitsByRoc(number_of_rocs);
+
+    if (_diagLevel > 1) {
+      std::cout << "[ArtBinaryPacketsFromDigis::streamTrackerData ] Total number of tracker non-empty DataBlocks = " <<
+	hits_SD.size() << std::endl;
+    }
+
+    uint8_t max_dtc_id = number_of_rocs / number_of_rocs_per_dtc - 1;
+    if (number_of_rocs % number_of_rocs_per_dtc > 0) {
+      max_dtc_id += 1;
+    }
+
+    for (uint8_t dtcID = 0; dtcID < max_dtc_id; dtcID++) {
+      for (uint8_t rocID = 0; rocID < number_of_rocs_per_dtc; ++rocID) {
+	size_t globalROCID = dtcID*number_of_rocs_per_dtc + rocID;
+
+	if (_rocOffsets[globalROCID] == _rocOffsets[globalROCID + 1]) {
+	  DataBlockHeader   headerData;
+	  fillEmptyHeaderDataPacket(headerData, eventNum, rocID, dtcID, DTCLib::DTC_Subsystem_Tracker);
+	  streamReserve(sizeof(DataBlockHeader));
+	  streamAppend(&headerData, sizeof(DataBlockHeader));
+	  continue;
+	}
+
+	for (size_t j = _rocOffsets[globalROCID]; j < _rocOffsets[globalROCID + 1]; ++j) {
+	  StrawDigi const& SD = hits_SD[_rocHits[j]];
+	  DataBlockHeader   headerData;
+	  fillTrackerHeaderDataPacket(SD, headerData, eventNum);
+	  TrackerDataPacket trkData;
+	  fillTrackerDataPacket(SD, trkData);
+
+	  streamReserve(sizeof(DataBlockHeader) + sizeof(TrackerDataPacket));
+	  streamAppend(&headerData, sizeof(DataBlockHeader));
+	  streamAppend(&trkData, sizeof(TrackerDataPacket));
+	}
+      }
+    }
+  }
+
+  void   ArtBinaryPacketsFromDigis::streamCalorimeterData(art::Event& evt, uint64_t& eventNum) {
+    auto  const& cdH = evt.getValidHandle(_cdtoken);
+    const CaloDigiCollection& hits_CD(*cdH);
+
+    _hitRocs.resize(hits_CD.size());
+    for (size_t i = 0; i < hits_CD.size(); ++i) {
+      _hitRocs[i] = _calorimeter->caloInfo().crystalByRO(hits_CD[i].roId()) / number_of_crystals_per_roc;
+    }
+    groupHitsByRoc(number_of_calo_rocs);
+
+    if (_diagLevel > 1) {
+      std::cout << "[ArtBinaryPacketsFromDigis::streamCalorimeterData ] Total number of calorimeter digis = " <<
+	hits_CD.size() << std::endl;
+    }
+
+    uint8_t max_dtc_id = number_of_calo_rocs / number_of_calo_rocs_per_dtc - 1;
+    if (number_of_calo_rocs % number_of_calo_rocs_per_dtc > 0) {
+      max_dtc_id += 1;
+    }
+
+    for (uint8_t dtcID = 0; dtcID < max_dtc_id; dtcID++) {
+      for (uint8_t rocID = 0; rocID < number_of_calo_rocs_per_dtc; ++rocID) {
+	size_t globalROCID = dtcID*number_of_calo_rocs_per_dtc + rocID;
+	size_t first = _rocOffsets[globalROCID];
+	size_t last  = _rocOffsets[globalROCID + 1];
+
+	DataBlockHeader   headerData;
+	if (first == last) {
+	  fillEmptyHeaderDataPacket(headerData, eventNum, rocID, dtcID, DTCLib::DTC_Subsystem_Calorimeter);
+	  streamReserve(sizeof(DataBlockHeader));
+	  streamAppend(&headerData, sizeof(DataBlockHeader));
+	  continue;
+	}
+
+	// header and byte counts, as in fillHeaderByteAndPacketCounts
+	uint16_t hitCount = last - first;
+	size_t   sz       = sizeof(DataBlockHeader) + sizeof(uint16_t) + sizeof(CalorimeterBoardID) +
+	  (sizeof(uint16_t) + sizeof(CalorimeterHitReadoutPacket)) * hitCount;
+	for (size_t j = first; j < last; ++j) {
+	  sz += sizeof(adc_t) * hits_CD[_rocHits[j]].waveform().size();
+	}
+	while (sz % 16 != 0) sz++;
+
+	fillCalorimeterHeaderDataPacket(hits_CD[_rocHits[first]], headerData, eventNum);
+	headerData.ByteCount   = sz;
+	headerData.PacketCount = (sz - 16) / 16;
+
+	streamReserve(sz);
+	streamAppend(&headerData, sizeof(DataBlockHeader));
+	streamAppend(&hitCount, sizeof(uint16_t));
+
+	uint16_t idxPos = sizeof(uint16_t) + sizeof(CalorimeterBoardID) + sizeof(uint16_t) * hitCount;
+	for (size_t j = first; j < last; ++j) {
+	  streamAppend(&idxPos, sizeof(uint16_t));
+	  idxPos += sizeof(CalorimeterHitReadoutPacket) + sizeof(adc_t) * hits_CD[_rocHits[j]].waveform().size();
+	}
+
+	CalorimeterBoardID      ccBoardID;
+	ccBoardID.BoardID             = globalROCID % number_of_calo_rocs_per_dtc;
+	ccBoardID.ChannelStatusFlagsA = 0;
+	ccBoardID.ChannelStatusFlagsB = 0;
+	ccBoardID.unused              = 0;
+	streamAppend(&ccBoardID, sizeof(CalorimeterBoardID));
+
+	for (size_t j = first; j < last; ++j) {
+	  CaloDigi const& CD        = hits_CD[_rocHits[j]];
+	  auto const&     waveform  = CD.waveform();
+	  size_t          crystalId = _calorimeter->caloInfo().crystalByRO(CD.roId());
+
+	  CalorimeterHitReadoutPacket   hitPacket;
+	  hitPacket.ChannelNumber   = CD.roId();
+	  hitPacket.DIRACA          = 0;
+	  hitPacket.DIRACB          = (((CD.roId() % 2) << 12) | (crystalId));
+	  hitPacket.ErrorFlags      = 0;
+	  hitPacket.Time            = CD.t0();
+	  hitPacket.NumberOfSamples = waveform.size();
+
+	  // the waveform is converted in place, right after the hit packet
+	  size_t  hitPos   = _streamPos;
+	  adc_t   content  = 0;
+	  size_t  indexMax = 0;
+	  _streamPos += sizeof(CalorimeterHitReadoutPacket);
+	  for (size_t i = 0; i < waveform.size(); ++i) {
+	    adc_t sample = (adc_t)waveform[i];
+	    if (sample > content) {
+	      content  = sample;
+	      indexMax = i;
+	    }
+	    streamAppend(&sample, sizeof(adc_t));
+	  }
+	  hitPacket.IndexOfMaxDigitizerSample = indexMax;
+	  memcpy(&_streamBuffer[hitPos], &hitPacket, sizeof(CalorimeterHitReadoutPacket));
+	}
+	streamPad();
+      }
+    }
+  }
+
+  void   ArtBinaryPacketsFromDigis::streamCrvData(art::Event& evt, uint64_t& eventNum) {
+    auto  const& crvdH = evt.getValidHandle(_crvtoken);
+    const CrvDigiCollection& digis(*crvdH);
+
+    _crvHits.resize(digis.size());
+    _hitRocs.resize(digis.size());
+    for (size_t i = 0; i < digis.size(); ++i) {
+      int globalRocID;
+      fillCrvDataPacket(digis[i], _crvHits[i], globalRocID);
+      _hitRocs[i] = globalRocID;
+    }
+    groupHitsByRoc(number_of_crv_rocs);
+
+    if (_diagLevel > 1) {
+      std::cout << "[ArtBinaryPacketsFromDigis::streamCrvData ] Total number of CRV digis = " << digis.size() << std::endl;
+    }
+
+    for (uint8_t globalRocID = 0; globalRocID < number_of_crv_rocs; globalRocID++) {
+      _crvScratch.hits.clear();
+      for (size_t j = _rocOffsets[globalRocID]; j < _rocOffsets[globalRocID + 1]; ++j) {
+	_crvScratch.hits.push_back(_crvHits[_rocHits[j]]);
+      }
+      fillCrvHeaderPacket(_crvScratch, globalRocID, eventNum);
+
+      streamReserve(_crvScratch.header.ByteCount);
+      streamAppend(&_crvScratch.header, sizeof(DataBlockHeader));
+      streamAppend(&_crvScratch.rocStatus, sizeof(CRVROCStatusPacket));
+      if (!_crvScratch.hits.empty()) {
+	streamAppend(&_crvScratch.hits[0], sizeof(CRVHitReadoutPacket) * _crvScratch.hits.size());
+      }
+      streamPad();
+    }
+  }
+
 }
 
 
@@ -38,6 +38,7 @@
 #include "Mu2eUtilities/inc/MuonCaptureSpectrum.hh"
 #include "Mu2eUtilities/inc/SimpleSpectrum.hh"
 #include "Mu2eUtilities/inc/BinnedSpectrum.hh"
+#include "Mu2eUtilities/inc/BinnedSpectrumSampler.hh"
 #include "Mu2eUtilities/inc/Table.hh"
 #include "Mu2eUtilities/inc/RootTreeSampler.hh"
 #include "GeneralUtilities/inc/RSNTIO.hh"
@@ -69,7 +70,7 @@ namespace mu2e {
 
     art::RandomNumberGenerator::base_engine_t& eng_;
 
-    CLHEP::RandGeneral  randSpectrum_;
+    BinnedSpectrumSampler randSpectrum_;
     CLHEP::RandFlat     randomFlat_;
     RandomUnitSphere    randomUnitSphere_;
     MuonCaptureSpectrum muonCaptureSpectrum_;
@@ -106,7 +107,7 @@ namespace mu2e {
     , phimin_                    (pset.get<double>("phimin",  0. ))
     , phimax_                    (pset.get<double>("phimax", CLHEP::twopi ))
     , eng_(createEngine(art::ServiceHandle<SeedService>()->getSeed()))
-    , randSpectrum_       (eng_, spectrum_.getPDF(), spectrum_.getNbins())
+    , randSpectrum_       (eng_, spectrum_, psphys_.get<std::string>("spectrumSampler", "RandGeneral"))
     , randomFlat_         (eng_)
     , randomUnitSphere_   (eng_, czmin_,czmax_,phimin_,phimax_)
     , muonCaptureSpectrum_(&randomFlat_,&randomUnitSphere_)
@@ -40,6 +40,7 @@
 #include "Mu2eUtilities/inc/PionCaptureSpectrum.hh"
 #include "Mu2eUtilities/inc/SimpleSpectrum.hh"
 #include "Mu2eUtilities/inc/BinnedSpectrum.hh"
+#include "Mu2eUtilities/inc/BinnedSpectrumSampler.hh"
 #include "Mu2eUtilities/inc/Table.hh"
 #include "Mu2eUtilities/inc/RootTreeSampler.hh"
 #include "GeneralUtilities/inc/RSNTIO.hh"
@@ -74,7 +75,7 @@ namespace mu2e {
 
     art::RandomNumberGenerator::base_engine_t& eng_;
 
-    CLHEP::RandGeneral  randSpectrum_;
+    BinnedSpectrumSampler randSpectrum_;
     CLHEP::RandFlat     randomFlat_;
     RandomUnitSphere    randomUnitSphere_;
     PionCaptureSpectrum pionCaptureSpectrum_;
@@ -116,7 +117,7 @@ namespace mu2e {
     , phimin_                    (pset.get<double>("phimin",  0. ))
     , phimax_                    (pset.get<double>("phimax", CLHEP::twopi ))
     , eng_(createEngine(art::ServiceHandle<SeedService>()->getSeed()))
-    , randSpectrum_       (eng_, spectrum_.getPDF(), spectrum_.getNbins())
+    , randSpectrum_       (eng_, spectrum_, psphys_.get<std::string>("spectrumSampler", "RandGeneral"))
     , randomFlat_         (eng_)
     , randomUnitSphere_   (eng_, czmin_,czmax_,phimin_,phimax_)
     , pionCaptureSpectrum_(&randomFlat_,&randomUnitSphere_)
@@ -39,6 +39,7 @@
 #include "Mu2eUtilities/inc/MuonCaptureSpectrum.hh"
 #include "Mu2eUtilities/inc/SimpleSpectrum.hh"
 #include "Mu2eUtilities/inc/BinnedSpectrum.hh"
+#include "Mu2eUtilities/inc/BinnedSpectrumSampler.hh"
 #include "Mu2eUtilities/inc/Table.hh"
 #include "Mu2eUtilities/inc/RootTreeSampler.hh"
 #include "GeneralUtilities/inc/RSNTIO.hh"
@@ -67,7 +68,7 @@ namespace mu2e {
     art::RandomNumberGenerator::base_engine_t& eng_;
     const double czmax_;
     const double czmin_;
-    CLHEP::RandGeneral*  randSpectrum_;
+    BinnedSpectrumSampler* randSpectrum_;
     RandomUnitSphere     randUnitSphere_;
     RandomUnitSphere     randUnitSphereExt_; //For photons, to limit cosz
     CLHEP::RandFlat      randFlat_;
@@ -151,7 +152,7 @@ namespace mu2e {
     // initialize binned spectrum - this needs to be done right
     parseSpectrumShape(psphys_);
 
-    randSpectrum_ = new CLHEP::RandGeneral(eng_, spectrum_.getPDF(), spectrum_.getNbins());
+    randSpectrum_ = new BinnedSpectrumSampler(eng_, spectrum_, psphys_.get<std::string>("spectrumSampler", "RandGeneral"));
 
     if ( doHistograms_ ) {
       art::ServiceHandle<art::TFileService> tfs;
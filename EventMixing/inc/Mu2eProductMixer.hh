@@ -1,7 +1,18 @@
 // A class that encapsulates event mixing code that is common for
 // different Mu2e use cases.  It provides and registers callbacks to
 // mix various data products, and is supposed to be used by MixFilter
-// "detail" classes.  More documentation can be found in
+// "detail" classes.
+//
+// In the frame pool mode the secondary events read for the first
+// primary event are kept in memory as a pool of frames, stored
+// flattened with art::Ptrs replaced by keys relative to the frame.
+// Every event, including the first one, is then built from the pool
+// frames selected by startPoolEvent(), so that the secondary input
+// is read only once.  Only GenParticles, SimParticles, StepPointMCs,
+// CaloShowerSteps, StrawGasSteps, ProtonBunchIntensity, proton time
+// maps and EventIDs are supported in this mode.
+//
+// More documentation can be found in
 //
 //    art/Framework/Modules/MixFilter.h
 //    art/Framework/IO/ProductMix/MixHelper.h
@@ -24,6 +35,7 @@
 #include "canvas/Utilities/InputTag.h"
 
 #include "art/Framework/IO/ProductMix/MixHelper.h"
+#include "art/Framework/Principal/Event.h"
 
 #include "MCDataProducts/inc/GenParticleCollection.hh"
 #include "MCDataProducts/inc/SimParticleCollection.hh"
@@ -76,7 +88,17 @@ namespace mu2e {
       fhicl::Table<CollectionMixerConfig> eventIDMixer { fhicl::Name("eventIDMixer") };
     };
 
-    Mu2eProductMixer(const Config& conf, art::MixHelper& helper);
+    Mu2eProductMixer(const Config& conf, art::MixHelper& helper, bool useFramePool = false);
+
+    // Frame pool mode: the number of frames in the pool, zero until it
+    // is filled by the first event.
+    size_t poolSize() const { return poolSize_; }
+
+    // Frame pool mode: the pool frames to be mixed into the event.
+    void startPoolEvent(const art::Event& event, const std::vector<size_t>& frames);
+
+    // Frame pool mode: memory used by the pooled products, in bytes.
+    size_t poolMemory() const;
 
   private:
 
@@ -133,6 +155,83 @@ namespace mu2e {
     std::vector<GenOffset> genOffsets_;
 
     void updateSimParticle(SimParticle& particle, SPOffset offset, art::PtrRemapper const& remap);
+
+    //----------------
+    // Frame pool mode.  Objects of all frames are stored contiguously;
+    // frame i owns the entries [frameBegin[i], frameBegin[i+1]).
+    // References to SimParticles and GenParticles are stored as keys
+    // relative to the frame, -1 for a null Ptr.
+    struct PooledSimParticles {
+      std::vector<SimParticle> particles;   // with all the Ptrs reset
+      std::vector<SPOffset> keys;
+      std::vector<long> parents;
+      std::vector<long> genParticles;
+      std::vector<size_t> daughterBegin { 0 };
+      std::vector<SPOffset> daughters;
+      std::vector<size_t> frameBegin { 0 };
+      std::vector<SPOffset> frameKeyRange;  // offset increment of the frame in the flattened collection
+    };
+
+    template<class T>
+    struct PooledObjects {
+      std::vector<T> objects;               // with the SimParticle Ptr reset
+      std::vector<long> simKeys;
+      std::vector<size_t> frameBegin { 0 };
+      size_t memory() const {
+        return objects.capacity()*sizeof(T) + simKeys.capacity()*sizeof(long) + frameBegin.capacity()*sizeof(size_t);
+      }
+    };
+
+    bool useFramePool_;
+    size_t poolSize_;
+    std::vector<size_t> poolFrames_;
+
+    // the output collections that pooled Ptrs point to
+    bool poolHasSims_;
+    std::string simInstance_;
+    art::ProductID simPID_;
+    art::EDProductGetter const* simGetter_;
+    bool poolHasGens_;
+    std::string genInstance_;
+    art::ProductID genPID_;
+    art::EDProductGetter const* genGetter_;
+
+    PooledObjects<GenParticle> poolGenParticles_;
+    PooledSimParticles poolSimParticles_;
+    std::vector<PooledObjects<StepPointMC> > poolStepPointMCs_;
+    std::vector<PooledObjects<CaloShowerStep> > poolCaloShowerSteps_;
+    std::vector<PooledObjects<StrawGasStep> > poolStrawGasSteps_;
+    std::vector<PooledObjects<double> > poolProtonTimeMaps_;
+    std::vector<PooledObjects<ProtonBunchIntensity> > poolProtonBunchIntensities_;
+    std::vector<PooledObjects<art::EventID> > poolEventIDs_;
+
+    void declarePoolMixOps(const Config& conf, art::MixHelper& helper);
+    void checkPoolSize(size_t nFrames);
+    void checkPoolFrames(size_t nFrames) const;
+    art::Ptr<SimParticle> poolSimPtr(long key, SPOffset offset) const;
+
+    bool poolGenParticles(std::vector<GenParticleCollection const*> const& in,
+                          GenParticleCollection& out);
+
+    bool poolSimParticles(std::vector<SimParticleCollection const*> const& in,
+                          SimParticleCollection& out);
+
+    template<class COLL>
+    bool poolSteps(PooledObjects<typename COLL::value_type>& pool,
+                   std::vector<COLL const*> const& in,
+                   COLL& out);
+
+    bool poolProtonTimeMap(PooledObjects<double>& pool,
+                           std::vector<SimParticleTimeMap const*> const& in,
+                           SimParticleTimeMap& out);
+
+    bool poolProtonBunchIntensity(PooledObjects<ProtonBunchIntensity>& pool,
+                                  std::vector<ProtonBunchIntensity const*> const& in,
+                                  ProtonBunchIntensity& out);
+
+    bool poolEventIDs(PooledObjects<art::EventID>& pool,
+                      std::vector<art::EventIDSequence const*> const& in,
+                      art::EventIDSequence& out);
   };
 
 }
@@ -7,9 +7,22 @@
 // of a secondary from a given proton creating a hit in a collection
 // to be mixed.  This Poisson is sampled by the module.
 //
+// With framePoolSize > 0 the module reads framePoolSize secondary
+// events once, for the first output event, and keeps them in memory.
+// The frames mixed into each output event are then drawn uniformly
+// from this pool without replacement, so that no further secondary
+// input is read and no frame appears twice in the same event.  An
+// event that needs more frames than the pool holds is an error.  The
+// pool should still be large compared to the number of frames mixed
+// per event, because frames are reused between output events.
+//
 // Andrei Gaponenko, 2018
 
 #include <random>
+#include <numeric>
+#include <utility>
+
+#include "cetlib_except/exception.h"
 
 #include "art/Framework/Principal/Event.h"
 #include "art/Framework/Core/ModuleMacros.h"
@@ -24,6 +37,7 @@
 #include "fhiclcpp/types/Table.h"
 #include "fhiclcpp/types/TupleAs.h"
 #include "canvas/Utilities/InputTag.h"
+#include "messagefacility/MessageLogger/MessageLogger.h"
 
 #include "EventMixing/inc/Mu2eProductMixer.hh"
 #include "Mu2eUtilities/inc/artURBG.hh"
@@ -50,6 +64,13 @@ namespace mu2e {
     bool writeEventIDs_;
     art::EventIDSequence idseq_;
 
+    const size_t framePoolSize_;
+    std::vector<size_t> poolFrames_;
+    std::vector<size_t> poolIndices_; // permutation of [0, framePoolSize_) for the draw
+    art::EventIDSequence poolEventIDs_;
+    bool poolFilled_;
+    bool poolReported_;
+
   public:
 
     struct Mu2eConfig {
@@ -92,6 +113,13 @@ namespace mu2e {
           Comment("Write out IDs of events on the secondary input stream."),
           false
           };
+
+      fhicl::Atom<unsigned> framePoolSize { Name("framePoolSize"),
+          Comment("If non-zero, read this many secondary events once and draw the frames\n"
+                  "mixed into every event from this in-memory pool.  Zero reads new\n"
+                  "secondary events for every output event."),
+          0u
+          };
     };
 
     // The ".mu2e" in FHICL parameters like
@@ -119,7 +147,7 @@ namespace mu2e {
 
   //================================================================
   MixBackgroundFramesDetail::MixBackgroundFramesDetail(const Parameters& pars, art::MixHelper& helper)
-    : spm_{ pars().mu2e().products(), helper }
+    : spm_{ pars().mu2e().products(), helper, pars().mu2e().framePoolSize() > 0 }
     , pbiTag_{ pars().mu2e().protonBunchIntensityTag() }
     , meanEventsPerProton_{ pars().mu2e().meanEventsPerProton() }
     , debugLevel_{ pars().mu2e().debugLevel() }
@@ -128,20 +156,53 @@ namespace mu2e {
     , totalBkgCount_(0)
     , skipFactor_{ pars().mu2e().skipFactor() }
     , writeEventIDs_{ pars().mu2e().writeEventIDs() }
+    , framePoolSize_{ pars().mu2e().framePoolSize() }
+    , poolIndices_( framePoolSize_ )
+    , poolFilled_{ false }
+    , poolReported_{ false }
   {
     if(writeEventIDs_) {
       helper.produces<art::EventIDSequence>();
     }
+    std::iota(poolIndices_.begin(), poolIndices_.end(), 0);
   }
 
   //================================================================
   void MixBackgroundFramesDetail::startEvent(const art::Event& event) {
     pbi_ = *event.getValidHandle<ProtonBunchIntensity>(pbiTag_);
     if(debugLevel_ > 0)std::cout << " Starting event mixing, Intensity = " << pbi_.intensity() << std::endl;
+
+    if(framePoolSize_ > 0) {
+      double mean = meanEventsPerProton_ * pbi_.intensity();
+      std::poisson_distribution<size_t> poisson(mean);
+      const size_t nFrames = poisson(urbg_);
+      if(nFrames > framePoolSize_) {
+        throw cet::exception("BADCONFIG")<<"MixBackgroundFrames: event needs "<<nFrames
+                                         <<" frames, but framePoolSize is only "<<framePoolSize_<<std::endl;
+      }
+
+      // Partial Fisher-Yates shuffle: the first nFrames entries of
+      // poolIndices_ become a uniform draw without replacement.  The
+      // permutation is kept between events, which does not bias the draw.
+      for(size_t i = 0; i < nFrames; ++i) {
+        std::uniform_int_distribution<size_t> uniform(i, framePoolSize_ - 1);
+        std::swap(poolIndices_[i], poolIndices_[uniform(urbg_)]);
+      }
+      poolFrames_.assign(poolIndices_.begin(), poolIndices_.begin() + nFrames);
+      spm_.startPoolEvent(event, poolFrames_);
+      if(debugLevel_ > 0)std::cout << " Mixing " << poolFrames_.size() << " frames from the pool " << std::endl;
+    }
   }
 
   //================================================================
   size_t MixBackgroundFramesDetail::nSecondaries() {
+    if(framePoolSize_ > 0) {
+      // Only the first event reads secondaries, to fill the pool
+      size_t res = poolFilled_ ? 0 : framePoolSize_;
+      poolFilled_ = true;
+      return res;
+    }
+
     double mean = meanEventsPerProton_ * pbi_.intensity();
     std::poisson_distribution<size_t> poisson(mean);
     auto res = poisson(urbg_);
@@ -161,11 +222,25 @@ namespace mu2e {
   }
 
   //================================================================
-  void MixBackgroundFramesDetail::processEventIDs(art::EventIDSequence const& seq) {
-    if(writeEventIDs_) {
-      idseq_ = seq;
+  void MixBackgroundFramesDetail::processEventIDs(art::EventIDSequence const& inseq) {
+    const art::EventIDSequence* pseq = &inseq;
+
+    if(framePoolSize_ > 0) {
+      if(!inseq.empty()) {
+        poolEventIDs_ = inseq;
+      }
+      idseq_.clear();
+      for(auto frame: poolFrames_) {
+        idseq_.push_back(poolEventIDs_.at(frame));
+      }
+      pseq = &idseq_;
+    }
+    else if(writeEventIDs_) {
+      idseq_ = inseq;
     }
 
+    const auto& seq = *pseq;
+
     if (debugLevel_ > 4) {
       std::cout << "The following bkg events were mixed in (START)" << std::endl;
       int counter = 0;
@@ -181,6 +256,12 @@ namespace mu2e {
 
   //================================================================
   void MixBackgroundFramesDetail::finalizeEvent(art::Event& e) {
+    if(framePoolSize_ > 0 && !poolReported_) {
+      poolReported_ = true;
+      mf::LogInfo("Summary")<<"MixBackgroundFrames: pooled "<<spm_.poolSize()
+                            <<" frames using "<<spm_.poolMemory()/1024<<" kB\n";
+    }
+
     if(writeEventIDs_) {
       auto o = std::make_unique<art::EventIDSequence>();
       o->swap(idseq_);
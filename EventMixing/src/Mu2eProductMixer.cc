@@ -38,10 +38,29 @@ namespace mu2e {
       }
       return std::distance(offsets.begin(), --ub);
     }
+
+    // Uniform access to the SimParticle Ptr of the pooled step types
+    art::Ptr<SimParticle> const& simPtr(StepPointMC const& step) { return step.simParticle(); }
+    art::Ptr<SimParticle> const& simPtr(CaloShowerStep const& step) { return step.simParticle(); }
+    art::Ptr<SimParticle> const& simPtr(StrawGasStep const& step) { return step.simParticle(); }
+    void setSimPtr(StepPointMC& step, art::Ptr<SimParticle> const& p) { step.simParticle() = p; }
+    void setSimPtr(CaloShowerStep& step, art::Ptr<SimParticle> const& p) { step.setSimParticle(p); }
+    void setSimPtr(StrawGasStep& step, art::Ptr<SimParticle> const& p) { step.simParticle() = p; }
   }
 
   //----------------------------------------------------------------
-  Mu2eProductMixer::Mu2eProductMixer(const Config& conf, art::MixHelper& helper) {
+  Mu2eProductMixer::Mu2eProductMixer(const Config& conf, art::MixHelper& helper, bool useFramePool)
+    : useFramePool_{useFramePool}
+    , poolSize_{0}
+    , poolHasSims_{false}
+    , simGetter_{nullptr}
+    , poolHasGens_{false}
+    , genGetter_{nullptr}
+  {
+    if(useFramePool_) {
+      declarePoolMixOps(conf, helper);
+      return;
+    }
 
     for(const auto& e: conf.genParticleMixer().mixingMap()) {
       helper.declareMixOp
@@ -95,6 +114,100 @@ namespace mu2e {
 
   }
 
+  //----------------------------------------------------------------
+  // The mix ops are declared in the same order as in the standard
+  // mode, so that GenParticles and SimParticles are mixed, and their
+  // offsets known, before the products that point to them.
+  void Mu2eProductMixer::declarePoolMixOps(const Config& conf, art::MixHelper& helper) {
+
+    if(conf.genParticleMixer().mixingMap().size() > 1 || conf.simParticleMixer().mixingMap().size() > 1) {
+      throw cet::exception("CONFIG")<<"Mu2eProductMixer: the frame pool mode supports at most one "
+                                    <<"GenParticle and one SimParticle collection"<<std::endl;
+    }
+    if(!conf.mcTrajectoryMixer().mixingMap().empty() || !conf.extMonSimHitMixer().mixingMap().empty()) {
+      throw cet::exception("CONFIG")<<"Mu2eProductMixer: MCTrajectories and ExtMonFNALSimHits "
+                                    <<"can not be mixed in the frame pool mode"<<std::endl;
+    }
+
+    // reserve the pools, they must not move once the ops are declared
+    poolStepPointMCs_.resize(conf.stepPointMCMixer().mixingMap().size());
+    poolCaloShowerSteps_.resize(conf.caloShowerStepMixer().mixingMap().size());
+    poolStrawGasSteps_.resize(conf.strawGasStepMixer().mixingMap().size());
+    poolProtonBunchIntensities_.resize(conf.protonBunchIntensityMixer().mixingMap().size());
+    poolProtonTimeMaps_.resize(conf.protonTimeMapMixer().mixingMap().size());
+    poolEventIDs_.resize(conf.eventIDMixer().mixingMap().size());
+
+    for(const auto& e: conf.genParticleMixer().mixingMap()) {
+      poolHasGens_ = true;
+      genInstance_ = e.resolvedInstanceName();
+      helper.declareMixOp<GenParticleCollection>
+        (e.inTag, e.resolvedInstanceName(),
+         [this](auto const& in, auto& out, auto const&) { return poolGenParticles(in, out); });
+    }
+
+    for(const auto& e: conf.simParticleMixer().mixingMap()) {
+      poolHasSims_ = true;
+      simInstance_ = e.resolvedInstanceName();
+      helper.declareMixOp<SimParticleCollection>
+        (e.inTag, e.resolvedInstanceName(),
+         [this](auto const& in, auto& out, auto const&) { return poolSimParticles(in, out); });
+    }
+
+    size_t i = 0;
+    for(const auto& e: conf.stepPointMCMixer().mixingMap()) {
+      auto& pool = poolStepPointMCs_[i++];
+      helper.declareMixOp<StepPointMCCollection>
+        (e.inTag, e.resolvedInstanceName(),
+         [this, &pool](auto const& in, auto& out, auto const&) { return poolSteps(pool, in, out); });
+    }
+
+    i = 0;
+    for(const auto& e: conf.caloShowerStepMixer().mixingMap()) {
+      auto& pool = poolCaloShowerSteps_[i++];
+      helper.declareMixOp<CaloShowerStepCollection>
+        (e.inTag, e.resolvedInstanceName(),
+         [this, &pool](auto const& in, auto& out, auto const&) { return poolSteps(pool, in, out); });
+    }
+
+    i = 0;
+    for(const auto& e: conf.strawGasStepMixer().mixingMap()) {
+      auto& pool = poolStrawGasSteps_[i++];
+      helper.declareMixOp<StrawGasStepCollection>
+        (e.inTag, e.resolvedInstanceName(),
+         [this, &pool](auto const& in, auto& out, auto const&) { return poolSteps(pool, in, out); });
+    }
+
+    i = 0;
+    for(const auto& e: conf.protonBunchIntensityMixer().mixingMap()) {
+      auto& pool = poolProtonBunchIntensities_[i++];
+      helper.declareMixOp<ProtonBunchIntensity>
+        (e.inTag, e.resolvedInstanceName(),
+         [this, &pool](auto const& in, auto& out, auto const&) { return poolProtonBunchIntensity(pool, in, out); });
+    }
+
+    i = 0;
+    for(const auto& e: conf.protonTimeMapMixer().mixingMap()) {
+      auto& pool = poolProtonTimeMaps_[i++];
+      helper.declareMixOp<SimParticleTimeMap>
+        (e.inTag, e.resolvedInstanceName(),
+         [this, &pool](auto const& in, auto& out, auto const&) { return poolProtonTimeMap(pool, in, out); });
+    }
+
+    i = 0;
+    for(const auto& e: conf.eventIDMixer().mixingMap()) {
+      auto& pool = poolEventIDs_[i++];
+      helper.declareMixOp<art::EventIDSequence>
+        (e.inTag, e.resolvedInstanceName(),
+         [this, &pool](auto const& in, auto& out, auto const&) { return poolEventIDs(pool, in, out); });
+    }
+
+    if(!poolHasSims_ && (!poolStepPointMCs_.empty() || !poolCaloShowerSteps_.empty() ||
+                         !poolStrawGasSteps_.empty() || !poolProtonTimeMaps_.empty())) {
+      throw cet::exception("CONFIG")<<"Mu2eProductMixer: the frame pool mode needs the SimParticles "
+                                    <<"pointed to by the mixed steps"<<std::endl;
+    }
+  }
+
   //----------------------------------------------------------------
   bool Mu2eProductMixer::mixGenParticles(std::vector<GenParticleCollection const*> const& in,
                                          GenParticleCollection& out,
@@ -285,6 +398,251 @@ namespace mu2e {
   }
 
   //----------------------------------------------------------------
+  // Frame pool mode
+  //----------------------------------------------------------------
+  void Mu2eProductMixer::startPoolEvent(const art::Event& event, const std::vector<size_t>& frames) {
+    poolFrames_ = frames;
+
+    if(poolHasSims_) {
+      simPID_ = event.getProductID<SimParticleCollection>(simInstance_);
+      simGetter_ = event.productGetter(simPID_);
+    }
+    if(poolHasGens_) {
+      genPID_ = event.getProductID<GenParticleCollection>(genInstance_);
+      genGetter_ = event.productGetter(genPID_);
+    }
+  }
+
+  //----------------------------------------------------------------
+  size_t Mu2eProductMixer::poolMemory() const {
+    const auto& sims = poolSimParticles_;
+    size_t res = poolGenParticles_.memory()
+      + sims.particles.capacity()*sizeof(SimParticle)
+      + (sims.keys.capacity() + sims.daughters.capacity() + sims.frameKeyRange.capacity())*sizeof(SPOffset)
+      + (sims.parents.capacity() + sims.genParticles.capacity())*sizeof(long)
+      + (sims.daughterBegin.capacity() + sims.frameBegin.capacity())*sizeof(size_t);
+
+    for(const auto& pool: poolStepPointMCs_) res += pool.memory();
+    for(const auto& pool: poolCaloShowerSteps_) res += pool.memory();
+    for(const auto& pool: poolStrawGasSteps_) res += pool.memory();
+    for(const auto& pool: poolProtonTimeMaps_) res += pool.memory();
+    for(const auto& pool: poolProtonBunchIntensities_) res += pool.memory();
+    for(const auto& pool: poolEventIDs_) res += pool.memory();
+
+    return res;
+  }
+
+  //----------------------------------------------------------------
+  // All pooled products must be filled from the same secondary events
+  void Mu2eProductMixer::checkPoolSize(size_t nFrames) {
+    if(poolSize_ == 0) {
+      poolSize_ = nFrames;
+    }
+    else if(poolSize_ != nFrames) {
+      throw cet::exception("BUG")<<"Mu2eProductMixer: filling a pool of "<<nFrames
+                                 <<" frames, expected "<<poolSize_<<std::endl;
+    }
+  }
+
+  void Mu2eProductMixer::checkPoolFrames(size_t nFrames) const {
+    for(auto frame: poolFrames_) {
+      if(frame >= nFrames) {
+        throw cet::exception("RANGE")<<"Mu2eProductMixer: frame "<<frame
+                                     <<" requested from a pool of "<<nFrames<<" frames"<<std::endl;
+      }
+    }
+  }
+
+  art::Ptr<SimParticle> Mu2eProductMixer::poolSimPtr(long key, SPOffset offset) const {
+    return (key < 0) ? art::Ptr<SimParticle>() : art::Ptr<SimParticle>(simPID_, key + offset, simGetter_);
+  }
+
+  //----------------------------------------------------------------
+  bool Mu2eProductMixer::poolGenParticles(std::vector<GenParticleCollection const*> const& in,
+                                          GenParticleCollection& out)
+  {
+    auto& pool = poolGenParticles_;
+    if(!in.empty()) {
+      checkPoolSize(in.size());
+      for(auto coll: in) {
+        if(coll) {
+          pool.objects.insert(pool.objects.end(), coll->begin(), coll->end());
+        }
+        pool.frameBegin.push_back(pool.objects.size());
+      }
+    }
+    checkPoolFrames(pool.frameBegin.size() - 1);
+
+    genOffsets_.clear();
+    for(auto frame: poolFrames_) {
+      genOffsets_.push_back(out.size());
+      out.insert(out.end(), pool.objects.begin() + pool.frameBegin[frame], pool.objects.begin() + pool.frameBegin[frame+1]);
+    }
+    return true;
+  }
+
+  //----------------------------------------------------------------
+  bool Mu2eProductMixer::poolSimParticles(std::vector<SimParticleCollection const*> const& in,
+                                          SimParticleCollection& out)
+  {
+    auto& pool = poolSimParticles_;
+    if(!in.empty()) {
+      checkPoolSize(in.size());
+      for(auto coll: in) {
+        if(coll) {
+          for(const auto& entry: *coll) {
+            SimParticle particle = entry.second;
+            pool.keys.push_back(entry.first.asUint());
+            pool.parents.push_back(particle.parent().isNonnull() ? long(particle.parent().key()) : -1);
+            pool.genParticles.push_back(particle.genParticle().isNonnull() ? long(particle.genParticle().key()) : -1);
+            for(const auto& d: particle.daughters()) {
+              pool.daughters.push_back(d.key());
+            }
+            pool.daughterBegin.push_back(pool.daughters.size());
+
+            particle.parent() = art::Ptr<SimParticle>();
+            particle.genParticle() = art::Ptr<GenParticle>();
+            particle.daughters().clear();
+            pool.particles.push_back(particle);
+          }
+        }
+        pool.frameBegin.push_back(pool.particles.size());
+        pool.frameKeyRange.push_back(coll ? coll->delta() : 0);
+      }
+    }
+    checkPoolFrames(pool.frameBegin.size() - 1);
+
+    // Same keys and offsets as flattenCollections() followed by updateSimParticle()
+    simOffsets_.clear();
+    SPOffset offset = 0;
+    for(size_t ie = 0; ie < poolFrames_.size(); ++ie) {
+      auto frame = poolFrames_[ie];
+      simOffsets_.push_back(offset);
+      for(size_t i = pool.frameBegin[frame]; i < pool.frameBegin[frame+1]; ++i) {
+        SimParticle particle = pool.particles[i];
+        particle.id() = SimParticle::key_type( particle.id().asInt() + offset );
+        particle.parent() = poolSimPtr(pool.parents[i], offset);
+        for(size_t id = pool.daughterBegin[i]; id < pool.daughterBegin[i+1]; ++id) {
+          particle.daughters().push_back(poolSimPtr(pool.daughters[id], offset));
+        }
+        if(!genOffsets_.empty() && pool.genParticles[i] >= 0) {
+          particle.genParticle() = art::Ptr<GenParticle>(genPID_, pool.genParticles[i] + genOffsets_[ie], genGetter_);
+        }
+        out.insert(std::make_pair(SimParticle::key_type(pool.keys[i] + offset), particle));
+      }
+      offset += pool.frameKeyRange[frame];
+    }
+    return true;
+  }
+
+  //----------------------------------------------------------------
+  template<class COLL>
+  bool Mu2eProductMixer::poolSteps(PooledObjects<typename COLL::value_type>& pool,
+                                   std::vector<COLL const*> const& in,
+                                   COLL& out)
+  {
+    if(!in.empty()) {
+      checkPoolSize(in.size());
+      for(auto coll: in) {
+        if(coll) {
+          for(const auto& step: *coll) {
+            pool.simKeys.push_back(simPtr(step).isNonnull() ? long(simPtr(step).key()) : -1);
+            pool.objects.push_back(step);
+            setSimPtr(pool.objects.back(), art::Ptr<SimParticle>());
+          }
+        }
+        pool.frameBegin.push_back(pool.objects.size());
+      }
+    }
+    checkPoolFrames(pool.frameBegin.size() - 1);
+
+    size_t nsteps = 0;
+    for(auto frame: poolFrames_) {
+      nsteps += pool.frameBegin[frame+1] - pool.frameBegin[frame];
+    }
+    out.reserve(out.size() + nsteps);
+
+    for(size_t ie = 0; ie < poolFrames_.size(); ++ie) {
+      auto frame = poolFrames_[ie];
+      for(size_t i = pool.frameBegin[frame]; i < pool.frameBegin[frame+1]; ++i) {
+        out.push_back(pool.objects[i]);
+        setSimPtr(out.back(), poolSimPtr(pool.simKeys[i], simOffsets_[ie]));
+      }
+    }
+    return true;
+  }
+
+  //----------------------------------------------------------------
+  bool Mu2eProductMixer::poolProtonTimeMap(PooledObjects<double>& pool,
+                                           std::vector<SimParticleTimeMap const*> const& in,
+                                           SimParticleTimeMap& out)
+  {
+    if(!in.empty()) {
+      checkPoolSize(in.size());
+      for(auto timemap: in) {
+        if(timemap) {
+          for(const auto& imap: *timemap) {
+            pool.simKeys.push_back(imap.first.key());
+            pool.objects.push_back(imap.second);
+          }
+        }
+        pool.frameBegin.push_back(pool.objects.size());
+      }
+    }
+    checkPoolFrames(pool.frameBegin.size() - 1);
+
+    for(size_t ie = 0; ie < poolFrames_.size(); ++ie) {
+      auto frame = poolFrames_[ie];
+      for(size_t i = pool.frameBegin[frame]; i < pool.frameBegin[frame+1]; ++i) {
+        out[poolSimPtr(pool.simKeys[i], simOffsets_[ie])] = pool.objects[i];
+      }
+    }
+    return true;
+  }
+
+  //----------------------------------------------------------------
+  bool Mu2eProductMixer::poolProtonBunchIntensity(PooledObjects<ProtonBunchIntensity>& pool,
+                                                  std::vector<ProtonBunchIntensity const*> const& in,
+                                                  ProtonBunchIntensity& out)
+  {
+    if(!in.empty()) {
+      checkPoolSize(in.size());
+      for(auto pbi: in) {
+        pool.objects.push_back(pbi ? *pbi : ProtonBunchIntensity());
+        pool.frameBegin.push_back(pool.objects.size());
+      }
+    }
+    checkPoolFrames(pool.frameBegin.size() - 1);
+
+    for(auto frame: poolFrames_) {
+      out.add(pool.objects[frame]);
+    }
+    return true;
+  }
+
+  //----------------------------------------------------------------
+  bool Mu2eProductMixer::poolEventIDs(PooledObjects<art::EventID>& pool,
+                                      std::vector<art::EventIDSequence const*> const& in,
+                                      art::EventIDSequence& out)
+  {
+    if(!in.empty()) {
+      checkPoolSize(in.size());
+      for(auto seq: in) {
+        if(seq) {
+          pool.objects.insert(pool.objects.end(), seq->begin(), seq->end());
+        }
+        pool.frameBegin.push_back(pool.objects.size());
+      }
+    }
+    checkPoolFrames(pool.frameBegin.size() - 1);
+
+    for(auto frame: poolFrames_) {
+      out.insert(out.end(), pool.objects.begin() + pool.frameBegin[frame], pool.objects.begin() + pool.frameBegin[frame+1]);
+    }
+    return true;
+  }
+
+  //----------------------------------------------------------------
 
 }
 //================================================================
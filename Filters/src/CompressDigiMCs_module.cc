@@ -26,6 +26,8 @@
 #include "art_root_io/TFileService.h"
 
 #include <memory>
+#include <limits>
+#include <algorithm>
 
 #include "MCDataProducts/inc/StrawDigiMCCollection.hh"
 #include "MCDataProducts/inc/CrvDigiMCCollection.hh"
@@ -36,10 +38,8 @@
 #include "MCDataProducts/inc/StepPointMCCollection.hh"
 #include "MCDataProducts/inc/StrawGasStep.hh"
 #include "MCDataProducts/inc/SimParticleCollection.hh"
-#include "Mu2eUtilities/inc/compressSimParticleCollection.hh"
 #include "MCDataProducts/inc/GenParticleCollection.hh"
 #include "MCDataProducts/inc/SimParticleTimeMap.hh"
-#include "MCDataProducts/inc/SimParticleRemapping.hh"
 #include "DataProducts/inc/IndexMap.hh"
 #include "MCDataProducts/inc/CaloClusterMC.hh"
 #include "MCDataProducts/inc/CrvCoincidenceClusterMCCollection.hh"
@@ -49,39 +49,91 @@
 namespace mu2e {
   class CompressDigiMCs;
 
-  typedef std::set<art::Ptr<SimParticle> > SimParticleSet;
-
-  class SimParticleSelector {
+  // Flat table of the new index of each object of one input collection,
+  // indexed by the key of the old art::Ptr
+  class IndexRemap {
   public:
-    SimParticleSelector(const SimParticleSet& simPartSet) {
-      for (const auto& i_simPart : simPartSet) {
-        cet::map_vector_key key = cet::map_vector_key(i_simPart.key());
-        m_keys.insert(key);
-      }
+    static constexpr uint32_t noIndex = std::numeric_limits<uint32_t>::max();
+
+    IndexRemap(const art::ProductID& pid, size_t size = 0) : m_pid(pid), m_newIndex(size, noIndex) { }
+
+    const art::ProductID& id() const { return m_pid; }
+
+    bool contains(size_t oldIndex) const { return oldIndex < m_newIndex.size(); }
+
+    uint32_t operator[](size_t oldIndex) const {
+      return oldIndex < m_newIndex.size() ? m_newIndex[oldIndex] : noIndex;
     }
 
-    bool operator[]( cet::map_vector_key key ) const {
-      return m_keys.find(key) != m_keys.end();
+    void set(size_t oldIndex, uint32_t newIndex) {
+      if (oldIndex >= m_newIndex.size()) {
+        m_newIndex.resize(oldIndex+1, noIndex);
+      }
+      m_newIndex[oldIndex] = newIndex;
     }
 
-    const std::set<cet::map_vector_key>& keys() const {
-      return m_keys;
+  private:
+    art::ProductID m_pid;
+    std::vector<uint32_t> m_newIndex;
+  };
+  typedef std::vector<IndexRemap> IndexRemaps;
+
+  // The SimParticles that are kept from one input SimParticleCollection, and their keys
+  // in the output collection. Both are stored densely, indexed by the position of the
+  // SimParticle in the input collection
+  class SimParticleKeepList {
+  public:
+    static constexpr size_t npos = std::numeric_limits<size_t>::max();
+    static constexpr uint32_t noKey = std::numeric_limits<uint32_t>::max();
+
+    SimParticleKeepList(const art::ProductID& pid, const SimParticleCollection& coll) :
+      m_pid(pid), m_coll(&coll), m_keep(coll.size(), false), m_newKeys(coll.size(), noKey), m_nKept(0) { }
+
+    const art::ProductID& id() const { return m_pid; }
+    const SimParticleCollection& collection() const { return *m_coll; }
+    size_t nKept() const { return m_nKept; }
+
+    // position of a SimParticle in the input collection (npos if it is not there)
+    size_t index(cet::map_vector_key key) const {
+      auto i_simPart = m_coll->find(key);
+      return i_simPart == m_coll->end() ? npos : i_simPart - m_coll->begin();
     }
 
-    void clear() {
-      m_keys.clear();
+    bool isKept(size_t index) const { return index != npos && m_keep[index]; }
+
+    // Keep a SimParticle and all its parents. The walk up the parent chain stops at the
+    // first parent that is already kept, since all of its own parents are kept as well
+    void keep(cet::map_vector_key key) {
+      size_t i = index(key);
+      while (!isKept(i)) {
+        if (i == npos) {
+          throw cet::exception("CompressDigiMCs") << "SimParticle " << key << " is not in collection " << m_pid << std::endl;
+        }
+        m_keep[i] = true;
+        ++m_nKept;
+
+        // parents that are not in this collection (e.g. dropped by an earlier compression) end the chain
+        const auto& parentPtr = (m_coll->begin() + i)->second.parent();
+        if (parentPtr.isNull() || parentPtr.id() != m_pid) {
+          break;
+        }
+        key = cet::map_vector_key(parentPtr.key());
+        i = index(key);
+      }
     }
 
-  private:
-    std::set<cet::map_vector_key> m_keys;
+    uint32_t newKey(size_t index) const { return index != npos ? m_newKeys[index] : noKey; }
+    void setNewKey(size_t index, uint32_t key) { m_newKeys[index] = key; }
 
+  private:
+    art::ProductID m_pid;
+    const SimParticleCollection* m_coll;
+    std::vector<bool> m_keep;
+    std::vector<uint32_t> m_newKeys;
+    size_t m_nKept;
   };
 
-  typedef std::map<art::Ptr<mu2e::CaloShowerStep>, art::Ptr<mu2e::CaloShowerStep> > CaloShowerStepRemap;
   typedef std::string InstanceLabel;
-  typedef std::map<cet::map_vector_key, cet::map_vector_key> KeyRemap;
-  typedef std::map<art::Ptr<mu2e::StepPointMC>, art::Ptr<mu2e::StepPointMC> > StepPointMCRemap;
-  typedef std::map<art::Ptr<mu2e::StrawGasStep>, art::Ptr<mu2e::StrawGasStep> > StrawGasStepRemap;
 }
 
 
@@ -106,9 +158,14 @@ public:
   art::Ptr<StepPointMC> copyStepPointMC(const mu2e::StepPointMC& old_step, const InstanceLabel& instance);
   art::Ptr<StrawGasStep> copyStrawGasStep(const mu2e::StrawGasStep& old_step);
   art::Ptr<mu2e::CaloShowerStep> copyCaloShowerStep(const mu2e::CaloShowerStep& old_calo_shower_step);
-  void copyCaloShowerSim(const mu2e::CaloShowerSim& old_calo_shower_sim, const CaloShowerStepRemap& remap);
-  void copyCaloShowerStepRO(const mu2e::CaloShowerStepRO& old_calo_shower_step_ro, const CaloShowerStepRemap& remap);
+  void copyCaloShowerSim(const mu2e::CaloShowerSim& old_calo_shower_sim, const IndexRemaps& remap);
+  void copyCaloShowerStepRO(const mu2e::CaloShowerStepRO& old_calo_shower_step_ro, const IndexRemaps& remap);
+  art::Ptr<mu2e::CaloShowerStep> remapCaloShowerStep(const art::Ptr<mu2e::CaloShowerStep>& old_ptr, const IndexRemaps& remap) const;
   void keepSimParticle(const art::Ptr<SimParticle>& sim_ptr);
+  SimParticleKeepList* findKeepList(const art::ProductID& pid);
+  void compressSimParticles(SimParticleKeepList& keepList);
+  art::Ptr<SimParticle> findNewSimParticle(const art::Ptr<SimParticle>& old_ptr);
+  art::Ptr<SimParticle> remapSimParticle(const art::Ptr<SimParticle>& old_ptr);
   void copyCaloClusterMC(const mu2e::CaloClusterMC& old_calo_cluster_mc);
   void copyCrvCoincClusterMC(const mu2e::CrvCoincidenceClusterMC& old_crv_coinc_cluster_mc);
   void copyPrimaryParticle(const mu2e::PrimaryParticle& old_primary_particle);
@@ -159,8 +216,8 @@ private:
   const art::EDProductGetter* _newCaloShowerStepGetter;
   std::map<art::ProductID, const art::EDProductGetter*> _oldCaloShowerStepGetter;
 
-  // record the SimParticles that we are keeping so we can use compressSimParticleCollection to do all the work for us
-  std::map<art::ProductID, SimParticleSet> _simParticlesToKeep;
+  // record the SimParticles that we are keeping, one entry per input SimParticleCollection
+  std::vector<SimParticleKeepList> _simParticlesToKeep;
 
   InstanceLabel _crvOutputInstanceLabel;
   std::vector<InstanceLabel> _newStepPointMCInstances;
@@ -189,9 +246,8 @@ private:
 
   // For CrvDigiMCs, there's a chance that the same StepPointMC will go into multiple CrvDigiMCs
   // This module didn't take this into account initially and so the same StepPointMC was being written out multiple times
-  // This std::set is used to make sure that this doesn't happen
-  std::set<art::Ptr<StepPointMC> > _crvStepPointMCsSeen;
-  std::map<art::Ptr<StepPointMC>, art::Ptr<StepPointMC> > _crvStepPointMCsMap;
+  // This table of the new index of each StepPointMC already copied is used to make sure that this doesn't happen
+  IndexRemaps _crvStepPointMCsMap;
 };
 
 
@@ -286,12 +342,14 @@ void mu2e::CompressDigiMCs::produce(art::Event & event)
   // Create all the new collections, ProductIDs and product getters for the SimParticles and GenParticles
   // There is one for each background frame plus one for the primary event
   unsigned int n_gen_particles_to_keep = 0;
+  _simParticlesToKeep.clear();
+  _simParticlesToKeep.reserve(_simParticleTags.size());
   for (std::vector<art::InputTag>::const_iterator i_tag = _simParticleTags.begin(); i_tag != _simParticleTags.end(); ++i_tag) {
     const auto& oldSimParticles = event.getValidHandle<SimParticleCollection>(*i_tag);
     art::ProductID i_product_id = oldSimParticles.id();
     const art::EDProductGetter* i_product_getter = event.productGetter(i_product_id);
 
-    _simParticlesToKeep[i_product_id].clear();
+    _simParticlesToKeep.emplace_back(i_product_id, *oldSimParticles);
 
     if (_keepAllGenParticles) {
       // Add all the SimParticles that are also GenParticles
@@ -378,7 +436,6 @@ void mu2e::CompressDigiMCs::produce(art::Event & event)
 
 
   if (_crvDigiMCTag != "") {
-    _crvStepPointMCsSeen.clear();
     _crvStepPointMCsMap.clear();
 
     event.getByLabel(_crvDigiMCTag, _crvDigiMCsHandle);
@@ -404,7 +461,7 @@ void mu2e::CompressDigiMCs::produce(art::Event & event)
   // Two possible compressions for calorimeter
   // The first just takes the CaloShowerSteps, CaloShowerSims and CaloShowerStepROs and reassigns Ptrs (i.e. no actual compression....)
   if (_caloClusterMCTag == "") {
-    CaloShowerStepRemap caloShowerStepRemap;
+    IndexRemaps caloShowerStepRemap;
     _newCaloShowerSteps = std::unique_ptr<CaloShowerStepCollection>(new CaloShowerStepCollection);
     _newCaloShowerStepsPID = event.getProductID<CaloShowerStepCollection>();
     _newCaloShowerStepGetter = event.productGetter(_newCaloShowerStepsPID);
@@ -413,10 +470,13 @@ void mu2e::CompressDigiMCs::produce(art::Event & event)
       art::ProductID i_product_id = oldCaloShowerSteps.id();
       _oldCaloShowerStepGetter[i_product_id] = event.productGetter(i_product_id);
 
+      caloShowerStepRemap.emplace_back(i_product_id, oldCaloShowerSteps->size());
+      IndexRemap& i_remap = caloShowerStepRemap.back();
       for (CaloShowerStepCollection::const_iterator i_caloShowerStep = oldCaloShowerSteps->begin(); i_caloShowerStep != oldCaloShowerSteps->end(); ++i_caloShowerStep) {
-        art::Ptr<mu2e::CaloShowerStep> oldShowerStepPtr(i_product_id,  i_caloShowerStep - oldCaloShowerSteps->begin(), _oldCaloShowerStepGetter[i_product_id]);
         art::Ptr<mu2e::CaloShowerStep> newShowerStepPtr = copyCaloShowerStep(*i_caloShowerStep);
-        caloShowerStepRemap[oldShowerStepPtr] = newShowerStepPtr;
+        if (newShowerStepPtr.isNonnull()) {
+          i_remap.set(i_caloShowerStep - oldCaloShowerSteps->begin(), newShowerStepPtr.key());
+        }
       }
     }
 
@@ -460,49 +520,18 @@ void mu2e::CompressDigiMCs::produce(art::Event & event)
   for (std::vector<art::InputTag>::const_iterator i_tag = _extraStepPointMCTags.begin(); i_tag != _extraStepPointMCTags.end(); ++i_tag) {
     const auto& stepPointMCs = event.getValidHandle<StepPointMCCollection>(*i_tag);
     for (const auto& stepPointMC : *stepPointMCs) {
-      for (const auto& simPartsToKeep : _simParticlesToKeep) {
-        const art::ProductID& oldProdID = simPartsToKeep.first;
-        if (stepPointMC.simParticle().id() != oldProdID) {
-          continue;
-        }
-        const SimParticleSet& alreadyKeptSimParts = simPartsToKeep.second;
-        for (const auto& alreadyKeptSimPart : alreadyKeptSimParts) {
-          if (stepPointMC.simParticle() == alreadyKeptSimPart) {
-            copyStepPointMC(stepPointMC, (*i_tag).instance() );
-          }
-        }
+      const SimParticleKeepList* keepList = findKeepList(stepPointMC.simParticle().id());
+      if (keepList && keepList->isKept(keepList->index(cet::map_vector_key(stepPointMC.simParticle().key())))) {
+        copyStepPointMC(stepPointMC, (*i_tag).instance() );
       }
     }
   }
 
   // Now compress the SimParticleCollections into their new collections
-  KeyRemap* keyRemap = new KeyRemap;
-  SimParticleRemapping remap;
   unsigned int keep_size = 0;
-  for (std::vector<art::InputTag>::const_iterator i_tag = _simParticleTags.begin(); i_tag != _simParticleTags.end(); ++i_tag) {
-    keyRemap->clear();
-    const auto& oldSimParticles = event.getValidHandle<SimParticleCollection>(*i_tag);
-    art::ProductID i_product_id = oldSimParticles.id();
-    SimParticleSelector simPartSelector(_simParticlesToKeep[i_product_id]);
-    keep_size += _simParticlesToKeep[i_product_id].size();
-    if (_rekeySimParticleCollection) {
-      compressSimParticleCollection(_newSimParticlesPID, _newSimParticleGetter, *oldSimParticles,
-                                    simPartSelector, *_newSimParticles, keyRemap);
-    }
-    else {
-      compressSimParticleCollection(_newSimParticlesPID, _newSimParticleGetter, *oldSimParticles,
-                                    simPartSelector, *_newSimParticles);
-    }
-
-    // Fill out the SimParticleRemapping
-    for (const auto& i_keptSimPart : _simParticlesToKeep[i_product_id]) {
-      cet::map_vector_key oldKey = cet::map_vector_key(i_keptSimPart.key());
-      cet::map_vector_key newKey = oldKey;
-      if (_rekeySimParticleCollection) {
-        newKey = keyRemap->at(oldKey);
-      }
-      remap[i_keptSimPart] = art::Ptr<SimParticle>(_newSimParticlesPID, newKey.asUint(), _newSimParticleGetter);
-    }
+  for (auto& i_keepList : _simParticlesToKeep) {
+    keep_size += i_keepList.nKept();
+    compressSimParticles(i_keepList);
   }
   if (keep_size != _newSimParticles->size()) {
     throw cet::exception("CompressDigiMCs") << "Number of SimParticles in output collection ("
@@ -534,10 +563,8 @@ void mu2e::CompressDigiMCs::produce(art::Event & event)
     const SimParticleTimeMap& i_oldTimeMap = *i_time_map;
     SimParticleTimeMap& i_newTimeMap = *_newSimParticleTimeMaps.at(i_element);
     for (const auto& timeMapPair : i_oldTimeMap) {
-      art::Ptr<SimParticle> oldSimPtr = timeMapPair.first;
-      const auto& newSimPtrIter = remap.find(oldSimPtr);
-      if (newSimPtrIter != remap.end()) {
-        art::Ptr<SimParticle> newSimPtr = newSimPtrIter->second;
+      art::Ptr<SimParticle> newSimPtr = findNewSimParticle(timeMapPair.first);
+      if (newSimPtr.isNonnull()) {
         i_newTimeMap[newSimPtr] = timeMapPair.second;
       }
     }
@@ -546,34 +573,34 @@ void mu2e::CompressDigiMCs::produce(art::Event & event)
    // Update the StepPointMCs
   for (const auto& i_instance : _newStepPointMCInstances) {
     for (auto& i_stepPointMC : *_newStepPointMCs.at(i_instance)) {
-      art::Ptr<SimParticle> newSimPtr = remap.at(i_stepPointMC.simParticle());
+      art::Ptr<SimParticle> newSimPtr = remapSimParticle(i_stepPointMC.simParticle());
       i_stepPointMC.simParticle() = newSimPtr;
     }
   }
  
   // Update the StrawGasSteps
   for (auto& i_strawGasStep : *_newStrawGasSteps) {
-    art::Ptr<SimParticle> newSimPtr = remap.at(i_strawGasStep.simParticle());
+    art::Ptr<SimParticle> newSimPtr = remapSimParticle(i_strawGasStep.simParticle());
     i_strawGasStep.simParticle() = newSimPtr;
   }
 
   if (_caloClusterMCTag == "") {
     // Update the CaloShowerSteps
     for (auto& i_caloShowerStep : *_newCaloShowerSteps) {
-      art::Ptr<SimParticle> newSimPtr = remap.at(i_caloShowerStep.simParticle());
+      art::Ptr<SimParticle> newSimPtr = remapSimParticle(i_caloShowerStep.simParticle());
       i_caloShowerStep.setSimParticle(newSimPtr);
     }
 
     // Update the CaloShowerSims
     for (auto& i_caloShowerSim : *_newCaloShowerSims) {
-      art::Ptr<SimParticle> newSimPtr = remap.at(i_caloShowerSim.sim());
+      art::Ptr<SimParticle> newSimPtr = remapSimParticle(i_caloShowerSim.sim());
       i_caloShowerSim.setSimParticle(newSimPtr);
     }
   }
   else if (_caloClusterMCTag != "") {
     for (auto& i_caloClusterMC : *_newCaloClusterMCs) {
       for (auto& i_caloMCEDep : i_caloClusterMC._edeps) {
-        art::Ptr<SimParticle> newSimPtr = remap.at(i_caloMCEDep.sim());
+        art::Ptr<SimParticle> newSimPtr = remapSimParticle(i_caloMCEDep.sim());
         i_caloMCEDep._simp = newSimPtr;
       }
     }
@@ -584,7 +611,7 @@ void mu2e::CompressDigiMCs::produce(art::Event & event)
     art::Ptr<SimParticle> oldSimPtr = i_crvDigiMC.GetSimParticle();
     art::Ptr<SimParticle> newSimPtr;
     if (oldSimPtr.isNonnull()) { // if the old CrvDigiMC doesn't have a null ptr for the SimParticle...
-      newSimPtr = remap.at(oldSimPtr);
+      newSimPtr = remapSimParticle(oldSimPtr);
     }
     else {
       newSimPtr = art::Ptr<SimParticle>();
@@ -596,27 +623,27 @@ void mu2e::CompressDigiMCs::produce(art::Event & event)
     for (auto& i_crvCoincClusterMC : *_newCrvCoincClusterMCs) {
       for (auto& i_pulseInfo : i_crvCoincClusterMC.GetModifiablePulses()) {
         art::Ptr<SimParticle> oldSimPtr = i_pulseInfo._simParticle;
-        art::Ptr<SimParticle> newSimPtr = remap.at(oldSimPtr);
+        art::Ptr<SimParticle> newSimPtr = remapSimParticle(oldSimPtr);
         i_pulseInfo._simParticle = newSimPtr;
       }
 
       art::Ptr<SimParticle> oldSimPtr = i_crvCoincClusterMC.GetMostLikelySimParticle();
-      art::Ptr<SimParticle> newSimPtr = remap.at(oldSimPtr);
+      art::Ptr<SimParticle> newSimPtr = remapSimParticle(oldSimPtr);
       i_crvCoincClusterMC.SetMostLikelySimParticle(newSimPtr);
     }
   }
   // Update PrimaryParticle if needs be
   if (_primaryParticleTag != "") {
     for (auto& i_simPartPtr : _newPrimaryParticle->modifySimParticles()) {
-      i_simPartPtr = remap.at(i_simPartPtr);
+      i_simPartPtr = remapSimParticle(i_simPartPtr);
     }
   }
   // Create new MC Trajectory collection
   if (_mcTrajectoryTag != "") {
     for (const auto& i_mcTrajectory : *_mcTrajectoriesHandle) {
-      art::Ptr<SimParticle> oldSimPtr = i_mcTrajectory.first;
-      if (remap.find(oldSimPtr) != remap.end()) {
-        _newMCTrajectories->insert(std::pair<art::Ptr<SimParticle>, mu2e::MCTrajectory>(remap.at(oldSimPtr), i_mcTrajectory.second));
+      art::Ptr<SimParticle> newSimPtr = findNewSimParticle(i_mcTrajectory.first);
+      if (newSimPtr.isNonnull()) {
+        _newMCTrajectories->insert(std::pair<art::Ptr<SimParticle>, mu2e::MCTrajectory>(newSimPtr, i_mcTrajectory.second));
       }
     }
   }
@@ -664,25 +691,29 @@ void mu2e::CompressDigiMCs::produce(art::Event & event)
 
 void mu2e::CompressDigiMCs::copyStrawDigiMC(const mu2e::StrawDigiMC& old_straw_digi_mc) {
 
-  StrawGasStepRemap step_remap;
-
   // Need to update the Ptrs for the StepPointMCs
+  // Both ends usually share the same StrawGasStep, which is copied only once
   StrawDigiMC::SGSPA newTriggerStepPtr;
   for(int i_end=0;i_end<StrawEnd::nends;++i_end){
     StrawEnd::End end = static_cast<StrawEnd::End>(i_end);
 
     const auto& old_step_point = old_straw_digi_mc.strawGasStep(end);
-    const auto& newStepPtrIter = step_remap.find(old_step_point);
-    if (newStepPtrIter == step_remap.end()) {
+    bool copied = false;
+    for (int j_end=0;j_end<i_end;++j_end) {
+      if (old_straw_digi_mc.strawGasStep(static_cast<StrawEnd::End>(j_end)) == old_step_point) {
+	newTriggerStepPtr[i_end] = newTriggerStepPtr[j_end];
+	copied = true;
+	break;
+      }
+    }
+    if (!copied) {
       if (old_step_point.isAvailable()) {
-	step_remap[old_step_point] = copyStrawGasStep( *old_step_point);
+	newTriggerStepPtr[i_end] = copyStrawGasStep( *old_step_point);
       }
       else { // this is a null Ptr but it should be added anyway to keep consistency (not expected for StrawDigis)
-	step_remap[old_step_point] = old_step_point;
+	newTriggerStepPtr[i_end] = old_step_point;
       }
     }
-    art::Ptr<StrawGasStep> new_step_point = step_remap.at(old_step_point);
-    newTriggerStepPtr[i_end] = new_step_point;
   }
   StrawDigiMC new_straw_digi_mc(old_straw_digi_mc, newTriggerStepPtr); // copy everything except the Ptrs from the old StrawDigiMC
   _newStrawDigiMCs->push_back(new_straw_digi_mc);
@@ -694,13 +725,20 @@ void mu2e::CompressDigiMCs::copyCrvDigiMC(const mu2e::CrvDigiMC& old_crv_digi_mc
   std::vector<art::Ptr<StepPointMC> > newStepPtrs;
   for (const auto& i_step_mc : old_crv_digi_mc.GetStepPoints()) {
     if (i_step_mc.isAvailable()) {
-      if (_crvStepPointMCsSeen.insert(i_step_mc).second == true) { // if we have inserted this StepPointMCPtrs (i.e. it hasn't already been seen)
+      auto i_remap = std::find_if(_crvStepPointMCsMap.begin(), _crvStepPointMCsMap.end(),
+                                  [&i_step_mc](const IndexRemap& remap){ return remap.id() == i_step_mc.id(); });
+      if (i_remap == _crvStepPointMCsMap.end()) {
+        _crvStepPointMCsMap.emplace_back(i_step_mc.id());
+        i_remap = _crvStepPointMCsMap.end() - 1;
+      }
+      uint32_t newIndex = (*i_remap)[i_step_mc.key()];
+      if (newIndex == IndexRemap::noIndex) { // if this StepPointMC hasn't already been seen
         art::Ptr<StepPointMC> newStepPtr = copyStepPointMC(*i_step_mc, _crvOutputInstanceLabel);
         newStepPtrs.push_back(newStepPtr);
-        _crvStepPointMCsMap[i_step_mc] = newStepPtr;
+        i_remap->set(i_step_mc.key(), newStepPtr.key());
       }
       else {
-        newStepPtrs.push_back(_crvStepPointMCsMap.at(i_step_mc));
+        newStepPtrs.push_back(art::Ptr<StepPointMC>(_newStepPointMCsPID.at(_crvOutputInstanceLabel), newIndex, _newStepPointMCGetter.at(_crvOutputInstanceLabel)));
       }
     }
     else { // this is a null Ptr but it should be added anyway to keep consistency (expected for CrvDigis)
@@ -736,7 +774,7 @@ art::Ptr<mu2e::CaloShowerStep> mu2e::CompressDigiMCs::copyCaloShowerStep(const m
   }
 }
 
-void mu2e::CompressDigiMCs::copyCaloShowerSim(const mu2e::CaloShowerSim& old_calo_shower_sim, const CaloShowerStepRemap& remap) {
+void mu2e::CompressDigiMCs::copyCaloShowerSim(const mu2e::CaloShowerSim& old_calo_shower_sim, const IndexRemaps& remap) {
 
   art::Ptr<SimParticle> oldSimPtr = old_calo_shower_sim.sim();
   keepSimParticle(oldSimPtr);
@@ -744,7 +782,7 @@ void mu2e::CompressDigiMCs::copyCaloShowerSim(const mu2e::CaloShowerSim& old_cal
   const auto& caloShowerStepPtrs = old_calo_shower_sim.caloShowerSteps();
   std::vector<art::Ptr<CaloShowerStep> > newCaloShowerStepPtrs;
   for (const auto& i_caloShowerStepPtr : caloShowerStepPtrs) {
-    newCaloShowerStepPtrs.push_back(remap.at(i_caloShowerStepPtr));
+    newCaloShowerStepPtrs.push_back(remapCaloShowerStep(i_caloShowerStepPtr, remap));
   }
 
   CaloShowerSim new_calo_shower_sim = old_calo_shower_sim;
@@ -753,11 +791,11 @@ void mu2e::CompressDigiMCs::copyCaloShowerSim(const mu2e::CaloShowerSim& old_cal
   _newCaloShowerSims->push_back(new_calo_shower_sim);
 }
 
-void mu2e::CompressDigiMCs::copyCaloShowerStepRO(const mu2e::CaloShowerStepRO& old_calo_shower_step_ro, const CaloShowerStepRemap& remap) {
+void mu2e::CompressDigiMCs::copyCaloShowerStepRO(const mu2e::CaloShowerStepRO& old_calo_shower_step_ro, const IndexRemaps& remap) {
 
   const auto& caloShowerStepPtr = old_calo_shower_step_ro.caloShowerStep();
   CaloShowerStepRO new_calo_shower_step_ro = old_calo_shower_step_ro;
-  new_calo_shower_step_ro.setCaloShowerStep(remap.at(caloShowerStepPtr));
+  new_calo_shower_step_ro.setCaloShowerStep(remapCaloShowerStep(caloShowerStepPtr, remap));
 
   _newCaloShowerStepROs->push_back(new_calo_shower_step_ro);
 }
@@ -811,18 +849,112 @@ art::Ptr<mu2e::StrawGasStep> mu2e::CompressDigiMCs::copyStrawGasStep(const mu2e:
   return art::Ptr<StrawGasStep>(_newStrawGasStepsPID, _newStrawGasSteps->size()-1, _newStrawGasStepGetter);
 }
 
+art::Ptr<mu2e::CaloShowerStep> mu2e::CompressDigiMCs::remapCaloShowerStep(const art::Ptr<mu2e::CaloShowerStep>& old_ptr, const IndexRemaps& remap) const {
+
+  for (const auto& i_remap : remap) {
+    if (i_remap.id() == old_ptr.id() && i_remap.contains(old_ptr.key())) {
+      uint32_t newIndex = i_remap[old_ptr.key()];
+      if (newIndex == IndexRemap::noIndex) { // the old CaloShowerStep was not copied
+        return art::Ptr<CaloShowerStep>();
+      }
+      return art::Ptr<CaloShowerStep>(_newCaloShowerStepsPID, newIndex, _newCaloShowerStepGetter);
+    }
+  }
+  throw cet::exception("CompressDigiMCs") << "CaloShowerStep " << old_ptr.id() << ":" << old_ptr.key()
+                                          << " is not in any of the input CaloShowerStepCollections" << std::endl;
+}
+
+mu2e::SimParticleKeepList* mu2e::CompressDigiMCs::findKeepList(const art::ProductID& pid) {
+
+  for (auto& i_keepList : _simParticlesToKeep) {
+    if (i_keepList.id() == pid) {
+      return &i_keepList;
+    }
+  }
+  return nullptr;
+}
+
 void mu2e::CompressDigiMCs::keepSimParticle(const art::Ptr<SimParticle>& sim_ptr) {
 
   // Also need to add all the parents too
-  _simParticlesToKeep[sim_ptr.id()].insert(sim_ptr);
-  art::Ptr<SimParticle> childPtr = sim_ptr;
-  art::Ptr<SimParticle> parentPtr = childPtr->parent();
+  SimParticleKeepList* keepList = findKeepList(sim_ptr.id());
+  if (!keepList) {
+    throw cet::exception("CompressDigiMCs") << "SimParticle " << sim_ptr.id() << ":" << sim_ptr.key()
+                                            << " is not in any of the simParticleTags collections" << std::endl;
+  }
+  keepList->keep(cet::map_vector_key(sim_ptr.key()));
+}
+
+// Copy the kept SimParticles into the new collection and fix up their parent and daughter Ptrs.
+// New keys are handed out in the same order as compressSimParticleCollection, i.e. the
+// parent and the daughters of a SimParticle have their key reserved when it is copied
+void mu2e::CompressDigiMCs::compressSimParticles(SimParticleKeepList& keepList) {
+
+  const SimParticleCollection& oldSimParticles = keepList.collection();
+  unsigned int initial_out_size = _newSimParticles->size();
+  unsigned int n_new_keys = 0;
+  auto getNewKey = [&](size_t index) {
+    uint32_t newKey = keepList.newKey(index);
+    if (newKey == SimParticleKeepList::noKey) {
+      newKey = _rekeySimParticleCollection ? initial_out_size + n_new_keys++ : (oldSimParticles.begin() + index)->first.asUint();
+      keepList.setNewKey(index, newKey);
+    }
+    return newKey;
+  };
+
+  for (size_t i_index = 0; i_index < oldSimParticles.size(); ++i_index) {
+    if (!keepList.isKept(i_index)) {
+      continue;
+    }
+
+    cet::map_vector_key newSimKey = cet::map_vector_key(getNewKey(i_index));
+    SimParticle& sim = (*_newSimParticles)[newSimKey];
+    sim = (oldSimParticles.begin() + i_index)->second;
+
+    if (_rekeySimParticleCollection) {
+      sim.id() = newSimKey; // need to make sure the SimParticle's trackId is the same as its key in the output collection
+    }
+
+    if (sim.isSecondary()) {
+      size_t parentIndex = keepList.index(cet::map_vector_key(sim.parent().key()));
+      if (keepList.isKept(parentIndex)) {
+        sim.parent() = art::Ptr<SimParticle>(_newSimParticlesPID, getNewKey(parentIndex), _newSimParticleGetter);
+      }
+    }
+
+    // Remove daughters that have been deleted.
+    std::vector<art::Ptr<SimParticle> > daughters;
+    for (const auto& i_daughter : sim.daughters()) {
+      size_t daughterIndex = keepList.index(cet::map_vector_key(i_daughter.key()));
+      if (keepList.isKept(daughterIndex)) {
+        daughters.push_back(art::Ptr<SimParticle>(_newSimParticlesPID, getNewKey(daughterIndex), _newSimParticleGetter));
+      }
+    }
+    sim.setDaughterPtrs(daughters);
+  }
+}
+
+// Returns a null Ptr if the SimParticle was not kept
+art::Ptr<mu2e::SimParticle> mu2e::CompressDigiMCs::findNewSimParticle(const art::Ptr<SimParticle>& old_ptr) {
+
+  const SimParticleKeepList* keepList = findKeepList(old_ptr.id());
+  if (keepList) {
+    uint32_t newKey = keepList->newKey(keepList->index(cet::map_vector_key(old_ptr.key())));
+    if (newKey != SimParticleKeepList::noKey) {
+      return art::Ptr<SimParticle>(_newSimParticlesPID, newKey, _newSimParticleGetter);
+    }
+  }
+  return art::Ptr<SimParticle>();
+}
+
+art::Ptr<mu2e::SimParticle> mu2e::CompressDigiMCs::remapSimParticle(const art::Ptr<SimParticle>& old_ptr) {
 
-  while (parentPtr) {
-    _simParticlesToKeep[sim_ptr.id()].insert(parentPtr);
-    childPtr = parentPtr;
-    parentPtr = parentPtr->parent();
+  art::Ptr<SimParticle> newSimPtr = findNewSimParticle(old_ptr);
+  if (newSimPtr.isNull()) {
+    throw cet::exception("CompressDigiMCs") << "SimParticle " << old_ptr.id() << ":" << old_ptr.key()
+                                            << " was not kept in the compression" << std::endl;
   }
+  return newSimPtr;
 }
 
 
@@ -8,8 +8,13 @@
 //
 
 // C++ include files
-#include <string>
+#include <functional>
+#include <iosfwd>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
 
 // Framework include files
 #include "fhiclcpp/ParameterSet.h"
@@ -62,10 +67,9 @@ public:
       // to use this generic way requires a map of names (typeid?) to
       // abstract elements.
       // find the detector element requested
+      // In lazy mode a detector that has not been made yet is still available.
       std::string name = typeid(DET).name();
-      DetMap::iterator it(_detectors.find(name));
-
-      return !(it==_detectors.end());
+      return knowsDetector(name);
 
     }
 
@@ -77,6 +81,9 @@ private:
     // Some day this will become a database key or similar.
     std::string _inputfile;
 
+    // Optional binary snapshot of the parsed input file; see ConfigTools/src/SimpleConfigSnapshot.hh
+    std::string _snapshotFile;
+
     // Control the behaviour of messages from the SimpleConfig object holding
     // the geometry parameters.
     bool _allowReplacement;
@@ -88,6 +95,12 @@ private:
     bool _printConfig;
     bool _printTopLevel;
 
+    // Make each detector the first time it is requested instead of all of them in preBeginRun.
+    bool _lazyConstruction;
+
+    // Print the time and memory spent making each detector at the end of the job.
+    bool _constructionReport;
+
     // The object that parses run-time configuration file.
     std::unique_ptr<SimpleConfig> _config;
 
@@ -115,15 +128,15 @@ private:
 
       // to use this generic way requires a map of names (typeid?) to
       // abstract elements.
-      // find the detector element requested
+      // find the detector element requested, making it if needed
       std::string name = typeid(DET).name();
-      DetMap::iterator it(_detectors.find(name));
-      if(it==_detectors.end())
+      Detector* det = findDetector(name);
+      if(det==nullptr)
         throw cet::exception("GEOM")
           << "Failed to retrieve detector element of type " << name << "\n";
 
       // this must succeed or there is something terribly wrong
-      DET* d = dynamic_cast<DET*>(it->second.get());
+      DET* d = dynamic_cast<DET*>(det);
 
       if(d==0)
         throw cet::exception("GEOM")
@@ -139,6 +152,35 @@ private:
     // All of the detectors that we know about.
     DetMap _detectors;
 
+    // The recipes to make the detectors present in the configuration.  A maker
+    // may provide more than one detector; each detector type name is mapped to
+    // the maker that provides it.
+    struct DetectorMaker {
+      std::string           label;
+      std::function<void()> make;
+      bool                  started = false;
+    };
+    std::vector<DetectorMaker>    _makers;
+    std::map<std::string, size_t> _makerIndex;
+
+    // Time (ms) and resident memory (kB) spent in each maker, excluding the
+    // detectors it requested from other makers.
+    struct ConstructionInfo {
+      std::string label;
+      double      time;
+      long        memory;
+    };
+    std::vector<ConstructionInfo> _constructionInfo;
+    std::vector<ConstructionInfo> _nestedConstruction;
+
+    // Serializes detector lookup and construction in lazy mode.
+    std::recursive_mutex _detectorMutex;
+
+    Detector* findDetector(std::string const& name);
+    bool knowsDetector(std::string const& name);
+    void runMaker(size_t index);
+    void printConstructionReport(std::ostream& os) const;
+
     // Keep a count of how many runs we have seen.
     int _run_count;
 
@@ -149,6 +191,7 @@ private:
     // Don't need to expose definition of private template in header
     template <typename DET> void addDetector(std::unique_ptr<DET> d);
     template <typename DETALIAS, typename DET> void addDetectorAliasToBaseClass(std::unique_ptr<DET> d);
+    template <typename... DETS> void addMaker(std::string const& label, std::function<void()> make);
 
     // Some information that is provided through the GeometryService
     // should only be used inside GEANT jobs.  The following method is
@@ -293,6 +293,8 @@ namespace mu2e {
                  thisCrystal.setNeighbors(calo_->neighborsByLevel(icry + crystalOffset,1,true),true);
                  thisCrystal.setNextNeighbors(calo_->neighborsByLevel(icry + crystalOffset,2,false),false);
                  thisCrystal.setNextNeighbors(calo_->neighborsByLevel(icry + crystalOffset,2,true),true);
+                 calo_->neighborTable_.add(thisCrystal.neighbors(false),thisCrystal.nextNeighbors(false));
+                 calo_->neighborTableRaw_.add(thisCrystal.neighbors(true),thisCrystal.nextNeighbors(true));
 
                  //pre-compute the crystal position in the mu2e frame (aka global frame)
                  CLHEP::Hep3Vector globalPosition = thisDisk->geomInfo().origin() + thisDisk->geomInfo().inverseRotation()*(thisCrystal.localPosition());
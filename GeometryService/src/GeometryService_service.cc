@@ -6,7 +6,11 @@
 //
 
 // C++ include files
+#include <chrono>
+#include <fstream>
+#include <iomanip>
 #include <iostream>
+#include <sstream>
 #include <utility>
 
 // Framework include files
@@ -89,17 +93,39 @@
 
 using namespace std;
 
+namespace {
+
+  // Resident set size of this process, in kB, from /proc/self/status; 0 if not available.
+  long residentMemory(){
+    std::ifstream proc("/proc/self/status");
+    std::string line;
+    while ( std::getline(proc,line) ){
+      if ( line.compare(0,6,"VmRSS:") == 0 ){
+        std::istringstream is(line.substr(6));
+        long val(0);
+        is >> val;
+        return val;
+      }
+    }
+    return 0;
+  }
+
+}
+
 namespace mu2e {
 
   GeometryService::GeometryService(fhicl::ParameterSet const& pset,
                                    art::ActivityRegistry&iRegistry) :
     _inputfile(            pset.get<std::string> ("inputFile",            "geom000.txt")),
+    _snapshotFile(         pset.get<std::string> ("snapshotFile",         "")),
     _allowReplacement(     pset.get<bool>        ("allowReplacement",     true)),
     _messageOnReplacement( pset.get<bool>        ("messageOnReplacement", false)),
     _messageOnDefault(     pset.get<bool>        ("messageOnDefault",     false)),
     _configStatsVerbosity( pset.get<int>         ("configStatsVerbosity", 0)),
     _printConfig(          pset.get<bool>        ("printConfig",          false)),
     _printTopLevel(        pset.get<bool>        ("printConfigTopLevel",  false)),
+    _lazyConstruction(     pset.get<bool>        ("lazyConstruction",     false)),
+    _constructionReport(   pset.get<bool>        ("constructionReport",   false)),
     _config(nullptr),
     _pset   (pset),
     standardMu2eDetector_( _pset.get<std::string>("simulatedDetector.tool_type") == "Mu2e"),
@@ -142,6 +168,20 @@ namespace mu2e {
         _detectors[detectorName] = it->second;
   }
 
+  // Register a maker that provides the detectors of types DETS.
+  template <typename... DETS>
+  void GeometryService::addMaker(std::string const& label, std::function<void()> make)
+  {
+    for ( std::string const& name : { std::string(typeid(DETS).name())... } ){
+      if ( _makerIndex.find(name) != _makerIndex.end() ) {
+        throw cet::exception("GEOM") << "more than one maker for detector with type name "
+                                     << name << "\n";
+      }
+      _makerIndex[name] = _makers.size();
+    }
+    _makers.push_back(DetectorMaker{label, make});
+  }
+
   void
   GeometryService::preBeginRun(art::Run const &) {
 
@@ -153,7 +193,8 @@ namespace mu2e {
     _config = unique_ptr<SimpleConfig>(new SimpleConfig(_inputfile,
                                                       _allowReplacement,
                                                       _messageOnReplacement,
-                                                      _messageOnDefault ));
+                                                      _messageOnDefault,
+                                                      _snapshotFile ));
 
     _config->printOpen(cout,"Geometry");
 
@@ -199,156 +240,279 @@ namespace mu2e {
     // Throw if the configuration is not self consistent.
     checkConfig();
 
-    // This must be the first detector added since other makers may wish to use it.
-    std::unique_ptr<DetectorSystem> tmpDetSys(DetectorSystemMaker::make(*_config));
-    const DetectorSystem& detSys = *tmpDetSys.get();
-    addDetector(std::move(tmpDetSys));
+    // Register a maker for every component present in the configuration.  The makers
+    // get the detectors they depend on through getElement, so in lazy mode those are
+    // made on demand too.  In eager mode they are all run here, in this order.
 
-    // Make a detector for every component present in the configuration.
+    // In eager mode this must be the first detector made since other makers may wish to use it.
+    addMaker<DetectorSystem>("DetectorSystem", [this](){
+        addDetector(DetectorSystemMaker::make(*_config));
+      });
 
-    std::unique_ptr<Beamline> tmpBeamline(BeamlineMaker::make(*_config));
-    const Beamline& beamline = *tmpBeamline.get();
-    addDetector(std::move(tmpBeamline));
+    addMaker<Beamline>("Beamline", [this](){
+        addDetector(BeamlineMaker::make(*_config));
+      });
 
-    std::unique_ptr<ProductionTarget> tmpProdTgt(ProductionTargetMaker::make(*_config, beamline.solenoidOffset()));
-    const ProductionTarget& prodTarget = *tmpProdTgt.get();
-    addDetector(std::move(tmpProdTgt));
+    addMaker<ProductionTarget>("ProductionTarget", [this](){
+        addDetector(ProductionTargetMaker::make(*_config, getElement<Beamline>()->solenoidOffset()));
+      });
 
-    std::unique_ptr<ProductionSolenoid>
-      tmpProductionSolenoid(ProductionSolenoidMaker(*_config, beamline.solenoidOffset()).getProductionSolenoidPtr());
+    addMaker<ProductionSolenoid>("ProductionSolenoid", [this](){
+        addDetector(ProductionSolenoidMaker(*_config, getElement<Beamline>()->solenoidOffset()).getProductionSolenoidPtr());
+      });
 
-    const ProductionSolenoid& ps = *tmpProductionSolenoid.get();
-    addDetector(std::move(tmpProductionSolenoid));
+    addMaker<PSEnclosure>("PSEnclosure", [this](){
+        addDetector(PSEnclosureMaker::make(*_config, getElement<ProductionSolenoid>()->psEndRefPoint()));
+      });
 
-    std::unique_ptr<PSEnclosure>
-      tmpPSE(PSEnclosureMaker::make(*_config, ps.psEndRefPoint()));
-    const PSEnclosure& pse = *tmpPSE.get();
-    addDetector(std::move(tmpPSE));
+    addMaker<PSVacuum>("PSVacuum", [this](){
+        const Beamline& beamline = *getElement<Beamline>();
 
-    // The Z coordinate of the boundary between PS and TS vacua
-    StraightSection const * ts1vac = beamline.getTS().getTSVacuum<StraightSection>( TransportSolenoid::TSRegion::TS1 );
-    const double vacPS_TS_z = ts1vac->getGlobal().z() - ts1vac->getHalfLength();
+        // The Z coordinate of the boundary between PS and TS vacua
+        StraightSection const * ts1vac = beamline.getTS().getTSVacuum<StraightSection>( TransportSolenoid::TSRegion::TS1 );
+        const double vacPS_TS_z = ts1vac->getGlobal().z() - ts1vac->getHalfLength();
 
-    addDetector(PSVacuumMaker::make(*_config, ps, pse, vacPS_TS_z));
+        addDetector(PSVacuumMaker::make(*_config, *getElement<ProductionSolenoid>(), *getElement<PSEnclosure>(), vacPS_TS_z));
+      });
 
     //addDetector(PSShieldMaker::make(*_config, ps.psEndRefPoint(), prodTarget.position()));
 
-   if (_config->getString("targetPS_model") == "MDC2018"){ 
-     //      std::cout << "adding Tier1 in GeometryService" << std::endl;
-      addDetector(PSShieldMaker::make(*_config, ps.psEndRefPoint(), prodTarget.position()));
-	} else 
-      if (_config->getString("targetPS_model") == "Hayman_v_2_0"){ 
-	//	std::cout << " adding Hayman in GeometryService" << std::endl;
-	addDetector(PSShieldMaker::make(*_config, ps.psEndRefPoint(), prodTarget.haymanProdTargetPosition()));
-	  } else 
-	{throw cet::exception("GEOM") << " " << __func__ << " illegal production target version specified in GeometryService_service = " << _config->getString("targetPS_model")  << std::endl;}
-
-
-
-
-
+    const std::string targetPS_model = _config->getString("targetPS_model");
+    if (targetPS_model == "MDC2018"){
+      //      std::cout << "adding Tier1 in GeometryService" << std::endl;
+      addMaker<PSShield>("PSShield", [this](){
+          addDetector(PSShieldMaker::make(*_config, getElement<ProductionSolenoid>()->psEndRefPoint(), getElement<ProductionTarget>()->position()));
+        });
+    } else if (targetPS_model == "Hayman_v_2_0"){
+      //	std::cout << " adding Hayman in GeometryService" << std::endl;
+      addMaker<PSShield>("PSShield", [this](){
+          addDetector(PSShieldMaker::make(*_config, getElement<ProductionSolenoid>()->psEndRefPoint(), getElement<ProductionTarget>()->haymanProdTargetPosition()));
+        });
+    } else {
+      throw cet::exception("GEOM") << " " << __func__ << " illegal production target version specified in GeometryService_service = " << targetPS_model  << std::endl;
+    }
 
-    // Construct building solids
-    std::unique_ptr<Mu2eHall> tmphall(Mu2eHallMaker::makeBuilding(*_g4GeomOptions,*_config));
-    const Mu2eHall& hall = *tmphall.get();
+    addMaker<Mu2eHall,Mu2eEnvelope>("Mu2eHall", [this](){
+        // Construct building solids
+        std::unique_ptr<Mu2eHall> tmphall(Mu2eHallMaker::makeBuilding(*_g4GeomOptions,*_config));
+        const Mu2eHall& hall = *tmphall.get();
 
-    // Determine Mu2e envelope from building solids
-    std::unique_ptr<Mu2eEnvelope> mu2eEnv (new Mu2eEnvelope(hall,*_config));
+        // Determine Mu2e envelope from building solids
+        std::unique_ptr<Mu2eEnvelope> mu2eEnv (new Mu2eEnvelope(hall,*_config));
 
-    // Make dirt based on Mu2e envelope
-    Mu2eHallMaker::makeDirt( *tmphall.get(), *_g4GeomOptions, *_config, *mu2eEnv.get() );
-    Mu2eHallMaker::makeTrapDirt( *tmphall.get(), *_g4GeomOptions, *_config, *mu2eEnv.get() );
+        // Make dirt based on Mu2e envelope
+        Mu2eHallMaker::makeDirt( *tmphall.get(), *_g4GeomOptions, *_config, *mu2eEnv.get() );
+        Mu2eHallMaker::makeTrapDirt( *tmphall.get(), *_g4GeomOptions, *_config, *mu2eEnv.get() );
 
-    addDetector(std::move( tmphall ) );
-    addDetector(std::move( mu2eEnv ) );
+        addDetector(std::move( tmphall ) );
+        addDetector(std::move( mu2eEnv ) );
+      });
 
-    std::unique_ptr<ProtonBeamDump> tmpDump(ProtonBeamDumpMaker::make(*_config, hall));
-    const ProtonBeamDump& dump = *tmpDump.get();
-    addDetector(std::move(tmpDump));
+    addMaker<ProtonBeamDump>("ProtonBeamDump", [this](){
+        addDetector(ProtonBeamDumpMaker::make(*_config, *getElement<Mu2eHall>()));
+      });
 
     // beamline info used to position DS
-    std::unique_ptr<DetectorSolenoid> tmpDS( DetectorSolenoidMaker::make( *_config, beamline ) );
-    const DetectorSolenoid& ds = *tmpDS.get();
-    addDetector(std::move(tmpDS));
+    addMaker<DetectorSolenoid>("DetectorSolenoid", [this](){
+        addDetector( DetectorSolenoidMaker::make( *_config, *getElement<Beamline>() ) );
+      });
 
     // DS info used to position DS downstream shielding
-    addDetector( DetectorSolenoidShieldingMaker::make( *_config, ds ) );
+    addMaker<DetectorSolenoidShielding>("DetectorSolenoidShielding", [this](){
+        addDetector( DetectorSolenoidShieldingMaker::make( *_config, *getElement<DetectorSolenoid>() ) );
+      });
 
-    std::unique_ptr<StoppingTarget> tmptgt(StoppingTargetMaker(detSys.getOrigin(), *_config).getTargetPtr());
-    const StoppingTarget& target = *tmptgt.get();
-    addDetector(std::move(tmptgt));
+    addMaker<StoppingTarget>("StoppingTarget", [this](){
+        addDetector(StoppingTargetMaker(getElement<DetectorSystem>()->getOrigin(), *_config).getTargetPtr());
+      });
 
     if (_config->getBool("hasTracker",false)){
-      TrackerMaker ttm( *_config );
-      addDetector( ttm.getTrackerPtr() );
+      addMaker<Tracker>("Tracker", [this](){
+          TrackerMaker ttm( *_config );
+          addDetector( ttm.getTrackerPtr() );
+        });
     }
 
     if(_config->getBool("hasMBS",false)){
-      MBSMaker mbs( *_config, beamline.solenoidOffset() );
-      addDetector( mbs.getMBSPtr() );
+      addMaker<MBS>("MBS", [this](){
+          MBSMaker mbs( *_config, getElement<Beamline>()->solenoidOffset() );
+          addDetector( mbs.getMBSPtr() );
+        });
     }
 
 
     if(_config->getBool("hasDiskCalorimeter",false)){
-      DiskCalorimeterMaker calorm( *_config, beamline.solenoidOffset() );
-      addDetector( calorm.calorimeterPtr() );
-      addDetectorAliasToBaseClass<Calorimeter>( calorm.calorimeterPtr() );  //add an alias to detector list
+      addMaker<DiskCalorimeter,Calorimeter>("DiskCalorimeter", [this](){
+          DiskCalorimeterMaker calorm( *_config, getElement<Beamline>()->solenoidOffset() );
+          addDetector( calorm.calorimeterPtr() );
+          addDetectorAliasToBaseClass<Calorimeter>( calorm.calorimeterPtr() );  //add an alias to detector list
+        });
     }
 
     if(_config->getBool("hasCosmicRayShield",false)){
-      CosmicRayShieldMaker crs( *_config, beamline.solenoidOffset() );
-      addDetector( crs.getCosmicRayShieldPtr() );
+      addMaker<CosmicRayShield>("CosmicRayShield", [this](){
+          CosmicRayShieldMaker crs( *_config, getElement<Beamline>()->solenoidOffset() );
+          addDetector( crs.getCosmicRayShieldPtr() );
+        });
     }
 
     if(_config->getBool("hasTSdA",false)){
-      addDetector( TSdAMaker::make(*_config,ds) );
+      addMaker<TSdA>("TSdA", [this](){
+          addDetector( TSdAMaker::make(*_config,*getElement<DetectorSolenoid>()) );
+        });
     }
 
     if(_config->getBool("hasExternalShielding",false)) {
-      addDetector( ExtShieldUpstreamMaker::make(*_config)  );
-      addDetector( ExtShieldDownstreamMaker::make(*_config));
-      addDetector( SaddleMaker::make(*_config));
-      addDetector( PipeMaker::make(*_config));
-      addDetector( ElectronicRackMaker::make(*_config));
+      addMaker<ExtShieldUpstream,ExtShieldDownstream,Saddle,Pipe,ElectronicRack>("ExternalShielding", [this](){
+          addDetector( ExtShieldUpstreamMaker::make(*_config)  );
+          addDetector( ExtShieldDownstreamMaker::make(*_config));
+          addDetector( SaddleMaker::make(*_config));
+          addDetector( PipeMaker::make(*_config));
+          addDetector( ElectronicRackMaker::make(*_config));
+        });
     }
 
 
 
-    std::unique_ptr<ExtMonFNALBuilding> tmpemb(ExtMonFNALBuildingMaker::make(*_config, hall, dump));
-    const ExtMonFNALBuilding& emfb = *tmpemb.get();
-    addDetector(std::move(tmpemb));
+    addMaker<ExtMonFNALBuilding>("ExtMonFNALBuilding", [this](){
+        addDetector(ExtMonFNALBuildingMaker::make(*_config, *getElement<Mu2eHall>(), *getElement<ProtonBeamDump>()));
+      });
     if(_config->getBool("hasExtMonFNAL",false)){
-      addDetector(ExtMonFNAL::ExtMonMaker::make(*_config, emfb));
-      addDetector(ExtMonFNALMuonIDMaker::make(*_config));
+      addMaker<ExtMonFNAL::ExtMon,ExtMonFNALMuonID>("ExtMonFNAL", [this](){
+          addDetector(ExtMonFNAL::ExtMonMaker::make(*_config, *getElement<ExtMonFNALBuilding>()));
+          addDetector(ExtMonFNALMuonIDMaker::make(*_config));
+        });
     }
     
 
 
     if(_config->getBool("hasVirtualDetector",false)){
-      addDetector(VirtualDetectorMaker::make(*_config));
+      addMaker<VirtualDetector>("VirtualDetector", [this](){
+          addDetector(VirtualDetectorMaker::make(*_config));
+        });
     }
       
     
     if(_config->getBool("hasBFieldManager",false)){
-      std::unique_ptr<BFieldConfig> bfc( BFieldConfigMaker(*_config, beamline).getBFieldConfig() );
-      BFieldManagerMaker bfmgr(*bfc);
-      addDetector(std::move(bfc));
-      addDetector(bfmgr.getBFieldManager());
+      addMaker<BFieldConfig,BFieldManager>("BFieldManager", [this](){
+          std::unique_ptr<BFieldConfig> bfc( BFieldConfigMaker(*_config, *getElement<Beamline>()).getBFieldConfig() );
+          BFieldManagerMaker bfmgr(*bfc);
+          addDetector(std::move(bfc));
+          addDetector(bfmgr.getBFieldManager());
+        });
     }
  
 
     if(_config->getBool("hasProtonAbsorber",false) && !_config->getBool("protonabsorber.isHelical", false) ){
-      MECOStyleProtonAbsorberMaker mecopam( *_config, ds, target);
-      addDetector( mecopam.getMECOStyleProtonAbsorberPtr() );
+      addMaker<MECOStyleProtonAbsorber>("MECOStyleProtonAbsorber", [this](){
+          MECOStyleProtonAbsorberMaker mecopam( *_config, *getElement<DetectorSolenoid>(), *getElement<StoppingTarget>());
+          addDetector( mecopam.getMECOStyleProtonAbsorberPtr() );
+        });
     }
 
     if(_config->getBool("hasSTM",false)){
-      STMMaker stm( *_config, beamline.solenoidOffset() );
-      addDetector( stm.getSTMPtr() );
+      addMaker<STM>("STM", [this](){
+          STMMaker stm( *_config, getElement<Beamline>()->solenoidOffset() );
+          addDetector( stm.getSTMPtr() );
+        });
+    }
+
+    if ( !_lazyConstruction ){
+      for ( size_t i=0; i<_makers.size(); ++i ){
+        if ( !_makers[i].started ) runMaker(i);
+      }
     }
 
   } // preBeginRun()
 
+  // Find a detector, in lazy mode running its maker if it has not been made yet.
+  Detector* GeometryService::findDetector(std::string const& name){
+    std::unique_lock<std::recursive_mutex> lock(_detectorMutex, std::defer_lock);
+    if ( _lazyConstruction ) lock.lock();
+
+    DetMap::iterator it(_detectors.find(name));
+    if ( it != _detectors.end() ) return it->second.get();
+
+    auto im = _makerIndex.find(name);
+    if ( im == _makerIndex.end() ) return nullptr;
+    if ( _makers[im->second].started ) {
+      throw cet::exception("GEOM")
+        << "Maker " << _makers[im->second].label
+        << " did not provide detector with type name " << name
+        << ", or depends on itself.\n";
+    }
+    runMaker(im->second);
+
+    it = _detectors.find(name);
+    return ( it == _detectors.end() ) ? nullptr : it->second.get();
+  }
+
+  bool GeometryService::knowsDetector(std::string const& name){
+    std::unique_lock<std::recursive_mutex> lock(_detectorMutex, std::defer_lock);
+    if ( _lazyConstruction ) lock.lock();
+    return _detectors.find(name) != _detectors.end() || _makerIndex.find(name) != _makerIndex.end();
+  }
+
+  // Run one maker and record the time and memory it used.  The detectors it
+  // requests from other makers are accounted to those makers.
+  void GeometryService::runMaker(size_t index){
+    DetectorMaker& maker = _makers[index];
+    maker.started = true;
+
+    _nestedConstruction.push_back(ConstructionInfo{maker.label, 0., 0});
+    long   mem0 = residentMemory();
+    auto   t0   = std::chrono::steady_clock::now();
+
+    maker.make();
+
+    double time   = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    long   memory = residentMemory() - mem0;
+    ConstructionInfo info = _nestedConstruction.back();
+    _nestedConstruction.pop_back();
+    if ( !_nestedConstruction.empty() ){
+      _nestedConstruction.back().time   += time;
+      _nestedConstruction.back().memory += memory;
+    }
+    info.time   = time   - info.time;
+    info.memory = memory - info.memory;
+    _constructionInfo.push_back(info);
+
+    if ( _lazyConstruction ){
+      mf::LogInfo("GEOM") << "GeometryService: made " << info.label << " on first request";
+    }
+  }
+
+  void GeometryService::printConstructionReport(std::ostream& os) const {
+    double totalTime(0.);
+    long   totalMemory(0);
+    os << "GeometryService: detector construction report ("
+       << ( _lazyConstruction ? "lazy" : "eager" ) << " construction)\n";
+    os << "  " << std::left << std::setw(28) << "Maker"
+       << std::right << std::setw(12) << "Time (ms)" << std::setw(14) << "Memory (kB)" << "\n";
+    for ( auto const& info : _constructionInfo ){
+      os << "  " << std::left << std::setw(28) << info.label
+         << std::right << std::setw(12) << std::fixed << std::setprecision(2) << info.time
+         << std::setw(14) << info.memory << "\n";
+      totalTime   += info.time;
+      totalMemory += info.memory;
+    }
+    os << "  " << std::left << std::setw(28) << "Total"
+       << std::right << std::setw(12) << std::fixed << std::setprecision(2) << totalTime
+       << std::setw(14) << totalMemory << "\n";
+    size_t unused(0);
+    for ( auto const& maker : _makers ){
+      if ( !maker.started ) ++unused;
+    }
+    if ( unused > 0 ){
+      os << "  Not made, never requested:";
+      for ( auto const& maker : _makers ){
+        if ( !maker.started ) os << " " << maker.label;
+      }
+      os << "\n";
+    }
+    os << std::defaultfloat;
+  }
+
   // Check that the configuration is self consistent.
   void GeometryService::checkConfig(){
     checkTrackerConfig();
@@ -376,12 +540,15 @@ namespace mu2e {
   // However we don't want to make WorldG4 available in non-Geant jobs.
   // Therefore it is added by G4_module via this dedicated call.
   void GeometryService::addWorldG4(const Mu2eHall& hall) {
+    std::unique_lock<std::recursive_mutex> lock(_detectorMutex, std::defer_lock);
+    if ( _lazyConstruction ) lock.lock();
     addDetector(WorldG4Maker::make(hall,*_config));
   }
 
   // Called after all modules have completed their end of job.
   void   GeometryService::postEndJob(){
     _config->printAllSummaries( cout, _configStatsVerbosity, "Geom: " );
+    if ( _constructionReport ) printConstructionReport(cout);
   }
 
 
@@ -0,0 +1,63 @@
+#ifndef MCDataProducts_StepTimeIndex_hh
+#define MCDataProducts_StepTimeIndex_hh
+//
+// Time index of a collection of MC steps (StrawGasSteps, CaloShowerSteps, ...).
+// The steps are grouped by the primary SimParticle of their track, since
+// SimParticleTimeOffset applies the same offset to all the descendants of a
+// primary, and the steps of each group are sorted by their time without offsets.
+// Digitizers can then compute the time offset once per group and binary-search
+// the steps that fold into their live window, instead of visiting every step.
+//
+#include "canvas/Persistency/Common/Ptr.h"
+#include "canvas/Persistency/Provenance/ProductID.h"
+
+#include "MCDataProducts/inc/SimParticle.hh"
+
+#include <vector>
+
+namespace mu2e {
+  class StepTimeIndex {
+    public:
+      struct Entry {
+        double   _time; // step time, without offsets
+        unsigned _step; // index of the step in the indexed collection
+        Entry() : _time(0.0), _step(0) {}
+        Entry(double time, unsigned step) : _time(time), _step(step) {}
+        bool operator < (Entry const& other) const { return _time < other._time; }
+      };
+
+      struct Group {
+        art::Ptr<SimParticle> _primary; // primary of all the steps in this group
+        unsigned _begin, _end; // range of this group's entries
+        Group() : _begin(0), _end(0) {}
+        Group(art::Ptr<SimParticle> const& primary, unsigned begin, unsigned end) :
+          _primary(primary), _begin(begin), _end(end) {}
+      };
+
+      StepTimeIndex() {}
+      explicit StepTimeIndex(art::ProductID const& steps) : _steps(steps) {}
+
+      art::ProductID const& steps() const { return _steps; }
+      std::vector<Group> const& groups() const { return _groups; }
+      std::vector<Entry> const& entries() const { return _entries; }
+
+      // add a group; the entries are sorted here
+      void addGroup(art::Ptr<SimParticle> const& primary, std::vector<Entry>& entries);
+
+      // Append to 'steps' the indices of the steps of a group whose time plus
+      // 'offset' is congruent, modulo 'period', to a time in [tmin, tmax].
+      // The selection is conservative (it includes a small margin), the
+      // caller is expected to apply its exact time cut to the selected steps.
+      void select(Group const& group, double offset,
+          double tmin, double tmax, double period,
+          std::vector<unsigned>& steps) const;
+
+    private:
+      art::ProductID _steps; // the indexed collection
+      std::vector<Group> _groups;
+      std::vector<Entry> _entries;
+  };
+
+  typedef std::vector<StepTimeIndex> StepTimeIndexCollection;
+}
+#endif
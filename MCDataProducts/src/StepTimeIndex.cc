@@ -0,0 +1,50 @@
+#include "MCDataProducts/inc/StepTimeIndex.hh"
+
+#include <algorithm>
+#include <cmath>
+
+namespace mu2e {
+
+  namespace {
+    // margin on the window edges to absorb rounding differences with the
+    // digitizer time folding (ns)
+    constexpr double windowMargin = 1.0;
+  }
+
+  void StepTimeIndex::addGroup(art::Ptr<SimParticle> const& primary, std::vector<Entry>& entries) {
+    std::stable_sort(entries.begin(),entries.end());
+    unsigned begin = _entries.size();
+    _entries.insert(_entries.end(),entries.begin(),entries.end());
+    _groups.emplace_back(primary,begin,_entries.size());
+  }
+
+  void StepTimeIndex::select(Group const& group, double offset,
+      double tmin, double tmax, double period,
+      std::vector<unsigned>& steps) const {
+    auto begin = _entries.begin() + group._begin;
+    auto end = _entries.begin() + group._end;
+    if(begin == end)return;
+    // a window longer than the period selects everything
+    if(tmax - tmin + 2.0*windowMargin >= period){
+      for(auto ie = begin; ie != end; ++ie)
+        steps.push_back(ie->_step);
+      return;
+    }
+    // step through the window repetitions, jumping over those with no steps
+    auto ie = begin;
+    while(ie != end){
+      long k = static_cast<long>(std::floor((ie->_time + offset - tmax - windowMargin)/period));
+      double lo = tmin + k*period - offset - windowMargin;
+      double hi = tmax + k*period - offset + windowMargin;
+      if(ie->_time > hi){
+        ++k;
+        lo += period;
+        hi += period;
+      }
+      ie = std::lower_bound(ie,end,Entry(lo,0));
+      auto ihi = std::upper_bound(ie,end,Entry(hi,0));
+      for(;ie != ihi; ++ie)
+        steps.push_back(ie->_step);
+    }
+  }
+}
@@ -65,6 +65,7 @@
 // straws
 #include "MCDataProducts/inc/StrawDigiMC.hh"
 #include "MCDataProducts/inc/StrawGasStep.hh"
+#include "MCDataProducts/inc/StepTimeIndex.hh"
 
 // tracking 
 #include "MCDataProducts/inc/TrackSummaryTruthAssns.hh"
@@ -11,6 +11,9 @@
 // Included from Geant4
 #include "G4MTRunManager.hh"
 
+//art includes
+#include "canvas/Persistency/Provenance/EventID.h"
+
 //Mu2e includes
 #include "Mu2eG4/inc/Mu2eG4Config.hh"
 #include "Mu2eG4/inc/PhysicalVolumeHelper.hh"
@@ -42,6 +45,11 @@ namespace mu2e {
                         long& s1, long& s2, long& s3,
                         G4bool reseedRequired);
 
+    // The seeds of an event are computed from the job seed and the art::EventID, so
+    // they do not depend on the worker that processes the event, on the order of the
+    // events, or on the range of the event numbers of the input file.
+    void eventSeeds(art::EventID const& id, long& s1, long& s2) const;
+
     inline G4VUserPhysicsList* getMasterPhysicsList() {return physicsList_;}
 
     inline void setPhysVolumeHelper(PhysicalVolumeHelper* phys_volume_helper) {physVolHelper_ = phys_volume_helper;}
@@ -65,6 +73,7 @@ namespace mu2e {
     G4VUserPhysicsList* physicsList_;
 
     int rmvlevel_;
+    long masterSeed_;
   };
 
 } // end namespace mu2e
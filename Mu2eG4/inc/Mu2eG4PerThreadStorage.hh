@@ -50,12 +50,18 @@ namespace mu2e {
                              SimParticleHelper* sim_part_helper,
                              SimParticlePrimaryHelper* sim_part_primary_helper,
                              HitHandles* gen_input_hits,
-                             art::InputTag gen_module_label) {
+                             art::InputTag gen_module_label,
+                             art::Handle<SimParticleCollection> const& input_sims,
+                             art::Handle<MCTrajectoryCollection> const& input_mc_trajectories) {
       artEvent = evt;
       simParticleHelper = sim_part_helper;
       simParticlePrimaryHelper = sim_part_primary_helper;
       genInputHits = gen_input_hits;
       generatorModuleLabel = gen_module_label;
+      // inputs from the previous simulation stage, retrieved by the module
+      // on the art thread before the G4 event is processed
+      inputSimHandle = input_sims;
+      inputMCTrajectoryHandle = input_mc_trajectories;
 
       if(!(generatorModuleLabel == art::InputTag())) {
         artEvent->getByLabel(generatorModuleLabel, gensHandle);
@@ -196,6 +202,8 @@ namespace mu2e {
       genInputHits = nullptr;
       gensHandle.clear();
       generatorModuleLabel = "";
+      inputSimHandle.clear();
+      inputMCTrajectoryHandle.clear();
 
       statG4 = nullptr;
       simPartCollection = nullptr;
@@ -222,6 +230,8 @@ namespace mu2e {
     const HitHandles* genInputHits = nullptr;
     art::Handle<GenParticleCollection> gensHandle;
     art::InputTag generatorModuleLabel;
+    art::Handle<SimParticleCollection> inputSimHandle;
+    art::Handle<MCTrajectoryCollection> inputMCTrajectoryHandle;
 
     std::unique_ptr<StatusG4> statG4 = nullptr;
     std::unique_ptr<SimParticleCollection> simPartCollection = nullptr;
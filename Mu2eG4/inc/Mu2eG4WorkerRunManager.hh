@@ -11,6 +11,9 @@
 // Included from Geant4
 #include "G4WorkerRunManager.hh"
 
+//art includes
+#include "canvas/Persistency/Provenance/EventID.h"
+
 //Mu2e includes
 #include "Mu2eG4/inc/Mu2eG4Config.hh"
 #include "Mu2eG4/inc/Mu2eG4ResourceLimits.hh"
@@ -51,7 +54,7 @@ namespace mu2e {
     void initializeUserActions(const G4ThreeVector& origin_in_world);
     void initializeRun(art::Event* art_event);
     void processEvent(art::Event*);
-    G4Event* generateEvt(G4int i_event);
+    G4Event* generateEvt(art::EventID const& id);
 
     inline bool workerRMInitialized() const { return m_managerInitialized; }
 
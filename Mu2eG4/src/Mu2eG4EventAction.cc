@@ -95,29 +95,10 @@ namespace mu2e {
     simsRemap = unique_ptr<SimParticleRemapping>( new SimParticleRemapping );
     extMonFNALHits = unique_ptr<ExtMonFNALSimHitCollection>( new ExtMonFNALSimHitCollection );
 
-    //these will NEVER be run in MT mode, so we don't need a mutex and lock
-    //on the _artEvent->getByLabel call, even though the call is not thread-safe
-    art::Handle<SimParticleCollection> inputSimHandle;
-    if(art::InputTag() != multiStagePars_.inputSimParticles()) {
-      _artEvent->getByLabel(multiStagePars_.inputSimParticles(), inputSimHandle);
-
-      if(!inputSimHandle.isValid()) {
-        throw cet::exception("CONFIG")
-          << "Error retrieving inputSimParticles for "
-          << multiStagePars_.inputSimParticles() <<"\n";
-      }
-    }
-
-    art::Handle<MCTrajectoryCollection> inputMCTrajectoryHandle;
-    if(art::InputTag() != multiStagePars_.inputMCTrajectories()) {
-      _artEvent->getByLabel(multiStagePars_.inputMCTrajectories(), inputMCTrajectoryHandle);
-
-      if(!inputMCTrajectoryHandle.isValid()) {
-        throw cet::exception("CONFIG")
-          << "Error retrieving inputMCTrajectories for "
-          << multiStagePars_.inputMCTrajectories() <<"\n";
-      }
-    }
+    //inputs from the previous simulation stage are retrieved by the module,
+    //on the art thread, and passed in through the per-thread storage
+    art::Handle<SimParticleCollection> const& inputSimHandle = perThreadObjects_->inputSimHandle;
+    art::Handle<MCTrajectoryCollection> const& inputMCTrajectoryHandle = perThreadObjects_->inputMCTrajectoryHandle;
 
     //these are OK, nothing put into or defined for event
     _sensitiveDetectorHelper->createProducts(*_artEvent, *_spHelper);
@@ -40,7 +40,17 @@
 
 using namespace std;
 
-namespace {G4Mutex setUpEventMutex = G4MUTEX_INITIALIZER;}
+namespace {
+  G4Mutex setUpEventMutex = G4MUTEX_INITIALIZER;
+
+  // splitmix64 finalizer
+  unsigned long long mixBits(unsigned long long x) {
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+  }
+}
 
 namespace mu2e {
 
@@ -55,9 +65,10 @@ namespace mu2e {
     sensitiveDetectorHelper_(conf.SDConfig()),
     masterRunAction_(nullptr),
     physicsList_(nullptr),
-    rmvlevel_(conf.debug().diagLevel())
+    rmvlevel_(conf.debug().diagLevel()),
+    masterSeed_(art::ServiceHandle<SeedService>()->getSeed())
   {
-    const_cast<CLHEP::HepRandomEngine*>(getMasterRandomEngine())->setSeed(art::ServiceHandle<SeedService>()->getSeed(),0);
+    const_cast<CLHEP::HepRandomEngine*>(getMasterRandomEngine())->setSeed(masterSeed_,0);
   }
 
   // Destructor of base is called automatically.  No need to do anything.
@@ -276,4 +287,15 @@ namespace mu2e {
   }
 
 
+  void Mu2eG4MTRunManager::eventSeeds(art::EventID const& id, long& s1, long& s2) const {
+    unsigned long long h = mixBits(static_cast<unsigned long long>(masterSeed_));
+    h = mixBits(h ^ id.run());
+    h = mixBits(h ^ id.subRun());
+    h = mixBits(h ^ id.event());
+    // G4 expects positive seeds
+    s1 = static_cast<long>(h & 0x7fffffffULL) + 1;
+    s2 = static_cast<long>((h >> 32) & 0x7fffffffULL) + 1;
+  }
+
+
 } // end namespace mu2e
@@ -281,10 +281,9 @@ namespace mu2e {
     
     runIsSeeded = false;
     eventLoopOnGoing = true;
-    G4int i_event = event->id().event();
         
     // below code is from ProcessOneEvent(i_event);
-     currentEvent = generateEvt(i_event);
+     currentEvent = generateEvt(event->id());
     
      if(eventLoopOnGoing) {
      eventManager->ProcessOneEvent(currentEvent);
@@ -294,15 +293,18 @@ namespace mu2e {
   }
   
   
-  G4Event* Mu2eG4WorkerRunManager::generateEvt(G4int i_event){
+  G4Event* Mu2eG4WorkerRunManager::generateEvt(art::EventID const& id){
     
-    G4Event* anEvent = new G4Event(i_event);
+    G4Event* anEvent = new G4Event(id.event());
     long s1 = 0;
     long s2 = 0;
     long s3 = 0;
     G4bool eventHasToBeSeeded = true;
     
-    eventLoopOnGoing = G4MTRunManager::GetMasterRunManager()->SetUpAnEvent(anEvent,s1,s2,s3,eventHasToBeSeeded);
+    // the master only does the bookkeeping here: the seeds of the G4 seed bunch are
+    // indexed by event number, which fails for the sparse, large event numbers of
+    // the files read by multi-stage jobs
+    eventLoopOnGoing = masterRM->SetUpAnEvent(anEvent,s1,s2,s3,false);
     runIsSeeded = true;
     
     if(!eventLoopOnGoing)
@@ -313,6 +315,7 @@ namespace mu2e {
     
     if(eventHasToBeSeeded)
     {
+      masterRM->eventSeeds(id,s1,s2);
       long seeds[3] = { s1, s2, 0 };
       G4Random::setTheSeeds(seeds,-1);
       runIsSeeded = true;
@@ -458,6 +458,28 @@ namespace mu2e {
       genInputHits.emplace_back(event.getValidHandle<StepPointMCCollection>(i));
     }
 
+    // SimParticles and MCTrajectories from the previous simulation stage.  They are
+    // read here, on the thread that owns the art::Event, rather than from the G4 user actions.
+    art::Handle<SimParticleCollection> inputSimHandle;
+    if(art::InputTag() != multiStagePars_.inputSimParticles()) {
+      event.getByLabel(multiStagePars_.inputSimParticles(), inputSimHandle);
+      if(!inputSimHandle.isValid()) {
+        throw cet::exception("CONFIG")
+          << "Error retrieving inputSimParticles for "
+          << multiStagePars_.inputSimParticles() <<"\n";
+      }
+    }
+
+    art::Handle<MCTrajectoryCollection> inputMCTrajectoryHandle;
+    if(art::InputTag() != multiStagePars_.inputMCTrajectories()) {
+      event.getByLabel(multiStagePars_.inputMCTrajectories(), inputMCTrajectoryHandle);
+      if(!inputMCTrajectoryHandle.isValid()) {
+        throw cet::exception("CONFIG")
+          << "Error retrieving inputMCTrajectories for "
+          << multiStagePars_.inputMCTrajectories() <<"\n";
+      }
+    }
+
     // ProductID and ProductGetter for the SimParticleCollection.
     art::ProductID simPartId(event.getProductID<SimParticleCollection>());
     art::EDProductGetter const* simProductGetter = event.productGetter(simPartId);
@@ -465,7 +487,8 @@ namespace mu2e {
     SimParticleHelper spHelper(multiStagePars_.simParticleNumberOffset(), simPartId, &event, simProductGetter);
     SimParticlePrimaryHelper parentHelper(&event, simPartId, gensHandle, simProductGetter);
 
-    perThreadStore.initializeEventInfo(&event, &spHelper, &parentHelper, &genInputHits, _generatorModuleLabel);
+    perThreadStore.initializeEventInfo(&event, &spHelper, &parentHelper, &genInputHits, _generatorModuleLabel,
+                                       inputSimHandle, inputMCTrajectoryHandle);
 
     // Run G4 for this event and access the completed event.
     BeamOnDoOneArtEvent( event.id().event() );
@@ -0,0 +1,52 @@
+#ifndef Mu2eUtilities_BinnedSpectrumSampler_hh
+#define Mu2eUtilities_BinnedSpectrumSampler_hh
+
+//
+// Random numbers in [0,1) distributed as the pdf of a BinnedSpectrum, to be
+// passed to BinnedSpectrum::sample().  The method is chosen by name:
+//
+//   "RandGeneral"            : CLHEP::RandGeneral (binary search per draw)
+//   "aliasTable"             : RandomAliasTable, same distribution in constant time
+//   "aliasTableInterpolated" : RandomAliasTable with a linear density within the bins
+//
+// The spectrum based generators take the name from the spectrumSampler
+// parameter of their physics block (default "RandGeneral").
+//
+
+#include <memory>
+#include <string>
+
+#include "CLHEP/Random/RandGeneral.h"
+
+#include "Mu2eUtilities/inc/BinnedSpectrum.hh"
+#include "Mu2eUtilities/inc/RandomAliasTable.hh"
+
+namespace CLHEP { class HepRandomEngine; }
+
+namespace mu2e {
+
+  class BinnedSpectrumSampler {
+
+  public:
+
+    BinnedSpectrumSampler(CLHEP::HepRandomEngine& engine,
+                          const BinnedSpectrum& spectrum,
+                          const std::string& method = "RandGeneral");
+
+    double fire() { return _aliasTable ? _aliasTable->fire() : _randGeneral->fire(); }
+
+    void fireArray(size_t n, double* vect);
+
+    const std::string& method() const { return _method; }
+
+  private:
+
+    std::string _method;
+    std::unique_ptr<CLHEP::RandGeneral> _randGeneral;
+    std::unique_ptr<RandomAliasTable>   _aliasTable;
+
+  };
+
+} // end of namespace mu2e
+
+#endif /* Mu2eUtilities_BinnedSpectrumSampler_hh */
@@ -27,11 +27,23 @@ namespace mu2e
        explicit MVATools(const Config& conf);
        explicit MVATools(const std::string& xmlfilename);
 
+       // work space for the batch evaluation; the evaluation methods are const and
+       // reentrant, the caller provides the scratch (or a thread-local one is used)
+       struct Scratch
+       {
+          std::vector<float> x;
+          std::vector<float> y;
+       };
+
        virtual ~MVATools();
        xercesc::DOMDocument* getXmlDoc();
        void     initMVA();
        float    evalMVA(const std::vector<float>&,  const MVAMask& vmask=0xffffffff) const;
        float    evalMVA(const std::vector<double>&, const MVAMask& vmask=0xffffffff) const;
+       void     evalMVA(const std::vector<std::vector<float> >& inputs, std::vector<float>& outputs,
+                        const MVAMask& vmask=0xffffffff) const;
+       void     evalMVA(const std::vector<std::vector<float> >& inputs, std::vector<float>& outputs,
+                        Scratch& scratch, const MVAMask& vmask=0xffffffff) const;
        void     showMVA() const;
        
        const std::vector<std::string>& titles() const { return title_;}     
@@ -46,10 +58,10 @@ namespace mu2e
        void   getNorm(xercesc::DOMDocument* xmlDoc);
        void   getWgts(xercesc::DOMDocument* xmlDoc);
        float  activation(float arg) const;
+       void   fillInputs(const std::vector<float>& v, const MVAMask& mask, float* x, unsigned stride) const;
+       void   evalBlock(const std::vector<float>* inputs, unsigned nvec, float* outputs,
+                        Scratch& scratch, const MVAMask& mask) const;
 
-       mutable std::vector<float> x_;
-       mutable std::vector<float> y_;
-       mutable std::vector<float> fv_;      
        std::vector<float>         wgts_;
        std::vector<unsigned>      links_;
        unsigned                   maxNeurons_;
@@ -62,6 +74,7 @@ namespace mu2e
        std::vector<std::string>   label_;
        std::string                activationTypeString_;
        std::string                mvaWgtsFile_;
+       unsigned                   xmlInits_;
 
   public:
        void   getCalib(std::map<float, float>& effCalib);
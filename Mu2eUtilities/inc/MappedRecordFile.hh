@@ -0,0 +1,88 @@
+// A flat binary file of fixed size records (for example IO::StoppedParticleF),
+// written once by rootTreeSamplerConvert and mapped read-only by RootTreeSampler.
+// All the processes on a node that map the same file share its pages, instead
+// of each holding a private copy of the records read from the ROOT trees.
+//
+// The file is a header padded to one page (4096 bytes), followed by the records.
+// The header stores the record size and the ROOT branch description of the
+// record type, which are checked when the file is mapped.
+
+#ifndef Mu2eUtilities_MappedRecordFile_hh
+#define Mu2eUtilities_MappedRecordFile_hh
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+
+namespace mu2e {
+
+  class MappedRecordFile {
+  public:
+
+    static constexpr std::size_t headerSize = 4096;
+
+    struct Header {
+      char          magic[8];
+      std::uint32_t version;
+      std::uint32_t recordSize;
+      std::uint64_t numRecords;
+      std::uint64_t dataOffset;
+      char          description[256];
+    };
+
+    // Maps the file read-only.  Throws if it is not a record file, or if the
+    // records are not of the given size and branch description.
+    MappedRecordFile(const std::string& fileName,
+                     std::size_t recordSize,
+                     const std::string& description);
+    ~MappedRecordFile();
+
+    MappedRecordFile(const MappedRecordFile&) = delete;
+    MappedRecordFile& operator=(const MappedRecordFile&) = delete;
+
+    const void* data() const { return static_cast<const char*>(map_) + dataOffset_; }
+    std::size_t numRecords() const { return numRecords_; }
+    std::size_t mappedBytes() const { return mappedBytes_; }
+
+    // Bytes of the mapping that are currently in memory (mincore), which are
+    // shared with the other processes mapping the same file.
+    std::size_t residentBytes() const;
+
+    const std::string& fileName() const { return fileName_; }
+
+    //----------------------------------------------------------------
+    class Writer {
+    public:
+      Writer(const std::string& fileName,
+             std::size_t recordSize,
+             const std::string& description);
+      ~Writer();
+
+      void write(const void* record);
+
+      // Writes the number of records into the header.  Called by the destructor
+      // if it was not called before.
+      void close();
+
+      std::size_t numRecords() const { return numRecords_; }
+
+    private:
+      std::string fileName_;
+      std::ofstream out_;
+      std::size_t recordSize_;
+      std::size_t numRecords_ = 0;
+      Header header_;
+    };
+
+  private:
+    std::string fileName_;
+    void* map_ = nullptr;
+    std::size_t mappedBytes_ = 0;
+    std::size_t dataOffset_ = 0;
+    std::size_t numRecords_ = 0;
+  };
+
+}
+
+#endif /* Mu2eUtilities_MappedRecordFile_hh */
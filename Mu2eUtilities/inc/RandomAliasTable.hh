@@ -0,0 +1,57 @@
+#ifndef Mu2eUtilities_RandomAliasTable_hh
+#define Mu2eUtilities_RandomAliasTable_hh
+
+//
+// Sample a binned pdf with the alias method (Walker, Vose): the table is
+// built once, and each draw takes a constant time, independent of the
+// number of bins, instead of the binary search of CLHEP::RandGeneral.
+//
+// As RandGeneral (with the default IntType=0), fire() returns a value in
+// [0,1): bin i of nBins is chosen with probability pdf[i], and the value is
+// spread uniformly over [i/nBins, (i+1)/nBins).  With interpolate=true, the
+// density within each bin is instead linear, with the slope given by the
+// neighbouring bins; the probability of each bin is unchanged.
+//
+// Each draw takes two flat random numbers from the engine.
+//
+
+#include <stddef.h>
+#include <vector>
+
+namespace CLHEP { class HepRandomEngine; }
+
+namespace mu2e {
+
+  class RandomAliasTable {
+
+  public:
+
+    RandomAliasTable(CLHEP::HepRandomEngine& engine, const double* pdf, size_t nBins, bool interpolate=false);
+
+    double fire();
+
+    // Fills vect with n values, taking the flat random numbers from the engine in one call
+    void fireArray(size_t n, double* vect);
+
+    size_t getNbins()     const { return _nBins; }
+    bool   interpolate()  const { return _interpolate; }
+
+  private:
+
+    double value(double r1, double r2) const;
+
+    CLHEP::HepRandomEngine& _engine;
+    size_t _nBins;
+    bool   _interpolate;
+
+    std::vector<double>   _prob;   // probability to keep bin i rather than its alias
+    std::vector<unsigned> _alias;
+    std::vector<double>   _slope;  // density in the bin is 1 + slope*(x-1/2), x in [0,1)
+
+    std::vector<double>   _flat;   // work space for fireArray
+
+  };
+
+} // end of namespace mu2e
+
+#endif /* Mu2eUtilities_RandomAliasTable_hh */
@@ -25,6 +25,13 @@
 // the feature (the default). If the number of inputs is less than
 // averageNumRecordsToUse, all input records are used.
 //
+// Alternatively, for EventRecord==NtupleRecord, the records can be
+// converted once into a flat file (see rootTreeSamplerConvert) given
+// by the mappedFile parameter.  The file is then mapped read-only
+// instead of reading the ROOT trees: the startup does not read any
+// records, and all the jobs on a node share the same memory.  All the
+// records in the file are used, averageNumRecordsToUse is ignored.
+//
 // See StoppedParticleReactionGun_module.cc and InFlightParticleSampler_module.cc
 // for examples of use.
 //
@@ -33,6 +40,9 @@
 #ifndef RootTreeSampler_hh
 #define RootTreeSampler_hh
 
+#include <chrono>
+#include <memory>
+#include <type_traits>
 #include <vector>
 
 #include "fhiclcpp/types/Atom.h"
@@ -52,6 +62,7 @@
 #include "TFile.h"
 
 #include "ConfigTools/inc/ConfigFileLookupPolicy.hh"
+#include "Mu2eUtilities/inc/MappedRecordFile.hh"
 
 namespace mu2e {
 
@@ -98,6 +109,13 @@ namespace mu2e {
                   "Name of the ROOT tree branch that maps input records to events."),
           [this](){ return !std::is_same<EventRecord,NtupleRecord>::value; }
       };
+
+      fhicl::Atom<std::string> mappedFile {
+        Name("mappedFile"),
+          Comment("A file written by rootTreeSamplerConvert.  If not empty, the records\n"
+                  "are mapped from this file instead of being read from the inputFiles."),
+          ""
+          };
     };
 
     RootTreeSampler(art::RandomNumberGenerator::base_engine_t& engine,
@@ -107,17 +125,28 @@ namespace mu2e {
     RootTreeSampler(art::RandomNumberGenerator::base_engine_t& engine,
                     const fhicl::ParameterSet& pset);
 
-    const EventRecord& fire() { return records_.at(randFlat_.fireInt(records_.size())); }
+    const EventRecord& fire() {
+      return mappedRecords_ ?
+        mappedRecords_[randFlat_.fireInt(mapped_->numRecords())] :
+        records_.at(randFlat_.fireInt(records_.size()));
+    }
 
     typename std::vector<EventRecord>::size_type
-    numRecords() const { return records_.size(); }
+    numRecords() const { return mappedRecords_ ? mapped_->numRecords() : records_.size(); }
 
   private:
     CLHEP::RandFlat randFlat_;
     std::vector<EventRecord> records_;
 
+    std::unique_ptr<MappedRecordFile> mapped_;
+    const EventRecord *mappedRecords_ = nullptr;
+
     typedef std::vector<std::string> Strings;
 
+    void mapRecords(const std::string& fileName);
+
+    void printStartup(std::chrono::steady_clock::time_point startTime) const;
+
     long countInputRecords(const art::ServiceHandle<art::TFileService>& tfs,
                            const Strings& files,
                            const std::string& treeName);
@@ -340,6 +369,15 @@ namespace mu2e {
                   const Config& conf)
     : randFlat_(engine)
   {
+    const auto startTime = std::chrono::steady_clock::now();
+
+    const std::string mappedFile(conf.mappedFile());
+    if(!mappedFile.empty()) {
+      mapRecords(mappedFile);
+      printStartup(startTime);
+      return;
+    }
+
     const auto inputFiles(conf.inputFiles());
     const auto treeName(conf.treeName());
     const long averageNumRecordsToUse(conf.averageNumRecordsToUse());
@@ -439,6 +477,8 @@ namespace mu2e {
 
     } // for(inputFiles)
 
+    printStartup(startTime);
+
   } // Constructor (conf)
 
   //================================================================
@@ -448,6 +488,15 @@ namespace mu2e {
                   const fhicl::ParameterSet& pset)
     : randFlat_(engine)
   {
+    const auto startTime = std::chrono::steady_clock::now();
+
+    const auto mappedFile(pset.get<std::string>("mappedFile", ""));
+    if(!mappedFile.empty()) {
+      mapRecords(mappedFile);
+      printStartup(startTime);
+      return;
+    }
+
     const auto inputFiles(pset.get<std::vector<std::string> >("inputFiles"));
     const auto treeName(pset.get<std::string>("treeName"));
     const long averageNumRecordsToUse(pset.get<long>("averageNumRecordsToUse", 0));
@@ -547,6 +596,8 @@ namespace mu2e {
 
     } // for(inputFiles)
 
+    printStartup(startTime);
+
   } // Constructor (pset)
 
   //================================================================
@@ -572,6 +623,57 @@ namespace mu2e {
     return res;
   }
 
+  //================================================================
+  template<class EventRecord, class NtupleRecord>
+  void RootTreeSampler<EventRecord, NtupleRecord>::mapRecords(const std::string& fileName)
+  {
+    if constexpr(std::is_same<EventRecord,NtupleRecord>::value) {
+      static_assert(std::is_trivially_copyable<EventRecord>::value,
+                    "RootTreeSampler: mapped records must be trivially copyable");
+
+      const std::string resolvedFileName = ConfigFileLookupPolicy()(fileName);
+      mapped_ = std::make_unique<MappedRecordFile>(resolvedFileName, sizeof(EventRecord),
+                                                   EventRecord::branchDescription());
+      if(mapped_->numRecords() == 0) {
+        throw cet::exception("BADINPUT")<<"RootTreeSampler: no records in \""<<resolvedFileName<<"\"\n";
+      }
+      mappedRecords_ = static_cast<const EventRecord*>(mapped_->data());
+    }
+    else {
+      throw cet::exception("BADCONFIG")<<"RootTreeSampler: mappedFile \""<<fileName
+                                       <<"\" is only supported for single ntuple records per event\n";
+    }
+  }
+
+  //================================================================
+  template<class EventRecord, class NtupleRecord>
+  void RootTreeSampler<EventRecord, NtupleRecord>::printStartup(std::chrono::steady_clock::time_point startTime) const
+  {
+    const double seconds =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+    if(mappedRecords_) {
+      std::cout<<"RootTreeSampler: mapped "<<mapped_->numRecords()
+               <<" records from "<<mapped_->fileName()
+               <<" in "<<seconds<<" s, "<<mapped_->mappedBytes()/1048576.
+               <<" MB shared, "<<mapped_->residentBytes()/1048576.
+               <<" MB resident"
+               <<std::endl;
+    }
+    else {
+      double bytes = records_.capacity()*sizeof(EventRecord);
+      if constexpr(!std::is_same<EventRecord,NtupleRecord>::value) {
+        for(const auto& r : records_) {
+          bytes += r.capacity()*sizeof(NtupleRecord);
+        }
+      }
+      std::cout<<"RootTreeSampler: loaded "<<records_.size()
+               <<" records in "<<seconds<<" s, "<<bytes/1048576.
+               <<" MB private memory"
+               <<std::endl;
+    }
+  }
+
   //================================================================
 }
 
@@ -0,0 +1,38 @@
+//
+// Random numbers distributed as the pdf of a BinnedSpectrum, see BinnedSpectrumSampler.hh
+//
+
+#include "cetlib_except/exception.h"
+
+#include "Mu2eUtilities/inc/BinnedSpectrumSampler.hh"
+
+namespace mu2e {
+
+  BinnedSpectrumSampler::BinnedSpectrumSampler(CLHEP::HepRandomEngine& engine,
+                                               const BinnedSpectrum& spectrum,
+                                               const std::string& method) :
+    _method(method)
+  {
+    if ( method == "RandGeneral" ) {
+      _randGeneral = std::make_unique<CLHEP::RandGeneral>(engine, spectrum.getPDF(), spectrum.getNbins());
+    }
+    else if ( method == "aliasTable" || method == "aliasTableInterpolated" ) {
+      _aliasTable = std::make_unique<RandomAliasTable>(engine, spectrum.getPDF(), spectrum.getNbins(),
+                                                       method == "aliasTableInterpolated");
+    }
+    else {
+      throw cet::exception("BADCONFIG")<<"BinnedSpectrumSampler: unknown spectrumSampler "<<method
+                                       <<", expect RandGeneral, aliasTable or aliasTableInterpolated\n";
+    }
+  }
+
+  void BinnedSpectrumSampler::fireArray(size_t n, double* vect) {
+    if ( _aliasTable ) {
+      _aliasTable->fireArray(n, vect);
+    }
+    else {
+      _randGeneral->fireArray(n, vect);
+    }
+  }
+
+} // end of namespace mu2e
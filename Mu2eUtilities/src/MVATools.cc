@@ -7,6 +7,9 @@
 #include <algorithm>
 #include <iostream>
 #include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <utility>
 #include <vector>
@@ -34,13 +37,15 @@
 
 using namespace xercesc;
 
+namespace {
+  // number of feature vectors evaluated together in the batch evaluation
+  constexpr unsigned batchBlock = 16;
+}
+
 namespace mu2e
 {
 
   MVATools::MVATools(const Config& config) :
-    x_(),
-    y_(),
-    fv_(),
     wgts_(),
     maxNeurons_(0),
     activeType_(aType::null),
@@ -51,7 +56,8 @@ namespace mu2e
     title_(),
     label_(),
     activationTypeString_("none"),
-    mvaWgtsFile_()
+    mvaWgtsFile_(),
+    xmlInits_(0)
   {
      ConfigFileLookupPolicy configFile;
      std::string weights = config.weights();
@@ -59,9 +65,6 @@ namespace mu2e
   }
 
   MVATools::MVATools(fhicl::ParameterSet const& pset) :
-    x_(),
-    y_(),
-    fv_(),
     wgts_(),
     maxNeurons_(0),
     activeType_(aType::null),
@@ -72,7 +75,8 @@ namespace mu2e
     title_(),
     label_(),
     activationTypeString_("none"),
-    mvaWgtsFile_()
+    mvaWgtsFile_(),
+    xmlInits_(0)
   {
      ConfigFileLookupPolicy configFile;
      std::string weights = pset.get<std::string>("MVAWeights");
@@ -80,9 +84,6 @@ namespace mu2e
   }
 
   MVATools::MVATools(const std::string& xmlfilename) :
-    x_(),
-    y_(),
-    fv_(),
     wgts_(), 
     maxNeurons_(0), 
     activeType_(aType::null),
@@ -93,7 +94,8 @@ namespace mu2e
     title_(), 
     label_(),
     activationTypeString_("none"),
-    mvaWgtsFile_() { 
+    mvaWgtsFile_(),
+    xmlInits_(0) { 
 
     ConfigFileLookupPolicy configFile;
     mvaWgtsFile_ = configFile(xmlfilename);
@@ -101,13 +103,27 @@ namespace mu2e
 
 
   MVATools::~MVATools() {
-    XMLPlatformUtils::Terminate();
+    for (unsigned i=0;i<xmlInits_;++i) XMLPlatformUtils::Terminate();
   }
 
   void MVATools::initMVA()
   {
     if (wgts_.size()>0) throw cet::exception("RECO")<<"mu2e::MVATools: already initialized" << std::endl;
 
+    // the XML is parsed once per weights file, the instances reading the same file copy the parsed network
+    static std::mutex cacheMutex;
+    static std::map<std::string, std::unique_ptr<const MVATools> > cache;
+    std::lock_guard<std::mutex> lock(cacheMutex);
+
+    auto icache = cache.find(mvaWgtsFile_);
+    if (icache != cache.end())
+    {
+       unsigned xmlInits = xmlInits_;
+       *this = *icache->second;
+       xmlInits_ = xmlInits;
+       return;
+    }
+
     xercesc::DOMDocument* xmlDoc = getXmlDoc();
     getGen(xmlDoc);
     getOpts(xmlDoc);
@@ -115,6 +131,10 @@ namespace mu2e
     getWgts(xmlDoc);
 
     xmlDoc->release();
+
+    auto parsed = std::make_unique<MVATools>(*this);
+    parsed->xmlInits_ = 0;
+    cache.emplace(mvaWgtsFile_,std::move(parsed));
   }
 
   void MVATools::getGen(xercesc::DOMDocument* xmlDoc)
@@ -269,6 +289,7 @@ namespace mu2e
     try
       {
 	XMLPlatformUtils::Initialize();
+	++xmlInits_;
       } 
     catch (XMLException& e)
       {
@@ -372,8 +393,6 @@ namespace mu2e
       }
 
       maxNeurons_ = *std::max_element(links_.begin(),links_.end());
-      x_ = std::vector<float>(maxNeurons_,0.0f);
-      y_ = std::vector<float>(maxNeurons_,0.0f);
 
       XMLString::release(&ATT_INDEX);
       XMLString::release(&ATT_NSYNAPSES);
@@ -428,28 +447,21 @@ namespace mu2e
 
   float MVATools::evalMVA(const std::vector<double >& v, const MVAMask& mask) const
   {
-     for (size_t i=0;i<v.size();++i)  fv_[i] = static_cast<float>(v[i]);
-     return evalMVA(fv_,mask);
+     thread_local std::vector<float> fv;
+     fv.assign(v.begin(),v.end());
+     return evalMVA(fv,mask);
   }
 
   float MVATools::evalMVA(const std::vector<float>& v, const MVAMask& mask) const
   {
+      thread_local Scratch scratch;
+      scratch.x.resize(maxNeurons_);
+      scratch.y.resize(maxNeurons_);
+      std::vector<float>& x = scratch.x;
+      std::vector<float>& y = scratch.y;
 
       // Normalize the input data and add the bias node, skip masked values
-      size_t ival(0);
-      for (size_t ivar=0; ivar < v.size(); ivar++)
-      {
-         if ( mask & (1<<ivar) )
-         {
-	    x_[ival]= isNorm_ ? (v[ivar]-voffset_[ival])*vscale_[ival] - 1.0 : v[ivar];
-	    ++ival;
-         }
-      }
-      x_[ival] = 1.0;
-
-      if (ival != links_[0]-1)
-	throw cet::exception("RECO")<<"mu2e::MVATools: mismatch input dimension (ival = " << ival << ") and network architecture (links_[0]-1 = " << links_[0]-1 << ")" << std::endl;
-
+      fillInputs(v,mask,x.data(),1);
 
       //perform feed forward calculation up to the last hidden layer
       unsigned idxWeight(0);
@@ -458,23 +470,110 @@ namespace mu2e
           //the number of synpases is given by the number of neurons in the next layer -1 (do not count bias neuron!)
           for (unsigned j=0;j<links_[k+1]-1;++j)
           {
-	     y_[j]=0.0f;
-	     for (unsigned i=0;i<links_[k];++i) y_[j] += wgts_[i+idxWeight]*x_[i];
-             y_[j] = activation(y_[j]);
+	     y[j]=0.0f;
+	     for (unsigned i=0;i<links_[k];++i) y[j] += wgts_[i+idxWeight]*x[i];
+             y[j] = activation(y[j]);
              idxWeight += links_[k];
           }
-          x_.swap(y_);
-          x_[links_[k+1]-1] = 1.0f; //add bias neuron
+          x.swap(y);
+          x[links_[k+1]-1] = 1.0f; //add bias neuron
       }
 
       //calculate output neuron value
       float yf(0.0);
-      for (unsigned i=0;i<links_.back();++i) yf += wgts_[i+idxWeight]*x_[i];
+      for (unsigned i=0;i<links_.back();++i) yf += wgts_[i+idxWeight]*x[i];
 
       if (oldMVA_) return yf;
       return  1.0/(1.0+expf(-yf));
   }
 
+  void MVATools::evalMVA(const std::vector<std::vector<float> >& inputs, std::vector<float>& outputs,
+                         const MVAMask& mask) const
+  {
+      thread_local Scratch scratch;
+      evalMVA(inputs,outputs,scratch,mask);
+  }
+
+  void MVATools::evalMVA(const std::vector<std::vector<float> >& inputs, std::vector<float>& outputs,
+                         Scratch& scratch, const MVAMask& mask) const
+  {
+      outputs.resize(inputs.size());
+      scratch.x.resize(maxNeurons_*batchBlock);
+      scratch.y.resize(maxNeurons_*batchBlock);
+
+      for (size_t first=0;first<inputs.size();first+=batchBlock)
+      {
+          unsigned nvec = std::min(inputs.size()-first,size_t(batchBlock));
+          evalBlock(&inputs[first],nvec,&outputs[first],scratch,mask);
+      }
+  }
+
+  // Evaluate up to batchBlock feature vectors together. The neuron values are stored neuron-major,
+  // x[i*batchBlock+b] is neuron i of vector b, so the inner loops run over the vectors of the block
+  // with a single weight and are vectorized by the compiler. The sums are accumulated in the same
+  // order as in the single vector evaluation, so the results are identical.
+  void MVATools::evalBlock(const std::vector<float>* inputs, unsigned nvec, float* outputs,
+                           Scratch& scratch, const MVAMask& mask) const
+  {
+      float* x = scratch.x.data();
+      float* y = scratch.y.data();
+
+      // unused lanes are zeroed so that they stay finite
+      std::fill(x,x+links_[0]*batchBlock,0.0f);
+      for (unsigned b=0;b<nvec;++b) fillInputs(inputs[b],mask,x+b,batchBlock);
+
+      unsigned idxWeight(0);
+      for (unsigned k=0;k<links_.size()-1;++k)
+      {
+          for (unsigned j=0;j<links_[k+1]-1;++j)
+          {
+             float* yj = y+j*batchBlock;
+             std::fill(yj,yj+batchBlock,0.0f);
+             for (unsigned i=0;i<links_[k];++i)
+             {
+                const float  w  = wgts_[i+idxWeight];
+                const float* xi = x+i*batchBlock;
+                for (unsigned b=0;b<batchBlock;++b) yj[b] += w*xi[b];
+             }
+             for (unsigned b=0;b<batchBlock;++b) yj[b] = activation(yj[b]);
+             idxWeight += links_[k];
+          }
+          std::swap(x,y);
+          float* bias = x+(links_[k+1]-1)*batchBlock;
+          std::fill(bias,bias+batchBlock,1.0f); //add bias neuron
+      }
+
+      float yf[batchBlock] = {0.0f};
+      for (unsigned i=0;i<links_.back();++i)
+      {
+         const float  w  = wgts_[i+idxWeight];
+         const float* xi = x+i*batchBlock;
+         for (unsigned b=0;b<batchBlock;++b) yf[b] += w*xi[b];
+      }
+
+      for (unsigned b=0;b<nvec;++b) outputs[b] = oldMVA_ ? yf[b] : 1.0/(1.0+expf(-yf[b]));
+  }
+
+  // Normalize the input data and add the bias node, skip masked values. The inputs are written
+  // to x[0], x[stride], x[2*stride], ...
+  void MVATools::fillInputs(const std::vector<float>& v, const MVAMask& mask, float* x, unsigned stride) const
+  {
+      size_t ival(0);
+      for (size_t ivar=0; ivar < v.size(); ivar++)
+      {
+         if ( mask & (1<<ivar) )
+         {
+	    x[ival*stride]= isNorm_ ? (v[ivar]-voffset_[ival])*vscale_[ival] - 1.0 : v[ivar];
+	    ++ival;
+         }
+      }
+
+      if (ival != links_[0]-1)
+	throw cet::exception("RECO")<<"mu2e::MVATools: mismatch input dimension (ival = " << ival << ") and network architecture (links_[0]-1 = " << links_[0]-1 << ")" << std::endl;
+
+      x[ival*stride] = 1.0;
+  }
+
 
 
 
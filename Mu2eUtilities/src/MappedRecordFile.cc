@@ -0,0 +1,162 @@
+#include "Mu2eUtilities/inc/MappedRecordFile.hh"
+
+#include <cerrno>
+#include <cstring>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "cetlib_except/exception.h"
+
+namespace mu2e {
+
+  namespace {
+    const char magicWord[8] = {'M','U','2','E','R','E','C','S'};
+    const std::uint32_t currentVersion = 1;
+  }
+
+  //================================================================
+  MappedRecordFile::MappedRecordFile(const std::string& fileName,
+                                     std::size_t recordSize,
+                                     const std::string& description)
+    : fileName_(fileName)
+  {
+    int fd = ::open(fileName.c_str(), O_RDONLY);
+    if(fd < 0) {
+      throw cet::exception("BADINPUT")<<"MappedRecordFile: can not open \""<<fileName
+                                      <<"\": "<<std::strerror(errno)<<"\n";
+    }
+
+    struct stat st;
+    if(::fstat(fd, &st) != 0 || std::size_t(st.st_size) < headerSize) {
+      ::close(fd);
+      throw cet::exception("BADINPUT")<<"MappedRecordFile: \""<<fileName
+                                      <<"\" is too short to be a record file\n";
+    }
+
+    mappedBytes_ = st.st_size;
+    map_ = ::mmap(nullptr, mappedBytes_, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if(map_ == MAP_FAILED) {
+      map_ = nullptr;
+      throw cet::exception("BADINPUT")<<"MappedRecordFile: can not map \""<<fileName
+                                      <<"\": "<<std::strerror(errno)<<"\n";
+    }
+
+    Header header;
+    std::memcpy(&header, map_, sizeof(header));
+    header.description[sizeof(header.description)-1] = 0;
+
+    std::string problem;
+    if(std::memcmp(header.magic, magicWord, sizeof(magicWord)) != 0) {
+      problem = "not a record file";
+    }
+    else if(header.version != currentVersion) {
+      problem = "unknown version "+std::to_string(header.version);
+    }
+    else if(header.recordSize != recordSize || description != header.description) {
+      problem = "the records are \""+std::string(header.description)+"\" of "
+        +std::to_string(header.recordSize)+" bytes, expect \""+description+"\" of "
+        +std::to_string(recordSize)+" bytes";
+    }
+    else if(header.dataOffset + header.numRecords*header.recordSize > mappedBytes_) {
+      problem = "the file is truncated";
+    }
+    if(!problem.empty()) {
+      ::munmap(map_, mappedBytes_);
+      map_ = nullptr;
+      throw cet::exception("BADINPUT")<<"MappedRecordFile: \""<<fileName<<"\": "<<problem<<"\n";
+    }
+
+    dataOffset_ = header.dataOffset;
+    numRecords_ = header.numRecords;
+
+    // The records are sampled at random, start reading them in the background.
+    ::madvise(map_, mappedBytes_, MADV_WILLNEED);
+  }
+
+  //================================================================
+  MappedRecordFile::~MappedRecordFile() {
+    if(map_) {
+      ::munmap(map_, mappedBytes_);
+    }
+  }
+
+  //================================================================
+  std::size_t MappedRecordFile::residentBytes() const {
+    const std::size_t pageSize = ::sysconf(_SC_PAGESIZE);
+    const std::size_t numPages = (mappedBytes_ + pageSize - 1)/pageSize;
+    std::vector<unsigned char> pages(numPages);
+    if(::mincore(map_, mappedBytes_, pages.data()) != 0) {
+      return 0;
+    }
+    std::size_t res = 0;
+    for(auto p : pages) {
+      if(p & 1) {
+        ++res;
+      }
+    }
+    return res*pageSize;
+  }
+
+  //================================================================
+  MappedRecordFile::Writer::Writer(const std::string& fileName,
+                                   std::size_t recordSize,
+                                   const std::string& description)
+    : fileName_(fileName)
+    , out_(fileName, std::ios::binary | std::ios::trunc)
+    , recordSize_(recordSize)
+  {
+    if(!out_) {
+      throw cet::exception("BADCONFIG")<<"MappedRecordFile: can not write \""<<fileName<<"\"\n";
+    }
+    if(description.size() >= sizeof(header_.description)) {
+      throw cet::exception("BADCONFIG")<<"MappedRecordFile: record description \""<<description
+                                       <<"\" is too long\n";
+    }
+
+    std::memset(&header_, 0, sizeof(header_));
+    std::memcpy(header_.magic, magicWord, sizeof(magicWord));
+    header_.version = currentVersion;
+    header_.recordSize = recordSize;
+    header_.dataOffset = headerSize;
+    std::strncpy(header_.description, description.c_str(), sizeof(header_.description)-1);
+
+    // Reserve the header page, it is written by close()
+    const std::vector<char> page(headerSize, 0);
+    out_.write(page.data(), page.size());
+  }
+
+  //================================================================
+  MappedRecordFile::Writer::~Writer() {
+    try {
+      close();
+    }
+    catch(...) {
+    }
+  }
+
+  //================================================================
+  void MappedRecordFile::Writer::write(const void* record) {
+    out_.write(static_cast<const char*>(record), recordSize_);
+    ++numRecords_;
+  }
+
+  //================================================================
+  void MappedRecordFile::Writer::close() {
+    if(!out_.is_open()) {
+      return;
+    }
+    header_.numRecords = numRecords_;
+    out_.seekp(0);
+    out_.write(reinterpret_cast<const char*>(&header_), sizeof(header_));
+    out_.close();
+    if(out_.fail()) {
+      throw cet::exception("BADCONFIG")<<"MappedRecordFile: error writing \""<<fileName_<<"\"\n";
+    }
+  }
+
+}
@@ -0,0 +1,110 @@
+//
+// Sample a binned pdf with the alias method, see RandomAliasTable.hh
+//
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+#include "CLHEP/Random/RandomEngine.h"
+#include "cetlib_except/exception.h"
+
+#include "Mu2eUtilities/inc/RandomAliasTable.hh"
+
+namespace mu2e {
+
+  RandomAliasTable::RandomAliasTable(CLHEP::HepRandomEngine& engine, const double* pdf, size_t nBins, bool interpolate) :
+    _engine(engine),
+    _nBins(nBins),
+    _interpolate(interpolate),
+    _prob(nBins, 1.),
+    _alias(nBins),
+    _slope(nBins, 0.)
+  {
+    if ( nBins == 0 ) {
+      throw cet::exception("BADCONFIG")<<"RandomAliasTable: no bins\n";
+    }
+
+    // As RandGeneral: negative weights are replaced by 0, and if no weight
+    // is positive the distribution is flat.
+    std::vector<double> weights(pdf, pdf+nBins);
+    double sum = 0.;
+    for ( size_t i = 0; i < nBins; ++i ) {
+      if ( weights[i] < 0. ) {
+        std::cerr << "RandomAliasTable: negative weight " << weights[i] << " in bin " << i
+                  << ", will substitute 0 weight" << std::endl;
+        weights[i] = 0.;
+      }
+      sum += weights[i];
+    }
+    if ( !(sum > 0.) ) {
+      std::cerr << "RandomAliasTable: no positive weights, will use a flat distribution" << std::endl;
+      std::fill(weights.begin(), weights.end(), 1.);
+      sum = nBins;
+    }
+
+    // Vose's construction: bins below the mean are filled up to the mean by
+    // the excess of a bin above the mean, which becomes their alias.
+    std::vector<double> scaled(nBins);
+    std::vector<unsigned> small, large;
+    for ( size_t i = 0; i < nBins; ++i ) {
+      _alias[i] = i;
+      scaled[i] = weights[i]*nBins/sum;
+      if ( scaled[i] < 1. ) small.push_back(i);
+      else                  large.push_back(i);
+    }
+    while ( !small.empty() && !large.empty() ) {
+      unsigned s = small.back(); small.pop_back();
+      unsigned l = large.back();
+      _prob[s]  = scaled[s];
+      _alias[s] = l;
+      scaled[l] -= 1. - scaled[s];
+      if ( scaled[l] < 1. ) {
+        large.pop_back();
+        small.push_back(l);
+      }
+    }
+    // What is left is 1 up to rounding
+
+    if ( _interpolate && nBins > 1 ) {
+      for ( size_t i = 0; i < nBins; ++i ) {
+        if ( weights[i] <= 0. ) continue;
+        double lo = weights[i > 0 ? i-1 : i];
+        double hi = weights[i+1 < nBins ? i+1 : i];
+        double step = (i > 0 && i+1 < nBins) ? 2. : 1.;
+        // the density may not become negative at either edge of the bin
+        _slope[i] = std::max(-2., std::min(2., (hi - lo)/step/weights[i]));
+      }
+    }
+  }
+
+  double RandomAliasTable::value(double r1, double r2) const {
+    double u = r1*_nBins;
+    size_t i = std::min(size_t(u), _nBins-1);
+    if ( u - i >= _prob[i] ) i = _alias[i];
+
+    double x = r2;
+    double s = _slope[i];
+    if ( s != 0. && r2 > 0. ) {
+      // invert x + s*(x*x - x)/2 = r2
+      double b = 1. - 0.5*s;
+      x = 2.*r2/(b + std::sqrt(b*b + 2.*s*r2));
+    }
+    return (i + x)/_nBins;
+  }
+
+  double RandomAliasTable::fire() {
+    double r1 = _engine.flat();
+    double r2 = _engine.flat();
+    return value(r1, r2);
+  }
+
+  void RandomAliasTable::fireArray(size_t n, double* vect) {
+    _flat.resize(2*n);
+    _engine.flatArray(2*n, _flat.data());
+    for ( size_t k = 0; k < n; ++k ) {
+      vect[k] = value(_flat[2*k], _flat[2*k+1]);
+    }
+  }
+
+} // end of namespace mu2e
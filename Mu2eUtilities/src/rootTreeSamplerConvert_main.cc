@@ -0,0 +1,144 @@
+//
+// Convert the ROOT trees read by RootTreeSampler into a flat record file that
+// RootTreeSampler maps instead (the mappedFile parameter).  All the entries of
+// all the input files are written, in order.  The output is mapped back and
+// compared with the last record read before the tool exits.
+//
+// Usage: rootTreeSamplerConvert [--record StoppedParticleF|StoppedParticleTauNormF]
+//                               [--tree <tree name>] [--branch <branch name>]
+//                               <output file> <input file> [<input file> ...]
+//
+// The defaults are those of the target muon stops: --record StoppedParticleF
+// --tree stoppedMuonDumper/stops --branch stops.
+//
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "cetlib_except/exception.h"
+
+#include "TFile.h"
+#include "TTree.h"
+#include "TBranch.h"
+
+#include "GeneralUtilities/inc/RSNTIO.hh"
+#include "Mu2eUtilities/inc/MappedRecordFile.hh"
+
+namespace {
+
+  template<class Record>
+  std::size_t convert(const std::string& outputFile,
+                      const std::vector<std::string>& inputFiles,
+                      const std::string& treeName,
+                      const std::string& branchName) {
+
+    mu2e::MappedRecordFile::Writer writer(outputFile, sizeof(Record), Record::branchDescription());
+
+    Record record;
+    for(const auto& fn : inputFiles) {
+      TFile *infile = TFile::Open(fn.c_str(), "READ");
+      if(!infile || infile->IsZombie()) {
+        throw cet::exception("BADINPUT")<<"rootTreeSamplerConvert: can not open \""<<fn<<"\"\n";
+      }
+
+      TTree *nt = dynamic_cast<TTree*>(infile->Get(treeName.c_str()));
+      if(!nt) {
+        throw cet::exception("BADINPUT")<<"rootTreeSamplerConvert: Could not get tree \""<<treeName
+                                        <<"\" from file \""<<fn<<"\"\n";
+      }
+      TBranch *bb = nt->GetBranch(branchName.c_str());
+      if(!bb) {
+        throw cet::exception("BADINPUT")<<"rootTreeSamplerConvert: Could not get branch \""<<branchName
+                                        <<"\" in tree \""<<treeName<<"\" from file \""<<fn<<"\"\n";
+      }
+      if(unsigned(bb->GetNleaves()) != Record::numBranchLeaves()) {
+        throw cet::exception("BADINPUT")<<"rootTreeSamplerConvert: wrong number of leaves: expect "
+                                        <<Record::numBranchLeaves()<<", but branch \""<<branchName
+                                        <<"\" in file \""<<fn<<"\" has "<<bb->GetNleaves()<<"\n";
+      }
+
+      bb->SetAddress(&record);
+      const Long64_t nTreeEntries = nt->GetEntries();
+      for(Long64_t i=0; i<nTreeEntries; ++i) {
+        bb->GetEntry(i);
+        writer.write(&record);
+      }
+      std::cout<<"rootTreeSamplerConvert: "<<nTreeEntries<<" entries from "<<fn<<std::endl;
+
+      delete infile;
+    }
+    writer.close();
+
+    mu2e::MappedRecordFile check(outputFile, sizeof(Record), Record::branchDescription());
+    const Record *mapped = static_cast<const Record*>(check.data());
+    if(check.numRecords() != writer.numRecords() ||
+       (writer.numRecords() > 0 &&
+        std::memcmp(&mapped[check.numRecords()-1], &record, sizeof(Record)) != 0)) {
+      throw cet::exception("BADINPUT")<<"rootTreeSamplerConvert: "<<outputFile
+                                      <<" does not reproduce the input records\n";
+    }
+
+    return writer.numRecords();
+  }
+}
+
+int main(int argc, char**argv) {
+
+  std::string recordType = "StoppedParticleF";
+  std::string treeName = "stoppedMuonDumper/stops";
+  std::string branchName = "stops";
+  std::vector<std::string> files;
+
+  for(int i=1; i<argc; ++i) {
+    const std::string w(argv[i]);
+    if((w == "--record" || w == "--tree" || w == "--branch") && i+1 < argc) {
+      const std::string value(argv[++i]);
+      if(w == "--record") recordType = value;
+      else if(w == "--tree") treeName = value;
+      else branchName = value;
+    }
+    else {
+      files.push_back(w);
+    }
+  }
+
+  if(files.size() < 2) {
+    std::cerr << "Usage: rootTreeSamplerConvert [--record StoppedParticleF|StoppedParticleTauNormF]\n"
+              << "                              [--tree <tree name>] [--branch <branch name>]\n"
+              << "                              <output file> <input file> [<input file> ...]" << std::endl;
+    return 1;
+  }
+
+  const std::string outputFile = files.front();
+  const std::vector<std::string> inputFiles(files.begin()+1, files.end());
+
+  try {
+    const auto startTime = std::chrono::steady_clock::now();
+
+    std::size_t numRecords = 0;
+    if(recordType == "StoppedParticleF") {
+      numRecords = convert<mu2e::IO::StoppedParticleF>(outputFile, inputFiles, treeName, branchName);
+    }
+    else if(recordType == "StoppedParticleTauNormF") {
+      numRecords = convert<mu2e::IO::StoppedParticleTauNormF>(outputFile, inputFiles, treeName, branchName);
+    }
+    else {
+      std::cerr << "rootTreeSamplerConvert: unknown record type " << recordType << std::endl;
+      return 1;
+    }
+
+    const double seconds =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    std::cout << "rootTreeSamplerConvert: wrote " << numRecords << " " << recordType
+              << " records to " << outputFile << " in " << seconds << " s" << std::endl;
+  }
+  catch(cet::exception& e) {
+    std::cerr << e.what() << std::endl;
+    return 2;
+  }
+
+  return 0;
+}
@@ -21,6 +21,7 @@
 #include "art/Framework/Principal/Handle.h"
 // C++ includes
 #include <array>
+#include <memory>
 #include <vector>
 namespace mu2e {
 
@@ -89,18 +90,48 @@ namespace mu2e {
     StrawEnd _tend; // end used to define time measruement
   };
   // ComboHitCollection is a non-trivial subclass of vector which includes navigation of nested ComboHits
+  // The navigation down to the StrawHit level is computed once per collection (see Lineage) and cached;
+  // the collection should not be changed after it has been navigated.
   class ComboHitCollection : public std::vector<mu2e::ComboHit> {
     public:
       ComboHitCollection(bool sorted=false) : _sorted(sorted) {}
       typedef std::vector<ComboHitCollection::const_iterator> CHCIter;
+      // contiguous range of indices
+      struct IndexRange {
+        const uint16_t* _begin;
+        const uint16_t* _end;
+        const uint16_t* begin() const { return _begin; }
+        const uint16_t* end() const { return _end; }
+        size_t size() const { return _end - _begin; }
+        bool empty() const { return _begin == _end; }
+        uint16_t operator[](size_t i) const { return _begin[i]; }
+      };
+      // flattened ComboHit -> StrawHit -> StrawDigi mapping of all the hits of a collection.
+      // The indices of hit ich are in [_offsets[ich], _offsets[ich+1])
+      struct Lineage {
+        const ComboHitCollection* _parentCol; // collection 1 layer below, 0 at the StrawHit level
+        const ComboHitCollection* _bottomCol; // StrawHit level collection
+        art::EventID _event; // event, number of hits and parent when this was built
+        size_t _size;
+        art::ProductID _parent;
+        std::vector<uint32_t> _offsets;
+        std::vector<StrawHitIndex> _shids; // StrawHit indices (= indices into _bottomCol)
+        std::vector<StrawDigiIndex> _sdids; // StrawDigi indices
+        std::vector<uint8_t> _valid; // false if the hit includes an invalid StrawHit level ComboHit
+      };
+      // mapping of this collection, built on first use from the parent collections found in the event
+      Lineage const& lineage(art::Event const& event) const;
+      // O(1) access to the StrawHit or StrawDigi indices used in a given ComboHit
+      IndexRange strawHitIndices(art::Event const& event, uint16_t chindex) const;
+      IndexRange strawDigiIndices(art::Event const& event, uint16_t chindex) const;
       // fill a vector of indices to the underlying digis used in a given ComboHit
-      // This function is called recursively, so the the vector must be empty on the top-most call
+      // The indices are appended to the vector
       void fillStrawDigiIndices(art::Event const& event, uint16_t chindex, std::vector<StrawHitIndex>& shids) const;
       // similarly fill to the StrawHit level
       void fillStrawHitIndices(art::Event const& event, uint16_t chindex, std::vector<StrawHitIndex>& shids) const;
       // do this for all the hits in the collection
       void fillStrawHitIndices(art::Event const& event, std::vector<std::vector<StrawHitIndex> >& shids) const;
-      // translate a collection of ComboHits into the lowest-level (straw) combo hits.  This function is recursive
+      // translate a collection of ComboHits into the lowest-level (straw) combo hits
       void fillComboHits(art::Event const& event, std::vector<uint16_t> const& indices, CHCIter& iters) const;
       // fill a vector of iterators to the ComboHits 1 layer below a given ComboHit.  This is NOT RECURSIVE
       // return value says whether there's a layer below or not (if not, output is empty)
@@ -120,6 +151,18 @@ namespace mu2e {
       // This can be used to chain back to the original StrawHit indices
       art::ProductID _parent;
       bool _sorted; // record if this collection was sorted
+      // transient cache of the lineage; copies of the collection start without it
+      class LineageCache {
+        public:
+          LineageCache() {}
+          LineageCache(LineageCache const&) {}
+          LineageCache& operator =(LineageCache const&) { _lineage.reset(); return *this; }
+          std::shared_ptr<const Lineage> _lineage;
+      };
+      mutable LineageCache _lineageCache; //! transient
+      void buildLineage(art::Event const& event, Lineage& lineage) const;
+      const ComboHitCollection* findParent(art::Event const& event) const;
+      IndexRange range(Lineage const& lineage, std::vector<uint16_t> const& indices, uint16_t chindex) const;
   };
   inline std::ostream& operator<<( std::ostream& ost,
                                    ComboHit const& hit){
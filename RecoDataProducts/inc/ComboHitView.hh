@@ -0,0 +1,58 @@
+#ifndef RecoDataProducts_ComboHitView_hh
+#define RecoDataProducts_ComboHitView_hh
+//
+// Structure-of-arrays copy of the fields of a ComboHitCollection used by the pattern
+// recognition loops: one float array per quantity, each starting on a cache line, plus the
+// hit flags, StrawIds and StrawHit counts.  Loops over all the hits of a collection read
+// only the arrays they use instead of the full (>100 byte) ComboHits.
+//
+// The view is built and owned by its user, e.g. once per event in TimeClusterFinder.  It is
+// a copy: it does not follow changes made to the collection after it was built.
+//
+#include "RecoDataProducts/inc/ComboHit.hh"
+#include <cstddef>
+#include <vector>
+namespace mu2e {
+
+  class ComboHitView {
+    public:
+      enum column {x_=0,y_,z_,time_,ctime_,phi_,wdirx_,wdiry_,wdirz_,wres_,tres_,wdist_,edep_,ncolumns};
+      explicit ComboHitView(ComboHitCollection const& chcol);
+      // no copies: the columns point into the buffer
+      ComboHitView(ComboHitView const&) = delete;
+      ComboHitView& operator =(ComboHitView const&) = delete;
+
+      size_t size() const { return _size; }
+      // single hit accessors, with the meaning of the ComboHit accessors of the same name
+      float x(size_t ich) const { return _col[x_][ich]; }
+      float y(size_t ich) const { return _col[y_][ich]; }
+      float z(size_t ich) const { return _col[z_][ich]; }
+      float time(size_t ich) const { return _col[time_][ich]; }
+      float correctedTime(size_t ich) const { return _col[ctime_][ich]; }
+      float phi(size_t ich) const { return _col[phi_][ich]; }
+      float wdirX(size_t ich) const { return _col[wdirx_][ich]; }
+      float wdirY(size_t ich) const { return _col[wdiry_][ich]; }
+      float wdirZ(size_t ich) const { return _col[wdirz_][ich]; }
+      float wireRes(size_t ich) const { return _col[wres_][ich]; }
+      float transRes(size_t ich) const { return _col[tres_][ich]; }
+      float wireDist(size_t ich) const { return _col[wdist_][ich]; }
+      float energyDep(size_t ich) const { return _col[edep_][ich]; }
+      float perp2(size_t ich) const { return x(ich)*x(ich) + y(ich)*y(ich); }
+      uint16_t nStrawHits(size_t ich) const { return _nsh[ich]; }
+      StrawId const& strawId(size_t ich) const { return _sid[ich]; }
+      StrawHitFlag const& flag(size_t ich) const { return _flag[ich]; }
+      // whole columns, for loops over all the hits
+      const float* data(column col) const { return _col[col]; }
+      const uint16_t* nStrawHits() const { return _nsh.data(); }
+      const StrawHitFlag* flags() const { return _flag.data(); }
+
+    private:
+      size_t _size;
+      std::vector<float> _buffer; // all the float columns, each padded to a cache line
+      const float* _col[ncolumns];
+      std::vector<uint16_t> _nsh;
+      std::vector<StrawId> _sid;
+      std::vector<StrawHitFlag> _flag;
+  };
+}
+#endif
@@ -8,6 +8,7 @@
 // art includes
 #include "cetlib_except/exception.h"
 // c++ includes
+#include <atomic>
 #include <iostream>
 using std::vector;
 namespace mu2e {
@@ -77,117 +78,113 @@ namespace mu2e {
     }
   }
 
-  void ComboHitCollection::fillStrawDigiIndices(art::Event const& event, uint16_t chindex, vector<StrawDigiIndex>& shids) const {
-    ComboHit const& ch = this->at(chindex);
-   // see if this collection references other collections: if so, go down 1 layer
+  const ComboHitCollection* ComboHitCollection::findParent(art::Event const& event) const {
+    art::Handle<ComboHitCollection> ph;
+    setParentHandle(event,ph);
+    if(!ph.isValid())
+      throw cet::exception("RECO")<<"mu2e::ComboHitCollection: Can't find parent collection" << std::endl;
+    return ph.product();
+  }
+
+  ComboHitCollection::Lineage const& ComboHitCollection::lineage(art::Event const& event) const {
+    std::shared_ptr<const Lineage> cached = std::atomic_load(&_lineageCache._lineage);
+    // rebuild if the collection was refilled since the cache was filled
+    if(cached && cached->_event == event.id() && cached->_size == size() && cached->_parent == _parent)
+      return *cached;
+    auto built = std::make_shared<Lineage>();
+    buildLineage(event,*built);
+    std::shared_ptr<const Lineage> fresh(built);
+    // if another thread got there first, use its copy: references to it may already be in use
+    if(!cached && !std::atomic_compare_exchange_strong(&_lineageCache._lineage,&cached,fresh))
+      return *cached;
+    if(cached) std::atomic_store(&_lineageCache._lineage,fresh);
+    return *fresh;
+  }
+
+  void ComboHitCollection::buildLineage(art::Event const& event, Lineage& lineage) const {
+    lineage._event = event.id();
+    lineage._size = size();
+    lineage._parent = _parent;
+    lineage._offsets.reserve(size()+1);
+    lineage._offsets.push_back(0);
+    lineage._valid.reserve(size());
     if(_parent.isValid()){
-    // get the parent handle
-      art::Handle<ComboHitCollection> ph;
-      setParentHandle(event,ph);
-      if(ph.isValid()){
-      // get the parent collection
-	const ComboHitCollection *pc = ph.product();
-	// recursive calls on the ComboHits in the parent collection referenced by the specified ComboHit
+      // go down 1 layer: the parent lineage is built (once) and the spans of the referenced hits concatenated
+      const ComboHitCollection *pc = findParent(event);
+      Lineage const& pl = pc->lineage(event);
+      lineage._parentCol = pc;
+      lineage._bottomCol = pl._bottomCol;
+      for(auto const& ch : *this){
+	bool valid(true);
 	for(uint16_t iind = 0;iind < ch.nCombo(); ++iind){
-	  pc->fillStrawDigiIndices(event,ch.index(iind),shids);
+	  uint16_t pind = ch.index(iind);
+	  if(pind >= pc->size())
+	    throw cet::exception("RECO")<<"mu2e::ComboHitCollection: invalid parent index " << pind << std::endl;
+	  lineage._shids.insert(lineage._shids.end(),pl._shids.begin()+pl._offsets[pind],pl._shids.begin()+pl._offsets[pind+1]);
+	  lineage._sdids.insert(lineage._sdids.end(),pl._sdids.begin()+pl._offsets[pind],pl._sdids.begin()+pl._offsets[pind+1]);
+	  valid &= pl._valid[pind] != 0;
 	}
-      } else {
-	throw cet::exception("RECO")<<"mu2e::ComboHitCollection: Can't find parent collection" << std::endl;
+	lineage._offsets.push_back(lineage._shids.size());
+	lineage._valid.push_back(valid);
       }
     } else {
-      if(ch.nCombo() != 1 || ch.nStrawHits() != 1)
-	throw cet::exception("RECO")<<"mu2e::ComboHitCollection: invalid ComboHit" << std::endl;
-      // if not, it is the bottom and references StrawHits; fill the index vector with the content
-      shids.push_back(ch.index(0));
+      // bottom: the combo hit index is the StrawHit index, and the ComboHit references the digi
+      lineage._parentCol = 0;
+      lineage._bottomCol = this;
+      for(size_t ich = 0;ich < size(); ++ich){
+	ComboHit const& ch = (*this)[ich];
+	bool valid = ch.nCombo() == 1 && ch.nStrawHits() == 1;
+	lineage._shids.push_back(ich);
+	lineage._sdids.push_back(ch._pind[0]);
+	lineage._offsets.push_back(lineage._shids.size());
+	lineage._valid.push_back(valid);
+      }
     }
   }
 
+  ComboHitCollection::IndexRange ComboHitCollection::range(Lineage const& lineage, vector<uint16_t> const& indices, uint16_t chindex) const {
+    if(chindex >= size())
+      throw cet::exception("RECO")<<"mu2e::ComboHitCollection: invalid index " << chindex << std::endl;
+    if(!lineage._valid[chindex])
+      throw cet::exception("RECO")<<"mu2e::ComboHitCollection: invalid ComboHit" << std::endl;
+    const uint16_t* base = indices.data();
+    return IndexRange{base + lineage._offsets[chindex], base + lineage._offsets[chindex+1]};
+  }
+
+  ComboHitCollection::IndexRange ComboHitCollection::strawHitIndices(art::Event const& event, uint16_t chindex) const {
+    Lineage const& ln = lineage(event);
+    return range(ln,ln._shids,chindex);
+  }
+
+  ComboHitCollection::IndexRange ComboHitCollection::strawDigiIndices(art::Event const& event, uint16_t chindex) const {
+    Lineage const& ln = lineage(event);
+    return range(ln,ln._sdids,chindex);
+  }
+
+  void ComboHitCollection::fillStrawDigiIndices(art::Event const& event, uint16_t chindex, vector<StrawDigiIndex>& shids) const {
+    IndexRange sdids = strawDigiIndices(event,chindex);
+    shids.insert(shids.end(),sdids.begin(),sdids.end());
+  }
+
   void ComboHitCollection::fillStrawHitIndices(art::Event const& event, uint16_t chindex, vector<StrawHitIndex>& shids) const {
-    ComboHit const& ch = this->at(chindex);
-   // see if this collection references other collections: if so, go down 1 layer
-    if(_parent.isValid()){
-    // get the parent handle
-      art::Handle<ComboHitCollection> ph;
-      setParentHandle(event,ph);
-      if(ph.isValid()){
-      // get the parent collection
-	const ComboHitCollection *pc = ph.product();
-	// recursive calls on the ComboHits in the parent collection referenced by the specified ComboHit
-	for(uint16_t iind = 0;iind < ch.nCombo(); ++iind){
-	  pc->fillStrawHitIndices(event,ch.index(iind),shids);
-	}
-      } else {
-	throw cet::exception("RECO")<<"mu2e::ComboHitCollection: Can't find parent collection" << std::endl;
-      }
-    } else {
-      if(ch.nCombo() != 1 || ch.nStrawHits() != 1)
-	throw cet::exception("RECO")<<"mu2e::ComboHitCollection: invalid ComboHit" << std::endl;
-      // if not, it is the bottom and the combo hit index is the same as the StrawHit index
-      shids.push_back(chindex);
-    }
+    IndexRange hids = strawHitIndices(event,chindex);
+    shids.insert(shids.end(),hids.begin(),hids.end());
   }
 
   void ComboHitCollection::fillStrawHitIndices(art::Event const& event, vector<vector<StrawHitIndex> >& shids) const {
-  // reset
+    Lineage const& ln = lineage(event);
     shids = vector<vector<StrawHitIndex> >(size());
-   // see if this collection references other collections: if so, go down 1 layer
-    if(parent().isValid()){
-    // get the parent handle
-      art::Handle<ComboHitCollection> ph;
-      setParentHandle(event,ph);
-      if(ph.isValid()){
-	const ComboHitCollection *pc = ph.product();
-	// check down 1 more layer
-	if(pc->parent().isValid()){
-	// call down 1 layer
-	  vector<vector<StrawHitIndex>> pshids(size());
-	  pc->fillStrawHitIndices(event,pshids);
-	// roll these up
-	  for(size_t ich=0;ich < size();++ich){
-	    ComboHit const& ch = (*this)[ich];
-	    for(auto iph : ch.indexArray())
-	      shids[ich].insert(shids[ich].end(),pshids[iph].begin(),pshids[iph].end());
-	  }
-	} else {
-	  // can skip a step in the hierarchy since the parent of this collection is at the top
-	  for(size_t ich=0;ich < size();++ich){
-	    ComboHit const& ch = (*this)[ich];
-	    shids[ich].insert(shids[ich].end(),ch.indexArray().begin(),ch.indexArray().end());
-	  }
-	}
-      } else {
-	throw cet::exception("RECO")<<"mu2e::ComboHitCollection: Can't find parent collection" << std::endl;
-      }
-    } else {
-    // already at the top: fill with self index
-      for(size_t ich = 0;ich < size(); ++ich)
-	shids[ich].push_back(ich);
-    }
+    for(size_t ich=0;ich < size();++ich)
+      shids[ich].assign(ln._shids.begin()+ln._offsets[ich],ln._shids.begin()+ln._offsets[ich+1]);
   }
 
   void ComboHitCollection::fillComboHits(art::Event const& event, std::vector<uint16_t> const& indices, CHCIter& iters) const {
-    if(_parent.isValid()){
-    // get the parent handle
-      art::Handle<ComboHitCollection> ph;
-      setParentHandle(event,ph);
-      if(ph.isValid()){
-      // get the parent collection
-	const ComboHitCollection *pc = ph.product();
-	// translate the indices down
-	std::vector<uint16_t> subindices;
-	for(auto index : indices){
-	  ComboHit const& ch = (*this)[index];
-	  for(uint16_t iind = 0;iind < ch.nCombo(); ++iind)
-	    subindices.push_back(ch.index(iind));
-	}
-	pc->fillComboHits(event,subindices,iters);
-      } else {
-	throw cet::exception("RECO")<<"mu2e::ComboHitCollection: Can't find parent collection" << std::endl;
-      }
-    } else {
-// already at lowest level: just translate indices to pointers
-      for(auto index : indices)
-	iters.push_back(std::next(begin(),index));
+    Lineage const& ln = lineage(event);
+    for(auto index : indices){
+      if(index >= size())
+	throw cet::exception("RECO")<<"mu2e::ComboHitCollection: invalid index " << index << std::endl;
+      for(uint32_t ish = ln._offsets[index];ish < ln._offsets[index+1]; ++ish)
+	iters.push_back(std::next(ln._bottomCol->begin(),ln._shids[ish]));
     }
   }
  
@@ -197,19 +194,11 @@ namespace mu2e {
     ComboHit const& ch = (*this)[chindex];
    // see if this collection references other collections: if so, we can fill the vector, if not reference myself
     if(_parent.isValid()){
-    // get the parent handle
-      art::Handle<ComboHitCollection> ph;
-      setParentHandle(event,ph);
-      if(ph.isValid()){
-      // get the parent collection
-	const ComboHitCollection *pc = ph.product();
-	for(uint16_t iind = 0;iind < ch.nCombo(); ++iind){
-	  iters.push_back(std::next(pc->begin(), ch.index(iind)));
-	}
-	retval = true;
-      } else {
-	throw cet::exception("RECO")<<"mu2e::ComboHitCollection: Can't find parent collection" << std::endl;
+      const ComboHitCollection *pc = lineage(event)._parentCol;
+      for(uint16_t iind = 0;iind < ch.nCombo(); ++iind){
+	iters.push_back(std::next(pc->begin(), ch.index(iind)));
       }
+      retval = true;
     }
     return retval; 
   }
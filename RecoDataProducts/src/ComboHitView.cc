@@ -0,0 +1,46 @@
+//
+// Structure-of-arrays copy of a ComboHitCollection
+//
+#include "RecoDataProducts/inc/ComboHitView.hh"
+#include <cstdint>
+namespace mu2e {
+
+  ComboHitView::ComboHitView(ComboHitCollection const& chcol) : _size(chcol.size()) {
+    // columns start on 64 byte boundaries: pad each one to a multiple of 16 floats, and leave
+    // room to align the start of the buffer
+    constexpr size_t line = 64/sizeof(float);
+    size_t stride = ((_size + line - 1)/line)*line;
+    _buffer.resize(stride*ncolumns + line);
+    float* base = _buffer.data();
+    size_t misalign = (reinterpret_cast<std::uintptr_t>(base)/sizeof(float))%line;
+    if(misalign != 0) base += line - misalign;
+    float* col[ncolumns];
+    for(size_t icol=0;icol < ncolumns; ++icol){
+      col[icol] = base + icol*stride;
+      _col[icol] = col[icol];
+    }
+
+    _nsh.reserve(_size);
+    _sid.reserve(_size);
+    _flag.reserve(_size);
+    for(size_t ich=0;ich < _size; ++ich){
+      ComboHit const& ch = chcol[ich];
+      col[x_][ich] = ch.pos().x();
+      col[y_][ich] = ch.pos().y();
+      col[z_][ich] = ch.pos().z();
+      col[time_][ich] = ch.time();
+      col[ctime_][ich] = ch.correctedTime();
+      col[phi_][ich] = ch.phi();
+      col[wdirx_][ich] = ch.wdir().x();
+      col[wdiry_][ich] = ch.wdir().y();
+      col[wdirz_][ich] = ch.wdir().z();
+      col[wres_][ich] = ch.wireRes();
+      col[tres_][ich] = ch.transRes();
+      col[wdist_][ich] = ch.wireDist();
+      col[edep_][ich] = ch.energyDep();
+      _nsh.push_back(ch.nStrawHits());
+      _sid.push_back(ch.strawId());
+      _flag.push_back(ch.flag());
+    }
+  }
+}
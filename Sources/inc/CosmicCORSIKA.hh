@@ -3,6 +3,12 @@
 #ifndef Sources_inc_CosmicCORSIKA_hh
 #define Sources_inc_CosmicCORSIKA_hh
 
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <limits>
+#include <mutex>
+#include <thread>
 #include <vector>
 
 
@@ -61,6 +67,7 @@ struct Config
   fhicl::Atom<float> targetBoxYmax{Name("targetBoxYmax"), Comment("Target box y max")};
   fhicl::Atom<float> targetBoxZmin{Name("targetBoxZmin"), Comment("Target box z min")};
   fhicl::Atom<float> targetBoxZmax{Name("targetBoxZmax"), Comment("Target box z max")};
+  fhicl::Atom<unsigned> readAheadEvents{Name("readAheadEvents"), Comment("Number of events decoded ahead of the source on a helper thread (0, the default: decode in the source thread)"), 0};
 };
 
 typedef fhicl::WrappedTable<Config> Parameters;
@@ -219,15 +226,28 @@ namespace mu2e {
       };
 
       virtual bool generate(GenParticleCollection &, unsigned int &);
-      void openFile(ifstream *f, unsigned &run, float &lowE, float &highE);
+      void openFile(const std::string &fileName, unsigned &run, float &lowE, float &highE);
+      void closeFile();
 
     private:
-      bool genEvent(std::map<std::pair<int,int>, GenParticleCollection> &particles_map);
+      bool decodeEvent(GenParticleCollection &, unsigned int &);
+      // Particles of a CORSIKA record in one tile of the extended target box:
+      // those that cross the target box (all if !projectToTargetBox), and
+      // the earliest time of all
+      struct Tile {
+        float timeOffset = std::numeric_limits<float>::max();
+        GenParticleCollection particles;
+      };
+      bool genEvent(std::map<std::pair<int,int>, Tile> &particles_map);
+      bool read(char *dst, size_t n);
+      void decodeAhead();
       float wrapvarBoxNo(const float var, const float low, const float high, int &boxno);
 
       std::vector<CLHEP::Hep3Vector> _targetBoxIntersections;
       std::vector<CLHEP::Hep3Vector> _worldIntersections;
-      std::map<std::pair<int,int>, GenParticleCollection> _particles_map;
+      std::map<std::pair<int,int>, Tile> _particles_map;
+      // pdgId and mass by CORSIKA particle id, filled as the ids are met
+      std::vector<std::pair<int,float>> _particleCache;
 
       GlobalConstantsHandle<ParticleDataTable> pdt;
 
@@ -250,7 +270,24 @@ namespace mu2e {
       float _targetBoxZmin = 0;
       float _targetBoxZmax = 0;
 
-      std::ifstream *input;
+      // The file is mapped, and read sequentially in records
+      const char *_data = nullptr;
+      size_t _size = 0;
+      size_t _pos = 0;
+
+      // Events decoded ahead by the _decoder thread
+      struct DecodedEvent {
+        GenParticleCollection particles;
+        unsigned int primaries = 0;
+        bool end = false;
+      };
+      unsigned _readAheadEvents = 0;
+      std::thread _decoder;
+      std::mutex _queueMutex;
+      std::condition_variable _queueChanged;
+      std::deque<DecodedEvent> _queue;
+      bool _stopDecoder = false;
+      std::exception_ptr _decoderError;
 
       unsigned _current_event_number = -1;
       unsigned _event_count = 0;
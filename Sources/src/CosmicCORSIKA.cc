@@ -7,6 +7,13 @@
 
 #include "Sources/inc/CosmicCORSIKA.hh"
 
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 using CLHEP::Hep3Vector;
 using CLHEP::HepLorentzVector;
 
@@ -23,21 +30,47 @@ namespace mu2e {
         _targetBoxYmax(conf.targetBoxYmax()),  // mm
         _targetBoxZmin(conf.targetBoxZmin()), // mm
         _targetBoxZmax(conf.targetBoxZmax()),  // mm
+        _readAheadEvents(conf.readAheadEvents()),
         _engine(seed),
         _randFlatX(_engine, -(_targetBoxXmax-_targetBoxXmin+_showerAreaExtension)/2, +(_targetBoxXmax-_targetBoxXmin+_showerAreaExtension)/2),
         _randFlatZ(_engine, -(_targetBoxZmax-_targetBoxZmin+_showerAreaExtension)/2, +(_targetBoxZmax-_targetBoxZmin+_showerAreaExtension)/2)
   {
   }
 
-  void CosmicCORSIKA::openFile(ifstream *f, unsigned &runNumber, float &lowE, float &highE)
+  void CosmicCORSIKA::openFile(const std::string &fileName, unsigned &runNumber, float &lowE, float &highE)
   {
-    input = f;
+    closeFile();
+
+    // The records are read from the mapped file, without a system call per read
+    int fd = ::open(fileName.c_str(), O_RDONLY);
+    if(fd < 0) {
+      throw std::runtime_error("Error: can not open "+fileName);
+    }
+    struct stat st;
+    if(::fstat(fd, &st) != 0) {
+      ::close(fd);
+      throw std::runtime_error("Error: can not stat "+fileName);
+    }
+    _size = st.st_size;
+    if(_size > 0) {
+      void *map = ::mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if(map == MAP_FAILED) {
+        ::close(fd);
+        _size = 0;
+        throw std::runtime_error("Error: can not map "+fileName);
+      }
+      ::madvise(map, _size, MADV_SEQUENTIAL);
+      _data = static_cast<const char*>(map);
+    }
+    ::close(fd);
+    _pos = 0;
+
     _current_event_number = -1;
     _event_count = 0;
     _run_number = -1;
     _infmt = Format::UNDEFINED;
 
-    while( input->read(_buf.ch, 4)) {
+    while(read(_buf.ch, 4)) {
       unsigned reclen = _buf.in[0];
       // CORSIKA records are in units of 4 bytes
       if(reclen % 4) {
@@ -51,8 +84,12 @@ namespace mu2e {
         throw std::runtime_error("Error: reclen too small");
       }
 
+      if(reclen > 4*_fbsize_words) {
+        throw std::runtime_error("Error: reclen too big");
+      }
+
       // Read the full record
-      if(!input->read(_buf.ch, reclen)) {
+      if(!read(_buf.ch, reclen)) {
         break;
       }
 
@@ -88,11 +125,52 @@ namespace mu2e {
       break;
 
     }
-    input->clear();
-    input->seekg(0, ios::beg);
+    _pos = 0;
+
+    if(_readAheadEvents > 0) {
+      _stopDecoder = false;
+      _decoderError = nullptr;
+      _decoder = std::thread(&CosmicCORSIKA::decodeAhead, this);
+    }
+  }
+
+  void CosmicCORSIKA::closeFile()
+  {
+    if(_decoder.joinable()) {
+      {
+        std::lock_guard<std::mutex> lock(_queueMutex);
+        _stopDecoder = true;
+      }
+      _queueChanged.notify_all();
+      _decoder.join();
+    }
+    _queue.clear();
+
+    if(_data) {
+      ::munmap(const_cast<char*>(_data), _size);
+    }
+    _data = nullptr;
+    _size = 0;
+    _pos = 0;
   }
 
   CosmicCORSIKA::~CosmicCORSIKA(){
+    closeFile();
+  }
+
+  // As std::istream::read: false if fewer than n bytes are left
+  bool CosmicCORSIKA::read(char *dst, size_t n)
+  {
+    if(_size - _pos < n) {
+      if(_size > _pos) {
+        std::memcpy(dst, _data + _pos, _size - _pos);
+      }
+      _pos = _size;
+      return false;
+    }
+    std::memcpy(dst, _data + _pos, n);
+    _pos += n;
+    return true;
   }
 
 
@@ -103,14 +181,14 @@ namespace mu2e {
     return (var - (high - low) * floor(var / (high - low))) + low;
   }
 
-  bool CosmicCORSIKA::genEvent(std::map<std::pair<int,int>, GenParticleCollection> &particles_map) {
+  bool CosmicCORSIKA::genEvent(std::map<std::pair<int,int>, Tile> &particles_map) {
 
       const float xOffset = _randFlatX.fire();
       const float zOffset = _randFlatZ.fire();
 
       // FORTRAN sequential records are prefixed with their length
       // in a 4-byte word
-      while( input->read(_buf.ch, 4)) {
+      while(read(_buf.ch, 4)) {
 
         unsigned reclen = _buf.in[0];
         // CORSIKA records are in units of 4 bytes
@@ -130,7 +208,7 @@ namespace mu2e {
         }
 
         // Read the full record
-        if(!input->read(_buf.ch, reclen)) {
+        if(!read(_buf.ch, reclen)) {
           break;
         }
 
@@ -189,7 +267,14 @@ namespace mu2e {
               if (id == 0)
                 continue;
               n_part++;
-              const int pdgId = corsikaToPdgId.at(id);
+              if (id >= _particleCache.size()) {
+                _particleCache.resize(id + 1, std::pair(0, 0.f));
+              }
+              if (_particleCache[id].first == 0) {
+                const int pdgId = corsikaToPdgId.at(id);
+                _particleCache[id] = std::pair(pdgId, float(pdt->particle(pdgId).ref().mass())); // to MeV
+              }
+              const int pdgId = _particleCache[id].first;
               const float P_x = _buf.fl[iword + i_part + 2] * _GeV2MeV;
               const float P_y = -_buf.fl[iword + i_part + 3] * _GeV2MeV;
               const float P_z = _buf.fl[iword + i_part + 1] * _GeV2MeV;
@@ -199,7 +284,7 @@ namespace mu2e {
               const float x = wrapvarBoxNo(_buf.fl[iword + i_part + 5] * _cm2mm + xOffset, _targetBoxXmin - _showerAreaExtension, _targetBoxXmax + _showerAreaExtension, boxnox);
               const float z = wrapvarBoxNo(-_buf.fl[iword + i_part + 4] * _cm2mm + zOffset, _targetBoxZmin - _showerAreaExtension, _targetBoxZmax + _showerAreaExtension, boxnoz);
               std::pair xz(boxnox, boxnoz);
-              const float m = pdt->particle(pdgId).ref().mass(); // to MeV
+              const float m = _particleCache[id].second;
 
               const float energy = safeSqrt(P_x * P_x + P_y * P_y + P_z * P_z + m * m);
 
@@ -207,17 +292,27 @@ namespace mu2e {
               const HepLorentzVector mom4(P_x, P_y, P_z, energy);
 
               const float particleTime = _buf.fl[iword + i_part + 6] * _ns2s;
-              GenParticle part(static_cast<PDGCode::type>(pdgId),
-                    GenId::cosmicCORSIKA, position, mom4,
-                    particleTime);
-
-              if (particles_map.count(xz) == 0) {
-                GenParticleCollection parts;
-                parts.push_back(part);
-                particles_map.insert({xz, parts});
-              } else {
-                particles_map[xz].push_back(part);
+
+              // The earliest time in the tile counts all particles, but only
+              // those that cross the target box are kept
+              Tile& tile = particles_map[xz];
+              if (particleTime < tile.timeOffset)
+                tile.timeOffset = particleTime;
+
+              if (_projectToTargetBox) {
+                _targetBoxIntersections.clear();
+                VectorVolume particleTarget(position, mom4.vect(),
+                                            _targetBoxXmin, _targetBoxXmax,
+                                            _targetBoxYmin, _targetBoxYmax,
+                                            _targetBoxZmin, _targetBoxZmax);
+                particleTarget.calIntersections(_targetBoxIntersections);
+                if (_targetBoxIntersections.empty())
+                  continue;
               }
+
+              tile.particles.emplace_back(static_cast<PDGCode::type>(pdgId),
+                                          GenId::cosmicCORSIKA, position, mom4,
+                                          particleTime);
             }
 
           }
@@ -229,7 +324,7 @@ namespace mu2e {
 
         // Here we expect the FORTRAN end of record padding,
         // read and verify its value.
-        if(!input->read(_buf.ch, 4)) {
+        if(!read(_buf.ch, 4)) {
           break;
         }
         if(_buf.in[0] != reclen) {
@@ -245,44 +340,83 @@ namespace mu2e {
   }
 
   bool CosmicCORSIKA::generate( GenParticleCollection& genParts, unsigned int &primaries)
+  {
+    if (!_decoder.joinable()) {
+      return decodeEvent(genParts, primaries);
+    }
+
+    std::unique_lock<std::mutex> lock(_queueMutex);
+    _queueChanged.wait(lock, [this]{ return !_queue.empty(); });
+    if (_queue.front().end) {
+      // the end stays in the queue, for any further call
+      if (_decoderError) {
+        std::rethrow_exception(_decoderError);
+      }
+      return false;
+    }
+    DecodedEvent event = std::move(_queue.front());
+    _queue.pop_front();
+    lock.unlock();
+    _queueChanged.notify_all();
+
+    genParts.insert(genParts.end(),
+                    std::make_move_iterator(event.particles.begin()),
+                    std::make_move_iterator(event.particles.end()));
+    primaries = event.primaries;
+    return true;
+  }
+
+  // Runs on the _decoder thread: decodes the events of the file, in order,
+  // keeping at most _readAheadEvents of them in the queue
+  void CosmicCORSIKA::decodeAhead()
+  {
+    while (true) {
+      DecodedEvent event;
+      std::exception_ptr error;
+      try {
+        event.end = !decodeEvent(event.particles, event.primaries);
+      }
+      catch (...) {
+        error = std::current_exception();
+        event.end = true;
+      }
+      const bool end = event.end;
+
+      std::unique_lock<std::mutex> lock(_queueMutex);
+      _queueChanged.wait(lock, [this]{ return _stopDecoder || _queue.size() < _readAheadEvents; });
+      if (_stopDecoder) {
+        return;
+      }
+      _decoderError = error;
+      _queue.push_back(std::move(event));
+      lock.unlock();
+      _queueChanged.notify_all();
+      if (end) {
+        return;
+      }
+    }
+  }
+
+  // Decodes the next event: the particles of the next CORSIKA record that fall
+  // in the same tile of the extended target box, and that cross the target box
+  // if projectToTargetBox is set
+  bool CosmicCORSIKA::decodeEvent( GenParticleCollection& genParts, unsigned int &primaries)
   {
     // loop over particles in the truth object
     bool passed = false;
     while (!passed) {
       if (_particles_map.size() == 0)
       {
-        if (!genEvent(_particles_map)) {
+        if (!genEvent(_particles_map) || _particles_map.empty()) {
           return false;
         }
       }
 
-      GenParticleCollection particles = _particles_map.begin()->second;
-      GenParticleCollection crossingParticles;
-
-      float timeOffset = std::numeric_limits<float>::max();
+      const Tile& tile = _particles_map.begin()->second;
       primaries = _primaries;
 
-      for (unsigned int i = 0; i < particles.size(); i++) {
-        GenParticle particle = particles[i];
-
-        _targetBoxIntersections.clear();
-        VectorVolume particleTarget(particle.position(), particle.momentum().vect(),
-                                    _targetBoxXmin, _targetBoxXmax,
-                                    _targetBoxYmin, _targetBoxYmax,
-                                    _targetBoxZmin, _targetBoxZmax);
-
-        particleTarget.calIntersections(_targetBoxIntersections);
-
-        if (_targetBoxIntersections.size() > 0 || !_projectToTargetBox)
-          crossingParticles.push_back(particle);
-
-        if (particle.time() < timeOffset)
-          timeOffset = particle.time();
-      }
-
-      for (unsigned int i = 0; i < crossingParticles.size(); i++) {
-          GenParticle part = crossingParticles[i];
-          genParts.push_back(GenParticle(part.pdgId(), part.generatorId(), part.position(), part.momentum(), part.time()+_tOffset-timeOffset));
+      for (const GenParticle& part : tile.particles) {
+          genParts.push_back(GenParticle(part.pdgId(), part.generatorId(), part.position(), part.momentum(), part.time()+_tOffset-tile.timeOffset));
       }
       _particles_map.erase(_particles_map.begin()->first);
 
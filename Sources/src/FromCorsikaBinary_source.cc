@@ -54,8 +54,6 @@ namespace mu2e {
       std::set<art::SubRunID> seenSRIDs_;
 
       std::string currentFileName_;
-      std::ifstream *currentFile_ = nullptr;
-      float garbage;
 
       unsigned currentSubRunNumber_; // from file
       // A helper function used to manage the principals.
@@ -126,11 +124,9 @@ namespace mu2e {
       currentFileName_ = filename;
       currentEventNumber_ = 0;
 
-      currentFile_ = new ifstream(currentFileName_);
-
       unsigned subrun = 0;
       float lowE, highE;
-      _corsikaGen.openFile(currentFile_, subrun, lowE, highE);
+      _corsikaGen.openFile(currentFileName_, subrun, lowE, highE);
       currentSubRunNumber_ = subrun;
       _lowE = lowE;
       _highE = highE;
@@ -140,7 +136,7 @@ namespace mu2e {
     //----------------------------------------------------------------
     void CorsikaBinaryDetail::closeCurrentFile() {
       currentFileName_ = "";
-      currentFile_->close();
+      _corsikaGen.closeFile();
     }
 
     //----------------------------------------------------------------
@@ -268,15 +268,14 @@ namespace mu2e {
         const auto& hit0 = cluster.caloCrystalHitsPtrVector().at(0);
         CLHEP::Hep3Vector center = cal.geomUtil().mu2eToDiskFF(cal.crystal(hit0->id()).diskId(), cal.crystal(hit0->id()).position());
         
-        std::vector<int> neighbors1 = cal.neighbors(hit0->id(),true);
-        std::vector<int> neighbors2 = cal.nextNeighbors(hit0->id(),true);
-        neighbors1.insert(neighbors1.end(), neighbors2.begin(), neighbors2.end());
+        //first and second rings of the raw map, -1 for positions without crystal
+        auto neighbors1 = cal.neighborTable(true).neighborsUpTo(hit0->id(),2);
             
         double eCells(0);
         std::vector<double> evec;
         evec.push_back(hit0->energyDep());
 
-        for (auto& in : neighbors1)
+        for (int in : neighbors1)
         {
             if (in == -1){evec.push_back(-1);continue;}
 
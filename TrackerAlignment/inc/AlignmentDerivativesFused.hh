@@ -0,0 +1,14 @@
+
+# ifndef FUSEDDOCADERIV_H
+# define FUSEDDOCADERIV_H
+
+// aligned wire position and direction (result[0-5]), then their derivatives with respect to
+// the plane and panel alignment parameters (result[6 + 12*i + j], wire component i, parameter j)
+void CosmicTrack_AlignedWire(double const& plane_dx, double const& plane_dy, double const& plane_dz, double const& plane_a, double const& plane_b, double const& plane_g, double const& panel_dx, double const& panel_dy, double const& panel_dz, double const& panel_a, double const& panel_b, double const& panel_g, double const& wire_x, double const& wire_y, double const& wire_z, double const& wdir_x, double const& wdir_y, double const& wdir_z, double const& plane_x, double const& plane_y, double const& plane_z, double const& panel_straw0x, double const& panel_straw0y, double const& panel_straw0z, double* result);
+
+// DCA signed by the hit ambiguity (result[0]), its derivatives with respect to a0, b0, a1, b1
+// (result[1-4]) and to the aligned wire position and direction (result[5-10])
+void CosmicTrack_DCA_Fused(double const& a0, double const& b0, double const& a1, double const& b1, double const& awire_x, double const& awire_y, double const& awire_z, double const& awdir_x, double const& awdir_y, double const& awdir_z, double* result);
+
+# endif
+
@@ -25,6 +25,7 @@
 #include "RecoDataProducts/inc/CosmicTrackSeed.hh"
 
 #include "TrackerAlignment/inc/AlignmentDerivatives.hh"
+#include "TrackerAlignment/inc/AlignmentDerivativesFused.hh"
 #include "TrackerAlignment/inc/MilleDataWriter.hh"
 #include <cstdint>
 #include <iterator>
@@ -98,6 +99,44 @@ std::pair<std::vector<double>, std::vector<double>>
     Tracker const& nominalTracker,
     double const& driftvel);
 
+/* Analytical derivatives from the fused kernels (AlignmentDerivativesFused), with the same
+ * values as analyticalDerivatives.  The aligned wire of each straw and its derivatives with
+ * respect to the plane and panel parameters do not depend on the track: they are computed at
+ * the first hit on the straw and kept until the alignment constants change.
+ */
+class FusedDerivatives {
+public:
+  static constexpr size_t nLocal = 5;
+  static constexpr size_t nGlobal = 12;
+
+  FusedDerivatives();
+
+  // call for each event with the cids of the alignment tables: a new IoV drops the cache
+  void setAlignment(int planeCid, int panelCid);
+
+  // derivatives of one hit: local[nLocal], global[nGlobal]
+  void derivatives(CosmicTimeTrack const& track,
+    StrawId const& strawId,
+    TrkAlignPlane const& planes,
+    TrkAlignPanel const& panels,
+    Tracker const& nominalTracker,
+    double driftvel,
+    double* local, double* global);
+
+private:
+  // aligned wire position and direction, then their derivatives (CosmicTrack_AlignedWire)
+  static constexpr size_t _nwire = 6 + 6 * nGlobal;
+
+  int _planeCid, _panelCid;
+  std::vector<double> _wires;  // _nwire per unique straw
+  std::vector<bool> _cached;
+
+  double const* alignedWire(StrawId const& strawId,
+    TrkAlignPlane const& planes,
+    TrkAlignPanel const& panels,
+    Tracker const& nominalTracker);
+};
+
 TMatrixD residualCovariance(CosmicTimeTrack const& track, 
   std::vector<double> const& track_cov,
   std::vector<std::vector<double>> const& local_derivatives,
@@ -7,10 +7,21 @@
 // http://github.com/ryuwd
 
 // Writes 'mille data' with support for doubles and gzip compression.
+// In asynchronous mode the records are collected in large blocks which a background thread
+// compresses and writes, so flushTrack only copies the track.  MilleShardedWriter spreads the
+// tracks over several such files (shards) and lists them in a manifest.
 
+#include <chrono>
+#include <condition_variable>
+#include <ctime>
+#include <deque>
 #include <fstream>
 #include <iostream>
+#include <memory>
+#include <mutex>
 #include <numeric>
+#include <string>
+#include <thread>
 #include <vector>
 
 #include <boost/iostreams/filter/gzip.hpp>
@@ -29,9 +40,33 @@ template <typename WORDTYPE> class MilleDataWriter {
   std::vector<WORDTYPE> track_buf;
   std::vector<int> label_buf;
 
+  // asynchronous mode: full blocks wait in the queue for the writer thread, which returns
+  // them to spare_blocks once written
+  bool async;
+  size_t block_size;
+  std::vector<char> block;
+  std::deque<std::vector<char>> queue;
+  std::vector<std::vector<char>> spare_blocks;
+  std::mutex queue_mutex;
+  std::condition_variable queue_cv;
+  std::thread writer;
+  bool closing;
+  bool closed;
+
+  // statistics
+  size_t n_records;
+  size_t n_bytes;
+  double flush_time;  // wall time spent in flushTrack [s]
+  double writer_cpu;  // CPU time of the writer thread (compression and I/O) [s]
+
+  static constexpr size_t max_queued_blocks = 2;
+
 public:
-  MilleDataWriter(const std::string& file, bool gzip = true, int buf_size = 1000) :
-      filename(file), file_stream(file, std::ios_base::out | std::ios_base::binary) {
+  MilleDataWriter(const std::string& file, bool gzip = true, int buf_size = 1000,
+                  bool async_write = false, size_t async_block_size = 1 << 23) :
+      filename(file), file_stream(file, std::ios_base::out | std::ios_base::binary),
+      async(async_write), block_size(async_block_size), closing(false), closed(false),
+      n_records(0), n_bytes(0), flush_time(0), writer_cpu(0) {
     if (gzip) {
       gz_fstream.push(gzip_compressor());
     }
@@ -39,8 +74,18 @@ public:
 
     track_buf.reserve(buf_size);
     label_buf.reserve(buf_size);
+
+    if (async) {
+      block.reserve(block_size);
+      writer = std::thread(&MilleDataWriter::writeBlocks, this);
+    }
   }
 
+  MilleDataWriter(MilleDataWriter const&) = delete;
+  MilleDataWriter& operator=(MilleDataWriter const&) = delete;
+
+  ~MilleDataWriter() { close(); }
+
   void pushHit(std::vector<WORDTYPE> const& local_derivatives,
                std::vector<WORDTYPE> const& global_derivatives,
                std::vector<int> const& global_labels, WORDTYPE const& measurement,
@@ -73,13 +118,56 @@ public:
   }
 
   void flushTrack() {
+    auto start = std::chrono::steady_clock::now();
     int words = n_words();
-    gz_fstream.write(reinterpret_cast<char*>(&words), sizeof(int));
-    gz_fstream.write(reinterpret_cast<char*>(track_buf.data()), track_buf.size() * sizeof(WORDTYPE));
-    gz_fstream.write(reinterpret_cast<char*>(label_buf.data()), label_buf.size() * sizeof(int));
+    size_t track_bytes = track_buf.size() * sizeof(WORDTYPE);
+    size_t label_bytes = label_buf.size() * sizeof(int);
+    if (async) {
+      append(reinterpret_cast<char*>(&words), sizeof(int));
+      append(reinterpret_cast<char*>(track_buf.data()), track_bytes);
+      append(reinterpret_cast<char*>(label_buf.data()), label_bytes);
+      if (block.size() >= block_size) {
+        submitBlock();
+      }
+    } else {
+      gz_fstream.write(reinterpret_cast<char*>(&words), sizeof(int));
+      gz_fstream.write(reinterpret_cast<char*>(track_buf.data()), track_bytes);
+      gz_fstream.write(reinterpret_cast<char*>(label_buf.data()), label_bytes);
+    }
+    ++n_records;
+    n_bytes += sizeof(int) + track_bytes + label_bytes;
     clear();
+    flush_time += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
   }
 
+  // write out what is buffered and close the file; the writer can't be used afterwards
+  void close() {
+    if (closed) {
+      return;
+    }
+    closed = true;
+    if (async) {
+      if (!block.empty()) {
+        submitBlock();
+      }
+      {
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        closing = true;
+      }
+      queue_cv.notify_all();
+      writer.join();
+    } else {
+      gz_fstream.reset();
+    }
+    file_stream.close();
+  }
+
+  std::string const& fileName() const { return filename; }
+  size_t records() const { return n_records; }
+  size_t bytes() const { return n_bytes; }
+  double flushTime() const { return flush_time; }
+  double writerCPUTime() const { return writer_cpu; }
+
   void clear() {
     label_buf.clear();
     track_buf.clear();
@@ -101,6 +189,58 @@ private:
     track_buf.emplace_back(data);
   }
 
+  void append(char const* data, size_t size) { block.insert(block.end(), data, data + size); }
+
+  // hand the current block to the writer thread, waiting if it is too far behind
+  void submitBlock() {
+    std::unique_lock<std::mutex> lock(queue_mutex);
+    queue_cv.wait(lock, [this] { return queue.size() < max_queued_blocks; });
+    queue.emplace_back(std::move(block));
+    if (spare_blocks.empty()) {
+      block = std::vector<char>();
+      block.reserve(block_size);
+    } else {
+      block = std::move(spare_blocks.back());
+      spare_blocks.pop_back();
+    }
+    lock.unlock();
+    queue_cv.notify_all();
+  }
+
+  static double threadCPUTime() {
+    timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec + 1e-9 * ts.tv_nsec;
+  }
+
+  // writer thread: compress and write the queued blocks in order until closed
+  void writeBlocks() {
+    double cpu_start = threadCPUTime();
+    std::unique_lock<std::mutex> lock(queue_mutex);
+    while (true) {
+      queue_cv.wait(lock, [this] { return closing || !queue.empty(); });
+      if (queue.empty()) {
+        break;
+      }
+      std::vector<char> next(std::move(queue.front()));
+      queue.pop_front();
+      lock.unlock();
+      queue_cv.notify_all();
+
+      gz_fstream.write(next.data(), next.size());
+      if (!gz_fstream) {
+        std::cerr << "MilleDataWriter: write to " << filename << " failed" << std::endl;
+      }
+      next.clear();
+
+      lock.lock();
+      spare_blocks.emplace_back(std::move(next));
+    }
+    lock.unlock();
+    gz_fstream.reset();
+    writer_cpu = threadCPUTime() - cpu_start;
+  }
+
   int n_words() {
     int result = label_buf.size() + track_buf.size();
 
@@ -114,4 +254,84 @@ private:
   }
 };
 
+// Tracks spread over nshards MilleDataWriter files, to compress on several threads.  The shards
+// are filled from one thread (AlignTrackCollector is a legacy module): this only adds background
+// compression threads, when the shards write asynchronously, not per-schedule output.  With one shard the file
+// name is unchanged, otherwise shard i of "name.bin.gz" is "name.shard<i>.bin.gz".  The manifest
+// lists the shards with their record counts; mergesteer.py accepts it in place of a steering file.
+template <typename WORDTYPE> class MilleShardedWriter {
+  std::vector<std::unique_ptr<MilleDataWriter<WORDTYPE>>> shards;
+
+public:
+  MilleShardedWriter(const std::string& file, size_t nshards = 1, bool gzip = true,
+                     bool async_write = false, size_t async_block_size = 1 << 23) {
+    for (size_t i = 0; i < nshards; ++i) {
+      shards.emplace_back(std::make_unique<MilleDataWriter<WORDTYPE>>(
+          shardName(file, i, nshards), gzip, 1000, async_write, async_block_size));
+    }
+  }
+
+  static std::string shardName(std::string const& file, size_t ishard, size_t nshards) {
+    if (nshards <= 1) {
+      return file;
+    }
+    std::string tag = ".shard" + std::to_string(ishard);
+    size_t pos = file.rfind(".bin");
+    if (pos == std::string::npos) {
+      return file + tag;
+    }
+    return file.substr(0, pos) + tag + file.substr(pos);
+  }
+
+  size_t size() const { return shards.size(); }
+  MilleDataWriter<WORDTYPE>& shard(size_t ishard) { return *shards[ishard % shards.size()]; }
+
+  std::vector<std::string> fileNames() const {
+    std::vector<std::string> names;
+    for (auto const& shard : shards) {
+      names.emplace_back(shard->fileName());
+    }
+    return names;
+  }
+
+  void close() {
+    for (auto& shard : shards) {
+      shard->close();
+    }
+  }
+
+  void writeManifest(std::string const& manifest) const {
+    std::ofstream output_file(manifest);
+    output_file << "! Mille data shards: file records bytes" << std::endl;
+    for (auto const& shard : shards) {
+      output_file << shard->fileName() << " " << shard->records() << " " << shard->bytes()
+                  << std::endl;
+    }
+  }
+
+  size_t records() const {
+    size_t n = 0;
+    for (auto const& shard : shards) {
+      n += shard->records();
+    }
+    return n;
+  }
+
+  double flushTime() const {
+    double t = 0;
+    for (auto const& shard : shards) {
+      t += shard->flushTime();
+    }
+    return t;
+  }
+
+  double writerCPUTime() const {
+    double t = 0;
+    for (auto const& shard : shards) {
+      t += shard->writerCPUTime();
+    }
+    return t;
+  }
+};
+
 #endif
@@ -6,6 +6,7 @@
 # TODO: unit testing
 
 import os
+import sys
 
 import sympy
 from sympy import Symbol, Matrix, diff, sqrt, atan2, cos, sin
@@ -139,6 +140,48 @@ def generate_expressions(approximate=False, remove_globalparam_dependence=False,
     return expressions, param_dict, aligned_doca, aligned_wpos, aligned_wdir
 
 
+def generate_fused_expressions():
+    # The DCA depends on the alignment parameters only through the aligned wire position and
+    # direction, which do not depend on the track.  The fused kernels split the calculation:
+    # the aligned wire and its derivatives with respect to the global parameters (computed once
+    # per straw and alignment constants), then for each hit the signed DCA and its derivatives
+    # with respect to the track parameters and to the aligned wire, which give the global
+    # derivatives by the chain rule.
+
+    def symbols(names):
+        return [Symbol(name, real=True) for name in names]
+
+    global_params = symbols(['plane_dx', 'plane_dy', 'plane_dz', 'plane_a', 'plane_b', 'plane_g',
+                             'panel_dx', 'panel_dy', 'panel_dz', 'panel_a', 'panel_b', 'panel_g'])
+    wire_params = symbols(['wire_x', 'wire_y', 'wire_z', 'wdir_x', 'wdir_y', 'wdir_z'])
+    plane_position = symbols(['plane_x', 'plane_y', 'plane_z'])
+    panel_position = symbols(['panel_straw0x', 'panel_straw0y', 'panel_straw0z'])
+
+    aligned_wpos, aligned_wdir = nested_transform_alignment(
+        Matrix(wire_params[:3]), Matrix(wire_params[3:]),
+        Matrix(plane_position), Matrix(panel_position),
+        Matrix(global_params[0:3]), global_params[3:6],
+        Matrix(global_params[6:9]), global_params[9:12])
+
+    aligned_wire = list(aligned_wpos) + list(aligned_wdir)
+    wire_exprs = aligned_wire + [diff(w, p) for w in aligned_wire for p in global_params]
+    wire_symbols = global_params + wire_params + plane_position + panel_position
+
+    # per hit: the wire is the aligned one
+    a0, b0, a1, b1 = symbols(['a0', 'b0', 'a1', 'b1'])
+    track_pos = Matrix([a0, 0, b0])
+    track_dir = unit_vector(Matrix([a1, -1, b1]))
+    hit_wire = symbols(['awire_x', 'awire_y', 'awire_z', 'awdir_x', 'awdir_y', 'awdir_z'])
+
+    # DCA signed by the hit ambiguity, as aligned_doca in generate_expressions: -dperp
+    signed_doca = -HitAmbiguity(track_pos, track_dir, Matrix(hit_wire[:3]), Matrix(hit_wire[3:]))
+    hit_params = [a0, b0, a1, b1]
+    hit_exprs = [signed_doca] + [diff(signed_doca, p) for p in hit_params + hit_wire]
+    hit_symbols = hit_params + hit_wire
+
+    return (wire_exprs, wire_symbols), (hit_exprs, hit_symbols)
+
+
 c_template = """
 
 # include "TrackerAlignment/inc/AlignmentDerivatives.hh"
@@ -205,6 +248,70 @@ def fn_from_expr(name, return_type, expr, symbols):
     return function_header_code, function_code
 
 
+def fused_fn_from_exprs(name, exprs, symbols):
+    # one function filling result[] with all the expressions, sharing their common subexpressions
+    tmpsyms = numbered_symbols("R")
+    replacements, reduced = cse(exprs, symbols=tmpsyms)
+
+    args = 'double const& %s, double* result' % (', double const& '.join([p.name for p in symbols]))
+    function_header_code = fn_template % ('void', name, args)
+
+    code = "void %s(%s)\n" % (name, args)
+    code += "{\n"
+    for s in replacements:
+        code += "    double %s = %s;\n" % (ccode(s[0]), ccode(s[1]))
+    for i, expr in enumerate(reduced):
+        code += "    result[%d] = %s;\n" % (i, ccode(expr))
+    code += "}\n"
+
+    return function_header_code, code
+
+
+fused_c_template = """
+
+# include "TrackerAlignment/inc/AlignmentDerivativesFused.hh"
+# include <math.h>
+
+%s
+
+"""
+
+fused_h_template = """
+# ifndef FUSEDDOCADERIV_H
+# define FUSEDDOCADERIV_H
+
+// aligned wire position and direction (result[0-5]), then their derivatives with respect to
+// the plane and panel alignment parameters (result[6 + 12*i + j], wire component i, parameter j)
+%s
+
+// DCA signed by the hit ambiguity (result[0]), its derivatives with respect to a0, b0, a1, b1
+// (result[1-4]) and to the aligned wire position and direction (result[5-10])
+%s
+
+# endif
+
+"""
+
+
+def write_fused(base_path):
+    print ("fused kernels...")
+    (wire_exprs, wire_symbols), (hit_exprs, hit_symbols) = generate_fused_expressions()
+
+    wire_header, wire_code = fused_fn_from_exprs('CosmicTrack_AlignedWire', wire_exprs, wire_symbols)
+    hit_header, hit_code = fused_fn_from_exprs('CosmicTrack_DCA_Fused', hit_exprs, hit_symbols)
+
+    source_filename = os.path.join(base_path, 'src/AlignmentDerivativesFused.cc')
+    header_filename = os.path.join(base_path, 'inc/AlignmentDerivativesFused.hh')
+
+    with open(source_filename, 'w') as f:
+        print ("writing %s.." % source_filename)
+        f.write(fused_c_template % ('\n\n'.join([wire_code, hit_code])))
+
+    with open(header_filename, 'w') as f:
+        print ("writing %s.." % header_filename)
+        f.write(fused_h_template % (wire_header, hit_header))
+
+
 def main():
     function_prefix = "GaussianDriftFit_ResidDeriv_"
 
@@ -220,6 +327,10 @@ def main():
 
     base_path = os.path.join(base_path, package_name)
 
+    write_fused(base_path)
+    if '--fused-only' in sys.argv[1:]:
+        return
+
     print ("algebra...")
     exprs, params, aligned_doca, _, _ = generate_expressions()
 
@@ -1,20 +1,43 @@
 import sys
 # merge steering files into one where
-# all input files (.bin) are included
+# all input files (.bin) are included.
+# Mille data manifests (.manifest, written by AlignTrackCollector
+# with MilleShards > 1) may be given too: their shards are included
+# with the input files of the steering files.
+
+def read_manifest(filename):
+    shards = []
+    with open(filename, 'r') as f:
+        for line in f.readlines():
+            line = line.strip()
+            if len(line) == 0 or line.startswith('!'):
+                continue
+            shards.append(line.split()[0])
+    return shards
 
 def main():
-    files=sys.argv[1:]
+    files=[f for f in sys.argv[1:] if not f.endswith('.manifest')]
+    shards=[]
+    for filename in sys.argv[1:]:
+        if filename.endswith('.manifest'):
+            shards += read_manifest(filename)
     file_lines=[]
+    inputs=set()
 
     nlines = -1
 
+    if len(files) == 0:
+        sys.exit('mergesteer.py: no steering files given, the shards of a manifest '
+                 'are added to the input files of the steering files')
+
     for filename in files:
         with open(filename, 'r') as f:
             lines = f.readlines()
             if nlines == -1:
                 nlines = len(lines)
-            if nlines != len(lines) or nlines < 0:
-                exit(1)
+            if nlines != len(lines):
+                sys.exit('mergesteer.py: %s has %d lines, but %s has %d'
+                         % (filename, len(lines), files[0], nlines))
             file_lines.append(lines)
 
     for lineno in range(nlines):
@@ -22,14 +45,17 @@ def main():
         if len(lines) == 0:
             continue
         if '.bin' in lines[0]: # include all mille file inputs
-            for line in lines:
-                print (line.strip())
+            for line in lines + shards:
+                if line.strip() not in inputs:
+                    inputs.add(line.strip())
+                    print (line.strip())
         else:
             pline = 0
             for line in lines:
                 # assert all other config lines equal
                 if pline != 0 and line != pline and '.txt' not in line:
-                    exit(1)
+                    sys.exit('mergesteer.py: line %d differs between the steering files: %s'
+                             % (lineno + 1, line.strip()))
                 pline = line
             print(lines[0].strip())
 
@@ -8,6 +8,7 @@
 // Consult README.md for more information
 
 #include <algorithm>
+#include <chrono>
 #include <cmath>
 #include <cstddef>
 #include <exception>
@@ -21,6 +22,7 @@
 #include <utility>
 #include <vector>
 
+#include "CosmicReco/inc/GaussNewtonDriftFitter.hh"
 #include "CosmicReco/inc/MinuitDriftFitter.hh"
 #include "CosmicReco/inc/PDFFit.hh"
 #include "DbTables/inc/TrkAlignPanel.hh"
@@ -185,6 +187,23 @@ public:
                                     Comment("Enable gzip compression for millepede output file"),
                                     false};
 
+    fhicl::Atom<int> milleshards{
+        Name("MilleShards"),
+        Comment("Number of files the tracks are spread over (shard<i> is added to MilleFile). "
+                "With more than one a manifest MilleFile.manifest lists them. "
+                "This only adds background compression threads (one per shard, with AsyncMilleOutput): "
+                "the module is a legacy module and fills all the shards from one thread, "
+                "there is no per-schedule output."), 1};
+
+    fhicl::Atom<bool> milleasync{
+        Name("AsyncMilleOutput"),
+        Comment("Compress and write the Millepede data in a background thread for each file"),
+        false};
+
+    fhicl::Atom<unsigned> milleblocksize{
+        Name("MilleBlockSize"),
+        Comment("Size in bytes of the blocks handed to the background writer"), 1 << 23};
+
     fhicl::Atom<std::string> steerfile{
         Name("SteerFile"), Comment("Output filename for Millepede steering file"), "mp-steer.txt"};
 
@@ -199,6 +218,11 @@ public:
         Name("UseNumericalDiffn"),
         Comment("Whether or not to use numerical derivatives. Default is false."), false};
 
+    fhicl::Atom<bool> usefused{
+        Name("UseFusedDerivatives"),
+        Comment("Whether to use the fused analytical derivatives (AlignmentDerivativesFused) "
+                "instead of one generated function per derivative. Default is false."), false};
+
     fhicl::Sequence<std::string> mpsteers{
         Name("SteeringOpts"),
         Comment("Additional configuration options to add to generated steering file."),
@@ -213,6 +237,10 @@ public:
         Name("EnableLOOCVFitting"),
         Comment("Whether to enable LOOCV track fitting to obtain 'unbiased' residuals. Default is true."), true};
 
+    fhicl::Atom<std::string> cvfitter{
+        Name("LOOCVFitter"),
+        Comment("Drift fit used for the LOOCV refits. Either 'Minuit' or 'GaussNewton'"), "Minuit"};
+
   };
 
   typedef art::EDAnalyzer::Table<Config> Parameters;
@@ -233,18 +261,24 @@ public:
   bool use_db;
 
   bool gzip_compress;
+  int mille_shards;
+  bool async_mille;
   std::string mille_filename;
   std::string steer_filename;
   std::string param_filename;
   std::string constr_filename;
 
   bool use_numeric_derivs;
+  bool use_fused_derivs;
+  AlignmentUtilities::FusedDerivatives fused_derivs;
   bool wroteMillepedeParams;
-  MilleDataWriter<double> mille_file;
+  MilleShardedWriter<double> mille_files;
+  std::chrono::steady_clock::time_point job_start;
   std::vector<std::string> steer_lines;
 
   double error_scale;
   bool use_unbiased_res;
+  bool use_gaussnewton_cv;
 
 
   std::string constrain_strat;
@@ -297,21 +331,34 @@ public:
       no_plane_rotations(conf().noplanerotations()), 
 
       gzip_compress(conf().millefilegzip()), 
+      mille_shards(conf().milleshards()),
+      async_mille(conf().milleasync()),
       mille_filename(conf().millefile()),
       steer_filename(conf().steerfile()), 
       param_filename(conf().paramfile()),
       constr_filename(conf().constrfile()),
 
       use_numeric_derivs(conf().usenumerical()),
+      use_fused_derivs(conf().usefused()),
 
       wroteMillepedeParams(false), 
-      mille_file(mille_filename, gzip_compress),
+      mille_files(mille_filename, mille_shards, gzip_compress,
+        async_mille, conf().milleblocksize()),
       steer_lines(conf().mpsteers()),
       error_scale(conf().errorscale()),
       use_unbiased_res(conf().enableCV()),
+      use_gaussnewton_cv(conf().cvfitter() == "GaussNewton"),
       constrain_strat(conf().constrainstrategy()),
       fixed_planes(conf().fixplane()) {
 
+    if (mille_shards < 1) {
+      throw cet::exception("RECO") << "MilleShards must be at least 1, not " << mille_shards;
+    }
+
+    if (!use_gaussnewton_cv && conf().cvfitter() != "Minuit") {
+      throw cet::exception("RECO") << "Unknown LOOCVFitter " << conf().cvfitter();
+    }
+
     if (no_panel_dofs) {
       _dof_per_panel = 0;
     }
@@ -337,6 +384,7 @@ public:
 };
 
 void AlignTrackCollector::beginJob() {
+  job_start = std::chrono::steady_clock::now();
   _trkAlignPlane_h = std::make_unique<DbHandle<TrkAlignPlane>>();
   _trkAlignPanel_h = std::make_unique<DbHandle<TrkAlignPanel>>();
 
@@ -383,9 +431,11 @@ void AlignTrackCollector::writeMillepedeSteering() {
   output_file << "! Steering file generated by AlignTrackCollector" << std::endl
               << "Cfiles" << std::endl
               << param_filename << std::endl
-              << constr_filename << std::endl
-              << mille_filename << std::endl
-              << std::endl;
+              << constr_filename << std::endl;
+  for (std::string const& filename : mille_files.fileNames()) {
+    output_file << filename << std::endl;
+  }
+  output_file << std::endl;
 
   for (std::string const& line : steer_lines) {
     output_file << line << std::endl;
@@ -565,12 +615,36 @@ void AlignTrackCollector::beginRun(art::Run const& run) {
 }
 
 void AlignTrackCollector::endJob() {
+  mille_files.close();
+  if (mille_shards > 1) {
+    mille_files.writeManifest(mille_filename + ".manifest");
+  }
 
   if (_diag > 0) {
     std::cout << "AlignTrackCollector: wrote " 
               << tracks_written << " tracks to " 
               << mille_filename
+              << (mille_shards > 1 ? " (" + std::to_string(mille_shards) + " shards)" : "")
               << std::endl;
+
+    // the rate is over the wall time of the job up to the closed files, the time spent in
+    // flushTrack (the part the event loop waits for) is given per record
+    size_t records = mille_files.records();
+    double wall_time =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - job_start).count();
+    std::cout << "AlignTrackCollector: " << records << " records written in " << wall_time
+              << " s wall time";
+    if (wall_time > 0) {
+      std::cout << " (" << records / wall_time << " records/s)";
+    }
+    if (records > 0) {
+      std::cout << ", flushTrack " << 1e6 * mille_files.flushTime() / records << " us/record";
+    }
+    if (async_mille) {
+      std::cout << ", background compression and writing used "
+                << mille_files.writerCPUTime() << " s CPU";
+    }
+    std::cout << std::endl;
   }
 
   writeMillepedeConstraints();
@@ -584,8 +658,9 @@ bool AlignTrackCollector::filter_CosmicTrackSeedCollection(
   // get alignment parameters for this event
   // N.B. alignment parameters MUST be unchanged for the entire job...
   // FIXME! check and enforce above
-  auto alignConsts_planes = _trkAlignPlane_h->get(event.id());
-  auto alignConsts_panels = _trkAlignPanel_h->get(event.id());
+  auto const& alignConsts_planes = _trkAlignPlane_h->get(event.id());
+  auto const& alignConsts_panels = _trkAlignPanel_h->get(event.id());
+  fused_derivs.setAlignment(_trkAlignPlane_h->cid(), _trkAlignPanel_h->cid());
 
   if (!wroteMillepedeParams) {
     writeMillepedeParams(alignConsts_planes, alignConsts_panels);
@@ -671,8 +746,14 @@ bool AlignTrackCollector::filter_CosmicTrackSeedCollection(
         std::vector<double> cov;
         bool converged;
 
-        MinuitDriftFitter::DoDriftTimeFit(
-          pars, errors, cov, converged, fit_object);
+        // the refit starts from the full fit, close to its minimum
+        if (use_gaussnewton_cv) {
+          GaussNewtonDriftFitter::DoDriftTimeFit(
+            pars, errors, cov, converged, fit_object);
+        } else {
+          MinuitDriftFitter::DoDriftTimeFit(
+            pars, errors, cov, converged, fit_object);
+        }
 
         // update track variable
         if (converged) {
@@ -705,6 +786,12 @@ bool AlignTrackCollector::filter_CosmicTrackSeedCollection(
         std::tie(derivativesLocal, derivativesGlobal) = AlignmentUtilities::numericalDerivatives(
           track, straw_id, rowpl, rowpa, nominalTracker, _srep);
       }
+      else if (use_fused_derivs) {
+        derivativesLocal.resize(AlignmentUtilities::FusedDerivatives::nLocal);
+        derivativesGlobal.resize(AlignmentUtilities::FusedDerivatives::nGlobal);
+        fused_derivs.derivatives(track, straw_id, alignConsts_planes, alignConsts_panels,
+          nominalTracker, driftvel, derivativesLocal.data(), derivativesGlobal.data());
+      }
       else {
         std::tie(derivativesLocal, derivativesGlobal) = AlignmentUtilities::analyticalDerivatives(
           track, straw_id, rowpl, rowpa, nominalTracker, driftvel);
@@ -848,7 +935,8 @@ bool AlignTrackCollector::filter_CosmicTrackSeedCollection(
         continue;
       }
 
-      // write hits to buffer
+      // write hits to buffer, the tracks going to the shards in turn
+      MilleDataWriter<double>& mille_file = mille_files.shard(tracks_written);
       for (size_t i = 0; i < (size_t)nHits; ++i) {
         residual_err[i] = drift_reso[i];
         mille_file.pushHit(local_derivs_temp[i], global_derivs_temp[i], labels_temp[i],
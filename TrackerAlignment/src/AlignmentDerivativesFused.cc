@@ -0,0 +1,276 @@
+
+
+# include "TrackerAlignment/inc/AlignmentDerivativesFused.hh"
+# include <math.h>
+
+void CosmicTrack_AlignedWire(double const& plane_dx, double const& plane_dy, double const& plane_dz, double const& plane_a, double const& plane_b, double const& plane_g, double const& panel_dx, double const& panel_dy, double const& panel_dz, double const& panel_a, double const& panel_b, double const& panel_g, double const& wire_x, double const& wire_y, double const& wire_z, double const& wdir_x, double const& wdir_y, double const& wdir_z, double const& plane_x, double const& plane_y, double const& plane_z, double const& panel_straw0x, double const& panel_straw0y, double const& panel_straw0z, double* result)
+{
+    double R0 = panel_dz + panel_straw0z - plane_z;
+    double R1 = sin(plane_a);
+    double R2 = sin(plane_g);
+    double R3 = R1*R2;
+    double R4 = sin(plane_b);
+    double R5 = cos(plane_a);
+    double R6 = cos(plane_g);
+    double R7 = R5*R6;
+    double R8 = R3 + R4*R7;
+    double R9 = cos(plane_b);
+    double R10 = sqrt(pow(panel_straw0x, 2) + pow(panel_straw0y, 2));
+    double R11 = 1.0/R10;
+    double R12 = R11*panel_straw0x;
+    double R13 = R11*panel_straw0y;
+    double R14 = R12*panel_dx - R13*panel_dy + panel_straw0x;
+    double R15 = R14*R9;
+    double R16 = R2*R5;
+    double R17 = R1*R6;
+    double R18 = -R16 + R17*R4;
+    double R19 = R12*panel_dy + R13*panel_dx + panel_straw0y;
+    double R20 = -R10 + sqrt(pow(wire_x, 2) + pow(wire_y, 2));
+    double R21 = sin(panel_b);
+    double R22 = R21*R8;
+    double R23 = cos(panel_g);
+    double R24 = cos(panel_b);
+    double R25 = R12*R24;
+    double R26 = sin(panel_g);
+    double R27 = R13*R24;
+    double R28 = R23*R25 - R26*R27;
+    double R29 = R28*R9;
+    double R30 = R23*R27 + R25*R26;
+    double R31 = -panel_straw0z + wire_z;
+    double R32 = cos(panel_a);
+    double R33 = R24*R8;
+    double R34 = R32*R33;
+    double R35 = sin(panel_a);
+    double R36 = R26*R35;
+    double R37 = R23*R32;
+    double R38 = R21*R37 + R36;
+    double R39 = R12*R38;
+    double R40 = R23*R35;
+    double R41 = -R21*R26*R32 + R40;
+    double R42 = -R41;
+    double R43 = -R13*R42 + R39;
+    double R44 = R43*R9;
+    double R45 = R44*R6;
+    double R46 = R13*R38;
+    double R47 = R12*R42 + R46;
+    double R48 = R18*R47;
+    double R49 = R0*R8 + R15*R6 + R18*R19 + R20*(R18*R30 - R22 + R29*R6) + R31*(R34 + R45 + R48);
+    double R50 = R17 - R2*R4*R5;
+    double R51 = -R50;
+    double R52 = R15*R2;
+    double R53 = R3*R4 + R7;
+    double R54 = R21*R51;
+    double R55 = R2*R29;
+    double R56 = R24*R51;
+    double R57 = R32*R56;
+    double R58 = R2*R44;
+    double R59 = R47*R53;
+    double R60 = R5*R9;
+    double R61 = R14*R4;
+    double R62 = R1*R9;
+    double R63 = R21*R60;
+    double R64 = R28*R4;
+    double R65 = R24*R32;
+    double R66 = R60*R65;
+    double R67 = R4*R43;
+    double R68 = R47*R62;
+    double R69 = R33*R35;
+    double R70 = R26*R32;
+    double R71 = R21*R40 - R70;
+    double R72 = R12*R71;
+    double R73 = R21*R36 + R37;
+    double R74 = -1.0*R13*R73 + 1.0*R72;
+    double R75 = R6*R9;
+    double R76 = R13*R71;
+    double R77 = 1.0*R12*R73 + 1.0*R76;
+    double R78 = R18*R77 + 1.0*R69 + R74*R75;
+    double R79 = R35*R56;
+    double R80 = R2*R9;
+    double R81 = R74*R80;
+    double R82 = R24*R60;
+    double R83 = R35*R82;
+    double R84 = R4*R74;
+    double R85 = -R18;
+    double R86 = R7*R9;
+    double R87 = R17*R9;
+    double R88 = -R53;
+    double R89 = -R71;
+    double R90 = -R73;
+    double R91 = R13*R90;
+    double R92 = R12*R89 - R91;
+    double R93 = R12*R90;
+    double R94 = R13*R89 + R93;
+    double R95 = R25*R37 - R27*R70;
+    double R96 = R25*R70 + R27*R37;
+    double R97 = R21*R23;
+    double R98 = R11*R21*R26*panel_straw0y - R12*R97;
+    double R99 = -R12*R21*R26 - R13*R97;
+    double R100 = -R30;
+    double R101 = R12*R41 - R46;
+    double R102 = R13*R41 + R39;
+    double R103 = R16*R9;
+    double R104 = R3*R9;
+    double R105 = R4*R5;
+    double R106 = R1*R4;
+    double R107 = 1.0*R35;
+    double R108 = R107*R24;
+    double R109 = R25*R40 - R27*R36;
+    double R110 = 1.0*R75;
+    double R111 = R25*R36 + R27*R40;
+    double R112 = 1.0*R18;
+    double R113 = -R76 + R93;
+    double R114 = R72 + R91;
+    double R115 = 1.0*R80;
+    double R116 = 1.0*R53;
+    double R117 = 1.0*R4;
+    result[0] = R49 + plane_dx;
+    result[1] = R0*R51 + R19*R53 + R20*(R30*R53 - R54 + R55) + R31*(R57 + R58 + R59) + R52 + plane_dy;
+    result[2] = R0*R60 + R19*R62 + R20*(R1*R30*R9 - R63 - R64) + R31*(R66 - R67 + R68) - R61 + plane_dz + plane_z;
+    result[3] = R78;
+    result[4] = R53*R77 + 1.0*R79 + R81;
+    result[5] = R62*R77 + 1.0*R83 - R84;
+    result[6] = 1;
+    result[7] = 0;
+    result[8] = 0;
+    result[9] = R0*R85 + R19*R8 + R20*(-R21*R85 + R30*R8) + R31*(R47*R8 + R65*R85);
+    result[10] = R0*R86 + R19*R87 + R20*(R1*R30*R6*R9 - R21*R86 - R6*R64) + R31*(R47*R87 - R6*R67 + R65*R86) - R6*R61;
+    result[11] = R0*R50 + R19*R88 + R20*(-R21*R50 + R30*R88 - R55) + R31*(R47*R88 + R50*R65 - R58) - R52;
+    result[12] = R12*R75 + R13*R18;
+    result[13] = R12*R18 - R13*R75;
+    result[14] = R8;
+    result[15] = R31*(R18*R94 - R69 + R75*R92);
+    result[16] = R20*(R18*R99 - R33 + R75*R98) + R31*(R18*R96 - R22*R32 + R75*R95);
+    result[17] = R20*(R100*R75 + R18*R28) + R31*(R101*R75 + R102*R18);
+    result[18] = 0;
+    result[19] = 1;
+    result[20] = 0;
+    result[21] = R0*R88 + R19*R51 + R20*(-R21*R88 + R30*R51) + R31*(R47*R51 + R65*R88);
+    result[22] = R0*R103 + R104*R19 - R2*R61 + R20*(R1*R2*R30*R9 - R103*R21 - R2*R64) + R31*(R103*R65 + R104*R47 - R2*R67);
+    result[23] = R49;
+    result[24] = R12*R80 + R13*R53;
+    result[25] = R12*R53 - R13*R80;
+    result[26] = R51;
+    result[27] = R31*(R53*R94 - R79 + R80*R92);
+    result[28] = R20*(R53*R99 - R56 + R80*R98) + R31*(-R32*R54 + R53*R96 + R80*R95);
+    result[29] = R20*(R100*R80 + R28*R53) + R31*(R101*R80 + R102*R53);
+    result[30] = 0;
+    result[31] = 0;
+    result[32] = 1;
+    result[33] = -R0*R62 + R19*R60 + R20*(R21*R62 + R30*R60) + R31*(R47*R60 - R62*R65);
+    result[34] = -R0*R105 - R106*R19 - R15 + R20*(-R106*R30 + R21*R4*R5 - R29) + R31*(-R105*R65 - R106*R47 - R44);
+    result[35] = 0;
+    result[36] = R1*R11*R9*panel_straw0y - R12*R4;
+    result[37] = R12*R62 + R13*R4;
+    result[38] = R60;
+    result[39] = R31*(R1*R9*R94 - R4*R92 - R83);
+    result[40] = R20*(R1*R9*R99 - R4*R98 - R82) + R31*(R1*R9*R96 - R32*R63 - R4*R95);
+    result[41] = R20*(R1*R28*R9 - R100*R4) + R31*(-R101*R4 + R102*R62);
+    result[42] = 0;
+    result[43] = 0;
+    result[44] = 0;
+    result[45] = R108*R85 + R77*R8;
+    result[46] = R108*R86 - R6*R84 + R77*R87;
+    result[47] = R108*R50 + R77*R88 - R81;
+    result[48] = 0;
+    result[49] = 0;
+    result[50] = 0;
+    result[51] = 1.0*R34 + 1.0*R45 + 1.0*R48;
+    result[52] = -R107*R22 + R109*R110 + R111*R112;
+    result[53] = R110*R113 + R112*R114;
+    result[54] = 0;
+    result[55] = 0;
+    result[56] = 0;
+    result[57] = R108*R88 + R51*R77;
+    result[58] = R103*R108 + R104*R77 - R2*R84;
+    result[59] = R78;
+    result[60] = 0;
+    result[61] = 0;
+    result[62] = 0;
+    result[63] = 1.0*R57 + 1.0*R58 + 1.0*R59;
+    result[64] = -R107*R54 + R109*R115 + R111*R116;
+    result[65] = R113*R115 + R114*R116;
+    result[66] = 0;
+    result[67] = 0;
+    result[68] = 0;
+    result[69] = -R108*R62 + R60*R77;
+    result[70] = -R105*R108 - R106*R77 - R74*R9;
+    result[71] = 0;
+    result[72] = 0;
+    result[73] = 0;
+    result[74] = 0;
+    result[75] = 1.0*R66 - 1.0*R67 + 1.0*R68;
+    result[76] = 1.0*R1*R111*R9 - R107*R63 - R109*R117;
+    result[77] = 1.0*R1*R114*R9 - R113*R117;
+}
+
+
+void CosmicTrack_DCA_Fused(double const& a0, double const& b0, double const& a1, double const& b1, double const& awire_x, double const& awire_y, double const& awire_z, double const& awdir_x, double const& awdir_y, double const& awdir_z, double* result)
+{
+    double R0 = pow(a1, 2);
+    double R1 = pow(b1, 2);
+    double R2 = R0 + R1 + 1;
+    double R3 = pow(R2, -1.0/2.0);
+    double R4 = R3*awdir_z;
+    double R5 = R3*awdir_x*b1 - R4*a1;
+    double R6 = R3*awdir_x;
+    double R7 = R3*awdir_y;
+    double R8 = R6 + R7*a1;
+    double R9 = -R4 - R7*b1;
+    double R10 = pow(R5, 2) + pow(R8, 2) + pow(R9, 2);
+    double R11 = pow(R10, -1.0/2.0);
+    double R12 = -awire_z + b0;
+    double R13 = R11*R8;
+    double R14 = a0 - awire_x;
+    double R15 = R11*R9;
+    double R16 = pow(R2, -3.0/2.0);
+    double R17 = R16*awdir_z;
+    double R18 = R17*a1;
+    double R19 = R16*awdir_y;
+    double R20 = R19*a1*b1;
+    double R21 = R11*R14;
+    double R22 = R16*awdir_x;
+    double R23 = R22*a1;
+    double R24 = R23*b1;
+    double R25 = -R7;
+    double R26 = R0*R19;
+    double R27 = R11*R12;
+    double R28 = pow(R10, -3.0/2.0);
+    double R29 = 2*R18;
+    double R30 = 2*R20;
+    double R31 = (1.0/2.0)*R9;
+    double R32 = -2*R7;
+    double R33 = (1.0/2.0)*R8;
+    double R34 = (1.0/2.0)*R5;
+    double R35 = -R31*(R29 + R30) - R33*(-2*R23 - 2*R26 - R32) - R34*(2*R0*R16*awdir_z - 2*R24 - 2*R4);
+    double R36 = R28*R35;
+    double R37 = R12*R8;
+    double R38 = R14*R9;
+    double R39 = R22*b1;
+    double R40 = R1*R22;
+    double R41 = R17*b1;
+    double R42 = R1*R19;
+    double R43 = -R31*(R32 + 2*R41 + 2*R42) - R33*(-R30 - 2*R39) - R34*(R29*b1 - 2*R40 + 2*R6);
+    double R44 = R28*R43;
+    double R45 = R27*R3;
+    double R46 = R3*R8;
+    double R47 = R3*R5;
+    double R48 = -R46 - R47*b1;
+    double R49 = R28*R48;
+    double R50 = R3*R9*b1 - R46*a1;
+    double R51 = R28*R50;
+    double R52 = R3*R9 + R47*a1;
+    double R53 = R28*R52;
+    result[0] = R11*R5*awire_y - R12*R13 - R14*R15;
+    result[1] = -R15;
+    result[2] = -R13;
+    result[3] = R11*awire_y*(R0*R16*awdir_z - R24 - R4) - R21*(R18 + R20) - R27*(-R23 - R25 - R26) + R28*R35*R5*awire_y - R36*R37 - R36*R38;
+    result[4] = R11*awire_y*(R18*b1 - R40 + R6) - R21*(R25 + R41 + R42) - R27*(-R20 - R39) + R28*R43*R5*awire_y - R37*R44 - R38*R44;
+    result[5] = R15;
+    result[6] = R11*R5;
+    result[7] = R13;
+    result[8] = R11*R3*awire_y*b1 + R28*R48*R5*awire_y - R37*R49 - R38*R49 - R45;
+    result[9] = R11*R14*R3*b1 + R28*R5*R50*awire_y - R37*R51 - R38*R51 - R45*a1;
+    result[10] = R11*R14*R3 - R11*R3*a1*awire_y + R28*R5*R52*awire_y - R37*R53 - R38*R53;
+}
+
+
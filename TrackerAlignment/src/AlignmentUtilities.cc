@@ -2,6 +2,7 @@
 // roneil@fnal.gov
 // ryunoneil@gmail.com
 
+#include <algorithm>
 #include <cstdint>
 #include <iostream>
 #include <iterator>
@@ -157,6 +158,85 @@ std::pair<std::vector<double>, std::vector<double>>
   return {derivativesLocal, derivativesGlobal};
 }
 
+FusedDerivatives::FusedDerivatives() :
+  _planeCid(-1), _panelCid(-1),
+  _wires(StrawId::_nustraws * _nwire), _cached(StrawId::_nustraws, false) {}
+
+void FusedDerivatives::setAlignment(int planeCid, int panelCid) {
+  if (planeCid != _planeCid || panelCid != _panelCid) {
+    _planeCid = planeCid;
+    _panelCid = panelCid;
+    std::fill(_cached.begin(), _cached.end(), false);
+  }
+}
+
+double const* FusedDerivatives::alignedWire(StrawId const& strawId,
+    TrkAlignPlane const& planes,
+    TrkAlignPanel const& panels,
+    Tracker const& nominalTracker) {
+  double* wire = &_wires[strawId.uniqueStraw() * _nwire];
+  if (_cached[strawId.uniqueStraw()]) {
+    return wire;
+  }
+
+  auto const& rowpl = planes.rowAt(strawId.getPlane());
+  auto const& rowpa = panels.rowAt(strawId.uniquePanel());
+  auto const& plane_origin = nominalTracker.getPlane(strawId.getPlane()).origin();
+  auto const& panel_origin = nominalTracker.getPanel(strawId).straw0MidPoint();
+
+  Straw const& nominalStraw = nominalTracker.getStraw(strawId);
+  auto const& nominalStraw_mp = nominalStraw.getMidPoint();
+  auto const& nominalStraw_dir = nominalStraw.getDirection();
+
+  CosmicTrack_AlignedWire(
+      rowpl.dx(), rowpl.dy(), rowpl.dz(), rowpl.rx(), rowpl.ry(), rowpl.rz(), 
+      rowpa.dx(), rowpa.dy(), rowpa.dz(), rowpa.rx(), rowpa.ry(), rowpa.rz(),
+
+      nominalStraw_mp.x(), nominalStraw_mp.y(), nominalStraw_mp.z(), 
+      nominalStraw_dir.x(),nominalStraw_dir.y(), nominalStraw_dir.z(),
+      plane_origin.x(), plane_origin.y(), plane_origin.z(), 
+      panel_origin.x(), panel_origin.y(), panel_origin.z(), 
+      wire);
+  _cached[strawId.uniqueStraw()] = true;
+  return wire;
+}
+
+void FusedDerivatives::derivatives(CosmicTimeTrack const& track,
+    StrawId const& strawId,
+    TrkAlignPlane const& planes,
+    TrkAlignPanel const& panels,
+    Tracker const& nominalTracker,
+    double driftvel,
+    double* local, double* global) {
+
+  double const* wire = alignedWire(strawId, planes, panels, nominalTracker);
+
+  // signed DCA, derivatives w.r.t. a0, b0, a1, b1 and the aligned wire
+  double dca[11];
+  CosmicTrack_DCA_Fused(
+      track.params[CosmicTimeTrack::a0], 
+      track.params[CosmicTimeTrack::b0], 
+      track.params[CosmicTimeTrack::a1], 
+      track.params[CosmicTimeTrack::b1], 
+      wire[0], wire[1], wire[2], wire[3], wire[4], wire[5], dca);
+
+  // time domain, as the generated CosmicTrack_DCA_LocalDeriv and GlobalDeriv
+  for (size_t i = 0; i < 4; ++i) {
+    local[i] = dca[1 + i] / driftvel;
+  }
+  local[4] = 1.0;
+
+  // chain rule through the aligned wire
+  double const* dwire = wire + 6;
+  for (size_t j = 0; j < nGlobal; ++j) {
+    double sum = 0;
+    for (size_t i = 0; i < 6; ++i) {
+      sum += dca[5 + i] * dwire[i * nGlobal + j];
+    }
+    global[j] = sum / driftvel;
+  }
+}
+
 int hitAmbiguity(CosmicTimeTrack const& track, Hep3Vector const& straw_mp,
                  Hep3Vector const& straw_dir) {
   Hep3Vector sep = track.intercept() - straw_mp;
@@ -38,6 +38,7 @@
 #include "RecoDataProducts/inc/StrawDigi.hh"
 #include "MCDataProducts/inc/StrawGasStep.hh"
 #include "MCDataProducts/inc/StrawDigiMC.hh"
+#include "MCDataProducts/inc/StepTimeIndex.hh"
 // temporary MC structures
 #include "TrackerMC/inc/StrawClusterSequencePair.hh"
 #include "TrackerMC/inc/StrawWaveform.hh"
@@ -113,6 +114,7 @@ namespace mu2e {
 	  fhicl::Atom<string> spinstance { Name("StrawGasStepInstance"), Comment("StrawGasStep Instance name"),""};
 	  fhicl::Atom<string> spmodule { Name("StrawGasStepModule"), Comment("StrawGasStep Module name"),""};
 	  fhicl::Sequence<art::InputTag> SPTO { Name("TimeOffsets"), Comment("Sim Particle Time Offset Maps")};
+	  fhicl::Atom<string> timeIndex { Name("StrawGasStepTimeIndex"), Comment("StepTimeIndexCollection of the StrawGasSteps. If set, only the steps that can fold into the digitization window are processed"),""};
 
 	};
 
@@ -172,6 +174,8 @@ namespace mu2e {
 	ProditionsHandle<StrawPhysics> _strawphys_h;
 	ProditionsHandle<StrawElectronics> _strawele_h;
 	art::Selector _selector;
+	art::InputTag _timeIndexTag;
+	vector<unsigned> _selectedSteps;
 	SimParticleTimeOffset _toff; // time offsets
 	// diagnostics
 	TTree* _swdiag;
@@ -208,6 +212,8 @@ namespace mu2e {
 	array<Float_t, StrawId::_nupanels> _ewMarkerROCdt;
 
 	//  helper functions
+	void selectSteps(StrawElectronics const& strawele, StepTimeIndex const& index,
+	    StrawGasStepCollection const& steps, vector<unsigned>& selected) const;
 	void fillClusterMap(StrawPhysics const& strawphys,
 	    StrawElectronics const& strawele,Tracker const& tracker,
 	    art::Event const& event, StrawClusterMap & hmap);
@@ -294,6 +300,7 @@ namespace mu2e {
       _firstEvent(true),      // Control some information messages.
       // This selector will select only data products with the given instance name.
       _selector{ art::ProductInstanceNameSelector(config().spinstance())},
+      _timeIndexTag(config().timeIndex()),
       _toff(config().SPTO())
       {
         if (config().spmodule() != ""){
@@ -302,6 +309,7 @@ namespace mu2e {
 	// Tell the framework what we consume.
 	consumesMany<StrawGasStepCollection>();
 	consumes<EventWindowMarker>(_ewMarkerTag);
+	if(!_timeIndexTag.label().empty())consumes<StepTimeIndexCollection>(_timeIndexTag);
 	// Tell the framework what we make.
 	produces<StrawDigiCollection>();
 	produces<StrawDigiMCCollection>();
@@ -516,11 +524,18 @@ namespace mu2e {
 	throw cet::exception("SIM")<<"mu2e::StrawDigisFromStrawGasSteps: No StrawGasStep collections found for tracker" << endl;
       }
 
+      // optional time indices of the StrawGasStep collections
+      map<art::ProductID,StepTimeIndex const*> timeIndices;
+      if(!_timeIndexTag.label().empty()){
+	auto const& indices = *event.getValidHandle<StepTimeIndexCollection>(_timeIndexTag);
+	for(auto const& index : indices)
+	  timeIndices[index.steps()] = &index;
+      }
+
       // Loop over StrawGasStep collections
       for ( auto const& sgsch : stepsHandles) {
 	StrawGasStepCollection const& steps(*sgsch);
-	// Loop over the StrawGasSteps in this collection
-	for(size_t isgs = 0; isgs < steps.size(); isgs++){
+	auto addGasStep = [&](size_t isgs) {
 	  auto const& sgs = steps[isgs];
 	  // lookup straw here, to avoid having to find the tracker for every step
 	  StrawId const & sid = sgs.strawId();
@@ -530,10 +545,43 @@ namespace mu2e {
 	    // create a clust from this step, and add it to the clust map
 	    addStep(strawphys,strawele,straw,sgsptr,hmap[sid]);
 	  }
+	};
+	auto iindex = timeIndices.find(sgsch.id());
+	if(iindex == timeIndices.end()){
+	  if(_firstEvent && !timeIndices.empty()){
+	    mf::LogWarning(_messageCategory) << "StrawDigisFromStrawGasSteps: no time index for "
+	      << sgsch.provenance()->branchName() << ", processing all steps\n";
+	  }
+	  // Loop over the StrawGasSteps in this collection
+	  for(size_t isgs = 0; isgs < steps.size(); isgs++)
+	    addGasStep(isgs);
+	} else {
+	  // Loop over the steps that can be in the digitization window, in collection order
+	  selectSteps(strawele,*iindex->second,steps,_selectedSteps);
+	  for(auto isgs : _selectedSteps)
+	    addGasStep(isgs);
 	}
       }
     }
 
+    // Select the steps whose offset time can fold into the window tested in addStep.  Steps
+    // of straws read out at all times are always selected.  The selection is returned in
+    // collection order so that the clusters are formed in the same order as without the index.
+    void StrawDigisFromStrawGasSteps::selectSteps(StrawElectronics const& strawele, StepTimeIndex const& index,
+	StrawGasStepCollection const& steps, vector<unsigned>& selected) const {
+      selected.clear();
+      for(auto const& group : index.groups()){
+	double offset = _toff.totalTimeOffset(group._primary) - _ewMarkerOffset;
+	index.select(group,offset,strawele.flashEnd() - _steptimebuf,strawele.flashStart(),_mbtime,selected);
+      }
+      if(!_allPlanes.empty()){
+	for(size_t isgs = 0; isgs < steps.size(); isgs++)
+	  if(readAll(steps[isgs].strawId()))selected.push_back(isgs);
+      }
+      sort(selected.begin(),selected.end());
+      selected.erase(unique(selected.begin(),selected.end()),selected.end());
+    }
+
     void StrawDigisFromStrawGasSteps::addStep(StrawPhysics const& strawphys,
 	StrawElectronics const& strawele,
 	Straw const& straw,
@@ -0,0 +1,74 @@
+//
+// Columnar file format for the TrackAnalysisReco output, shared by TrkAnaColumnWriter
+// and TrkAnaColumnReader.
+//
+// Every leaf of a leaf list branch is a fixed width column named <branch>.<leaf>; object
+// branches are a column of fixed size records, vector branches a list column (entries
+// per row plus the records).  Rows are written in row groups; inside a group each column
+// is a separate block, byte shuffled (the n-th byte of every value stored together) and
+// compressed with the ROOT compression algorithms, so a reader only decompresses the
+// columns it uses.
+//
+// Layout (native byte order, checked on reading):
+//   header     : magic, byte order mark, format version
+//   row groups : column blocks
+//   footer     : columns (name, kind, leaf type, width, shuffled value size, type name,
+//                compression)
+//                row groups (number of rows, then for each column whether it is present
+//                and its data block, plus the entries block for list columns)
+//   trailer    : footer offset, magic
+// A block is described by its offset, stored size, raw size and flags.  Columns declared
+// after the first row group are absent from the earlier groups and read as zeros.
+//
+#ifndef TrkDiag_TrkAnaColumnFormat_hh
+#define TrkDiag_TrkAnaColumnFormat_hh
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace mu2e {
+
+  namespace TrkAnaColumnFormat {
+
+    extern const char          magic[8];
+    const std::uint32_t        byteOrder = 0x01020304;
+    const std::uint32_t        version   = 1;
+
+    enum ColumnKind  { fixedColumn = 0, listColumn = 1 };
+    enum BlockFlags  { compressed = 1, shuffled = 2 };
+
+    // leaf type used for record (object) columns
+    const char recordType = 'X';
+
+    // one leaf of a leaf list: name, ROOT type code and number of values
+    struct Leaf {
+      std::string name;
+      char        type;
+      unsigned    count;
+    };
+
+    // split a ROOT leaf list; throws for unsupported types
+    std::vector<Leaf> parseLeafList(const std::string& leaves);
+
+    // size of a value of a ROOT leaf type
+    unsigned typeSize(char type);
+
+    // value of a leaf as a double, for scans and printouts
+    double toDouble(char type, const char* address);
+
+    // byte shuffle of n values of size bytes, and its inverse
+    void shuffle(const char* in, size_t n, size_t size, char* out);
+    void unshuffle(const char* in, size_t n, size_t size, char* out);
+
+    // compress with a ROOT compression setting (100*algorithm+level); return false if the
+    // block did not compress and should be stored as is
+    bool compress(const char* in, size_t n, int setting, std::vector<char>& out);
+
+    // decompress a block into n bytes; throws if the block is corrupt
+    void decompress(const char* in, size_t stored, char* out, size_t n);
+
+  }
+}
+
+#endif
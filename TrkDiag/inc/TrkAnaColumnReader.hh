@@ -0,0 +1,80 @@
+//
+// Reader for the TrackAnalysisReco columnar files written by TrkAnaColumnWriter.  Columns
+// are read one row group at a time; only the blocks of the requested column are read and
+// decompressed.
+//
+#ifndef TrkDiag_TrkAnaColumnReader_hh
+#define TrkDiag_TrkAnaColumnReader_hh
+
+#include "TrkDiag/inc/TrkAnaColumnFormat.hh"
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace mu2e {
+
+  class TrkAnaColumnReader {
+
+  public:
+
+    struct Column {
+      std::string name;
+      int         kind;
+      char        type;
+      unsigned    width;
+      unsigned    valueSize;
+      std::string typeName;
+      int         compression;
+    };
+
+    // throws if the file cannot be opened or is not a columnar trkana file
+    explicit TrkAnaColumnReader(const std::string& fileName);
+
+    const std::vector<Column>& columns() const { return _columns; }
+    int      columnIndex(const std::string& name) const; // -1 if the column does not exist
+    size_t   nRowGroups() const { return _groups.size(); }
+    uint64_t nRows(size_t group) const { return _groups.at(group).nRows; }
+    uint64_t nRows() const;
+
+    // read a column of a row group.  data gets nRows*width bytes for fixed columns; for list
+    // columns counts (if given) gets the number of entries of each row and data the entries
+    void readColumn(size_t group, size_t column, std::vector<char>& data, std::vector<uint32_t>* counts = 0);
+
+    // value of a leaf column entry as a double
+    static double value(char type, const char* address) { return TrkAnaColumnFormat::toDouble(type,address); }
+
+  private:
+
+    struct Block {
+      uint64_t offset, stored, raw;
+      uint32_t flags;
+    };
+
+    struct GroupColumn {
+      bool  present;
+      Block data, counts;
+    };
+
+    struct Group {
+      uint64_t                 nRows;
+      std::vector<GroupColumn> columns;
+    };
+
+    void readBlock(const Block& block, unsigned valueSize, std::vector<char>& out);
+    void readFooter();
+
+    template <class T> T get();
+    std::string getString();
+
+    std::string         _fileName;
+    std::ifstream       _in;
+    std::vector<Column> _columns;
+    std::vector<Group>  _groups;
+    std::vector<char>   _buffer, _plain, _unpacked;
+  };
+
+}
+
+#endif
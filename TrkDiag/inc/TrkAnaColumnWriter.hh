@@ -0,0 +1,96 @@
+//
+// TrackAnalysisReco output to a columnar file, see TrkDiag/inc/TrkAnaColumnFormat.hh for
+// the layout.  The rows are buffered column by column and written every rowGroupSize rows
+// and on close().
+//
+// Object and vector branches are stored as fixed size records: a copy of the struct as it
+// is in memory, described by its type name.  They can only be read back by a program built
+// with the same struct definitions.
+//
+#ifndef TrkDiag_TrkAnaColumnWriter_hh
+#define TrkDiag_TrkAnaColumnWriter_hh
+
+#include "TrkDiag/inc/TrkAnaWriter.hh"
+#include "TrkDiag/inc/TrkAnaColumnFormat.hh"
+
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <type_traits>
+
+namespace mu2e {
+
+  class TrkAnaColumnWriter : public TrkAnaWriter {
+
+  public:
+
+    // compression is the ROOT setting 100*algorithm+level, 0 to store the data uncompressed
+    TrkAnaColumnWriter(const std::string& fileName, unsigned rowGroupSize, int compression, bool shuffle);
+    ~TrkAnaColumnWriter();
+
+    void addStruct(const std::string& name, void* address, const std::string& leaves) override;
+    bool hasBranch(const std::string& name) const override { return _branches.count(name) != 0; }
+    void fill() override;
+    void close() override;
+
+  protected:
+
+    void addObjectBranch(const ObjectBranch& branch) override;
+
+  private:
+
+    struct Column {
+      std::string           name;
+      int                   kind;
+      char                  type;
+      unsigned              width;      // bytes per row (fixed) or per entry (list)
+      unsigned              valueSize;  // size of the values shuffled together
+      std::string           typeName;
+      const char*           address;    // leaf columns
+      int                   object;     // index of the object branch, -1 for leaf columns
+      std::vector<char>     data;
+      std::vector<uint32_t> counts;
+    };
+
+    struct Block {
+      uint64_t offset, stored, raw;
+      uint32_t flags;
+    };
+
+    struct GroupColumn {
+      Block data, counts;
+    };
+
+    struct Group {
+      uint64_t                 nRows;
+      std::vector<GroupColumn> columns; // columns declared after this group are absent
+    };
+
+    void  addColumn(Column column);
+    void  writeGroup();
+    Block writeBlock(const char* data, size_t n, unsigned valueSize);
+    void  writeFooter();
+
+    template <class T> void put(const T& t) {
+      static_assert(std::is_trivially_copyable<T>::value, "put writes the bytes of the value");
+      _out.write(reinterpret_cast<const char*>(&t), sizeof(T));
+    }
+    void putString(const std::string& s);
+
+    std::string               _fileName;
+    std::ofstream             _out;
+    unsigned                  _rowGroupSize;
+    int                       _compression;
+    bool                      _shuffle;
+    std::map<std::string,int> _branches;
+    std::vector<ObjectBranch> _objects;
+    std::vector<Column>       _columns;
+    std::vector<Group>        _groups;
+    uint64_t                  _nRows;   // rows in the current group
+    bool                      _closed;
+    std::vector<char>         _shuffled, _compressed;
+  };
+
+}
+
+#endif
@@ -0,0 +1,35 @@
+//
+// TrackAnalysisReco output to a TTree (the trkana tree), one branch per declared struct.
+//
+#ifndef TrkDiag_TrkAnaTreeWriter_hh
+#define TrkDiag_TrkAnaTreeWriter_hh
+
+#include "TrkDiag/inc/TrkAnaWriter.hh"
+
+namespace mu2e {
+
+  class TrkAnaTreeWriter : public TrkAnaWriter {
+
+  public:
+
+    // the tree is owned by the caller (usually the TFileService)
+    explicit TrkAnaTreeWriter(TTree* tree) : _tree(tree) {}
+
+    void addStruct(const std::string& name, void* address, const std::string& leaves) override {
+      _tree->Branch(name.c_str(), address, leaves.c_str());
+    }
+    bool hasBranch(const std::string& name) const override { return _tree->GetBranch(name.c_str()) != 0; }
+    void fill() override { _tree->Fill(); }
+
+  protected:
+
+    void addObjectBranch(const ObjectBranch& branch) override { branch.makeBranch(*_tree, branch.name); }
+
+  private:
+
+    TTree* _tree;
+  };
+
+}
+
+#endif
@@ -0,0 +1,89 @@
+//
+// Interface for the outputs of TrackAnalysisReco.  The module declares its branches once
+// and calls fill() for every row; each writer decides how the rows are stored.
+//
+//  - addStruct: a flat struct described by a ROOT leaf list, as returned by the leafnames()
+//    functions of the info structs ("mom/F:momerr/F:...").  The leaves are packed in the
+//    order of the list, as for a TTree leaf list branch.
+//  - addObject / addVector: a struct or a vector of structs that the TTree output streams
+//    through its dictionary (CRV and hit level information).
+//
+// The addresses must stay valid until the writer is closed.
+//
+#ifndef TrkDiag_TrkAnaWriter_hh
+#define TrkDiag_TrkAnaWriter_hh
+
+#include "TTree.h"
+
+#include <boost/core/demangle.hpp>
+#include <functional>
+#include <string>
+#include <type_traits>
+#include <typeinfo>
+#include <vector>
+
+namespace mu2e {
+
+  // Types that the columnar output stores as a copy of their bytes: the trivially copyable
+  // types, and the structs opted in by a specialization.  Only structs of numbers and of
+  // ROOT GenVector vectors (XYZVec) should be opted in: depending on the ROOT version the
+  // vectors have a user-provided copy constructor that copies the coordinates.
+  template <class T> struct TrkAnaByteCopyable : std::is_trivially_copyable<T> {};
+
+  class TrkAnaWriter {
+
+  public:
+
+    virtual ~TrkAnaWriter() {}
+
+    virtual void addStruct(const std::string& name, void* address, const std::string& leaves) = 0;
+
+    template <class T> void addObject(const std::string& name, T* object) {
+      static_assert(TrkAnaByteCopyable<T>::value, "object branches are stored as a copy of their bytes");
+      ObjectBranch branch;
+      branch.name       = name;
+      branch.typeName   = boost::core::demangle(typeid(T).name());
+      branch.size       = sizeof(T);
+      branch.isVector   = false;
+      branch.data       = [object]() { return static_cast<const void*>(object); };
+      branch.count      = []() { return size_t(1); };
+      branch.makeBranch = [object](TTree& tree, const std::string& bname) { tree.Branch(bname.c_str(), object); };
+      addObjectBranch(branch);
+    }
+
+    template <class T> void addVector(const std::string& name, std::vector<T>* vec) {
+      static_assert(TrkAnaByteCopyable<T>::value, "vector branches are stored as a copy of their bytes");
+      ObjectBranch branch;
+      branch.name       = name;
+      branch.typeName   = boost::core::demangle(typeid(T).name());
+      branch.size       = sizeof(T);
+      branch.isVector   = true;
+      branch.data       = [vec]() { return static_cast<const void*>(vec->data()); };
+      branch.count      = [vec]() { return vec->size(); };
+      branch.makeBranch = [vec](TTree& tree, const std::string& bname) { tree.Branch(bname.c_str(), vec); };
+      addObjectBranch(branch);
+    }
+
+    virtual bool hasBranch(const std::string& name) const = 0;
+    virtual void fill() = 0;
+    virtual void close() {}
+
+  protected:
+
+    // type-erased object or vector branch; makeBranch is only used by the TTree output
+    struct ObjectBranch {
+      std::string name;
+      std::string typeName;
+      size_t      size;
+      bool        isVector;
+      std::function<const void*()>                    data;
+      std::function<size_t()>                         count;
+      std::function<void(TTree&, const std::string&)> makeBranch;
+    };
+
+    virtual void addObjectBranch(const ObjectBranch& branch) = 0;
+  };
+
+}
+
+#endif
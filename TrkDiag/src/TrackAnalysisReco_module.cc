@@ -71,18 +71,25 @@
 #include "TrkDiag/inc/InfoMCStructHelper.hh"
 #include "RecoDataProducts/inc/RecoQual.hh"
 #include "TrkDiag/inc/RecoQualInfo.hh"
+#include "TrkDiag/inc/TrkAnaTreeWriter.hh"
+#include "TrkDiag/inc/TrkAnaColumnWriter.hh"
 // CRV info
 #include "CRVAnalysis/inc/CRVAnalysis.hh"
 #include "MCDataProducts/inc/SimParticleTimeMap.hh"
 
 // C++ includes.
 #include <iostream>
+#include <memory>
 #include <string>
 #include <cmath>
 
 using namespace std;
 
 namespace mu2e {
+  // the hit level structs hold an XYZVec, see TrkAnaByteCopyable
+  template <> struct TrkAnaByteCopyable<TrkStrawHitInfo> : std::true_type {};
+  template <> struct TrkAnaByteCopyable<TrkStrawHitInfoMC> : std::true_type {};
+
 // Need this for the BaBar headers.
   using CLHEP::Hep3Vector;
   typedef KalSeedCollection::const_iterator KSCIter;
@@ -152,6 +159,11 @@ namespace mu2e {
       fhicl::Atom<bool> fillmcxtra{Name("FillExtraMCSteps"),false};
       fhicl::OptionalSequence<art::InputTag> mcxtratags{Name("ExtraMCStepCollectionTags"), Comment("Input tags for any other StepPointMCCollections you want written out")};
       fhicl::OptionalSequence<std::string> mcxtrasuffix{Name("ExtraMCStepBranchSuffix"), Comment("The suffix to the branch for the extra MC steps (e.g. putting \"ipa\" will give a branch \"demcipa\")")};
+      fhicl::Atom<std::string> outputFormat{Name("OutputFormat"), Comment("Output: TTree (trkana tree in the TFileService file), Columnar (columnar file) or Both"), "TTree"};
+      fhicl::Atom<std::string> columnarFileName{Name("ColumnarFileName"), Comment("Name of the columnar output file"), "trkana.tcol"};
+      fhicl::Atom<unsigned> columnarRowGroupSize{Name("ColumnarRowGroupSize"), Comment("Number of rows per row group of the columnar output"), 4096};
+      fhicl::Atom<int> columnarCompression{Name("ColumnarCompression"), Comment("ROOT compression setting (100*algorithm+level) of the columnar output, 0 for none"), 101};
+      fhicl::Atom<bool> columnarShuffle{Name("ColumnarShuffle"), Comment("Byte shuffle the numeric columns before compression"), true};
     };
     typedef art::EDAnalyzer::Table<Config> Parameters;
 
@@ -159,6 +171,7 @@ namespace mu2e {
     virtual ~TrackAnalysisReco() { }
 
     void beginJob();
+    void endJob();
     void beginSubRun(const art::SubRun & subrun ) override;
     void analyze(const art::Event& e);
 
@@ -173,6 +186,8 @@ namespace mu2e {
 
     // main TTree
     TTree* _trkana;
+    // outputs: the TTree and/or the columnar file
+    std::vector<std::unique_ptr<TrkAnaWriter> > _writers;
     TProfile* _tht; // profile plot of track hit times: just an example
     // general event info branch
     double _meanPBI;
@@ -241,6 +256,9 @@ namespace mu2e {
     void fillEventInfo(const art::Event& event);
     void fillTriggerBits(const art::Event& event,std::string const& process);
     void resetBranches();
+    void addBranch(const std::string& name, void* address, const std::string& leaves);
+    template <typename T> void addObjectBranch(const std::string& name, T* object);
+    template <typename T> void addObjectBranch(const std::string& name, std::vector<T>* vec);
     size_t findSupplementTrack(KalSeedCollection const& kcol,KalSeed const& candidate, bool sameColl);
     void fillAllInfos(const art::Handle<KalSeedCollection>& ksch, size_t i_branch, size_t i_kseed);
 
@@ -253,6 +271,7 @@ namespace mu2e {
   TrackAnalysisReco::TrackAnalysisReco(const Parameters& conf):
     art::EDAnalyzer(conf),
     _conf(conf()),
+    _trkana(0),
     _trigbitsh(0),
     _infoMCStructHelper(conf().infoMCStructHelper())
   {
@@ -315,84 +334,98 @@ namespace mu2e {
 
   void TrackAnalysisReco::beginJob( ){
     art::ServiceHandle<art::TFileService> tfs;
-// create TTree
-    _trkana=tfs->make<TTree>("trkana","track analysis");
+// create the outputs
+    std::string format = _conf.outputFormat();
+    if (format != "TTree" && format != "Columnar" && format != "Both")
+      throw cet::exception("CONFIG") << "TrackAnalysisReco: unknown OutputFormat " << format << " (TTree, Columnar or Both)\n";
+    if (format != "Columnar") {
+      _trkana=tfs->make<TTree>("trkana","track analysis");
+      _writers.emplace_back(new TrkAnaTreeWriter(_trkana));
+    }
+    if (format != "TTree") {
+      _writers.emplace_back(new TrkAnaColumnWriter(_conf.columnarFileName(), _conf.columnarRowGroupSize(),
+                                                   _conf.columnarCompression(), _conf.columnarShuffle()));
+    }
     _tht=tfs->make<TProfile>("tht","Track Hit Time Profile",RecoCount::_nshtbins,-25.0,1725.0);
 // add event info branch
-    _trkana->Branch("evtinfo.",&_einfo,EventInfo::leafnames().c_str());
+    addBranch("evtinfo.",&_einfo,EventInfo::leafnames());
 // hit counting branch
-    _trkana->Branch("hcnt.",&_hcnt,HitCount::leafnames().c_str());
+    addBranch("hcnt.",&_hcnt,HitCount::leafnames());
 // track counting branch
     std::vector<std::string> trkcntleaves;
     for (const auto& i_branchConfig : _allBranches) {
       trkcntleaves.push_back(i_branchConfig.branch());
     }
-    _trkana->Branch("tcnt",&_tcnt,_tcnt.leafnames(trkcntleaves).c_str());
+    addBranch("tcnt",&_tcnt,_tcnt.leafnames(trkcntleaves));
 
 // create all candidate and supplement branches
     for (size_t i_branch = 0; i_branch < _allBranches.size(); ++i_branch) {
       BranchConfig i_branchConfig = _allBranches.at(i_branch);
       std::string branch = i_branchConfig.branch();
-      _trkana->Branch(branch.c_str(),&_allTIs.at(i_branch),TrkInfo::leafnames().c_str());
-      _trkana->Branch((branch+"ent").c_str(),&_allEntTIs.at(i_branch),TrkFitInfo::leafnames().c_str());
-      _trkana->Branch((branch+"mid").c_str(),&_allMidTIs.at(i_branch),TrkFitInfo::leafnames().c_str());
-      _trkana->Branch((branch+"xit").c_str(),&_allXitTIs.at(i_branch),TrkFitInfo::leafnames().c_str());
-      _trkana->Branch((branch+"tch").c_str(),&_allTCHIs.at(i_branch),TrkCaloHitInfo::leafnames().c_str());
+      addBranch(branch,&_allTIs.at(i_branch),TrkInfo::leafnames());
+      addBranch(branch+"ent",&_allEntTIs.at(i_branch),TrkFitInfo::leafnames());
+      addBranch(branch+"mid",&_allMidTIs.at(i_branch),TrkFitInfo::leafnames());
+      addBranch(branch+"xit",&_allXitTIs.at(i_branch),TrkFitInfo::leafnames());
+      addBranch(branch+"tch",&_allTCHIs.at(i_branch),TrkCaloHitInfo::leafnames());
       if (_conf.filltrkqual() && i_branchConfig.options().filltrkqual()) {
-	_trkana->Branch((branch+"trkqual").c_str(), &_allTQIs.at(i_branch), TrkQualInfo::leafnames().c_str());
+	addBranch(branch+"trkqual",&_allTQIs.at(i_branch),TrkQualInfo::leafnames());
       }
       if (_conf.filltrkpid() && i_branchConfig.options().filltrkpid()) {
-	_trkana->Branch((branch+"trkpid").c_str(), &_allTPIs.at(i_branch), TrkPIDInfo::leafnames().c_str());
+	addBranch(branch+"trkpid",&_allTPIs.at(i_branch),TrkPIDInfo::leafnames());
       }
       // optionally add hit-level branches
       // (for the time being diagLevel : 2 will still work, but I propose removing this at some point)
       if(_conf.diag() > 1 || (_conf.fillhits() && i_branchConfig.options().fillhits())){ 
-	_trkana->Branch((branch+"tsh").c_str(),&_allTSHIs.at(i_branch));
-	_trkana->Branch((branch+"tsm").c_str(),&_allTSMIs.at(i_branch));
+	addObjectBranch(branch+"tsh",&_allTSHIs.at(i_branch));
+	addObjectBranch(branch+"tsm",&_allTSMIs.at(i_branch));
       }
       // optionall add MC branches
       if(_conf.fillmc() && i_branchConfig.options().fillmc()){
-	_trkana->Branch((branch+"mc").c_str(),&_allMCTIs.at(i_branch),TrkInfoMC::leafnames().c_str());
-	_trkana->Branch((branch+"mcgen").c_str(),&_allMCGenTIs.at(i_branch),GenInfo::leafnames().c_str());
-	_trkana->Branch((branch+"mcpri").c_str(),&_allMCPriTIs.at(i_branch),GenInfo::leafnames().c_str());
-	_trkana->Branch((branch+"mcent").c_str(),&_allMCEntTIs.at(i_branch),TrkInfoMCStep::leafnames().c_str());
-	_trkana->Branch((branch+"mcmid").c_str(),&_allMCMidTIs.at(i_branch),TrkInfoMCStep::leafnames().c_str());
-	_trkana->Branch((branch+"mcxit").c_str(),&_allMCXitTIs.at(i_branch),TrkInfoMCStep::leafnames().c_str());
-	_trkana->Branch((branch+"tchmc").c_str(),&_allMCTCHIs.at(i_branch),CaloClusterInfoMC::leafnames().c_str());
+	addBranch(branch+"mc",&_allMCTIs.at(i_branch),TrkInfoMC::leafnames());
+	addBranch(branch+"mcgen",&_allMCGenTIs.at(i_branch),GenInfo::leafnames());
+	addBranch(branch+"mcpri",&_allMCPriTIs.at(i_branch),GenInfo::leafnames());
+	addBranch(branch+"mcent",&_allMCEntTIs.at(i_branch),TrkInfoMCStep::leafnames());
+	addBranch(branch+"mcmid",&_allMCMidTIs.at(i_branch),TrkInfoMCStep::leafnames());
+	addBranch(branch+"mcxit",&_allMCXitTIs.at(i_branch),TrkInfoMCStep::leafnames());
+	addBranch(branch+"tchmc",&_allMCTCHIs.at(i_branch),CaloClusterInfoMC::leafnames());
 	// at hit-level MC information
 	// (for the time being diagLevel will still work, but I propose removing this at some point)
 	if(_conf.diag() > 1 || (_conf.fillhits() && i_branchConfig.options().fillhits())){ 
-	  _trkana->Branch((branch+"tshmc").c_str(),&_allTSHIMCs.at(i_branch));
+	  addObjectBranch(branch+"tshmc",&_allTSHIMCs.at(i_branch));
 	}
       }
     }
 // trigger info.  Actual names should come from the BeginRun object FIXME
     if(_conf.filltrig()) {
-      _trkana->Branch("trigbits",&_trigbits,"trigbits/i");
+      addBranch("trigbits",&_trigbits,"trigbits/i");
     }
 // calorimeter information for the downstream electron track
 // CRV info
     if(_conf.crv()) {
-      _trkana->Branch("crvinfo",&_crvinfo);
-      _trkana->Branch("crvsummary",&_crvsummary);
-      _trkana->Branch("bestcrv",&_bestcrv,"bestcrv/I");
+      addObjectBranch("crvinfo",&_crvinfo);
+      addObjectBranch("crvsummary",&_crvsummary);
+      addBranch("bestcrv",&_bestcrv,"bestcrv/I");
       if(_conf.crvpulses()) {
-        _trkana->Branch("crvpulseinfo",&_crvpulseinfo);
-        _trkana->Branch("crvwaveforminfo",&_crvwaveforminfo);
+        addObjectBranch("crvpulseinfo",&_crvpulseinfo);
+        addObjectBranch("crvwaveforminfo",&_crvwaveforminfo);
       }
       if(_conf.fillmc()){
 	if(_conf.crv())
         {
-          _trkana->Branch("crvinfomc",&_crvinfomc);
-          _trkana->Branch("crvsummarymc",&_crvsummarymc);
-          _trkana->Branch("crvinfomcplane",&_crvinfomcplane);
+          addObjectBranch("crvinfomc",&_crvinfomc);
+          addObjectBranch("crvsummarymc",&_crvsummarymc);
+          addObjectBranch("crvinfomcplane",&_crvinfomcplane);
           if(_conf.crvpulses())
-            _trkana->Branch("crvpulseinfomc",&_crvpulseinfomc);
+            addObjectBranch("crvpulseinfomc",&_crvpulseinfomc);
         }
       }
     }
 // helix info
-   if(_conf.helices()) _trkana->Branch("helixinfo",&_hinfo,HelixInfo::leafnames().c_str());
+   if(_conf.helices()) addBranch("helixinfo",&_hinfo,HelixInfo::leafnames());
+  }
+
+  void TrackAnalysisReco::endJob() {
+    for (auto& writer : _writers) writer->close();
   }
 
   void TrackAnalysisReco::beginSubRun(const art::SubRun & subrun ) {
@@ -569,12 +602,12 @@ namespace mu2e {
 	  }
 	}
       }
-      // fill this row in the TTree
-      _trkana->Fill();
+      // fill this row in the outputs
+      for (auto& writer : _writers) writer->fill();
     }
 
     if(_conf.pempty() && candidateKSC.size()==0) { // if we want to process empty events
-      _trkana->Fill();
+      for (auto& writer : _writers) writer->fill();
     }
   }
 
@@ -823,13 +856,27 @@ namespace mu2e {
 	outputHandles.push_back(i_handle);
 	labels.push_back(branchname);
       }
-      if (!_trkana->GetBranch(branchname.c_str())) {  // only want to create the branch once
-	_trkana->Branch(branchname.c_str(), &infostruct, infostruct.leafnames(labels).c_str());
+      if (!_writers.front()->hasBranch(branchname)) {  // only want to create the branch once
+	addBranch(branchname, &infostruct, infostruct.leafnames(labels));
       }
     }
     return outputHandles;
   }
 
+  void TrackAnalysisReco::addBranch(const std::string& name, void* address, const std::string& leaves) {
+    for (auto& writer : _writers) writer->addStruct(name, address, leaves);
+  }
+
+  template <typename T>
+  void TrackAnalysisReco::addObjectBranch(const std::string& name, T* object) {
+    for (auto& writer : _writers) writer->addObject(name, object);
+  }
+
+  template <typename T>
+  void TrackAnalysisReco::addObjectBranch(const std::string& name, std::vector<T>* vec) {
+    for (auto& writer : _writers) writer->addVector(name, vec);
+  }
+
   void TrackAnalysisReco::resetBranches() {
     for (size_t i_branch = 0; i_branch < _allBranches.size(); ++i_branch) {
       _allTIs.at(i_branch).reset();
@@ -0,0 +1,129 @@
+//
+// Helpers for the TrackAnalysisReco columnar format, see TrkDiag/inc/TrkAnaColumnFormat.hh
+//
+#include "TrkDiag/inc/TrkAnaColumnFormat.hh"
+
+#include "cetlib_except/exception.h"
+
+#include "RZip.h"
+
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+
+namespace mu2e {
+
+  namespace TrkAnaColumnFormat {
+
+    const char magic[8] = { 'M','U','2','E','T','C','O','L' };
+
+    // R__zip works on pieces of at most this size, with a 9 byte header each
+    static const size_t maxPiece    = 0xffffff;
+    static const size_t pieceHeader = 9;
+
+    unsigned typeSize(char type) {
+      switch (type) {
+        case 'B': case 'b': case 'O':           return 1;
+        case 'S': case 's':                     return 2;
+        case 'I': case 'i': case 'F': case 'f': return 4;
+        case 'D': case 'd': case 'L': case 'l':
+        case 'G': case 'g':                     return 8;
+        default:
+          throw cet::exception("TrkAna") << "TrkAnaColumnFormat: unsupported leaf type " << type << "\n";
+      }
+    }
+
+    std::vector<Leaf> parseLeafList(const std::string& leaves) {
+      std::vector<Leaf> list;
+      std::istringstream is(leaves);
+      std::string token;
+      while (std::getline(is,token,':')) {
+        if (token.empty()) continue;
+        Leaf leaf{token,'F',1};
+        size_t slash = token.find('/');
+        if (slash != std::string::npos) {
+          if (slash+2 != token.size())
+            throw cet::exception("TrkAna") << "TrkAnaColumnFormat: bad leaf " << token << "\n";
+          leaf.type = token[slash+1];
+          leaf.name = token.substr(0,slash);
+        }
+        size_t bracket = leaf.name.find('[');
+        if (bracket != std::string::npos) {
+          leaf.count = std::stoul(leaf.name.substr(bracket+1));
+          leaf.name  = leaf.name.substr(0,bracket);
+        }
+        typeSize(leaf.type); // check the type
+        list.push_back(leaf);
+      }
+      return list;
+    }
+
+    template <class T> static double as(const char* address) {
+      T t;
+      std::memcpy(&t,address,sizeof(T));
+      return double(t);
+    }
+
+    double toDouble(char type, const char* address) {
+      switch (type) {
+        case 'B': return as<std::int8_t>(address);
+        case 'b': return as<std::uint8_t>(address);
+        case 'O': return as<std::uint8_t>(address);
+        case 'S': return as<std::int16_t>(address);
+        case 's': return as<std::uint16_t>(address);
+        case 'I': return as<std::int32_t>(address);
+        case 'i': return as<std::uint32_t>(address);
+        case 'F': case 'f': return as<float>(address);
+        case 'D': case 'd': return as<double>(address);
+        case 'L': case 'G': return as<std::int64_t>(address);
+        case 'l': case 'g': return as<std::uint64_t>(address);
+        default : return 0;
+      }
+    }
+
+    void shuffle(const char* in, size_t n, size_t size, char* out) {
+      for (size_t i=0; i<n; ++i)
+        for (size_t b=0; b<size; ++b) out[b*n+i] = in[i*size+b];
+    }
+
+    void unshuffle(const char* in, size_t n, size_t size, char* out) {
+      for (size_t i=0; i<n; ++i)
+        for (size_t b=0; b<size; ++b) out[i*size+b] = in[b*n+i];
+    }
+
+    bool compress(const char* in, size_t n, int setting, std::vector<char>& out) {
+      out.clear();
+      if (setting <= 0 || n == 0) return false;
+      size_t done(0);
+      while (done < n) {
+        int srcsize = std::min(maxPiece, n-done);
+        int tgtsize = srcsize;                    // no gain if the piece does not shrink
+        int irep(0);
+        size_t start = out.size();
+        out.resize(start+tgtsize+pieceHeader);
+        R__zip(setting, &srcsize, const_cast<char*>(in+done), &tgtsize, &out[start], &irep);
+        if (irep <= 0 || size_t(irep) >= size_t(srcsize)) {out.clear(); return false;}
+        out.resize(start+irep);
+        done += srcsize;
+      }
+      return true;
+    }
+
+    void decompress(const char* in, size_t stored, char* out, size_t n) {
+      size_t used(0), done(0);
+      while (used < stored && done < n) {
+        unsigned char* src = reinterpret_cast<unsigned char*>(const_cast<char*>(in+used));
+        int srcsize(0), tgtsize(0), irep(0);
+        if (stored-used < pieceHeader || R__unzip_header(&srcsize, src, &tgtsize) != 0 ||
+            size_t(srcsize) > stored-used || size_t(tgtsize) > n-done) break;
+        R__unzip(&srcsize, src, &tgtsize, reinterpret_cast<unsigned char*>(out+done), &irep);
+        if (irep != tgtsize) break;
+        used += srcsize;
+        done += tgtsize;
+      }
+      if (used != stored || done != n)
+        throw cet::exception("TrkAna") << "TrkAnaColumnFormat: corrupt compressed block\n";
+    }
+
+  }
+}
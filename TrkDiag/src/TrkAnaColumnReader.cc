@@ -0,0 +1,136 @@
+//
+// Reader for the TrackAnalysisReco columnar files, see TrkDiag/inc/TrkAnaColumnReader.hh
+//
+#include "TrkDiag/inc/TrkAnaColumnReader.hh"
+
+#include "cetlib_except/exception.h"
+
+#include <cstring>
+
+namespace mu2e {
+
+  using namespace TrkAnaColumnFormat;
+
+  TrkAnaColumnReader::TrkAnaColumnReader(const std::string& fileName) :
+    _fileName(fileName), _in(fileName, std::ios::binary)
+  {
+    if (!_in)
+      throw cet::exception("TrkAna") << "TrkAnaColumnReader: cannot open " << fileName << "\n";
+    readFooter();
+  }
+
+  template <class T> T TrkAnaColumnReader::get() {
+    T t;
+    if (!_in.read(reinterpret_cast<char*>(&t), sizeof(T)))
+      throw cet::exception("TrkAna") << "TrkAnaColumnReader: truncated file " << _fileName << "\n";
+    return t;
+  }
+
+  std::string TrkAnaColumnReader::getString() {
+    std::string s(get<uint32_t>(), ' ');
+    if (!s.empty() && !_in.read(&s[0], s.size()))
+      throw cet::exception("TrkAna") << "TrkAnaColumnReader: truncated file " << _fileName << "\n";
+    return s;
+  }
+
+  void TrkAnaColumnReader::readFooter() {
+    char mark[sizeof(magic)];
+    _in.read(mark, sizeof(mark));
+    if (!_in || std::memcmp(mark, magic, sizeof(magic)) != 0)
+      throw cet::exception("TrkAna") << "TrkAnaColumnReader: " << _fileName << " is not a trkana columnar file\n";
+    if (get<uint32_t>() != byteOrder)
+      throw cet::exception("TrkAna") << "TrkAnaColumnReader: " << _fileName << " was written with another byte order\n";
+    uint32_t fileVersion = get<uint32_t>();
+    if (fileVersion != version)
+      throw cet::exception("TrkAna") << "TrkAnaColumnReader: " << _fileName << " has unsupported version " << fileVersion << "\n";
+
+    _in.seekg(-int(sizeof(uint64_t)+sizeof(magic)), std::ios::end);
+    uint64_t footerOffset = get<uint64_t>();
+    _in.read(mark, sizeof(mark));
+    if (!_in || std::memcmp(mark, magic, sizeof(magic)) != 0)
+      throw cet::exception("TrkAna") << "TrkAnaColumnReader: " << _fileName << " has no footer (file not closed?)\n";
+
+    _in.seekg(footerOffset);
+    _columns.resize(get<uint32_t>());
+    for (auto& column : _columns) {
+      column.name        = getString();
+      column.kind        = get<int32_t>();
+      column.type        = get<char>();
+      column.width       = get<uint32_t>();
+      column.valueSize   = get<uint32_t>();
+      column.typeName    = getString();
+      column.compression = get<int32_t>();
+    }
+    _groups.resize(get<uint32_t>());
+    for (auto& group : _groups) {
+      group.nRows = get<uint64_t>();
+      group.columns.resize(_columns.size());
+      for (auto& gc : group.columns) {
+        gc.present = get<uint8_t>() != 0;
+        if (!gc.present) continue;
+        for (Block* block : {&gc.data, &gc.counts}) {
+          block->offset = get<uint64_t>();
+          block->stored = get<uint64_t>();
+          block->raw    = get<uint64_t>();
+          block->flags  = get<uint32_t>();
+        }
+      }
+    }
+  }
+
+  int TrkAnaColumnReader::columnIndex(const std::string& name) const {
+    for (size_t icol=0; icol<_columns.size(); ++icol)
+      if (_columns[icol].name == name) return icol;
+    return -1;
+  }
+
+  uint64_t TrkAnaColumnReader::nRows() const {
+    uint64_t n(0);
+    for (const auto& group : _groups) n += group.nRows;
+    return n;
+  }
+
+  void TrkAnaColumnReader::readColumn(size_t group, size_t icol, std::vector<char>& data, std::vector<uint32_t>* counts) {
+    const Column&      column = _columns.at(icol);
+    const Group&       grp    = _groups.at(group);
+    const GroupColumn& gc     = grp.columns.at(icol);
+
+    if (!gc.present) {
+      // column declared after this row group was written
+      if (column.kind == fixedColumn) data.assign(grp.nRows*column.width, 0);
+      else data.clear();
+      if (counts) counts->assign(column.kind == listColumn ? grp.nRows : 0, 0);
+      return;
+    }
+
+    readBlock(gc.data, column.valueSize, data);
+    if (counts) {
+      counts->clear();
+      if (column.kind == listColumn) {
+        readBlock(gc.counts, sizeof(uint32_t), _unpacked);
+        counts->resize(_unpacked.size()/sizeof(uint32_t));
+        std::memcpy(counts->data(), _unpacked.data(), counts->size()*sizeof(uint32_t));
+      }
+    }
+  }
+
+  void TrkAnaColumnReader::readBlock(const Block& block, unsigned valueSize, std::vector<char>& out) {
+    _buffer.resize(block.stored);
+    _in.clear();
+    _in.seekg(block.offset);
+    if (block.stored > 0 && !_in.read(_buffer.data(), block.stored))
+      throw cet::exception("TrkAna") << "TrkAnaColumnReader: truncated file " << _fileName << "\n";
+
+    out.resize(block.raw);
+    char* target = out.data();
+    if (block.flags & shuffled) {
+      _plain.resize(block.raw);
+      target = _plain.data();
+    }
+    if (block.flags & compressed) decompress(_buffer.data(), block.stored, target, block.raw);
+    else if (block.stored == block.raw) std::memcpy(target, _buffer.data(), block.raw);
+    else throw cet::exception("TrkAna") << "TrkAnaColumnReader: corrupt block in " << _fileName << "\n";
+    if (block.flags & shuffled) unshuffle(_plain.data(), block.raw/valueSize, valueSize, out.data());
+  }
+
+}
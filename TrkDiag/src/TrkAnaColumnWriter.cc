@@ -0,0 +1,187 @@
+//
+// TrackAnalysisReco output to a columnar file, see TrkDiag/inc/TrkAnaColumnWriter.hh
+//
+#include "TrkDiag/inc/TrkAnaColumnWriter.hh"
+
+#include "cetlib_except/exception.h"
+
+#include <cstring>
+
+namespace mu2e {
+
+  using namespace TrkAnaColumnFormat;
+
+  TrkAnaColumnWriter::TrkAnaColumnWriter(const std::string& fileName, unsigned rowGroupSize, int compression, bool shuffle) :
+    _fileName(fileName), _out(fileName, std::ios::binary | std::ios::trunc),
+    _rowGroupSize(rowGroupSize), _compression(compression), _shuffle(shuffle), _nRows(0), _closed(false)
+  {
+    if (!_out)
+      throw cet::exception("TrkAna") << "TrkAnaColumnWriter: cannot open " << fileName << "\n";
+    if (_rowGroupSize == 0)
+      throw cet::exception("TrkAna") << "TrkAnaColumnWriter: the row group size must be positive\n";
+    _out.write(magic, sizeof(magic));
+    put(byteOrder);
+    put(version);
+  }
+
+  TrkAnaColumnWriter::~TrkAnaColumnWriter() {
+    // no exception may leave a destructor: a file that cannot be finished has no footer
+    try { close(); }
+    catch (...) {}
+  }
+
+  void TrkAnaColumnWriter::addStruct(const std::string& name, void* address, const std::string& leaves) {
+    if (hasBranch(name))
+      throw cet::exception("TrkAna") << "TrkAnaColumnWriter: branch " << name << " declared twice\n";
+    _branches[name] = -1;
+
+    std::string prefix = name;
+    if (!prefix.empty() && prefix.back() == '.') prefix.pop_back();
+    std::vector<Leaf> list = parseLeafList(leaves);
+
+    const char* leafAddress = static_cast<const char*>(address);
+    for (const auto& leaf : list) {
+      Column column;
+      column.name      = (list.size() == 1 && leaf.name == prefix) ? prefix : prefix + "." + leaf.name;
+      column.kind      = fixedColumn;
+      column.type      = leaf.type;
+      column.valueSize = typeSize(leaf.type);
+      column.width     = column.valueSize*leaf.count;
+      column.address   = leafAddress;
+      column.object    = -1;
+      addColumn(column);
+      leafAddress += column.width;
+    }
+  }
+
+  void TrkAnaColumnWriter::addObjectBranch(const ObjectBranch& branch) {
+    if (hasBranch(branch.name))
+      throw cet::exception("TrkAna") << "TrkAnaColumnWriter: branch " << branch.name << " declared twice\n";
+    _branches[branch.name] = _objects.size();
+    _objects.push_back(branch);
+
+    Column column;
+    column.name      = branch.name;
+    column.kind      = branch.isVector ? listColumn : fixedColumn;
+    column.type      = recordType;
+    column.width     = branch.size;
+    column.valueSize = 1;
+    column.typeName  = branch.typeName;
+    column.address   = 0;
+    column.object    = _objects.size()-1;
+    addColumn(column);
+  }
+
+  void TrkAnaColumnWriter::addColumn(Column column) {
+    if (_closed)
+      throw cet::exception("TrkAna") << "TrkAnaColumnWriter: column " << column.name << " added after close\n";
+    for (const auto& other : _columns)
+      if (other.name == column.name)
+        throw cet::exception("TrkAna") << "TrkAnaColumnWriter: duplicate column " << column.name << "\n";
+    // rows already filled in the current group get empty values
+    if (column.kind == fixedColumn) column.data.assign(_nRows*column.width, 0);
+    else column.counts.assign(_nRows, 0);
+    _columns.push_back(std::move(column));
+  }
+
+  void TrkAnaColumnWriter::fill() {
+    if (_closed)
+      throw cet::exception("TrkAna") << "TrkAnaColumnWriter: fill after close\n";
+    for (auto& column : _columns) {
+      const char* data = column.address;
+      size_t      n    = 1;
+      if (column.object >= 0) {
+        const ObjectBranch& branch = _objects[column.object];
+        data = static_cast<const char*>(branch.data());
+        n    = branch.count();
+      }
+      if (column.kind == listColumn) column.counts.push_back(n);
+      if (n > 0) column.data.insert(column.data.end(), data, data + n*column.width);
+    }
+    if (++_nRows == _rowGroupSize) writeGroup();
+  }
+
+  void TrkAnaColumnWriter::close() {
+    if (_closed) return;
+    _closed = true;
+    if (_nRows > 0) writeGroup();
+    writeFooter();
+    _out.close();
+    if (!_out)
+      throw cet::exception("TrkAna") << "TrkAnaColumnWriter: error writing " << _fileName << "\n";
+  }
+
+  void TrkAnaColumnWriter::writeGroup() {
+    Group group;
+    group.nRows = _nRows;
+    for (auto& column : _columns) {
+      GroupColumn gc;
+      gc.data   = writeBlock(column.data.data(), column.data.size(), column.valueSize);
+      gc.counts = Block{0,0,0,0};
+      if (column.kind == listColumn)
+        gc.counts = writeBlock(reinterpret_cast<const char*>(column.counts.data()),
+                               column.counts.size()*sizeof(uint32_t), sizeof(uint32_t));
+      group.columns.push_back(gc);
+      column.data.clear();
+      column.counts.clear();
+    }
+    _groups.push_back(group);
+    _nRows = 0;
+    if (!_out)
+      throw cet::exception("TrkAna") << "TrkAnaColumnWriter: error writing " << _fileName << "\n";
+  }
+
+  TrkAnaColumnWriter::Block TrkAnaColumnWriter::writeBlock(const char* data, size_t n, unsigned valueSize) {
+    Block block{uint64_t(_out.tellp()), n, n, 0};
+    if (_shuffle && valueSize > 1 && n%valueSize == 0) {
+      _shuffled.resize(n);
+      shuffle(data, n/valueSize, valueSize, _shuffled.data());
+      data = _shuffled.data();
+      block.flags |= shuffled;
+    }
+    if (compress(data, n, _compression, _compressed)) {
+      data = _compressed.data();
+      block.stored = _compressed.size();
+      block.flags |= compressed;
+    }
+    _out.write(data, block.stored);
+    return block;
+  }
+
+  void TrkAnaColumnWriter::putString(const std::string& s) {
+    put(uint32_t(s.size()));
+    _out.write(s.data(), s.size());
+  }
+
+  void TrkAnaColumnWriter::writeFooter() {
+    uint64_t footerOffset = _out.tellp();
+    put(uint32_t(_columns.size()));
+    for (const auto& column : _columns) {
+      putString(column.name);
+      put(int32_t(column.kind));
+      put(column.type);
+      put(uint32_t(column.width));
+      put(uint32_t(column.valueSize));
+      putString(column.typeName);
+      put(int32_t(_compression));
+    }
+    put(uint32_t(_groups.size()));
+    for (const auto& group : _groups) {
+      put(group.nRows);
+      for (size_t icol=0; icol<_columns.size(); ++icol) {
+        uint8_t present = icol < group.columns.size();
+        put(present);
+        if (!present) continue;
+        for (const Block* block : {&group.columns[icol].data, &group.columns[icol].counts}) {
+          put(block->offset);
+          put(block->stored);
+          put(block->raw);
+          put(block->flags);
+        }
+      }
+    }
+    put(footerOffset);
+    _out.write(magic, sizeof(magic));
+  }
+
+}
@@ -0,0 +1,120 @@
+//
+// Benchmark of a full scan of the TrackAnalysisReco output: every value of every leaf list
+// branch of the trkana TTree is read and summed, then the same is done with the columnar
+// file written by the same job (OutputFormat : "Both").  Object and vector branches are
+// skipped in both, since the columnar file stores them as opaque records.
+//
+// Usage: trkAnaScan <root file> <tree path> <columnar file>
+//   e.g. trkAnaScan trkana.root TrkAnaNeg/trkana trkana.tcol
+//
+// The sums are printed together with the times; they should agree up to the order of the
+// additions.
+//
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "cetlib_except/exception.h"
+
+#include "TFile.h"
+#include "TTree.h"
+#include "TBranch.h"
+#include "TBranchElement.h"
+#include "TLeaf.h"
+
+#include "TrkDiag/inc/TrkAnaColumnReader.hh"
+
+namespace {
+
+  typedef std::chrono::steady_clock Clock;
+
+  double seconds(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now()-start).count();
+  }
+
+  void scanTree(TTree* tree, long long& rows, long long& values, double& sum) {
+    std::vector<TLeaf*> leaves;
+    tree->SetBranchStatus("*",0);
+    TIter next(tree->GetListOfBranches());
+    while (TBranch* branch = static_cast<TBranch*>(next())) {
+      if (dynamic_cast<TBranchElement*>(branch)) continue; // dictionary streamed branch
+      tree->SetBranchStatus(branch->GetName(),1);
+      TIter nextLeaf(branch->GetListOfLeaves());
+      while (TLeaf* leaf = static_cast<TLeaf*>(nextLeaf())) leaves.push_back(leaf);
+    }
+    rows = tree->GetEntries();
+    for (long long ientry=0; ientry<rows; ++ientry) {
+      tree->GetEntry(ientry);
+      for (TLeaf* leaf : leaves) {
+        int len = leaf->GetLen();
+        for (int i=0; i<len; ++i) sum += leaf->GetValue(i);
+        values += len;
+      }
+    }
+  }
+
+  void scanColumns(mu2e::TrkAnaColumnReader& reader, long long& rows, long long& values, double& sum) {
+    std::vector<char> data;
+    rows = reader.nRows();
+    for (size_t group=0; group<reader.nRowGroups(); ++group) {
+      for (size_t icol=0; icol<reader.columns().size(); ++icol) {
+        const auto& column = reader.columns()[icol];
+        if (column.type == mu2e::TrkAnaColumnFormat::recordType) continue;
+        reader.readColumn(group, icol, data);
+        for (size_t i=0; i+column.valueSize<=data.size(); i+=column.valueSize) {
+          sum += mu2e::TrkAnaColumnReader::value(column.type, &data[i]);
+          ++values;
+        }
+      }
+    }
+  }
+}
+
+int main(int argc, char**argv) {
+
+  if (argc != 4) {
+    std::cerr << "Usage: trkAnaScan <root file> <tree path> <columnar file>" << std::endl;
+    return 1;
+  }
+
+  try {
+    TFile file(argv[1]);
+    TTree* tree = dynamic_cast<TTree*>(file.Get(argv[2]));
+    if (file.IsZombie() || !tree) {
+      std::cerr << "trkAnaScan: no tree " << argv[2] << " in " << argv[1] << std::endl;
+      return 2;
+    }
+
+    long long treeRows(0), treeValues(0);
+    double treeSum(0);
+    Clock::time_point start = Clock::now();
+    scanTree(tree, treeRows, treeValues, treeSum);
+    double treeTime = seconds(start);
+
+    long long colRows(0), colValues(0);
+    double colSum(0);
+    start = Clock::now();
+    mu2e::TrkAnaColumnReader reader(argv[3]);
+    scanColumns(reader, colRows, colValues, colSum);
+    double colTime = seconds(start);
+
+    std::cout << "trkAnaScan: full scan of the leaf list branches\n"
+              << "  TTree    : " << treeRows << " rows, " << treeValues << " values, "
+              << treeTime << " s, sum " << treeSum << "\n"
+              << "  columnar : " << colRows << " rows, " << colValues << " values, "
+              << colTime << " s, sum " << colSum << " (" << reader.nRowGroups() << " row groups)" << std::endl;
+
+    if (treeRows != colRows || treeValues != colValues) {
+      std::cerr << "trkAnaScan: the TTree and the columnar file have different contents" << std::endl;
+      return 3;
+    }
+  }
+  catch (cet::exception& e) {
+    std::cerr << "trkAnaScan: " << e.what() << std::endl;
+    return 2;
+  }
+
+  return 0;
+}
@@ -11,6 +11,8 @@
 //
 
 // C++ includes.
+#include <array>
+#include <chrono>
 #include <iostream>
 #include <string>
 #include <sstream>
@@ -70,6 +72,45 @@ namespace mu2e {
   const int MAXNBACK = 10000;
   const double RUNGE_KUTTA_KQ = 1.e-9*VELOCITY_OF_LIGHT; //k = 2.99e-1, q = 1. Actual charge is multiplied in runtime. 
 
+  // Fixed-size 6x6 matrix for the covariance transport, avoids the heap allocations of HepMatrix
+  typedef std::array<std::array<double,6>,6> TrkExtMatrix6;
+
+  namespace {
+    TrkExtMatrix6 toMatrix6 (const HepMatrix & m) {
+      TrkExtMatrix6 r;
+      for (int i = 0 ; i < 6 ; ++i) 
+        for (int j = 0 ; j < 6 ; ++j) r[i][j] = m[i][j];
+      return r;
+    }
+
+    HepMatrix toHepMatrix (const TrkExtMatrix6 & m) {
+      HepMatrix r(6,6,0);
+      for (int i = 0 ; i < 6 ; ++i) 
+        for (int j = 0 ; j < 6 ; ++j) r[i][j] = m[i][j];
+      return r;
+    }
+
+    // J*E*J^T
+    TrkExtMatrix6 similarity (const TrkExtMatrix6 & J, const TrkExtMatrix6 & E) {
+      TrkExtMatrix6 JE, r;
+      for (int i = 0 ; i < 6 ; ++i) {
+        for (int j = 0 ; j < 6 ; ++j) {
+          double sum = 0;
+          for (int k = 0 ; k < 6 ; ++k) sum += J[i][k]*E[k][j];
+          JE[i][j] = sum;
+        }
+      }
+      for (int i = 0 ; i < 6 ; ++i) {
+        for (int j = 0 ; j < 6 ; ++j) {
+          double sum = 0;
+          for (int k = 0 ; k < 6 ; ++k) sum += JE[i][k]*J[j][k];
+          r[i][j] = sum;
+        }
+      }
+      return r;
+    }
+  }
+
 
 
   namespace TrkExtExitCode {
@@ -114,6 +155,7 @@ namespace mu2e {
     bool _mcFlag;
     bool _useVirtualDetector;
     int _bFieldGradientMode;
+    bool _fixedSizeMatrices;
     bool _turnOnMultipleScattering;
     int _debugLevel;
     int _verbosity;
@@ -132,6 +174,9 @@ namespace mu2e {
     std::vector<TH1F *> _hPfin;
     std::vector<TH1F *> _hDeltapPA;
     std::vector<TH1F *> _hDeltapST;
+    std::vector<TH1F *> _hExtTime;
+    std::vector<double> _extTime;
+    std::vector<unsigned> _extTracks;
     TNtuple * _hNtracks;
     
 
@@ -175,8 +220,11 @@ namespace mu2e {
                                       double & byx, double & byy, double & byz, 
                                       double & bzx, double & bzy, double & bzz);
     bool checkOutofReflectionLimit (bool updown, const Hep3Vector & x, const Hep3Vector & p); // in Detector coordinate
+    bool getTransportJacobian(TrkExtTrajPoint & r0, double ds, double deltapp, int charge, TrkExtMatrix6 & J);
     HepMatrix getCovarianceTransport(TrkExtTrajPoint & r0, double ds, double deltapp, int charge);
+    TrkExtMatrix6 getCovarianceTransportFixed(TrkExtTrajPoint & r0, double ds, double deltapp, int charge);
     HepMatrix getCovarianceMultipleScattering(TrkExtTrajPoint & r0, double ds);
+    TrkExtMatrix6 getCovarianceMultipleScatteringFixed(TrkExtTrajPoint & r0, double ds);
 
 
 
@@ -197,7 +245,8 @@ namespace mu2e {
     _recordingStep(pset.get<double>("recordingStep", 10.0)),    // in mm
     _mcFlag(pset.get<bool>("mcFlag", false)),
     _useVirtualDetector(pset.get<bool>("useVirtualDetector", false)),
-    _bFieldGradientMode(pset.get<int>("bFieldGradientMode", 1)),
+    _bFieldGradientMode(pset.get<int>("bFieldGradientMode", 1)),  // 0: none, 1: finite differences, 2: analytic from the field map
+    _fixedSizeMatrices(pset.get<bool>("fixedSizeMatrices", true)),
     _turnOnMultipleScattering(pset.get<bool>("turnOnMultipleScattering", true)),
     _debugLevel(pset.get<int>("debugLevel", 1)),
     _verbosity(pset.get<int>("verbosity", 1)),
@@ -274,13 +323,18 @@ namespace mu2e {
     }
 
     if (_bFieldGradientMode != 0 
-        && _bFieldGradientMode != 1) {
+        && _bFieldGradientMode != 1
+        && _bFieldGradientMode != 2) {
       if (_verbosity>=0) cout << "TrkExt: bFieldGradientMode forced to 1" << endl;
       _bFieldGradientMode = 1;
     }
 
     if (_verbosity>=1) cout << "TrkExt: extrapolationStep = " << _extrapolationStep << endl;
     if (_verbosity>=1) cout << "TrkExt: recordingStep = " << _recordingStep << endl;
+    if (_verbosity>=1) cout << "TrkExt: bFieldGradientMode = " << _bFieldGradientMode << ", fixedSizeMatrices = " << _fixedSizeMatrices << endl;
+
+    _extTime.assign(_trkPatRecInstanceName.size(), 0.);
+    _extTracks.assign(_trkPatRecInstanceName.size(), 0);
 
     // histograms
 
@@ -307,6 +361,7 @@ namespace mu2e {
         _hPfin.push_back((TH1F*)0);
         _hDeltapPA.push_back((TH1F*)0);
         _hDeltapST.push_back((TH1F*)0);
+        _hExtTime.push_back((TH1F*)0);
       }
       for (unsigned int i = 0 ; i <_trkPatRecInstanceName.size() ; ++i) {
         sprintf (hname, "hExitCode_%d", i);
@@ -339,6 +394,9 @@ namespace mu2e {
         sprintf (hname, "hDeltapST_%d", i);
         sprintf (htitle, "Energy loss in ST for %s", _trkPatRecInstanceName.name(i).c_str());
         _hDeltapST[i] = tfs->make<TH1F>(hname, htitle, 200, -2, 2);
+        sprintf (hname, "hExtTime_%d", i);
+        sprintf (htitle, "Extrapolation time per track (ms) for %s", _trkPatRecInstanceName.name(i).c_str());
+        _hExtTime[i] = tfs->make<TH1F>(hname, htitle, 200, 0, 100);
       }
     }
     _hNtracks = tfs->make<TNtuple>("hNtracks", "Extrapolation statistics", "hepid:dir:ntrk");
@@ -370,6 +428,9 @@ namespace mu2e {
     if (_verbosity>=2) cout << "TrkExt: From endJob. " << endl;
     for ( unsigned int i = 0 ; i < _trkPatRecInstanceName.size() ; ++i) {
       _hNtracks->Fill(_trkPatRecInstanceName.hepid(i), _trkPatRecInstanceName.updown(i), _trkPatRecInstanceName.ntrk(i));
+      if (_verbosity>=1 && _extTracks[i] > 0) {
+        cout << "TrkExt: " << _trkPatRecInstanceName.name(i) << " : " << _extTracks[i] << " tracks extrapolated, mean time per track " << _extTime[i]/_extTracks[i] << " ms" << endl;
+      }
     }
 
   }
@@ -434,11 +495,16 @@ namespace mu2e {
         }
   
         int nsteps;
+        auto extStart = std::chrono::steady_clock::now();
         //upstream ptl extrapolates  time-forward to stopping target
         if (instance.updown) nsteps = doExtrapolation (xstop, pstop, tstop, covstop, true, instance); 
         //downstream ptl extrapolates  time-backward to stopping target
         else                 nsteps = doExtrapolation (xstart, pstart, tstart, covstart, false, instance); 
+        double extTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - extStart).count();
+        _extTime[instanceIter] += extTime;
+        ++_extTracks[instanceIter];
         if (_flagDiagnostics) {
+          _hExtTime[instanceIter]->Fill(extTime);
           _hExitCode[instanceIter]->Fill(_traj.exitCode());
           _hNSteps[instanceIter]->Fill(nsteps);
           _hNData[instanceIter]->Fill(_traj.size());
@@ -513,6 +579,23 @@ namespace mu2e {
                                       double & byx, double & byy, double & byz, 
                                       double & bzx, double & bzy, double & bzz) {
 
+    if (_bFieldGradientMode == 2) {
+      // analytic gradient of the field map interpolation, one map lookup instead of seven
+      Hep3Vector B0;
+      Hep3Vector grad[3];
+      _bfMgr->getBFieldWithGradient(x + _origin, B0, grad);
+      bxx = grad[0].x();
+      bxy = grad[1].x();
+      bxz = grad[2].x();
+      byx = grad[0].y();
+      byy = grad[1].y();
+      byz = grad[2].y();
+      bzx = grad[0].z();
+      bzy = grad[1].z();
+      bzz = grad[2].z();
+      return B0;
+    }
+
     Hep3Vector B0 = getBField(x);
 
     if (_bFieldGradientMode == 1) {
@@ -892,16 +975,27 @@ namespace mu2e {
       }  // end of material effect check
 
       // covariance calculation -calculating covariance from transport is default
-      HepMatrix cov1 = getCovarianceTransport(r0, ds, deltapp, charge);
-
-      // calculate covariance from multiple scattering and add to previous one - it's optional
-      if (_turnOnMultipleScattering) {
-        HepMatrix cov2 = getCovarianceMultipleScattering(r0, ds);
-        HepMatrix cov = cov1 + cov2;
-        r1.setCovariance (cov);
+      if (_fixedSizeMatrices) {
+        TrkExtMatrix6 cov = getCovarianceTransportFixed(r0, ds, deltapp, charge);
+        if (_turnOnMultipleScattering) {
+          TrkExtMatrix6 cov2 = getCovarianceMultipleScatteringFixed(r0, ds);
+          for (int i = 0 ; i < 6 ; ++i) 
+            for (int j = 0 ; j < 6 ; ++j) cov[i][j] += cov2[i][j];
+        }
+        r1.setCovariance (toHepMatrix(cov));
       }
       else {
-        r1.setCovariance (cov1);
+        HepMatrix cov1 = getCovarianceTransport(r0, ds, deltapp, charge);
+  
+        // calculate covariance from multiple scattering and add to previous one - it's optional
+        if (_turnOnMultipleScattering) {
+          HepMatrix cov2 = getCovarianceMultipleScattering(r0, ds);
+          HepMatrix cov = cov1 + cov2;
+          r1.setCovariance (cov);
+        }
+        else {
+          r1.setCovariance (cov1);
+        }
       }
 
       // PA and ST hit booking
@@ -973,21 +1067,14 @@ namespace mu2e {
 
 ///////// Covariance ////////////
 
-  HepMatrix TrkExt::getCovarianceTransport(TrkExtTrajPoint & r0, double ds, double deltapp, int charge) {
-    const HepMatrix & E = r0.covariance();
-    HepMatrix Ep(6,6,0);
-    if (E.num_row() !=6 || E.num_col() !=6) {
-      if (_verbosity>=0) cout << "TrkExt Warning : cannot calculate covariance" << endl;
-      return Ep;
-    }
-    HepMatrix J(6,6,0);
+  bool TrkExt::getTransportJacobian(TrkExtTrajPoint & r0, double ds, double deltapp, int charge, TrkExtMatrix6 & J) {
     double px = r0.px();
     double py = r0.py();
     double pz = r0.pz();
     double p = r0.momentum().mag();
     if (p == 0) {
       if (_verbosity>=0) cout << "TrkExt Warning : 0 momentum?" << endl;
-      return Ep;
+      return false;
     }
     double pp = p*p;
     double ppp = pp*p;
@@ -1054,6 +1141,20 @@ namespace mu2e {
     J[5][4] = kqds/ppp *(-Bx*pp - py*(px*By-py*Bx));
     J[5][5] = 1+deltapp-kqds/ppp*pz*(px*By-py*Bx);
 
+    return true;
+  }
+
+  HepMatrix TrkExt::getCovarianceTransport(TrkExtTrajPoint & r0, double ds, double deltapp, int charge) {
+    const HepMatrix & E = r0.covariance();
+    HepMatrix Ep(6,6,0);
+    if (E.num_row() !=6 || E.num_col() !=6) {
+      if (_verbosity>=0) cout << "TrkExt Warning : cannot calculate covariance" << endl;
+      return Ep;
+    }
+    TrkExtMatrix6 J6;
+    if (!getTransportJacobian(r0, ds, deltapp, charge, J6)) return Ep;
+    HepMatrix J = toHepMatrix(J6);
+
     HepMatrix JT = J.T();
 
     Ep =  J*E*JT;
@@ -1061,7 +1162,23 @@ namespace mu2e {
     return Ep;
   }
 
+  TrkExtMatrix6 TrkExt::getCovarianceTransportFixed(TrkExtTrajPoint & r0, double ds, double deltapp, int charge) {
+    const HepMatrix & E = r0.covariance();
+    TrkExtMatrix6 Ep = {};
+    if (E.num_row() !=6 || E.num_col() !=6) {
+      if (_verbosity>=0) cout << "TrkExt Warning : cannot calculate covariance" << endl;
+      return Ep;
+    }
+    TrkExtMatrix6 J;
+    if (!getTransportJacobian(r0, ds, deltapp, charge, J)) return Ep;
+    return similarity(J, toMatrix6(E));
+  }
+
   HepMatrix TrkExt::getCovarianceMultipleScattering(TrkExtTrajPoint & r0, double ds) {
+    return toHepMatrix(getCovarianceMultipleScatteringFixed(r0, ds));
+  }
+
+  TrkExtMatrix6 TrkExt::getCovarianceMultipleScatteringFixed(TrkExtTrajPoint & r0, double ds) {
     Hep3Vector e = r0.momentum().unit();
     double costh1 = e.x();
     double costh2 = e.y();
@@ -1070,7 +1187,7 @@ namespace mu2e {
     double sinth22  = 1. - costh2*costh2;
     double sinth32  = 1. - costh3*costh3;
 
-    HepMatrix R(3,3,0);
+    double R[3][3];
     R[0][0] = sinth12;
     R[0][1] = -costh1*costh2;
     R[0][2] = -costh1*costh3;
@@ -1087,7 +1204,7 @@ namespace mu2e {
     double m12 = 0.5*th*th*ds*p;
     double m22 = th*th*p*p;
     
-    HepMatrix Em(6,6,0);
+    TrkExtMatrix6 Em;
 
     for (int i = 0 ; i < 3 ; ++i) {
       for (int j = 0 ; j <3 ; ++j) {
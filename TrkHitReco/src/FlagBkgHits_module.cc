@@ -82,7 +82,7 @@ namespace mu2e
          void classifyCluster(BkgClusterCollection& bkgccolFast, BkgClusterCollection& bkgccol, BkgQualCollection& bkgqcol, 
                               StrawHitFlagCollection& chfcol, const ComboHitCollection& chcol) const;
          void fillBkgQual(    const BkgCluster& cluster, BkgQual& cqual, const ComboHitCollection& chcol) const;
-         void fillMVA(        BkgQual& cqual) const;
+         std::vector<float> mvaInputs(const BkgQual& cqual) const;
          void countHits(      const BkgCluster& cluster, unsigned& nactive, unsigned& nstereo, const ComboHitCollection& chcol) const;
          void countPlanes(    const BkgCluster& cluster, BkgQual& cqual, const ComboHitCollection& chcol) const;
          int  findClusterIdx( BkgClusterCollection& bkgccol, unsigned ich) const;
@@ -211,7 +211,6 @@ namespace mu2e
       }
 
       //produce StrawHit flags
-      // Note: fillStrawHitIndices is quite slow and should be improved 
       if (flagsh_)
       {
           auto shH = event.getValidHandle(shtoken_);
@@ -219,13 +218,11 @@ namespace mu2e
 
           unsigned nsh = shcol->size();
           auto shfcol  = std::make_unique<StrawHitFlagCollection>(nsh);
-          std::vector<std::vector<StrawHitIndex> > shids;
-          chcol.fillStrawHitIndices(event,shids);
           for (size_t ich = 0;ich < nch;++ich)
           {
               StrawHitFlag flag = chfcol[ich];
               flag.merge(chcol[ich].flag());
-              for(auto ish : shids[ich]) (*shfcol)[ish] = flag;
+              for(auto ish : chcol.strawHitIndices(event,ich)) (*shfcol)[ish] = flag;
           }
 
           event.put(std::move(shfcol),"StrawHits");
@@ -263,11 +260,31 @@ namespace mu2e
          for (const auto& chit : cluster.hits()) chfcol[chit] = flag;
       }      
       
-      for (auto& cluster : bkgccol)
+      // fill the cluster quality first, and evaluate the MVA of all the clusters at once
+      std::vector<BkgQual> cquals(bkgccol.size());
+      std::vector<std::vector<float> > mvavars;
+      std::vector<size_t> mvaclusters;
+      for (size_t icl=0;icl<bkgccol.size();++icl)
+      {
+           fillBkgQual(bkgccol[icl], cquals[icl], chcol);
+           if (cquals[icl].status() == MVAStatus::unset) continue;
+           mvavars.push_back(mvaInputs(cquals[icl]));
+           mvaclusters.push_back(icl);
+      }
+
+      std::vector<float> mvaout;
+      bkgMVA_.evalMVA(mvavars,mvaout);
+      for (size_t imva=0;imva<mvaclusters.size();++imva)
+      {
+           BkgQual& cqual = cquals[mvaclusters[imva]];
+           cqual.setMVAValue(mvaout[imva]);
+           cqual.setMVAStatus(MVAStatus::calculated);
+      }
+
+      for (size_t icl=0;icl<bkgccol.size();++icl)
       {                
-           BkgQual cqual;
-           fillBkgQual(cluster, cqual, chcol);
-           fillMVA(cqual);
+           BkgCluster& cluster = bkgccol[icl];
+           BkgQual& cqual = cquals[icl];
 
            StrawHitFlag flag(StrawHitFlag::bkgclust);
            if (cqual.MVAOutput() > bkgMVAcut_)
@@ -323,10 +340,8 @@ namespace mu2e
   
   
   //----------------------------------------------
-  void FlagBkgHits::fillMVA(BkgQual& cqual) const
+  std::vector<float> FlagBkgHits::mvaInputs(const BkgQual& cqual) const
   {
-       if (cqual.status() == MVAStatus::unset) return;
-
        std::vector<float> mvavars(7,0.0);
        mvavars[0] = cqual.varValue(BkgQual::crho);
        mvavars[1] = cqual.varValue(BkgQual::zmin);
@@ -335,10 +350,7 @@ namespace mu2e
        mvavars[4] = cqual.varValue(BkgQual::np);
        mvavars[5] = cqual.varValue(BkgQual::npfrac);
        mvavars[6] = cqual.varValue(BkgQual::nhits);
-       float mvaout = bkgMVA_.evalMVA(mvavars);
-
-       cqual.setMVAValue(mvaout);
-       cqual.setMVAStatus(MVAStatus::calculated);
+       return mvavars;
    }
 
 
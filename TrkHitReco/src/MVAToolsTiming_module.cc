@@ -0,0 +1,102 @@
+//
+// Benchmark of the MVATools evaluation: the same random feature vectors are scored
+// one at a time and in batches, and the evaluations per second of both paths and
+// their largest difference are printed at the end of the job.
+//
+#include "art/Framework/Core/EDAnalyzer.h"
+#include "art/Framework/Core/ModuleMacros.h"
+#include "art/Framework/Principal/Event.h"
+#include "fhiclcpp/types/Atom.h"
+#include "fhiclcpp/types/Table.h"
+#include "messagefacility/MessageLogger/MessageLogger.h"
+
+#include "Mu2eUtilities/inc/MVATools.hh"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace mu2e
+{
+  class MVAToolsTiming : public art::EDAnalyzer
+  {
+     public:
+        struct Config
+        {
+           using Name    = fhicl::Name;
+           using Comment = fhicl::Comment;
+           fhicl::Table<MVATools::Config> mva{        Name("MVA"),        Comment("MVA Configuration") };
+           fhicl::Atom<unsigned>          nVectors{   Name("NVectors"),   Comment("Number of feature vectors scored per event"),100000 };
+           fhicl::Atom<unsigned>          seed{       Name("Seed"),       Comment("Seed of the feature vector generator"),1 };
+        };
+
+        explicit MVAToolsTiming(const art::EDAnalyzer::Table<Config>& config);
+        void beginJob() override;
+        void analyze(const art::Event& event) override;
+        void endJob() override;
+
+     private:
+        MVATools                         mva_;
+        unsigned                         nvec_;
+        std::mt19937                     engine_;
+        std::vector<std::vector<float> > inputs_;
+        double                           tsingle_, tbatch_, maxdiff_;
+        unsigned long                    neval_;
+  };
+
+  MVAToolsTiming::MVAToolsTiming(const art::EDAnalyzer::Table<Config>& config) :
+     art::EDAnalyzer{config},
+     mva_(config().mva()),
+     nvec_(config().nVectors()),
+     engine_(config().seed()),
+     inputs_(),
+     tsingle_(0.0),
+     tbatch_(0.0),
+     maxdiff_(0.0),
+     neval_(0)
+  {}
+
+  void MVAToolsTiming::beginJob()
+  {
+     auto t0 = std::chrono::steady_clock::now();
+     mva_.initMVA();
+     auto t1 = std::chrono::steady_clock::now();
+     mf::LogInfo("MVAToolsTiming") << "MVATools initialization: "
+                                   << std::chrono::duration<double>(t1-t0).count() << " s";
+  }
+
+  void MVAToolsTiming::analyze(const art::Event&)
+  {
+     // the normalization maps the training range to [-1,1], so the inputs are drawn
+     // around it; the timing does not depend on the values
+     std::uniform_real_distribution<float> flat(-2.0,2.0);
+     inputs_.assign(nvec_,std::vector<float>(mva_.titles().size()));
+     for (auto& v : inputs_)
+        for (auto& x : v) x = flat(engine_);
+
+     std::vector<float> single(nvec_), batch;
+     auto t0 = std::chrono::steady_clock::now();
+     for (unsigned i=0;i<nvec_;++i) single[i] = mva_.evalMVA(inputs_[i]);
+     auto t1 = std::chrono::steady_clock::now();
+     mva_.evalMVA(inputs_,batch);
+     auto t2 = std::chrono::steady_clock::now();
+
+     tsingle_ += std::chrono::duration<double>(t1-t0).count();
+     tbatch_  += std::chrono::duration<double>(t2-t1).count();
+     neval_   += nvec_;
+     for (unsigned i=0;i<nvec_;++i) maxdiff_ = std::max(maxdiff_,double(std::abs(single[i]-batch[i])));
+  }
+
+  void MVAToolsTiming::endJob()
+  {
+     if (neval_ == 0) return;
+     mf::LogInfo("MVAToolsTiming") << "MVATools evaluations: " << neval_ << "\n"
+                                   << "  single vector : " << (tsingle_ > 0 ? neval_/tsingle_ : 0) << " evaluations/s\n"
+                                   << "  batch         : " << (tbatch_  > 0 ? neval_/tbatch_  : 0) << " evaluations/s\n"
+                                   << "  largest difference : " << maxdiff_;
+  }
+}
+
+DEFINE_ART_MODULE(mu2e::MVAToolsTiming);
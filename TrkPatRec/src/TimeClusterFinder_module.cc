@@ -17,6 +17,7 @@
 #include "Mu2eUtilities/inc/polyAtan2.hh"
 // data
 #include "RecoDataProducts/inc/ComboHit.hh"
+#include "RecoDataProducts/inc/ComboHitView.hh"
 #include "RecoDataProducts/inc/StrawHitFlag.hh"
 #include "RecoDataProducts/inc/TimeCluster.hh"
 #include "RecoDataProducts/inc/CaloClusterCollection.hh"
@@ -101,6 +102,7 @@ namespace mu2e {
             fhicl::Atom<bool>                       refine                 {Name("PrefilterCluster"),       Comment("Apply hit pre-filtering algorithm") }; 
             fhicl::Atom<bool>                       preFilter              {Name("RecoverHits"),            Comment("Apply hit recovery algorithm") }; 
             fhicl::Atom<int>                        npeak                  {Name("PeakWidth"),              Comment("Time Peak Width") }; 
+            fhicl::Atom<bool>                       sortedhits             {Name("SortedHits"),             Comment("Find clusters on time-sorted hits"), false }; 
             fhicl::Atom<int>                        printfreq              {Name("printFrequency"),         Comment("Print frequency"), 100 }; 
             fhicl::Atom<int>                        debugLevel             {Name("debugLevel"),             Comment("Debut Level"), 0 }; 
         };
@@ -121,6 +123,8 @@ namespace mu2e {
        const art::ProductToken<CaloClusterCollection>  _ccToken;      
        const StrawHitFlagCollection* _shfcol;
        const ComboHitCollection*     _chcol;
+       std::unique_ptr<ComboHitView> _chview; // hot fields of _chcol, read in the hit loops
+       std::vector<float>            _chtime; // T0 calculator time of each ComboHit
        const CaloClusterCollection*  _cccol;
        StrawHitFlag                  _hsel;
        StrawHitFlag                  _hbkg;
@@ -141,10 +145,18 @@ namespace mu2e {
        bool                          _preFilter;
        bool                          _recover;
        int                           _npeak;
+       bool                          _sortedhits;
        int                           _printfreq;
        int                           _debug;    
        TH1F                          _timespec;
        TimeCluMVA                    _pmva; // input variables to TMVA for cluster cleaning
+       // time-sorted hits engine
+       std::vector<StrawHitIndex>    _shsort;  // selected hits in time order
+       std::vector<float>            _stime;   // their times
+       std::vector<float>            _tspec;   // time spectrum bin contents, same binning as _timespec
+       std::vector<double>           _nsum, _tsum; // prefix sums of the bin contents and of contents*bin center
+       std::vector<int>              _hclust;  // cluster assigned to each hit
+       std::vector<char>             _hstate;  // hits of the cluster being recovered and recovery candidates
 
 
       void findClusters(TimeClusterCollection& tccol);
@@ -159,6 +171,11 @@ namespace mu2e {
       void refineCluster(TimeCluster& tc);
       void findPeaks(TimeClusterCollection& seeds);
       void assignHits(TimeClusterCollection& tccol );
+      void sortHits();
+      void fillSortedSpectrum();
+      void findSortedPeaks(TimeClusterCollection& tccol);
+      void assignSortedHits(TimeClusterCollection& tccol );
+      void recoverSortedHits(TimeCluster& tc);
       bool goodHit(const StrawHitFlag& flag) const;
   };
 
@@ -192,6 +209,7 @@ namespace mu2e {
      _preFilter    ( config().preFilter()),        
      _recover      ( config().recover()),      
      _npeak        ( config().npeak()), 
+     _sortedhits   ( config().sortedhits()), 
      _printfreq    ( config().printfreq()),
      _debug        ( config().debugLevel())
     {
@@ -221,6 +239,8 @@ namespace mu2e {
 
     auto const& chH = event.getValidHandle(_chToken);
     _chcol = chH.product();
+    _chview = std::make_unique<ComboHitView>(*_chcol);
+    _ttcalc.comboHitTimes(*_chview,_pitch,_chtime);
 
     art::Handle<CaloClusterCollection> ccH{}; // need to cache for later Ptr creation 
     if(_usecc){
@@ -260,11 +280,17 @@ namespace mu2e {
 
   //--------------------------------------------------------------------------------------------------------------
   void TimeClusterFinder::findClusters(TimeClusterCollection& tccol) {
-    // find seed from hits
-    fillTimeSpectrum();
-    findPeaks(tccol);
-    // associate hits to seeds
-    assignHits(tccol);
+    // find seed from hits, and associate hits to seeds
+    if(_sortedhits){
+      sortHits();
+      fillSortedSpectrum();
+      findSortedPeaks(tccol);
+      assignSortedHits(tccol);
+    } else {
+      fillTimeSpectrum();
+      findPeaks(tccol);
+      assignHits(tccol);
+    }
     // loop over seeds and fill/refine information
     auto itc = tccol.begin();
     while(itc != tccol.end()){
@@ -274,7 +300,12 @@ namespace mu2e {
       if( tc.nStrawHits() >= _minnhits) {
 	clusterMean(tc);
 	if (_refine) refineCluster(tc);
-	if (_recover) recoverHits(tc);
+	if (_recover) {
+	  if(_sortedhits)
+	    recoverSortedHits(tc);
+	  else
+	    recoverHits(tc);
+	}
       }
       if (tc.nStrawHits() < _minnhits) {
 	itc = tccol.erase(itc);
@@ -311,9 +342,7 @@ namespace mu2e {
     _timespec.Reset();
     for (unsigned istr=0; istr<_chcol->size();++istr) {
       if (_testflag && !goodHit((*_shfcol)[istr])) continue;
-      ComboHit const& ch = (*_chcol)[istr];
-      float time = _ttcalc.comboHitTime((*_chcol)[istr],_pitch);
-      _timespec.Fill(time,ch.nStrawHits());
+      _timespec.Fill(_chtime[istr],_chview->nStrawHits(istr));
     }
   }
 
@@ -321,8 +350,7 @@ namespace mu2e {
   // assign hits to the closest time peak
     for(size_t istr=0; istr<_chcol->size(); ++istr) {
       if ((!_testflag) || goodHit((*_shfcol)[istr])) {
-	ComboHit const& ch =(*_chcol)[istr];
-	float time = _ttcalc.comboHitTime(ch,_pitch);
+	float time = _chtime[istr];
 	float mindt(1e5);
 	auto besttc = tccol.end();
 	// find the closest seed (if any)
@@ -387,18 +415,16 @@ namespace mu2e {
     tc._nsh = 0;
     for(auto ish :tc._strawHitIdxs) {
       if (_testflag && !goodHit((*_shfcol)[ish])) continue;
-      ComboHit const& ch = (*_chcol)[ish];
-      unsigned nsh = ch.nStrawHits();
+      unsigned nsh = _chview->nStrawHits(ish);
       tc._nsh += nsh;
-      const XYZVec& pos = ch.pos();
-      float htime = _ttcalc.comboHitTime(ch,_pitch);
-      float hwt = ch.nStrawHits();
+      float htime = _chtime[ish];
+      float hwt = nsh;
       tmin(htime);
       tmax(htime);
       tacc(htime,weight=hwt);
-      xacc(pos.x(),weight=hwt);
-      yacc(pos.y(),weight=hwt);
-      zacc(pos.z(),weight=hwt);
+      xacc(_chview->x(ish),weight=hwt);
+      yacc(_chview->y(ish),weight=hwt);
+      zacc(_chview->z(ish),weight=hwt);
     }
 
     if (tc.hasCaloCluster()) {
@@ -429,8 +455,7 @@ namespace mu2e {
       auto iworst = tc._strawHitIdxs.end();
       float maxadPhi(_maxdPhi);
       for( auto ips = tc._strawHitIdxs.begin(); ips != tc._strawHitIdxs.end(); ++ips){
-	ComboHit const& ch = (*_chcol)[*ips];
-	float phi   = polyAtan2(ch.pos().y(), ch.pos().x()); 
+	float phi   = polyAtan2(_chview->y(*ips), _chview->x(*ips));
 	float dphi  = Angles::deltaPhi(phi,pphi);
 	float adphi = std::abs(dphi);
 	if(adphi > maxadPhi ){
@@ -453,19 +478,18 @@ namespace mu2e {
       for(size_t ich=0;ich < _chcol->size(); ++ich){
 	if ((!_testflag) || goodHit((*_shfcol)[ich])) {
 	  if(std::find(tc._strawHitIdxs.begin(),tc._strawHitIdxs.end(),ich) == tc._strawHitIdxs.end()){
-	    ComboHit const& ch = (*_chcol)[ich];
-	    float cht = _ttcalc.comboHitTime(ch,_pitch);
+	    float cht = _chtime[ich];
 	    _pmva._dt = fabs(cht - tc._t0._t0);
 	    if(_pmva._dt < _maxdt+tc._t0._t0err){
-	      float phi = polyAtan2(ch.pos().y(), ch.pos().x());//ch.phi();
+	      float phi = polyAtan2(_chview->y(ich), _chview->x(ich));//ch.phi();
 	      float dphi = fabs(Angles::deltaPhi(phi,pphi));
 	      if(dphi < _maxdPhi){ 
 		_pmva._dphi = dphi;
-		_pmva._rho = ch.pos().Perp2();
-		_pmva._nsh = ch.nStrawHits();
-		_pmva._plane = ch.strawId().plane();
-		_pmva._werr = ch.wireRes();
-		_pmva._wdist = fabs(ch.wireDist());
+		_pmva._rho = _chview->perp2(ich);
+		_pmva._nsh = _chview->nStrawHits(ich);
+		_pmva._plane = _chview->strawId(ich).plane();
+		_pmva._werr = _chview->wireRes(ich);
+		_pmva._wdist = fabs(_chview->wireDist(ich));
 
 		float mvaout(-1.0);
 		if (tc.hasCaloCluster())
@@ -485,37 +509,37 @@ namespace mu2e {
   }
 
   std::vector<StrawHitIndex>::iterator TimeClusterFinder::removeHit(TimeCluster& tc, ISH iworst) {
-    ComboHit const& ch = (*_chcol)[*iworst];
-    unsigned nsh = ch.nStrawHits();
+    size_t ich = *iworst;
+    unsigned nsh = _chview->nStrawHits(ich);
     float denom = float(tc._nsh - nsh);
     // update time cluster properties 
     if(!tc.hasCaloCluster()){
-      float cht = _ttcalc.comboHitTime(ch,_pitch);
+      float cht = _chtime[ich];
       float newt0  = (tc._t0._t0*tc._nsh - cht*nsh)/denom;
       tc._t0._t0err = sqrt((tc._t0._t0err*tc._t0._t0err*tc._nsh - (cht-newt0)*(cht-tc._t0._t0)*nsh )/denom);
       tc._t0._t0 = newt0;
     }
-    tc._pos.SetX((tc._pos.x()*tc._nsh - ch.pos().x()*nsh)/denom);
-    tc._pos.SetY((tc._pos.y()*tc._nsh - ch.pos().x()*nsh)/denom);
-    tc._pos.SetZ((tc._pos.z()*tc._nsh - ch.pos().x()*nsh)/denom);
+    tc._pos.SetX((tc._pos.x()*tc._nsh - _chview->x(ich)*nsh)/denom);
+    tc._pos.SetY((tc._pos.y()*tc._nsh - _chview->x(ich)*nsh)/denom);
+    tc._pos.SetZ((tc._pos.z()*tc._nsh - _chview->x(ich)*nsh)/denom);
     tc._nsh -= nsh;
     return tc._strawHitIdxs.erase(iworst);
   }
 
   void TimeClusterFinder::addHit(TimeCluster& tc,size_t iadd) {
-    ComboHit const& ch = (*_chcol)[iadd];
-    unsigned nsh = ch.nStrawHits();
+    size_t ich = iadd;
+    unsigned nsh = _chview->nStrawHits(ich);
     float denom = float(tc._nsh + nsh);
     // update time cluster properties 
     if(!tc.hasCaloCluster()){
-      float cht = _ttcalc.comboHitTime(ch,_pitch);
+      float cht = _chtime[ich];
       float newt0  = (tc._t0._t0*tc._nsh + cht*nsh)/denom;
       tc._t0._t0err = sqrt((tc._t0._t0err*tc._t0._t0err*tc._nsh + (cht-newt0)*(cht-tc._t0._t0)*nsh )/denom);
       tc._t0._t0 = newt0;
     }
-    tc._pos.SetX((tc._pos.x()*tc._nsh + ch.pos().x()*nsh)/denom);
-    tc._pos.SetY((tc._pos.y()*tc._nsh + ch.pos().x()*nsh)/denom);
-    tc._pos.SetZ((tc._pos.z()*tc._nsh + ch.pos().x()*nsh)/denom);
+    tc._pos.SetX((tc._pos.x()*tc._nsh + _chview->x(ich)*nsh)/denom);
+    tc._pos.SetY((tc._pos.y()*tc._nsh + _chview->x(ich)*nsh)/denom);
+    tc._pos.SetZ((tc._pos.z()*tc._nsh + _chview->x(ich)*nsh)/denom);
     tc._nsh += nsh;
     tc._strawHitIdxs.push_back(iadd);
   }
@@ -525,13 +549,12 @@ namespace mu2e {
     accumulator_set<float, stats<tag::weighted_variance(lazy)>, float > terr;
     accumulator_set<float, stats<tag::weighted_mean >,float > xacc, yacc, zacc;
     for(StrawHitIndex ish : tc._strawHitIdxs) {
-      ComboHit const& ch = (*_chcol)[ish];
-      float hwt = ch.nStrawHits();
-      float cht = _ttcalc.comboHitTime(ch,_pitch);
+      float hwt = _chview->nStrawHits(ish);
+      float cht = _chtime[ish];
       terr(cht,weight=hwt);
-      xacc(ch.pos().x(),weight=hwt);
-      yacc(ch.pos().y(),weight=hwt);
-      zacc(ch.pos().z(),weight=hwt);
+      xacc(_chview->x(ish),weight=hwt);
+      yacc(_chview->y(ish),weight=hwt);
+      zacc(_chview->z(ish),weight=hwt);
     }
     if (tc.hasCaloCluster()) {
       if(_useccpos){
@@ -557,18 +580,18 @@ namespace mu2e {
       float worstmva(100.0);
       float pphi = polyAtan2(tc._pos.y(), tc._pos.x());
       for (auto ips=tc._strawHitIdxs.begin();ips != tc._strawHitIdxs.end();++ips) {
-        ComboHit const& ch = (*_chcol)[*ips];
-        float cht = _ttcalc.comboHitTime(ch,_pitch);
+        size_t ich = *ips;
+        float cht = _chtime[ich];
 
         _pmva._dt = fabs(cht - tc._t0._t0);
-        float phi = polyAtan2(ch.pos().y(), ch.pos().x());//ch.phi();
+        float phi = polyAtan2(_chview->y(ich), _chview->x(ich));//ch.phi();
         float dphi = Angles::deltaPhi(phi,pphi);
         _pmva._dphi = fabs(dphi);
-	_pmva._rho = ch.pos().Perp2();
-	_pmva._nsh = ch.nStrawHits();
-	_pmva._plane = ch.strawId().plane();
-	_pmva._werr = ch.wireRes();
-	_pmva._wdist = fabs(ch.wireDist());
+	_pmva._rho = _chview->perp2(ich);
+	_pmva._nsh = _chview->nStrawHits(ich);
+	_pmva._plane = _chview->strawId(ich).plane();
+	_pmva._werr = _chview->wireRes(ich);
+	_pmva._wdist = fabs(_chview->wireDist(ich));
 
 	float mvaout(-1.0);
 	if (tc.hasCaloCluster())
@@ -588,6 +611,160 @@ namespace mu2e {
     }
   }
 
+  //--------------------------------------------------------------------------------------------------------------
+  // time-sorted hits engine: the selected hits are sorted by time once per event, the peaks are found with
+  // prefix sums over the spectrum, hits are assigned by sweeping the hits and seeds together in time, and
+  // the hit recovery only looks at the hits inside the cluster time window.
+  void TimeClusterFinder::sortHits() {
+    _shsort.clear();
+    for(size_t istr=0; istr<_chcol->size(); ++istr)
+      if ((!_testflag) || goodHit((*_shfcol)[istr])) _shsort.push_back(istr);
+    std::stable_sort(_shsort.begin(),_shsort.end(),
+	[this](StrawHitIndex i1, StrawHitIndex i2){ return _chtime[i1] < _chtime[i2]; });
+    _stime.clear();
+    for(auto ish : _shsort) _stime.push_back(_chtime[ish]);
+  }
+
+  void TimeClusterFinder::fillSortedSpectrum() {
+    // same binning as TH1::FindBin, so the peaks are those of the histogram
+    int nbins = _timespec.GetNbinsX();
+    _tspec.assign(nbins+2,0.0);
+    for(size_t isort=0; isort<_shsort.size(); ++isort){
+      float time = _stime[isort];
+      int ibin = time < _tmin ? 0 : (time >= _tmax ? nbins+1 : 1 + int(nbins*(double(time)-_tmin)/(double(_tmax)-_tmin)));
+      _tspec[ibin] += _chview->nStrawHits(_shsort[isort]);
+    }
+    // prefix sums: _nsum[ibin] is the sum of the bins below ibin
+    _nsum.assign(nbins+2,0.0);
+    _tsum.assign(nbins+2,0.0);
+    for(int ibin=1; ibin < nbins+1; ++ibin){
+      _nsum[ibin+1] = _nsum[ibin] + _tspec[ibin];
+      _tsum[ibin+1] = _tsum[ibin] + _timespec.GetBinCenter(ibin)*_tspec[ibin];
+    }
+    if (_debug > 2) {
+      _timespec.Reset();
+      for(int ibin=0; ibin < nbins+2; ++ibin) _timespec.SetBinContent(ibin,_tspec[ibin]);
+    }
+  }
+
+  void TimeClusterFinder::findSortedPeaks(TimeClusterCollection& tccol) {
+    int nbins = _timespec.GetNbinsX()+1;
+    std::vector<bool> alreadyUsed(nbins,false);
+    // blank out bins around input times (from calo clusters)
+    for(auto const& tc : tccol ){ 
+      int ibin = _timespec.FindBin(tc._t0._t0);
+      for(int jbin = std::max(1,ibin-_npeak);jbin < std::min(nbins,ibin+_npeak+1); ++jbin)
+	alreadyUsed[jbin] = true;
+    }
+    std::vector<BinContent> bcv;
+    for (int ibin=1;ibin < nbins; ++ibin)
+      if (_tspec[ibin] >= _ymin) bcv.push_back(make_pair(_tspec[ibin],ibin));
+    std::sort(bcv.begin(),bcv.end(),[](const BinContent& x, const BinContent& y){return x.first > y.first;});
+
+    for (const auto& bc : bcv) {
+      if (alreadyUsed[bc.second]) continue;
+      int lo = std::max(1,bc.second-_npeak);
+      int hi = std::min(nbins,bc.second+_npeak+1);
+      for (int ibin = lo; ibin < hi; ++ibin) alreadyUsed[ibin] = true;
+      // window sums from the prefix sums
+      float nsh = _nsum[hi] - _nsum[lo];
+      float t0 = (_tsum[hi] - _tsum[lo])/nsh;
+      if (nsh > _minnhits){
+	TimeCluster tc;
+	tc._t0 = TrkT0(t0,_tbin*0.5); // bin width
+	tc._nsh = nsh;
+	tccol.push_back(tc);
+      }    
+    }
+  }
+
+  void TimeClusterFinder::assignSortedHits(TimeClusterCollection& tccol ) {
+    // seeds in time order; hits can only be assigned to seeds within the widest acceptance
+    std::vector<size_t> tcsort(tccol.size());
+    double maxerr(0.0);
+    for(size_t itc=0; itc < tccol.size(); ++itc){
+      tcsort[itc] = itc;
+      maxerr = std::max(maxerr,double(tccol[itc]._t0._t0err));
+    }
+    std::sort(tcsort.begin(),tcsort.end(),
+	[&tccol](size_t i1, size_t i2){ return tccol[i1]._t0._t0 < tccol[i2]._t0._t0; });
+    double window = _maxdt + maxerr;
+    _hclust.assign(_chcol->size(),-1);
+    size_t first(0);
+    for(size_t isort=0; isort<_shsort.size(); ++isort){
+      float time = _stime[isort];
+      while(first < tcsort.size() && tccol[tcsort[first]]._t0._t0 < time - window) ++first;
+      float mindt(1e5);
+      int best(-1);
+      for(size_t jtc = first; jtc < tcsort.size() && tccol[tcsort[jtc]]._t0._t0 <= time + window; ++jtc){
+	int itc = tcsort[jtc];
+	float dt = fabs(time - tccol[itc]._t0._t0);
+	// as in assignHits, ties go to the first seed in the collection
+	if (dt < _maxdt+tccol[itc]._t0._t0err && (dt < mindt || (dt == mindt && itc < best))){
+	  mindt = dt;
+	  best = itc;
+	}
+      }
+      _hclust[_shsort[isort]] = best;
+    }
+    // fill the clusters in hit order
+    for(size_t istr=0; istr<_chcol->size(); ++istr)
+      if(_hclust[istr] >= 0) tccol[_hclust[istr]]._strawHitIdxs.push_back(istr);
+  }
+
+  void TimeClusterFinder::recoverSortedHits(TimeCluster& tc){
+    enum {unused=0,inclust,candidate};
+    _hstate.assign(_chcol->size(),unused);
+    for(auto ish : tc._strawHitIdxs) _hstate[ish] = inclust;
+    bool changed(true);
+    while (changed) {
+      changed = false;
+      float pphi = polyAtan2(tc._pos.y(), tc._pos.x());
+      // candidates are the hits in the time window of the cluster, tested in hit order as in recoverHits
+      double window = _maxdt+tc._t0._t0err;
+      auto ibeg = std::lower_bound(_stime.begin(),_stime.end(),tc._t0._t0-window);
+      auto iend = std::upper_bound(ibeg,_stime.end(),tc._t0._t0+window);
+      size_t imin(_chcol->size()), imax(0);
+      for(auto it = ibeg; it != iend; ++it){
+	StrawHitIndex ich = _shsort[it - _stime.begin()];
+	if(_hstate[ich] == unused){
+	  _hstate[ich] = candidate;
+	  imin = std::min(imin,size_t(ich));
+	  imax = std::max(imax,size_t(ich)+1);
+	}
+      }
+      for(size_t ich=imin; ich < imax; ++ich){
+	if(_hstate[ich] != candidate) continue;
+	_hstate[ich] = unused;
+	float cht = _chtime[ich];
+	_pmva._dt = fabs(cht - tc._t0._t0);
+	if(_pmva._dt < _maxdt+tc._t0._t0err){
+	  float phi = polyAtan2(_chview->y(ich), _chview->x(ich));
+	  float dphi = fabs(Angles::deltaPhi(phi,pphi));
+	  if(dphi < _maxdPhi){ 
+	    _pmva._dphi = dphi;
+	    _pmva._rho = _chview->perp2(ich);
+	    _pmva._nsh = _chview->nStrawHits(ich);
+	    _pmva._plane = _chview->strawId(ich).plane();
+	    _pmva._werr = _chview->wireRes(ich);
+	    _pmva._wdist = fabs(_chview->wireDist(ich));
+
+	    float mvaout(-1.0);
+	    if (tc.hasCaloCluster())
+	      mvaout = _tcCaloMVA.evalMVA(_pmva._pars);
+	    else
+	      mvaout = _tcMVA.evalMVA(_pmva._pars);
+	    if (mvaout > _minaddmva) {
+	      addHit(tc,ich);
+	      _hstate[ich] = inclust;
+	      changed = true;
+	    }
+	  }
+	}
+      }
+    }
+  }
+
   bool TimeClusterFinder::goodHit(const StrawHitFlag& flag) const
   {
     return flag.hasAllProperties(_hsel) && !flag.hasAnyProperty(_hbkg);
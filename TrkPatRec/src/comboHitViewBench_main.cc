@@ -0,0 +1,151 @@
+//
+// Benchmark of the pattern recognition hit loops on a ComboHitCollection read directly
+// and through its ComboHitView.  A synthetic collection is filled, then the loops of
+// TimeClusterFinder (time spectrum, weighted means) and RobustHelixFinder (flag selection)
+// are run over it both ways.
+//
+// Usage: comboHitViewBench [number of hits] [number of passes]
+//
+// The sums are printed together with the times; they agree up to the float rounding of
+// the view.  The view construction is timed separately, as it is done once per event.
+//
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "CLHEP/Units/PhysicalConstants.h"
+
+#include "RecoDataProducts/inc/ComboHit.hh"
+#include "RecoDataProducts/inc/ComboHitView.hh"
+
+namespace {
+
+  typedef std::chrono::steady_clock Clock;
+
+  double seconds(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now()-start).count();
+  }
+
+  // same constants as the TimeClusterFinderDe configuration
+  const double pitch = 0.6;
+  const float tmin(400.0), tmax(1700.0), tbin(15.0);
+
+  void fillCollection(mu2e::ComboHitCollection& chcol, size_t nhits) {
+    std::mt19937 rng(20181);
+    std::uniform_real_distribution<float> uphi(-M_PI,M_PI), urho(380.0,680.0), uz(-1500.0,1500.0);
+    std::uniform_real_distribution<float> utime(tmin,tmax), udt(0.0,40.0), ures(5.0,40.0);
+    chcol.reserve(nhits);
+    for (size_t ich=0; ich<nhits; ++ich) {
+      mu2e::ComboHit ch;
+      float phi = uphi(rng), rho = urho(rng);
+      ch._pos = mu2e::XYZVec(rho*cos(phi), rho*sin(phi), uz(rng));
+      ch._wdir = mu2e::XYZVec(-sin(phi), cos(phi), 0.0);
+      ch._time = utime(rng);
+      ch._dtime = udt(rng);
+      ch._ptime = 0.1*udt(rng);
+      ch._wres = ures(rng);
+      ch._tres = 0.2*ures(rng);
+      ch._wdist = 0.1*ures(rng);
+      ch._nsh = 1 + rng()%2;
+      ch._ncombo = ch._nsh;
+      if (rng()%4 == 0) ch._flag.merge(mu2e::StrawHitFlag::bkg);
+      if (rng()%8 != 0) ch._flag.merge(mu2e::StrawHitFlag::energysel);
+      chcol.push_back(ch);
+    }
+  }
+
+  struct Result {
+    double time = 0.0;
+    double sum = 0.0;
+  };
+
+  // time spectrum and the weighted mean position and time of the selected hits
+  Result loopHits(mu2e::ComboHitCollection const& chcol, mu2e::StrawHitFlag const& hsel,
+    mu2e::StrawHitFlag const& hbkg, std::vector<float>& spectrum) {
+    Result res;
+    Clock::time_point start = Clock::now();
+    double scale = 1.0/(pitch*CLHEP::c_light);
+    float sx(0.0), sy(0.0), sz(0.0), st(0.0), sw(0.0);
+    for (auto const& ch : chcol) {
+      float time = ch.correctedTime() - ch.pos().z()*scale;
+      if (time >= tmin && time < tmax) spectrum[size_t((time-tmin)/tbin)] += ch.nStrawHits();
+      if (ch.flag().hasAnyProperty(hsel) && !ch.flag().hasAnyProperty(hbkg)) {
+        float wt = ch.nStrawHits();
+        sx += wt*ch.pos().x(); sy += wt*ch.pos().y(); sz += wt*ch.pos().z();
+        st += wt*time; sw += wt;
+      }
+    }
+    res.time = seconds(start);
+    res.sum = sx + sy + sz + st + sw;
+    return res;
+  }
+
+  Result loopView(mu2e::ComboHitView const& view, mu2e::StrawHitFlag const& hsel,
+    mu2e::StrawHitFlag const& hbkg, std::vector<float>& spectrum, std::vector<float>& times) {
+    Result res;
+    Clock::time_point start = Clock::now();
+    double scale = 1.0/(pitch*CLHEP::c_light);
+    const float* ctime = view.data(mu2e::ComboHitView::ctime_);
+    const float* zpos = view.data(mu2e::ComboHitView::z_);
+    const uint16_t* nsh = view.nStrawHits();
+    times.resize(view.size());
+    for (size_t ich=0; ich<view.size(); ++ich) times[ich] = ctime[ich] - zpos[ich]*scale;
+    for (size_t ich=0; ich<view.size(); ++ich) {
+      float time = times[ich];
+      if (time >= tmin && time < tmax) spectrum[size_t((time-tmin)/tbin)] += nsh[ich];
+    }
+    const float* xpos = view.data(mu2e::ComboHitView::x_);
+    const float* ypos = view.data(mu2e::ComboHitView::y_);
+    const mu2e::StrawHitFlag* flags = view.flags();
+    float sx(0.0), sy(0.0), sz(0.0), st(0.0), sw(0.0);
+    for (size_t ich=0; ich<view.size(); ++ich) {
+      if (flags[ich].hasAnyProperty(hsel) && !flags[ich].hasAnyProperty(hbkg)) {
+        float wt = nsh[ich];
+        sx += wt*xpos[ich]; sy += wt*ypos[ich]; sz += wt*zpos[ich];
+        st += wt*times[ich]; sw += wt;
+      }
+    }
+    res.time = seconds(start);
+    res.sum = sx + sy + sz + st + sw;
+    return res;
+  }
+}
+
+int main(int argc, char**argv) {
+
+  size_t nhits = argc > 1 ? strtoul(argv[1],0,10) : 20000;
+  unsigned npass = argc > 2 ? strtoul(argv[2],0,10) : 1000;
+
+  mu2e::ComboHitCollection chcol;
+  fillCollection(chcol,nhits);
+  mu2e::StrawHitFlag hsel(mu2e::StrawHitFlag::energysel), hbkg(mu2e::StrawHitFlag::bkg);
+
+  Clock::time_point start = Clock::now();
+  mu2e::ComboHitView view(chcol);
+  double viewTime = seconds(start);
+
+  std::vector<float> spectrum(size_t((tmax-tmin)/tbin)+1,0.0), times;
+  Result hits, cols;
+  for (unsigned ipass=0; ipass<npass; ++ipass) {
+    Result res = loopHits(chcol,hsel,hbkg,spectrum);
+    hits.time += res.time; hits.sum += res.sum;
+  }
+  double hitSpectrum(0.0);
+  for (auto val : spectrum) hitSpectrum += val;
+  std::fill(spectrum.begin(),spectrum.end(),0.0);
+  for (unsigned ipass=0; ipass<npass; ++ipass) {
+    Result res = loopView(view,hsel,hbkg,spectrum,times);
+    cols.time += res.time; cols.sum += res.sum;
+  }
+  double viewSpectrum(0.0);
+  for (auto val : spectrum) viewSpectrum += val;
+
+  std::cout << "comboHitViewBench: " << nhits << " hits (" << sizeof(mu2e::ComboHit) << " bytes each), "
+            << npass << " passes\n"
+            << "  view construction : " << viewTime << " s\n"
+            << "  ComboHits         : " << hits.time << " s, sum " << hits.sum << ", spectrum " << hitSpectrum << "\n"
+            << "  ComboHitView      : " << cols.time << " s, sum " << cols.sum << ", spectrum " << viewSpectrum << std::endl;
+  return 0;
+}
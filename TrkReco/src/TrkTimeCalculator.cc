@@ -48,6 +48,17 @@ namespace mu2e
         return ch.time() - tflt - _avgDriftTime; // otherwise make an average correction
    }
 
+   void TrkTimeCalculator::comboHitTimes(ComboHitView const& view,double pitch, std::vector<float>& times) const
+   {
+      times.resize(view.size());
+      const float* zpos = view.data(ComboHitView::z_);
+      const float* htime = _useTOTdrift ? view.data(ComboHitView::ctime_) : view.data(ComboHitView::time_);
+      double offset = _useTOTdrift ? 0.0 : _avgDriftTime;
+      double scale = 1.0/(pitch*_beta*CLHEP::c_light);
+      for (size_t ich=0;ich < view.size(); ++ich)
+        times[ich] = htime[ich] - zpos[ich]*scale - offset;
+   }
+
    double TrkTimeCalculator::caloClusterTime(CaloCluster const& cc,double pitch) const 
    {
       mu2e::GeomHandle<mu2e::Calorimeter> ch;